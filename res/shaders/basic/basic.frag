@@ -1,8 +1,37 @@
 #version 450
+#extension GL_EXT_nonuniform_qualifier : require
 
 // Uniforms
 layout (set = 0, binding = 2) uniform sampler samp;
-layout (set = 0, binding = 3) uniform texture2D texDiffuse[4096];
+
+// Virtual textures, see rendering/virtualTexture.hpp
+struct VirtualTexture {
+    uint pageTableBase;
+    uint atlas;
+    uint width;
+    uint height;
+    uint mipCount;
+    uint pageSize;
+    uint border;
+    uint padding;
+};
+
+layout (std430, set = 0, binding = 3) readonly buffer VirtualTextures {
+    VirtualTexture virtualTextures[];
+};
+
+// Atlas column in bits 0-11, row in bits 12-23, mip level the page holds in bits 24-29
+layout (std430, set = 0, binding = 4) readonly buffer PageTable {
+    uint pageTable[];
+};
+
+// One bit per page table entry, set for every page this frame wanted
+layout (std430, set = 0, binding = 5) buffer Feedback {
+    uint feedback[];
+};
+
+// Bindless texture heap
+layout (set = 1, binding = 0) uniform texture2D textures2D[];
 
 // Inputs
 layout (location = 0) in vec3 fragColor;
@@ -16,6 +45,70 @@ layout (push_constant) uniform PushConstantObject {
     layout(offset = 128) uint indexDiffuseTexture;
 } pc;
 
+const uint kVirtualTextureBit = 0x80000000u;
+
+uvec2 getLevelSize(VirtualTexture vt, uint mip)
+{
+    return max(uvec2(vt.width, vt.height) >> mip, uvec2(1));
+}
+
+uvec2 getLevelPages(VirtualTexture vt, uint mip)
+{
+    return (getLevelSize(vt, mip) + vt.pageSize - 1) / vt.pageSize;
+}
+
+vec4 sampleVirtualTexture(uint index, vec2 uv)
+{
+    VirtualTexture vt = virtualTextures[index];
+
+    // Mip level the hardware would have picked, derivatives come from the unwrapped coordinates
+    vec2 texels = uv * vec2(vt.width, vt.height);
+    vec2 dx = dFdx(texels);
+    vec2 dy = dFdy(texels);
+    float lod = 0.5 * log2(max(max(dot(dx, dx), dot(dy, dy)), 1e-8));
+    uint mip = uint(clamp(floor(lod), 0.0, float(vt.mipCount - 1)));
+
+    uv = fract(uv);
+
+    // Page table entry of the wanted page
+    uint firstPage = 0;
+    for(uint m = 0; m < mip; m++)
+    {
+        uvec2 pages = getLevelPages(vt, m);
+        firstPage += pages.x * pages.y;
+    }
+    uvec2 pages = getLevelPages(vt, mip);
+    uvec2 page = min(uvec2(uv * vec2(getLevelSize(vt, mip))) / vt.pageSize, pages - 1);
+    uint entryIndex = vt.pageTableBase + firstPage + page.y * pages.x + page.x;
+
+    uint bit = 1u << (entryIndex & 31u);
+    if((feedback[entryIndex >> 5] & bit) == 0)
+    {
+        atomicOr(feedback[entryIndex >> 5], bit);
+    }
+
+    // The entry holds the wanted page or the closest resident ancestor
+    uint entry = pageTable[entryIndex];
+    uvec2 slot = uvec2(entry & 0xFFFu, (entry >> 12) & 0xFFFu);
+    uint residentMip = (entry >> 24) & 0x3Fu;
+
+    vec2 residentTexels = uv * vec2(getLevelSize(vt, residentMip));
+    vec2 residentPage = min(floor(residentTexels / float(vt.pageSize)), vec2(getLevelPages(vt, residentMip) - 1));
+    vec2 inPage = clamp(residentTexels - residentPage * float(vt.pageSize), vec2(0.0), vec2(vt.pageSize));
+
+    float stride = float(vt.pageSize + 2 * vt.border);
+    vec2 atlasTexel = vec2(slot) * stride + float(vt.border) + inPage;
+    vec2 atlasSize = vec2(textureSize(sampler2D(textures2D[nonuniformEXT(vt.atlas)], samp), 0));
+
+    return textureLod(sampler2D(textures2D[nonuniformEXT(vt.atlas)], samp), atlasTexel / atlasSize, 0.0);
+}
+
 void main() {
-    outColor = texture(sampler2D(texDiffuse[pc.indexDiffuseTexture], samp), fragTexCoord);
-}
\ No newline at end of file
+    if((pc.indexDiffuseTexture & kVirtualTextureBit) != 0)
+    {
+        outColor = sampleVirtualTexture(pc.indexDiffuseTexture & ~kVirtualTextureBit, fragTexCoord);
+        return;
+    }
+
+    outColor = texture(sampler2D(textures2D[pc.indexDiffuseTexture], samp), fragTexCoord);
+}
@@ -1,5 +1,9 @@
 #version 450
 
+// E_VertexLayout, see rendering/resources/vertexLayout.hpp
+layout (constant_id = 2) const uint vertexLayout = 0;
+const uint kVertexLayoutCompact = 1;
+
 layout(set = 0, binding = 0) uniform UniformBufferObject {
     mat4 model;
     mat4 view;
@@ -12,17 +16,38 @@ layout (set = 0, binding = 1) uniform ModelMatrices{
 
 layout (push_constant) uniform PushConstantObject {
     layout(offset = 0) uint index;
+    // Compact meshes only, position = positionOffset + positionScale * inPosition
+    layout(offset = 16) vec4 positionScale;
+    layout(offset = 32) vec4 positionOffset;
 } pc;
 
+// Compact vertices store unorm16 positions and octahedral snorm16 normals, the missing components read as 0
 layout (location = 0) in vec3 inPosition;
-layout (location = 1) in vec3 inColor;
+layout (location = 1) in vec3 inNormal;
 layout (location = 2) in vec2 inTexCoord;
 
 layout(location = 0) out vec3 fragColor;
 layout(location = 1) out vec2 fragTexCoord;
 
+vec3 decodeOctahedral(vec2 encoded)
+{
+    vec3 direction = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    float fold = max(-direction.z, 0.0);
+    direction.xy += mix(vec2(fold), vec2(-fold), greaterThanEqual(direction.xy, vec2(0.0)));
+    return normalize(direction);
+}
+
 void main() {
-    gl_Position = ubo.proj * ubo.view * modelMatrices.model[pc.index] * vec4(inPosition, 1.0);
-    fragColor = inColor;
+    vec3 position = inPosition;
+    vec3 normal = inNormal;
+
+    if(vertexLayout == kVertexLayoutCompact)
+    {
+        position = pc.positionOffset.xyz + pc.positionScale.xyz * inPosition;
+        normal = decodeOctahedral(inNormal.xy);
+    }
+
+    gl_Position = ubo.proj * ubo.view * modelMatrices.model[pc.index] * vec4(position, 1.0);
+    fragColor = normal;
     fragTexCoord = inTexCoord;
-}
\ No newline at end of file
+}
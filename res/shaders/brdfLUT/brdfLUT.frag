@@ -6,6 +6,9 @@ layout (location = 0) in vec2 TexCoords;
 // Outputs
 layout (location = 0) out vec2 fragColor;
 
+// Specialization constants
+layout (constant_id = 1) const uint SAMPLE_COUNT = 1024u;
+
 // Constants 
 const float PI = 3.14159265359;
 
@@ -95,7 +98,6 @@ vec2 IntegrateBRDF(float NdotV, float roughness)
 
     vec3 N = vec3(0.0, 0.0, 1.0);
     
-    const uint SAMPLE_COUNT = 1024u;
     for(uint i = 0u; i < SAMPLE_COUNT; ++i)
     {
         // generates a sample vector that's biased towards the
@@ -12,9 +12,11 @@ layout (push_constant) uniform PushConstants
     layout(offset = 128) float roughness;
 }pc;
 
+// Specialization constants
+layout (constant_id = 1) const uint SAMPLE_COUNT = 4096u;
+
 // Constants
 const float PI = 3.14159265359;
-const uint SAMPLE_COUNT = 4096u;
 
 // Outputs
 layout (location = 0) out vec4 FragColor;
@@ -1,8 +1,11 @@
 #version 450
+#extension GL_EXT_nonuniform_qualifier : require
 
 // Uniforms
 layout (set = 0, binding = 1) uniform sampler samp;
-layout (set = 0, binding = 2) uniform textureCube texCubemap[64];
+
+// Bindless texture heap
+layout (set = 1, binding = 1) uniform textureCube texturesCube[];
 
 // Inputs
 layout (location = 0) in vec3 TexCoords;
@@ -16,6 +19,6 @@ layout (push_constant) uniform PushConstantObject {
 
 void main()
 {    
-    vec4 color = texture(samplerCube(texCubemap[pc.indexCubeTexture], samp), TexCoords);
+    vec4 color = texture(samplerCube(texturesCube[pc.indexCubeTexture], samp), TexCoords);
     FragColor = color;
 }
\ No newline at end of file
@@ -46,9 +46,10 @@ entt::entity Scene::addCamera()
 
 // Model
 
-entt::entity Scene::addModel(const std::string& path, const std::array<float, 3>& initialPosition, const std::array<float, 3>& initialRotation, const std::array<float, 3>& initialScale)
+entt::entity Scene::addModel(const std::string& path, const std::array<float, 3>& initialPosition, const std::array<float, 3>& initialRotation, const std::array<float, 3>& initialScale, bool optimizeMeshes, bool keepGeometry)
 {
-    entt::entity model = _core->getRendering().lock()->getModelMeshLibrary().createModel(_registry, path);
+    // The model is drawn once its import finishes, the entity and its transform exist right away
+    entt::entity model = _core->getRendering().lock()->getModelMeshLibrary().createModelAsync(_registry, path, optimizeMeshes, keepGeometry);
 
     glm::vec3 position = glm::vec3(initialPosition[0], initialPosition[1], initialPosition[2]);
     glm::quat rotation = glm::quat(glm::radians(glm::vec3(initialRotation[0], initialRotation[1], initialRotation[2])));
@@ -18,7 +18,7 @@ public:
     [[nodiscard]] entt::entity newEntity();
 
     // Model functions
-    entt::entity addModel(const std::string& path, const std::array<float, 3>& position = {0.0f, 0.0f, 0.0f}, const std::array<float, 3>& rotation = {0.0f, 0.0f, 0.0f}, const std::array<float, 3>& scale = {1.0f, 1.0f, 1.0f});
+    entt::entity addModel(const std::string& path, const std::array<float, 3>& position = {0.0f, 0.0f, 0.0f}, const std::array<float, 3>& rotation = {0.0f, 0.0f, 0.0f}, const std::array<float, 3>& scale = {1.0f, 1.0f, 1.0f}, bool optimizeMeshes = true, bool keepGeometry = false);
     std::vector<std::string> getAllModelNames() const;
 
     // Camera functions
@@ -1,6 +1,7 @@
 #include "ECS/components/skybox.hpp"
 
 #include "rendering/rendering.hpp"
+#include "rendering/strategy/SChain.hpp"
 
 
 Skybox createSkybox(std::shared_ptr<rendering_system> core, const std::string& path)
@@ -8,7 +9,15 @@ Skybox createSkybox(std::shared_ptr<rendering_system> core, const std::string& p
     Skybox skybox;
 
     skybox.cube = shapes::cube::model();
-    skybox.texture = core->getTextureSystem().bakeCubemap(path, true);
+    skybox.sourceKey = core->getTextureSystem().getSourceKey(path);
+
+    // The lighting maps are baked in the same submission as the cubemap, only the PBS chain samples them
+    bool bakeLighting = std::dynamic_pointer_cast<PBSShadingStrategyChain>(core->getStrategyChain()) != nullptr;
+    environmentMaps maps = core->getTextureSystem().bakeEnvironment(path, skybox.sourceKey, true, bakeLighting);
+    skybox.texture = maps.cubemap;
+    skybox.irradianceMap = maps.irradianceMap;
+    skybox.prefilteredMap = maps.prefilteredMap;
+    skybox.brdfLUT = maps.brdfLUT;
 
     return skybox;
 }
\ No newline at end of file
@@ -9,6 +9,7 @@ struct Skybox
     Model cube;
     image texture;
     bool enabled = false;
+    uint64_t sourceKey = 0;     // content hash of the source image, keys the baked maps on disk
 
     // Optional if PBR is enabled
     image irradianceMap;
@@ -1,6 +1,7 @@
 #include "GUI/imGUIHandler.hpp"
 #include "rendering/rendering.hpp"
 #include "rendering/swapChainManager.hpp"
+#include "rendering/strategy/SNode.hpp"
 
 #include "ECS/components/spatial.hpp"
 #include "ECS/components/camera.hpp"
@@ -143,6 +144,36 @@ void imGUI_handler::createPerformanceCollapsible()
 
         // Frame time plot
         ImGui::PlotLines("Frame Times", FPSCounter::getTimes(), FPSCounter::getArraySize());
+
+        // Descriptor churn, pool counts that keep climbing mean sets are leaking
+        const DescriptorAllocator::Stats& persistent = _core->getFrameManager().getDescriptorAllocator()->getStats();
+        DescriptorAllocator::Stats transient = _core->getFrameManager().getTransientDescriptorStats();
+        ImGui::Text("Descriptor sets: %u persistent, %u transient this frame", persistent.allocations, transient.allocations);
+        ImGui::Text("Descriptor pools: %u persistent, %u transient", persistent.pools, transient.pools);
+
+        // Levels of detail, triangles of the opaque pass against the full meshes
+        std::shared_ptr<RenderOpaqueNode> opaque = _core->getStrategyChain() ? _core->getStrategyChain()->getNode<RenderOpaqueNode>() : nullptr;
+        if(opaque)
+        {
+            const RenderOpaqueNode::lodStats& lods = opaque->getLodStats();
+            ImGui::Text("Triangles: %zu drawn of %zu", lods.trianglesRendered, lods.trianglesAvailable);
+        }
+
+        const clusterCullingStats& clusters = _core->getClusterCullingSystem().getStats();
+        ImGui::Text("Cluster culling: %zu of %zu triangles submitted, %zu meshlets", clusters.trianglesSubmitted, clusters.trianglesTested, clusters.meshlets);
+
+        // Vertex cache efficiency of the models optimized at import
+        for(const auto& [path, report] : _core->getModelMeshLibrary().getOptimizationReports())
+        {
+            std::string name = path.substr(path.find_last_of("/\\") + 1);
+            ImGui::Text("%s: ACMR %.3f -> %.3f, vertices %zu -> %zu", name.c_str(), report.acmrBefore, report.acmrAfter, report.verticesBefore, report.verticesAfter);
+        }
+
+        // GPU time of the last environment bake
+        for(const bakeStageTiming& timing : _core->getTextureSystem().getBakeTimings())
+        {
+            ImGui::Text("IBL bake %s: %.2f ms", timing.stage.c_str(), timing.milliseconds);
+        }
     }
 }
 
@@ -68,9 +68,11 @@ void Manta::loadModel(
     const std::string& path, 
     std::array<float, 3> position, 
     std::array<float, 3> rotation,
-    std::array<float, 3> scale)
+    std::array<float, 3> scale,
+    bool optimizeMeshes,
+    bool keepGeometry)
 {
-    m_scene->addModel(path, position, rotation, scale);
+    m_scene->addModel(path, position, rotation, scale, optimizeMeshes, keepGeometry);
 }
 
 void Manta::loadSkybox(const std::string& path, bool setAsActive)
@@ -29,7 +29,9 @@ public:
         const std::string& path, 
         std::array<float, 3> position = {0.0f, 0.0f, 0.0f}, 
         std::array<float, 3> rotation = {0.0f, 0.0f, 0.0f},
-        std::array<float, 3> scale = {1.0f, 1.0f, 1.0f});
+        std::array<float, 3> scale = {1.0f, 1.0f, 1.0f},
+        bool optimizeMeshes = true,
+        bool keepGeometry = false);     // CPU copy of the meshes, for physics or picking
 
     // Load Skybox
     void loadSkybox(const std::string& path, bool setAsActive = true);
@@ -16,6 +16,15 @@ struct settingsData
     uint32_t windowHeight;
 
     const unsigned int framesInFlight;
+
+    // Run the spirv-opt performance passes on freshly compiled shaders
+    const bool optimizeShaders;
+
+    // Cap on streamed texture memory in MB, 0 leaves it to the driver reported budget
+    const uint32_t textureBudgetMB;
+
+    // Upload imported meshes in the quantised vertex layout, see rendering/resources/vertexLayout.hpp
+    const bool compactVertices;
 };
 
 void initializeSettingsData(entt::registry& registry);
@@ -0,0 +1,557 @@
+#include "rendering/clusterCulling.hpp"
+
+#include "rendering/rendering.hpp"
+#include "core/settings.hpp"
+#include "util/physicalDeviceHelper.hpp"
+
+#include "ECS/components/camera.hpp"
+#include "ECS/components/spatial.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+    // Meshes with fewer meshlets are drawn whole, the dispatch would cost more than it saves
+    const size_t kMinCulledMeshlets = 4;
+
+    // maxComputeWorkGroupCount is at least 65535, larger meshes take several dispatches
+    const uint32_t kMaxMeshletsPerDispatch = 65535;
+
+    const VkFormat kDepthPyramidFormat = VK_FORMAT_R32_SFLOAT;
+    const uint32_t kDepthPyramidGroupSize = 8;
+
+    // Mirrors CullingFrame in res/shaders/clusterCull/clusterCull.comp
+    struct cullingFrame
+    {
+        glm::vec4 frustumPlanes[6];
+        glm::vec4 cameraPosition;
+        glm::mat4 pyramidView;
+        glm::vec4 pyramidProjection;
+        glm::vec4 pyramidSize;
+    };
+
+    // Mirrors Params in clusterCull.comp
+    struct cullingPushConstants
+    {
+        glm::mat4 model;
+        float scale;
+        uint32_t firstMeshlet;
+        uint32_t drawIndex;
+        uint32_t shortIndices;
+        uint32_t coneCulling;
+    };
+
+    // Non-uniform scale and shear change the angles between normals, the meshlet cones only hold under rotation and uniform scale
+    bool preservesAngles(const glm::mat4& modelMatrix)
+    {
+        glm::mat3 linear = glm::mat3(modelMatrix);
+        glm::mat3 gram = glm::transpose(linear) * linear;
+
+        float scaleSquared = (gram[0][0] + gram[1][1] + gram[2][2]) / 3.0f;
+        float tolerance = scaleSquared * 1e-3f;
+        for(int column = 0; column < 3; column++)
+        {
+            for(int row = 0; row < 3; row++)
+            {
+                float expected = column == row ? scaleSquared : 0.0f;
+                if(std::abs(gram[column][row] - expected) > tolerance)
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    // Mirrors Params in res/shaders/depthPyramid/depthPyramid.comp
+    struct depthPyramidPushConstants
+    {
+        uint32_t sourceSize[2];
+        uint32_t destinationSize[2];
+    };
+
+    uint32_t nextPowerOfTwo(uint32_t value)
+    {
+        uint32_t result = 1;
+        while(result < value)
+        {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    bool hasStencil(VkFormat format)
+    {
+        return format == VK_FORMAT_D32_SFLOAT_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT;
+    }
+
+    // Gribb and Hartmann, for a [0, 1] depth range, normalised so the distances are in world units
+    void extractFrustumPlanes(const glm::mat4& viewProjection, glm::vec4 planes[6])
+    {
+        glm::vec4 rows[4];
+        for(int i = 0; i < 4; i++)
+        {
+            rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+        }
+
+        planes[0] = rows[3] + rows[0];
+        planes[1] = rows[3] - rows[0];
+        planes[2] = rows[3] + rows[1];
+        planes[3] = rows[3] - rows[1];
+        planes[4] = rows[2];
+        planes[5] = rows[3] - rows[2];
+
+        for(int i = 0; i < 6; i++)
+        {
+            planes[i] /= glm::length(glm::vec3(planes[i]));
+        }
+    }
+}
+
+cluster_culling_system::cluster_culling_system(rendering_system* core) :
+    _core(core)
+{
+    ;
+}
+
+void cluster_culling_system::init()
+{
+    _occlusionSupported = canSampleDepthFormat(_core->getPhysicalDevice());
+
+    _core->getPipelineSystem().createComputePipeline("clusterCull");
+    if(_occlusionSupported)
+    {
+        _core->getPipelineSystem().createComputePipeline("depthPyramid");
+    }
+
+    // The index stream and the draws grow with the scene, the uniforms are written every frame
+    unsigned int framesInFlight = getSettingsData(_core->getRegistry()).framesInFlight;
+    _frames.resize(framesInFlight);
+
+    for(frameResources& resources : _frames)
+    {
+        resources.uniforms = _core->getMemorySystem().createBuffer(sizeof(cullingFrame), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        resources.uniforms.descriptorInfo = {resources.uniforms.buffer, 0, sizeof(cullingFrame)};
+        vkMapMemory(_core->getLogicalDevice(), resources.uniforms.memory, 0, sizeof(cullingFrame), 0, &resources.uniforms.mappedTo);
+    }
+
+    // Nothing is in flight yet, no frame has to be waited on
+    updateDepthPyramid(0);
+}
+
+void cluster_culling_system::cullModels(VkCommandBuffer commandBuffer, uint32_t frame, std::vector<Model>& models)
+{
+    frameResources& resources = _frames[frame];
+
+    // 1 - The frame's last submission is done, its draw counts are final
+    readBackStats(resources);
+    updateDepthPyramid(frame);
+
+    // 2 - Every mesh drawn at full detail gets a region of the index stream as large as its full level
+    struct culledMesh
+    {
+        const Mesh* mesh;
+        const glm::mat4* modelMatrix;
+        float scale;
+        bool coneCulling;
+    };
+    std::vector<culledMesh> culledMeshes;
+    std::vector<VkDrawIndexedIndirectCommand> draws;
+    uint32_t indexCount = 0;
+
+    resources.stats = clusterCullingStats();
+
+    for(Model& model : models)
+    {
+        model.meshClusterDraws.assign(model.meshes->size(), kNoClusterDraw);
+
+        float scale = std::max({glm::length(glm::vec3(model.modelMatrix[0])), glm::length(glm::vec3(model.modelMatrix[1])), glm::length(glm::vec3(model.modelMatrix[2]))});
+        bool coneCulling = preservesAngles(model.modelMatrix);
+
+        for(size_t i = 0; i < model.meshes->size(); i++)
+        {
+            const Mesh& mesh = (*model.meshes)[i];
+
+            // Meshlets only cover the full level of detail
+            bool fullDetail = i >= model.meshLods.size() || model.meshLods[i] == 0;
+            if(!fullDetail || mesh.meshletCount < kMinCulledMeshlets || mesh.meshletBuffer.buffer == VK_NULL_HANDLE)
+            {
+                continue;
+            }
+
+            uint32_t meshIndexCount = mesh.lods.empty() ? mesh.indexCount : mesh.lods.front().indexCount;
+
+            model.meshClusterDraws[i] = static_cast<uint32_t>(draws.size());
+            draws.push_back({0, 1, indexCount, 0, 0});
+            culledMeshes.push_back({&mesh, &model.modelMatrix, scale, coneCulling});
+            indexCount += meshIndexCount;
+
+            resources.stats.meshlets += mesh.meshletCount;
+            resources.stats.trianglesTested += meshIndexCount / 3;
+        }
+    }
+
+    resources.drawCount = static_cast<uint32_t>(draws.size());
+    if(draws.empty())
+    {
+        return;
+    }
+
+    reserveFrameResources(resources, indexCount, resources.drawCount);
+    std::memcpy(resources.draws.mappedTo, draws.data(), draws.size() * sizeof(VkDrawIndexedIndirectCommand));
+
+    // 3 - Camera of this frame and of the frame the depth pyramid holds
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::vec3 cameraPosition;
+    getCamera(view, projection, cameraPosition);
+
+    cullingFrame uniforms{};
+    extractFrustumPlanes(projection * view, uniforms.frustumPlanes);
+    uniforms.cameraPosition = glm::vec4(cameraPosition, 1.0f);
+    uniforms.pyramidView = _depthPyramidView;
+    uniforms.pyramidProjection = glm::vec4(_depthPyramidProjection[0][0], _depthPyramidProjection[1][1], _depthPyramidProjection[2][2], _depthPyramidProjection[3][2]);
+    uniforms.pyramidSize = glm::vec4(_depthPyramidExtent.width, _depthPyramidExtent.height, _depthPyramid.mipLevels, _depthPyramidValid ? 1.0f : 0.0f);
+    std::memcpy(resources.uniforms.mappedTo, &uniforms, sizeof(uniforms));
+
+    // 4 - One workgroup per meshlet
+    shaderPipeline& pipeline = _core->getPipelineSystem().getPipeline("clusterCull");
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.pipeline);
+
+    VkDescriptorBufferInfo outputInfo = {resources.indices.buffer, 0, VK_WHOLE_SIZE};
+    VkDescriptorBufferInfo drawInfo = {resources.draws.buffer, 0, VK_WHOLE_SIZE};
+
+    VkDescriptorImageInfo pyramidInfo{};
+    pyramidInfo.sampler = _core->getTextureSystem().getTextureSampler();
+    pyramidInfo.imageView = _depthPyramid.imageView;
+    pyramidInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+    for(size_t i = 0; i < culledMeshes.size(); i++)
+    {
+        const Mesh& mesh = *culledMeshes[i].mesh;
+
+        VkDescriptorBufferInfo meshletInfo = {mesh.meshletBuffer.buffer, 0, VK_WHOLE_SIZE};
+        VkDescriptorBufferInfo sourceInfo = {mesh.indexBuffer.buffer, 0, VK_WHOLE_SIZE};
+
+        VkDescriptorSet descriptorSet;
+        _core->getFrameManager().getTransientDescriptorBuilder()
+            .bindBuffer(0, &resources.uniforms.descriptorInfo, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+            .bindBuffer(1, &meshletInfo, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+            .bindBuffer(2, &sourceInfo, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+            .bindBuffer(3, &outputInfo, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+            .bindBuffer(4, &drawInfo, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+            .bindImage(5, &pyramidInfo, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT)
+            .build(descriptorSet);
+
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.layout, 0, 1, &descriptorSet, 0, nullptr);
+
+        cullingPushConstants constants{};
+        constants.model = *culledMeshes[i].modelMatrix;
+        constants.scale = culledMeshes[i].scale;
+        constants.drawIndex = static_cast<uint32_t>(i);
+        constants.shortIndices = mesh.indexType == VK_INDEX_TYPE_UINT16 ? 1 : 0;
+        constants.coneCulling = culledMeshes[i].coneCulling ? 1 : 0;
+
+        uint32_t meshletCount = mesh.meshletCount;
+        for(uint32_t first = 0; first < meshletCount; first += kMaxMeshletsPerDispatch)
+        {
+            constants.firstMeshlet = first;
+            vkCmdPushConstants(commandBuffer, pipeline.layout, VK_SHADER_STAGE_COMPUTE_BIT, PUSH_CONSTANT_COMPUTE_OFFSET, sizeof(constants), &constants);
+            vkCmdDispatch(commandBuffer, std::min(meshletCount - first, kMaxMeshletsPerDispatch), 1, 1);
+        }
+    }
+
+    // 5 - The draws of this frame read the index stream and the counts, the host reads the counts once the fence signals
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_HOST_READ_BIT;
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_HOST_BIT, 0,
+        1, &barrier,
+        0, nullptr,
+        0, nullptr);
+}
+
+void cluster_culling_system::buildDepthPyramid(VkCommandBuffer commandBuffer, uint32_t frame)
+{
+    if(!_occlusionSupported)
+    {
+        return;
+    }
+
+    updateDepthPyramid(frame);
+
+    image& depth = _core->getSwapChainSystem().getSwapChain().depthImage;
+
+    // 1 - The depth buffer becomes readable, the pyramid is done being read by this frame's culling
+    std::array<VkImageMemoryBarrier, 2> barriers{};
+    for(VkImageMemoryBarrier& barrier : barriers)
+    {
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    }
+
+    barriers[0].image = depth.image;
+    barriers[0].subresourceRange = {VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, 0, 1};
+    if(hasStencil(depth.format))
+    {
+        barriers[0].subresourceRange.aspectMask |= VK_IMAGE_ASPECT_STENCIL_BIT;
+    }
+    barriers[0].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    barriers[0].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    barriers[0].oldLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    barriers[0].newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+
+    barriers[1].image = _depthPyramid.image;
+    barriers[1].subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, _depthPyramid.mipLevels, 0, 1};
+    barriers[1].srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    barriers[1].dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barriers[1].oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+    barriers[1].newLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+        0, nullptr,
+        0, nullptr,
+        static_cast<uint32_t>(barriers.size()), barriers.data());
+
+    // 2 - Level by level, each one reduces the one before it
+    shaderPipeline& pipeline = _core->getPipelineSystem().getPipeline("depthPyramid");
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.pipeline);
+
+    uint32_t sourceWidth = _depthPyramidExtent.width;
+    uint32_t sourceHeight = _depthPyramidExtent.height;
+
+    for(uint32_t level = 0; level < _depthPyramid.mipLevels; level++)
+    {
+        VkDescriptorImageInfo sourceInfo{};
+        sourceInfo.sampler = _core->getTextureSystem().getTextureSampler();
+        sourceInfo.imageView = level == 0 ? depth.imageView : _depthPyramidLevels[level - 1];
+        sourceInfo.imageLayout = level == 0 ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_GENERAL;
+
+        VkDescriptorImageInfo destinationInfo{};
+        destinationInfo.imageView = _depthPyramidLevels[level];
+        destinationInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+        VkDescriptorSet descriptorSet;
+        _core->getFrameManager().getTransientDescriptorBuilder()
+            .bindImage(0, &sourceInfo, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT)
+            .bindImage(1, &destinationInfo, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT)
+            .build(descriptorSet);
+
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.layout, 0, 1, &descriptorSet, 0, nullptr);
+
+        depthPyramidPushConstants constants{};
+        constants.sourceSize[0] = sourceWidth;
+        constants.sourceSize[1] = sourceHeight;
+        constants.destinationSize[0] = std::max(_depthPyramid.width >> level, 1u);
+        constants.destinationSize[1] = std::max(_depthPyramid.height >> level, 1u);
+
+        vkCmdPushConstants(commandBuffer, pipeline.layout, VK_SHADER_STAGE_COMPUTE_BIT, PUSH_CONSTANT_COMPUTE_OFFSET, sizeof(constants), &constants);
+        vkCmdDispatch(commandBuffer, (constants.destinationSize[0] + kDepthPyramidGroupSize - 1) / kDepthPyramidGroupSize, (constants.destinationSize[1] + kDepthPyramidGroupSize - 1) / kDepthPyramidGroupSize, 1);
+
+        // The next level reads this one
+        VkImageMemoryBarrier levelBarrier = barriers[1];
+        levelBarrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, level, 1, 0, 1};
+        levelBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        levelBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+            0, nullptr,
+            0, nullptr,
+            1, &levelBarrier);
+
+        sourceWidth = constants.destinationSize[0];
+        sourceHeight = constants.destinationSize[1];
+    }
+
+    // 3 - The depth buffer goes back to being an attachment, the next frame's render pass waits for the reads
+    barriers[0].srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    barriers[0].dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    barriers[0].oldLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+    barriers[0].newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, 0,
+        0, nullptr,
+        0, nullptr,
+        1, &barriers[0]);
+
+    // The next frame tests against this one's camera
+    glm::vec3 cameraPosition;
+    getCamera(_depthPyramidView, _depthPyramidProjection, cameraPosition);
+    _depthPyramidValid = true;
+}
+
+void cluster_culling_system::readBackStats(const frameResources& resources)
+{
+    if(resources.drawCount == 0)
+    {
+        _stats = resources.stats;
+        return;
+    }
+
+    const VkDrawIndexedIndirectCommand* draws = static_cast<const VkDrawIndexedIndirectCommand*>(resources.draws.mappedTo);
+
+    _stats = resources.stats;
+    _stats.trianglesSubmitted = 0;
+    for(uint32_t i = 0; i < resources.drawCount; i++)
+    {
+        _stats.trianglesSubmitted += draws[i].indexCount / 3;
+    }
+}
+
+void cluster_culling_system::reserveFrameResources(frameResources& resources, uint32_t indexCount, uint32_t drawCount)
+{
+    memory_system& memory = _core->getMemorySystem();
+
+    // Half again as much as needed, so a slowly growing scene doesn't reallocate every frame
+    if(indexCount > resources.indexCapacity)
+    {
+        if(resources.indices.buffer != VK_NULL_HANDLE)
+        {
+            memory.freeBuffer(resources.indices);
+        }
+
+        resources.indexCapacity = indexCount + indexCount / 2;
+        resources.indices = memory.createBuffer(static_cast<VkDeviceSize>(resources.indexCapacity) * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    }
+
+    if(drawCount > resources.drawCapacity)
+    {
+        if(resources.draws.buffer != VK_NULL_HANDLE)
+        {
+            memory.freeBuffer(resources.draws);
+        }
+
+        resources.drawCapacity = drawCount + drawCount / 2;
+        VkDeviceSize drawsSize = static_cast<VkDeviceSize>(resources.drawCapacity) * sizeof(VkDrawIndexedIndirectCommand);
+        resources.draws = memory.createBuffer(drawsSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        vkMapMemory(_core->getLogicalDevice(), resources.draws.memory, 0, drawsSize, 0, &resources.draws.mappedTo);
+    }
+}
+
+void cluster_culling_system::updateDepthPyramid(uint32_t frame)
+{
+    VkExtent2D extent = _core->getSwapChainSystem().getSwapChain().Extent;
+    if(_depthPyramid.image != VK_NULL_HANDLE && extent.width == _depthPyramidExtent.width && extent.height == _depthPyramidExtent.height)
+    {
+        return;
+    }
+
+    // The swap chain was resized, the other frames in flight may still test against the old pyramid
+    // This frame's fence was waited on when its image was acquired
+    if(_depthPyramid.image != VK_NULL_HANDLE)
+    {
+        std::vector<VkFence> fences;
+        for(uint32_t i = 0; i < _frames.size(); i++)
+        {
+            if(i != frame)
+            {
+                fences.push_back(_core->getSwapChainSystem().getInFlightFence(i));
+            }
+        }
+        if(!fences.empty())
+        {
+            vkWaitForFences(_core->getLogicalDevice(), static_cast<uint32_t>(fences.size()), fences.data(), VK_TRUE, std::numeric_limits<uint64_t>::max());
+        }
+        destroyDepthPyramid();
+    }
+
+    // 1 - Power of two levels, every texel of level L covers exactly 2^(L+1) depth buffer pixels per axis
+    texture_system& textures = _core->getTextureSystem();
+
+    uint32_t width = nextPowerOfTwo((extent.width + 1) / 2);
+    uint32_t height = nextPowerOfTwo((extent.height + 1) / 2);
+    uint32_t levels = 1;
+    while((std::max(width, height) >> levels) > 0)
+    {
+        levels++;
+    }
+
+    _depthPyramid = textures.createImage(width, height, levels, kDepthPyramidFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    _depthPyramid.imageView = textures.createImageView(_depthPyramid.image, kDepthPyramidFormat, VK_IMAGE_ASPECT_COLOR_BIT, 0, levels, VK_IMAGE_VIEW_TYPE_2D);
+
+    for(uint32_t level = 0; level < levels; level++)
+    {
+        _depthPyramidLevels.push_back(textures.createImageView(_depthPyramid.image, kDepthPyramidFormat, VK_IMAGE_ASPECT_COLOR_BIT, level, 1, VK_IMAGE_VIEW_TYPE_2D));
+    }
+
+    // 2 - Written as a storage image and sampled by the culling pass, it stays in the general layout
+    VkCommandBuffer commandBuffer = _core->getCommandBufferSystem().beginSingleTimeCommands();
+
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = _depthPyramid.image;
+    barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, levels, 0, 1};
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+        0, nullptr,
+        0, nullptr,
+        1, &barrier);
+
+    _core->getCommandBufferSystem().endSingleTimeCommands(commandBuffer);
+
+    _depthPyramid.layout = VK_IMAGE_LAYOUT_GENERAL;
+    _depthPyramidExtent = extent;
+    _depthPyramidValid = false;
+}
+
+void cluster_culling_system::destroyDepthPyramid()
+{
+    for(VkImageView view : _depthPyramidLevels)
+    {
+        vkDestroyImageView(_core->getLogicalDevice(), view, nullptr);
+    }
+    _depthPyramidLevels.clear();
+
+    _core->getTextureSystem().cleanupImage(_depthPyramid);
+    _depthPyramid = image{};
+}
+
+void cluster_culling_system::getCamera(glm::mat4& view, glm::mat4& projection, glm::vec3& position) const
+{
+    entt::registry& registry = _core->getRegistry();
+    entt::entity camera = _core->getScene()->getActiveCamera();
+
+    const MVPMatrix& mvp = registry.get<MVPMatrix>(camera);
+    view = mvp.view;
+    projection = mvp.projection;
+    projection[1][1] *= -1;
+
+    position = registry.get<::position>(camera).value;
+}
+
+void cluster_culling_system::cleanup()
+{
+    memory_system& memory = _core->getMemorySystem();
+
+    for(frameResources& resources : _frames)
+    {
+        memory.freeBuffer(resources.uniforms);
+        if(resources.indices.buffer != VK_NULL_HANDLE)
+        {
+            memory.freeBuffer(resources.indices);
+        }
+        if(resources.draws.buffer != VK_NULL_HANDLE)
+        {
+            memory.freeBuffer(resources.draws);
+        }
+    }
+    _frames.clear();
+
+    if(_depthPyramid.image != VK_NULL_HANDLE)
+    {
+        destroyDepthPyramid();
+    }
+}
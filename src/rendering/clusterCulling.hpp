@@ -0,0 +1,89 @@
+#pragma once
+
+// GLFW
+#include "wrapper/glfw.hpp"
+#include "wrapper/glm.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "rendering/resources/texture.hpp"
+#include "rendering/resources/memory.hpp"
+
+class rendering_system;
+struct Model;
+
+// Meshes that went through the culling pass, as read back from the last frame whose fence signaled
+struct clusterCullingStats
+{
+    size_t meshlets = 0;
+    size_t trianglesTested = 0;
+    size_t trianglesSubmitted = 0;
+};
+
+// GPU culling of meshlets, see meshOptimizer::buildMeshlets
+// Before the render pass a compute pass drops the meshlets outside the frustum, facing away from the camera or behind the previous frame's depth,
+// and appends the triangles of the others to an index stream per frame in flight, drawn with vkCmdDrawIndexedIndirect
+// After the render pass the depth buffer is reduced into the depth pyramid the next frame tests against
+class cluster_culling_system
+{
+public:
+    cluster_culling_system(rendering_system* core);
+
+    void init();
+
+    // Outside of a render pass, after the frame's fence: records the culling of every mesh drawn at full detail and fills in meshClusterDraws
+    void cullModels(VkCommandBuffer commandBuffer, uint32_t frame, std::vector<Model>& models);
+
+    // Index stream and indirect commands the frame's culled meshes are drawn from
+    VkBuffer getIndexBuffer(uint32_t frame) const { return _frames[frame].indices.buffer; }
+    VkBuffer getDrawBuffer(uint32_t frame) const { return _frames[frame].draws.buffer; }
+
+    // Outside of a render pass, once the frame's depth buffer is final
+    void buildDepthPyramid(VkCommandBuffer commandBuffer, uint32_t frame);
+
+    const clusterCullingStats& getStats() const { return _stats; }
+
+    void cleanup();
+
+private:
+    // Buffers of one frame in flight, only touched once the frame's fence has signaled
+    struct frameResources
+    {
+        memoryBuffer uniforms{};
+        memoryBuffer indices{};             // device local index stream
+        memoryBuffer draws{};               // host visible, the draw counts are read back
+        uint32_t indexCapacity = 0;
+        uint32_t drawCapacity = 0;
+
+        // What the frame's last submission culled
+        uint32_t drawCount = 0;
+        clusterCullingStats stats;
+    };
+
+    void readBackStats(const frameResources& resources);
+    void reserveFrameResources(frameResources& resources, uint32_t indexCount, uint32_t drawCount);
+
+    // The pyramid follows the swap chain extent, level 0 is half the depth buffer rounded up to a power of two
+    // A resize waits for the frames in flight other than frame, the one being recorded
+    void updateDepthPyramid(uint32_t frame);
+    void destroyDepthPyramid();
+
+    // Active camera, with the projection flipped like the uniform buffers
+    void getCamera(glm::mat4& view, glm::mat4& projection, glm::vec3& position) const;
+
+    rendering_system* _core;
+
+    std::vector<frameResources> _frames;
+
+    image _depthPyramid{};
+    std::vector<VkImageView> _depthPyramidLevels;
+    VkExtent2D _depthPyramidExtent = {0, 0};        // depth buffer the pyramid was made for
+    bool _depthPyramidValid = false;                // holds the depth of a rendered frame
+    glm::mat4 _depthPyramidView = glm::mat4(1.0f);  // camera of that frame
+    glm::mat4 _depthPyramidProjection = glm::mat4(1.0f);
+    bool _occlusionSupported = false;               // the depth buffer can be sampled
+
+    clusterCullingStats _stats;
+};
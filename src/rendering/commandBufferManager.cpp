@@ -4,10 +4,13 @@
 #include "util/physicalDeviceHelper.hpp"
 #include "util/VertexShapes.hpp"
 
-command_buffer_system::command_buffer_system(rendering_system* core, VkQueue& graphicsQueue, VkQueue& presentationQueue) :
+#include <algorithm>
+
+command_buffer_system::command_buffer_system(rendering_system* core, VkQueue& graphicsQueue, VkQueue& presentationQueue, VkQueue& transferQueue) :
     _core(core),
     _graphicsQueue(graphicsQueue), 
     _presentationQueue(presentationQueue),
+    _transferQueue(transferQueue),
     _framesInFlight(getSettingsData(core->getRegistry()).framesInFlight)
 {
     // Set the default clear values
@@ -103,6 +106,62 @@ void command_buffer_system::endSingleTimeCommands(VkCommandBuffer commandBuffer)
     vkFreeCommandBuffers(_core->getLogicalDevice(), _commandPool, 1, &commandBuffer);
 }
 
+VkCommandBuffer command_buffer_system::beginTransferCommands()
+{
+    VkCommandBufferAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandPool = _transferCommandPool;
+    allocInfo.commandBufferCount = 1;
+
+    VkCommandBuffer commandBuffer;
+    if(vkAllocateCommandBuffers(_core->getLogicalDevice(), &allocInfo, &commandBuffer) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to allocate transfer command buffer!");
+    }
+
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    vkBeginCommandBuffer(commandBuffer, &beginInfo);
+
+    return commandBuffer;
+}
+
+VkFence command_buffer_system::submitTransferCommands(VkCommandBuffer commandBuffer)
+{
+    vkEndCommandBuffer(commandBuffer);
+
+    VkFenceCreateInfo fenceInfo = {};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+    VkFence fence;
+    if(vkCreateFence(_core->getLogicalDevice(), &fenceInfo, nullptr, &fence) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create transfer fence!");
+    }
+
+    VkSubmitInfo submitInfo = {};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &commandBuffer;
+
+    if(vkQueueSubmit(_transferQueue, 1, &submitInfo, fence) != VK_SUCCESS)
+    {
+        vkDestroyFence(_core->getLogicalDevice(), fence, nullptr);
+        throw std::runtime_error("failed to submit transfer command buffer!");
+    }
+
+    return fence;
+}
+
+void command_buffer_system::freeTransferCommands(VkCommandBuffer commandBuffer, VkFence fence)
+{
+    vkDestroyFence(_core->getLogicalDevice(), fence, nullptr);
+    vkFreeCommandBuffers(_core->getLogicalDevice(), _transferCommandPool, 1, &commandBuffer);
+}
+
 VkCommandBuffer command_buffer_system::generateCommandBuffer()
 {
     VkCommandBufferAllocateInfo allocInfo{};
@@ -122,6 +181,22 @@ VkCommandBuffer command_buffer_system::generateCommandBuffer()
 }
 
 VkResult command_buffer_system::beginRecordingCommandBuffer(VkCommandBuffer& commandBuffer, E_RenderPassType renderPassType, VkFramebuffer framebuffer, VkExtent2D extent)
+{
+    VkResult result = beginCommandBuffer(commandBuffer);
+
+    beginRenderPass(commandBuffer, renderPassType, framebuffer, extent);
+
+    return result;
+}
+
+VkResult command_buffer_system::endRecordingCommandBuffer(VkCommandBuffer& commandBuffer)
+{
+    endRenderPass(commandBuffer);
+
+    return endCommandBuffer(commandBuffer);
+}
+
+VkResult command_buffer_system::beginCommandBuffer(VkCommandBuffer& commandBuffer)
 {
     // Begin command buffer
     VkCommandBufferBeginInfo beginInfo{};
@@ -131,6 +206,19 @@ VkResult command_buffer_system::beginRecordingCommandBuffer(VkCommandBuffer& com
 
     VkResult result = vkBeginCommandBuffer(commandBuffer, &beginInfo);
 
+    // Nothing is bound to a freshly started command buffer
+    _boundDescriptors[commandBuffer] = boundDescriptorState{};
+
+    return result;
+}
+
+VkResult command_buffer_system::endCommandBuffer(VkCommandBuffer& commandBuffer)
+{
+    return vkEndCommandBuffer(commandBuffer);
+}
+
+void command_buffer_system::beginRenderPass(VkCommandBuffer& commandBuffer, E_RenderPassType renderPassType, VkFramebuffer framebuffer, VkExtent2D extent)
+{
     // Begin Render Pass
     VkRenderPassBeginInfo renderPassInfo{};
     renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
@@ -144,16 +232,12 @@ VkResult command_buffer_system::beginRecordingCommandBuffer(VkCommandBuffer& com
     renderPassInfo.pClearValues = _clearValues.data();
 
     vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-
-    return result;
 }
 
-VkResult command_buffer_system::endRecordingCommandBuffer(VkCommandBuffer& commandBuffer)
+void command_buffer_system::endRenderPass(VkCommandBuffer& commandBuffer)
 {
     // End Render Pass
     vkCmdEndRenderPass(commandBuffer);
-
-    return vkEndCommandBuffer(commandBuffer);
 }
 
 void command_buffer_system::recordCommandBuffer(const renderRequest& request)
@@ -179,8 +263,9 @@ void command_buffer_system::recordCommandBuffer(const renderRequest& request)
     vkCmdSetViewport(request.commandBuffer, 0, 1, &viewport);
     vkCmdSetScissor(request.commandBuffer, 0, 1, &scissor);
 
-    // Descriptor set
-    if (request.descriptorSets.size() != 0)
+    // Descriptor set, skipped when the same sets are already bound through the same (shared) pipeline layout
+    boundDescriptorState& bound = _boundDescriptors[request.commandBuffer];
+    if (request.descriptorSets.size() != 0 && (bound.layout != request.pipeline.layout || bound.descriptorSets != request.descriptorSets))
     {
         vkCmdBindDescriptorSets(request.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, request.pipeline.layout, 
             0, 
@@ -188,6 +273,9 @@ void command_buffer_system::recordCommandBuffer(const renderRequest& request)
             &request.descriptorSets[0], 
             0, 
             nullptr);
+
+        bound.layout = request.pipeline.layout;
+        bound.descriptorSets = request.descriptorSets;
     }
     
     // General push constant
@@ -205,12 +293,41 @@ void command_buffer_system::recordCommandBuffer(const renderRequest& request)
             vkCmdPushConstants(request.commandBuffer, request.pipeline.layout, request.perModelPC[i].stageFlags , request.perModelPC[i].offset, request.perModelPC[i].size, request.perModelPC[i].data);
         }
 
-        for(auto& mesh : *request.models[i].meshes)
+        const Model& model = request.models[i];
+
+        for(size_t m{0}; m < model.meshes->size(); ++m)
         {
+            const Mesh& mesh = (*model.meshes)[m];
+
+            if(mesh.vertexLayout != request.vertexLayout)
+            {
+                continue;
+            }
+
+            // Meshes that went through cluster culling draw the triangles that survived it
+            uint32_t clusterDraw = m < model.meshClusterDraws.size() ? model.meshClusterDraws[m] : kNoClusterDraw;
+            if(request.clusterDrawBuffer == VK_NULL_HANDLE)
+            {
+                clusterDraw = kNoClusterDraw;
+            }
+
             // Attribute data
             VkDeviceSize offsets[] = {0};
             vkCmdBindVertexBuffers(request.commandBuffer, 0, 1, &mesh.vertexBuffer.buffer, offsets);
-            vkCmdBindIndexBuffer(request.commandBuffer, mesh.indexBuffer.buffer, 0, VK_INDEX_TYPE_UINT32);
+            if(clusterDraw != kNoClusterDraw)
+            {
+                vkCmdBindIndexBuffer(request.commandBuffer, request.clusterIndexBuffer, 0, VK_INDEX_TYPE_UINT32);
+            }
+            else
+            {
+                vkCmdBindIndexBuffer(request.commandBuffer, mesh.indexBuffer.buffer, 0, mesh.indexType);
+            }
+
+            // Quantised positions are mapped back to model space in the vertex shader
+            if(mesh.vertexLayout == E_VertexLayout::COMPACT)
+            {
+                vkCmdPushConstants(request.commandBuffer, request.pipeline.layout, VK_SHADER_STAGE_VERTEX_BIT, PUSH_CONSTANT_VERTEX_DEQUANTIZATION_OFFSET, sizeof(vertexQuantization), &mesh.quantization);
+            }
 
             // Texture Index push constants
             if(request.useTextureLibraryBinds)
@@ -218,8 +335,19 @@ void command_buffer_system::recordCommandBuffer(const renderRequest& request)
                 vkCmdPushConstants(request.commandBuffer, request.pipeline.layout, VK_SHADER_STAGE_FRAGMENT_BIT, 128, sizeof(unsigned int), &mesh.textureIndices[static_cast<unsigned int>(E_TextureType::DIFFUSE)]);
             }
             
-            // Draw call
-            vkCmdDrawIndexed(request.commandBuffer, static_cast<uint32_t>(mesh.indexData.size()), 1, 0, 0, 0);
+            if(clusterDraw != kNoClusterDraw)
+            {
+                vkCmdDrawIndexedIndirect(request.commandBuffer, request.clusterDrawBuffer, clusterDraw * sizeof(VkDrawIndexedIndirectCommand), 1, sizeof(VkDrawIndexedIndirectCommand));
+                continue;
+            }
+
+            // Draw call, the level of detail picked for this model or the full mesh
+            meshLod lod = {0, mesh.indexCount, 0.0f};
+            if(!mesh.lods.empty())
+            {
+                lod = mesh.lods[m < model.meshLods.size() ? std::min<size_t>(model.meshLods[m], mesh.lods.size() - 1) : 0];
+            }
+            vkCmdDrawIndexed(request.commandBuffer, lod.indexCount, 1, lod.firstIndex, 0, 0);
         }
     }
 
@@ -270,11 +398,16 @@ void command_buffer_system::submitCommandBuffer(VkCommandBuffer& cmdBuffer,  std
 
 void command_buffer_system::freeCommandBuffers(VkCommandBuffer& commandBuffer)
 {
+    _boundDescriptors.erase(commandBuffer);
     vkFreeCommandBuffers(_core->getLogicalDevice(), _commandPool, 1, &commandBuffer);
 }
 
 void command_buffer_system::freeCommandBuffers(std::vector<VkCommandBuffer>& commandBuffers)
 {
+    for(auto& commandBuffer : commandBuffers)
+    {
+        _boundDescriptors.erase(commandBuffer);
+    }
     vkFreeCommandBuffers(_core->getLogicalDevice(), _commandPool, static_cast<uint32_t>(commandBuffers.size()), commandBuffers.data());
 }
 
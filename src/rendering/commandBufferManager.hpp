@@ -2,6 +2,7 @@
 
 // STD includes
 #include <vector>
+#include <unordered_map>
 
 // Third party includes
 #include <entt/entt.hpp>
@@ -39,8 +40,13 @@ struct renderRequest
 
     VkFence fence;
 
-    // Models
+    // Models, meshes in a different vertex layout than the pipeline's are skipped
     std::vector<Model> models;
+    E_VertexLayout vertexLayout = E_VertexLayout::STANDARD;
+
+    // Index stream and indirect commands of the meshes in Model::meshClusterDraws, see cluster_culling_system
+    VkBuffer clusterIndexBuffer = VK_NULL_HANDLE;
+    VkBuffer clusterDrawBuffer = VK_NULL_HANDLE;
 
     // Descriptor sets
     std::vector<VkDescriptorSet> descriptorSets;
@@ -51,6 +57,14 @@ struct renderRequest
     bool useTextureLibraryBinds = false;
 };
 
+// Descriptor sets currently bound to a command buffer
+// Sets bound through one pipeline layout remain valid for any pipeline sharing that layout
+struct boundDescriptorState
+{
+    VkPipelineLayout layout = VK_NULL_HANDLE;
+    std::vector<VkDescriptorSet> descriptorSets;
+};
+
 struct FrameData
 {
     VkCommandBuffer commandBuffer;
@@ -61,7 +75,7 @@ struct FrameData
 class command_buffer_system
 {
 public:
-    command_buffer_system(rendering_system* core, VkQueue& graphicsQueue, VkQueue& presentationQueue);
+    command_buffer_system(rendering_system* core, VkQueue& graphicsQueue, VkQueue& presentationQueue, VkQueue& transferQueue);
 
     void createCommandPools();
     std::vector<VkCommandBuffer> createCommandBuffers(short unsigned int count);
@@ -69,10 +83,21 @@ public:
     VkCommandBuffer beginSingleTimeCommands();
     void endSingleTimeCommands(VkCommandBuffer commandBuffer);
 
+    // Same on the transfer queue, the caller polls the returned fence instead of waiting for the queue
+    VkCommandBuffer beginTransferCommands();
+    VkFence submitTransferCommands(VkCommandBuffer commandBuffer);
+    void freeTransferCommands(VkCommandBuffer commandBuffer, VkFence fence);
+
     VkCommandBuffer generateCommandBuffer();
     VkResult beginRecordingCommandBuffer(VkCommandBuffer& commandBuffer, E_RenderPassType renderPassType, VkFramebuffer framebuffer, VkExtent2D extent);
     VkResult endRecordingCommandBuffer(VkCommandBuffer& commandBuffer);
 
+    // Separate halves of the above, for command buffers that hold several render passes
+    VkResult beginCommandBuffer(VkCommandBuffer& commandBuffer);
+    VkResult endCommandBuffer(VkCommandBuffer& commandBuffer);
+    void beginRenderPass(VkCommandBuffer& commandBuffer, E_RenderPassType renderPassType, VkFramebuffer framebuffer, VkExtent2D extent);
+    void endRenderPass(VkCommandBuffer& commandBuffer);
+
     void recordCommandBuffer(const renderRequest& request);
     
     void resetCommandBuffer(VkCommandBuffer& commandBuffer);
@@ -100,9 +125,12 @@ private:
 
     VkQueue& _graphicsQueue;                                // graphics queue
     VkQueue& _presentationQueue;                            // presentation queue
+    VkQueue& _transferQueue;                                // transfer queue
 
     std::array<VkClearValue, 2> _clearValues;               // clear values for the render pass
     VkViewport _viewport;                                   // viewport
     VkRect2D _scissor;                                      // scissor
 
+    std::unordered_map<VkCommandBuffer, boundDescriptorState> _boundDescriptors;    // descriptor sets bound per command buffer being recorded
+
 };
\ No newline at end of file
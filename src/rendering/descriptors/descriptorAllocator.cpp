@@ -10,6 +10,7 @@ DescriptorAllocator::DescriptorAllocator(VkDevice device)  :
 
     _descriptorSizes[poolType::POOL_TYPE_BASIC] = PoolSizes().basicSizes;
     _descriptorSizes[poolType::POOL_TYPE_BINDLESS] = PoolSizes().bindLessSizes;
+    _descriptorSizes[poolType::POOL_TYPE_TRANSIENT] = PoolSizes().basicSizes;
 }
 
 void DescriptorAllocator::cleanup()
@@ -34,8 +35,8 @@ void DescriptorAllocator::cleanup()
 
 VkDescriptorPool DescriptorAllocator::grabPool(poolType type)
 {
-    // Check if reusable pools are available
-    if (_freePools.size() > 0)
+    // Check if reusable pools of this type are available
+    if (!_freePools[type].empty())
     {
         VkDescriptorPool pool = _freePools[type].back();
         _freePools[type].pop_back();
@@ -44,11 +45,17 @@ VkDescriptorPool DescriptorAllocator::grabPool(poolType type)
     else
     {
         // Create a new pool
+        if (type == poolType::POOL_TYPE_TRANSIENT)
+        {
+            return createPool(type, _device, kMaxTransientDescriptorSets, 0);
+        }
+
         VkDescriptorPoolCreateFlags flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
 
         if (type == poolType::POOL_TYPE_BINDLESS)
         {
-            flags |= VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT;
+            flags |= VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+            return createPool(type, _device, kMaxBindlessDescriptorSets, flags);
         }
 
         return createPool(type, _device, kMaxDescriptorSets, flags);
@@ -57,7 +64,7 @@ VkDescriptorPool DescriptorAllocator::grabPool(poolType type)
 
 VkDescriptorPool DescriptorAllocator::createPool(poolType type, VkDevice device, int count, VkDescriptorPoolCreateFlags flags)
 {
-    std::vector<VkDescriptorPoolSize> sizes = getPoolSizes(type);
+    std::vector<VkDescriptorPoolSize> sizes = getPoolSizes(type, count);
 
     VkDescriptorPoolCreateInfo poolInfo{};
     poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
@@ -71,18 +78,19 @@ VkDescriptorPool DescriptorAllocator::createPool(poolType type, VkDevice device,
     {
         throw std::runtime_error("Failed to create descriptor pool");
     }
+    _stats.pools++;
 
     return descriptorPool;
 }
 
-std::vector<VkDescriptorPoolSize> DescriptorAllocator::getPoolSizes(poolType type)
+std::vector<VkDescriptorPoolSize> DescriptorAllocator::getPoolSizes(poolType type, uint32_t setCount)
 {
     std::vector<VkDescriptorPoolSize> sizes;
     sizes.reserve(_descriptorSizes[type].size());
 
     for (auto& size : _descriptorSizes[type])
     {
-        sizes.push_back({size.first, static_cast<uint32_t>(size.second * kMaxDescriptorSets)});
+        sizes.push_back({size.first, static_cast<uint32_t>(size.second * setCount)});
     }
 
     return sizes;
@@ -112,6 +120,12 @@ bool DescriptorAllocator::allocate(VkDescriptorSet* set, VkDescriptorSetLayout l
     switch (allocResult)
     {
         case VK_SUCCESS:
+            _stats.allocations++;
+            _stats.totalAllocations++;
+            if (type == poolType::POOL_TYPE_BASIC)
+            {
+                _setPools[*set] = allocInfo.descriptorPool;
+            }
             return true;
         case VK_ERROR_FRAGMENTED_POOL:
         case VK_ERROR_OUT_OF_POOL_MEMORY:
@@ -124,7 +138,7 @@ bool DescriptorAllocator::allocate(VkDescriptorSet* set, VkDescriptorSetLayout l
     if(needReallocate)
     {
         // allocate a new pool and try again'
-        _currentPool[type] = grabPool();
+        _currentPool[type] = grabPool(type);
         _usedPools[type].push_back(_currentPool[type]);
 
         allocInfo.descriptorPool = _currentPool[type];
@@ -132,6 +146,12 @@ bool DescriptorAllocator::allocate(VkDescriptorSet* set, VkDescriptorSetLayout l
 
         if (allocResult == VK_SUCCESS)
         {
+            _stats.allocations++;
+            _stats.totalAllocations++;
+            if (type == poolType::POOL_TYPE_BASIC)
+            {
+                _setPools[*set] = allocInfo.descriptorPool;
+            }
             return true;
         }
 
@@ -140,23 +160,41 @@ bool DescriptorAllocator::allocate(VkDescriptorSet* set, VkDescriptorSetLayout l
     return false;
 }
 
+void DescriptorAllocator::free(VkDescriptorSet set)
+{
+    auto it = _setPools.find(set);
+    if (it == _setPools.end())
+    {
+        throw std::runtime_error("Descriptor set was not allocated from a basic pool of this allocator");
+    }
+
+    vkFreeDescriptorSets(_device, it->second, 1, &set);
+    _setPools.erase(it);
+}
+
 void DescriptorAllocator::resetPools()
 {
-    // Move all used pools to free pools
-    for (auto pools : _usedPools)
+    // Move all used pools to free pools, bindless sets persist for the lifetime of the device
+    for (auto& pools : _usedPools)
     {
+        if (pools.first == poolType::POOL_TYPE_BINDLESS)
+        {
+            continue;
+        }
+
         for(auto pool : pools.second)
         {
             vkResetDescriptorPool(_device, pool, 0);
             _freePools[pools.first].push_back(pool);
         }
-    }
+        pools.second.clear();
 
-    // Clear used pools
-    _usedPools.clear();
+        _currentPool[pools.first] = VK_NULL_HANDLE;
+    }
 
-    // Reset current pool
-    resetCurrentPools();
+    _setPools.clear();
+    _stats.allocations = 0;
+    _stats.resets++;
 }
 
 void DescriptorAllocator::resetCurrentPools()
@@ -11,7 +11,8 @@
 enum class poolType : uint8_t
 {
     POOL_TYPE_BASIC,
-    POOL_TYPE_BINDLESS,     // Currently unused
+    POOL_TYPE_BINDLESS,     // Update-after-bind pools for the global texture heap
+    POOL_TYPE_TRANSIENT,    // Linear pools, sets are never freed individually, only reset in bulk
     POOL_TYPE_UNUSED        // This one must always be the last entry, see DescriptorAllocator::resetCurrentPools()
 };
 
@@ -40,13 +41,26 @@ public:
 
         const std::vector<std::pair<VkDescriptorType, float>> bindLessSizes = 
         {
-            { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 10.0f},
+            { VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, static_cast<float>(kTextureArraySize + kCubemapArraySize) },
         };
 
     };
 
+    // Allocation counters, for spotting descriptor churn
+    struct Stats
+    {
+        uint32_t allocations = 0;           // sets allocated since the last reset
+        uint64_t totalAllocations = 0;      // sets allocated over the allocator lifetime
+        uint32_t pools = 0;                 // pools created, reused pools are not counted again
+        uint32_t resets = 0;
+    };
+
     void resetPools();
     bool allocate (VkDescriptorSet* set, VkDescriptorSetLayout layout, poolType type = poolType::POOL_TYPE_BASIC);
+    // Returns a basic set to the pool it came from
+    void free(VkDescriptorSet set);
+
+    const Stats& getStats() const { return _stats; }
 
     VkDescriptorPool grabPool(poolType type = poolType::POOL_TYPE_BASIC);
 
@@ -58,7 +72,7 @@ private:
 
 
     VkDescriptorPool createPool(poolType type, VkDevice device, int count, VkDescriptorPoolCreateFlags flags);
-    std::vector<VkDescriptorPoolSize> getPoolSizes(poolType type);
+    std::vector<VkDescriptorPoolSize> getPoolSizes(poolType type, uint32_t setCount);
 
 
     std::unordered_map<poolType , VkDescriptorPool> _currentPool;
@@ -71,4 +85,9 @@ private:
     std::unordered_map<poolType, std::vector<VkDescriptorPool>> _usedPools;
     std::unordered_map<poolType, std::vector<VkDescriptorPool>> _freePools;
 
+    Stats _stats;
+
+    // Owning pool of every live basic set, needed to free them individually
+    std::unordered_map<VkDescriptorSet, VkDescriptorPool> _setPools;
+
 };
\ No newline at end of file
@@ -1,12 +1,13 @@
 #include "rendering/descriptors/descriptorBuilder.hpp"
 
 
-DescriptorBuilder DescriptorBuilder::begin(DescriptorLayoutCache* layoutCache, DescriptorAllocator* allocator)
+DescriptorBuilder DescriptorBuilder::begin(DescriptorLayoutCache* layoutCache, DescriptorAllocator* allocator, poolType pool)
 {
     DescriptorBuilder builder;
     
     builder.cache = layoutCache;
     builder.alloc = allocator;
+    builder.pool = pool;
     return builder;
 }
 
@@ -100,6 +101,22 @@ DescriptorBuilder& DescriptorBuilder::bindImageArray(uint32_t binding, std::vect
     return *this;
 }
 
+DescriptorBuilder& DescriptorBuilder::reserveImageArray(uint32_t binding, uint32_t count, VkDescriptorType type, VkShaderStageFlags stageFlags)
+{
+    // Create a descriptor set layout binding, no write is recorded
+    VkDescriptorSetLayoutBinding bind{};
+
+    bind.descriptorCount = count;
+    bind.descriptorType = type;
+    bind.pImmutableSamplers = nullptr;
+    bind.stageFlags = stageFlags;
+    bind.binding = binding;
+
+    bindings.push_back(bind);
+
+    return *this;
+}
+
 bool DescriptorBuilder::build(VkDescriptorSet& set, VkDescriptorSetLayout& layout)
 {
     // Create the descriptor set layout
@@ -113,7 +130,7 @@ bool DescriptorBuilder::build(VkDescriptorSet& set, VkDescriptorSetLayout& layou
     layout = cache->createDescriptorLayout(&layoutInfo);
 
     // Allocate the descriptor set
-    bool success = alloc->allocate(&set, layout);
+    bool success = alloc->allocate(&set, layout, pool);
     if(!success)
     {
         return false;
@@ -142,19 +159,20 @@ bool DescriptorBuilder::buildBindless(VkDescriptorSet& set, VkDescriptorSetLayou
     // Create the descriptor set layout
     VkDescriptorSetLayoutCreateInfo layoutInfo = {};
     layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-    layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT;
+    layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
 
     layoutInfo.pBindings = bindings.data();
     layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
 
-    VkDescriptorBindingFlags bindless_flags =   VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT | 
-                                                VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT_EXT |
-                                                VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT;
+    // Every binding can hold unwritten slots and be updated while the set is bound by in-flight frames
+    std::vector<VkDescriptorBindingFlags> bindlessFlags(bindings.size(),    VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | 
+                                                                            VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+                                                                            VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT);
 
-    VkDescriptorSetLayoutBindingFlagsCreateInfoEXT extendedInfo{};
-    extendedInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT;
-    extendedInfo.bindingCount = static_cast<uint32_t>(bindings.size());
-    extendedInfo.pBindingFlags = &bindless_flags;
+    VkDescriptorSetLayoutBindingFlagsCreateInfo extendedInfo{};
+    extendedInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+    extendedInfo.bindingCount = static_cast<uint32_t>(bindlessFlags.size());
+    extendedInfo.pBindingFlags = bindlessFlags.data();
 
     layoutInfo.pNext = &extendedInfo;
 
@@ -173,7 +191,10 @@ bool DescriptorBuilder::buildBindless(VkDescriptorSet& set, VkDescriptorSetLayou
         write.dstSet = set;
     }
 
-    vkUpdateDescriptorSets(alloc->getDevice(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+    if (!writes.empty())
+    {
+        vkUpdateDescriptorSets(alloc->getDevice(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+    }
 
     return true;
 }
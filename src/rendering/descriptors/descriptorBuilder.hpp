@@ -10,12 +10,14 @@
 class DescriptorBuilder
 {
 public:
-    static DescriptorBuilder begin(DescriptorLayoutCache* layoutCache, DescriptorAllocator* allocator );
+    static DescriptorBuilder begin(DescriptorLayoutCache* layoutCache, DescriptorAllocator* allocator, poolType pool = poolType::POOL_TYPE_BASIC);
 
 	DescriptorBuilder& bindBuffer(uint32_t binding, VkDescriptorBufferInfo* bufferInfo, VkDescriptorType type, VkShaderStageFlags stageFlags);
 	DescriptorBuilder& bindImage(uint32_t binding, VkDescriptorImageInfo* imageInfo, VkDescriptorType type, VkShaderStageFlags stageFlags);
 	DescriptorBuilder& bindImageSampler(uint32_t binding, VkDescriptorImageInfo* samplerImageInfo, VkShaderStageFlags stageFlags);
 	DescriptorBuilder& bindImageArray(uint32_t binding, std::vector<VkDescriptorImageInfo>* imageInfo, uint32_t count, VkDescriptorType type, VkShaderStageFlags stageFlags);
+	// Declares an array binding without writing it, bindless sets fill their slots later on
+	DescriptorBuilder& reserveImageArray(uint32_t binding, uint32_t count, VkDescriptorType type, VkShaderStageFlags stageFlags);
 
 	bool build(VkDescriptorSet& set, VkDescriptorSetLayout& layout);
 	bool build(VkDescriptorSet& set);
@@ -29,4 +31,5 @@ private:
 
 	DescriptorLayoutCache* cache;
 	DescriptorAllocator* alloc;
+	poolType pool = poolType::POOL_TYPE_BASIC;
 };
\ No newline at end of file
@@ -1,12 +1,20 @@
 #pragma once
 
 
-// Descriptor pool sizes
-static constexpr unsigned int kMaxBindlessResources = 100;
+// Bindless pool sizes, the global texture heap is the only set living in these pools
+static constexpr unsigned int kMaxBindlessDescriptorSets = 4;
 
 // Descriptor pool sizes
 static constexpr unsigned int kMaxDescriptorSets = 1000;
 
+// Transient pool sizes, per frame in flight arenas are reset in bulk so they stay small
+static constexpr unsigned int kMaxTransientDescriptorSets = 64;
+
 // Texture array default size
 static constexpr unsigned int kTextureArraySize = 4096;
-static constexpr unsigned int kCubemapArraySize = 64;
\ No newline at end of file
+static constexpr unsigned int kCubemapArraySize = 64;
+
+// Global bindless texture heap, shaders index it with the texture ids handed out by the texture system
+static constexpr unsigned int kBindlessTextureSet = 1;
+static constexpr unsigned int kBindlessTexture2DBinding = 0;
+static constexpr unsigned int kBindlessTextureCubeBinding = 1;
@@ -21,16 +21,33 @@ VkDescriptorSetLayout DescriptorLayoutCache::createDescriptorLayout(VkDescriptor
 {
     DescriptorLayoutInfo layoutInfo;
     layoutInfo.bindings.reserve(info->bindingCount);
+    layoutInfo.bindingFlags.resize(info->bindingCount, 0);
+    layoutInfo.flags = info->flags;
     bool isSorted = true;
     int lastBinding = -1;
 
+    // Binding flags are chained through pNext, they are part of the layout identity
+    const VkBaseInStructure* next = static_cast<const VkBaseInStructure*>(info->pNext);
+    while (next != nullptr)
+    {
+        if (next->sType == VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO)
+        {
+            auto flagsInfo = reinterpret_cast<const VkDescriptorSetLayoutBindingFlagsCreateInfo*>(next);
+            for (uint32_t i = 0; i < flagsInfo->bindingCount && i < info->bindingCount; i++)
+            {
+                layoutInfo.bindingFlags[i] = flagsInfo->pBindingFlags[i];
+            }
+        }
+        next = next->pNext;
+    }
+
     // Copy the bindings from the info to the layoutInfo
     for (uint32_t i = 0; i < info->bindingCount; i++)
     {
         layoutInfo.bindings.push_back(info->pBindings[i]);
         
         // Check if the bindings are sorted
-        if(info->pBindings[i].binding > lastBinding)
+        if(static_cast<int>(info->pBindings[i].binding) > lastBinding)
         {
             lastBinding = info->pBindings[i].binding;
         }
@@ -39,10 +56,24 @@ VkDescriptorSetLayout DescriptorLayoutCache::createDescriptorLayout(VkDescriptor
             isSorted = false;
         }
     }
-    // Sort if they arent
+    // Sort if they arent, keeping every binding paired with its flags
     if(!isSorted)
     {
-        std::sort(layoutInfo.bindings.begin(), layoutInfo.bindings.end(), [](const VkDescriptorSetLayoutBinding& a, const VkDescriptorSetLayoutBinding& b) { return a.binding < b.binding; });
+        std::vector<uint32_t> order(layoutInfo.bindings.size());
+        for (uint32_t i = 0; i < order.size(); i++)
+        {
+            order[i] = i;
+        }
+        std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return layoutInfo.bindings[a].binding < layoutInfo.bindings[b].binding; });
+
+        DescriptorLayoutInfo sorted;
+        sorted.flags = layoutInfo.flags;
+        for (uint32_t i : order)
+        {
+            sorted.bindings.push_back(layoutInfo.bindings[i]);
+            sorted.bindingFlags.push_back(layoutInfo.bindingFlags[i]);
+        }
+        layoutInfo = std::move(sorted);
     }
 
     // Try to grab from cache
@@ -68,7 +99,7 @@ VkDescriptorSetLayout DescriptorLayoutCache::createDescriptorLayout(VkDescriptor
 
 bool DescriptorLayoutCache::DescriptorLayoutInfo::operator==(const DescriptorLayoutInfo& other) const
 {
-    if (bindings.size() != other.bindings.size())
+    if (bindings.size() != other.bindings.size() || flags != other.flags || bindingFlags != other.bindingFlags)
     {
         return false;
     }
@@ -94,12 +125,14 @@ size_t DescriptorLayoutCache::DescriptorLayoutInfo::hash() const
 {
     using std::size_t;  
 
-    size_t result = std::hash<size_t>()(bindings.size());
+    size_t result = std::hash<size_t>()(bindings.size()) ^ std::hash<size_t>()(flags) << 1;
 
-    for(const VkDescriptorSetLayoutBinding& b : bindings)
+    for(size_t i = 0; i < bindings.size(); i++)
     {
+        const VkDescriptorSetLayoutBinding& b = bindings[i];
+
         // Pack the binding into a single size_t
-        size_t binding_hash = b.binding | b.descriptorType << 8 | b.descriptorCount << 16 | b.stageFlags << 24;
+        size_t binding_hash = b.binding | b.descriptorType << 8 | b.descriptorCount << 16 | b.stageFlags << 24 | static_cast<size_t>(bindingFlags[i]) << 32;
 
         result ^= std::hash<size_t>()(binding_hash);
     }
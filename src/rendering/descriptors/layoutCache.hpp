@@ -20,6 +20,9 @@ public:
     struct DescriptorLayoutInfo {
         //good idea to turn this into a inlined array
         std::vector<VkDescriptorSetLayoutBinding> bindings;
+        // Per binding flags (partially bound, update after bind...), parallel to bindings
+        std::vector<VkDescriptorBindingFlags> bindingFlags;
+        VkDescriptorSetLayoutCreateFlags flags = 0;
 
         bool operator==(const DescriptorLayoutInfo& other) const;
 
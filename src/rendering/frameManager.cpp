@@ -7,6 +7,8 @@
 #include "core/settings.hpp"
 #include <boost/uuid/uuid_generators.hpp> // UUID's for descriptor sets
 
+#include <algorithm>
+
 
 frame_manager::frame_manager(rendering_system* core) : 
     _core(core)
@@ -19,54 +21,226 @@ void frame_manager::initDescriptorBuilder()
     _descriptorLayoutCache = std::make_unique<DescriptorLayoutCache>(_core->getLogicalDevice());
     _descriptorAllocator = std::make_unique<DescriptorAllocator>(_core->getLogicalDevice());
     _descriptorBuilder = std::make_unique<DescriptorBuilder>();
+
+    uint32_t framesInFlight = getSettingsData(_core->getRegistry()).framesInFlight;
+    for(uint32_t i = 0; i < framesInFlight; i++)
+    {
+        _transientAllocators.push_back(std::make_unique<DescriptorAllocator>(_core->getLogicalDevice()));
+    }
 }
 
 boost::uuids::uuid frame_manager::compileDescriptorSet(std::vector<descriptorSetBindings>& singleFrameBindings)
 {
-    boost::uuids::uuid id = boost::uuids::random_generator()();
-
     descriptorSets dSets;
+    std::vector<uint64_t> requestKey;
 
     for(auto& descriptorSetBindings : singleFrameBindings)
     {
-        DescriptorBuilder builder = DescriptorBuilder::begin(_descriptorLayoutCache.get(), _descriptorAllocator.get());
-        for(auto& binding : descriptorSetBindings)
-        {   
-            switch(binding.descriptorType)
+        VkDescriptorSet descriptorSet = getCachedDescriptorSet(descriptorSetBindings);
+        dSets.push_back(descriptorSet);
+        requestKey.push_back((uint64_t)descriptorSet);
+    }
+
+    // The id is derived from the sets themselves, so identical requests share an entry
+    boost::uuids::name_generator_sha1 generator(boost::uuids::ns::oid());
+    boost::uuids::uuid id = generator(requestKey.data(), requestKey.size() * sizeof(uint64_t));
+
+    _descriptorSets[id] = dSets;
+    _staleDescriptorSets.erase(id);
+
+    return id;
+}
+
+VkDescriptorSet frame_manager::getCachedDescriptorSet(const descriptorSetBindings& descriptorSetBindings)
+{
+    std::vector<uint64_t> resources;
+    descriptorSetKey key = makeDescriptorSetKey(descriptorSetBindings, resources);
+
+    auto it = _descriptorSetCache.find(key);
+    if(it != _descriptorSetCache.end())
+    {
+        return it->second.set;
+    }
+
+    DescriptorBuilder builder = DescriptorBuilder::begin(_descriptorLayoutCache.get(), _descriptorAllocator.get());
+    for(auto& binding : descriptorSetBindings)
+    {   
+        switch(binding.descriptorType)
+        {
+            case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+            case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+                builder.bindBuffer(binding.binding, (VkDescriptorBufferInfo*)binding.data, binding.descriptorType, binding.stageFlags);
+                break;
+            case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+            case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+                if (binding.count == 1)
+                {
+                    builder.bindImage(binding.binding, (VkDescriptorImageInfo*)binding.data, binding.descriptorType, binding.stageFlags);
+                }
+                else
+                {
+                    builder.bindImageArray(binding.binding, (std::vector<VkDescriptorImageInfo>*)binding.data, binding.count, binding.descriptorType, binding.stageFlags);
+                }
+                break;
+            case VK_DESCRIPTOR_TYPE_SAMPLER:
+                builder.bindImageSampler(binding.binding, (VkDescriptorImageInfo*)binding.data, binding.stageFlags);
+                break;
+            default:
+                throw std::runtime_error("Invalid descriptor type");
+        }
+    }
+
+    VkDescriptorSet descriptorSet;
+    if(!builder.build(descriptorSet))
+    {
+        throw std::runtime_error("Failed to build descriptor set");
+    }
+
+    for(uint64_t resource : resources)
+    {
+        _referencedResources[resource]++;
+    }
+    _descriptorSetCache[key] = {descriptorSet, std::move(resources)};
+
+    return descriptorSet;
+}
+
+descriptorSetKey frame_manager::makeDescriptorSetKey(const descriptorSetBindings& bindings, std::vector<uint64_t>& resources) const
+{
+    descriptorSetKey key;
+
+    auto addImageInfo = [&](const VkDescriptorImageInfo& info)
+    {
+        key.words.push_back((uint64_t)info.sampler);
+        key.words.push_back((uint64_t)info.imageView);
+        key.words.push_back(static_cast<uint64_t>(info.imageLayout));
+
+        if(info.sampler != VK_NULL_HANDLE) resources.push_back((uint64_t)info.sampler);
+        if(info.imageView != VK_NULL_HANDLE) resources.push_back((uint64_t)info.imageView);
+    };
+
+    for(const auto& binding : bindings)
+    {
+        // Layout part
+        key.words.push_back(static_cast<uint64_t>(binding.binding) | static_cast<uint64_t>(binding.descriptorType) << 32);
+        key.words.push_back(static_cast<uint64_t>(binding.count) | static_cast<uint64_t>(binding.stageFlags) << 32);
+
+        // Content part
+        switch(binding.descriptorType)
+        {
+            case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+            case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
             {
-                case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
-                    builder.bindBuffer(binding.binding, (VkDescriptorBufferInfo*)binding.data, binding.descriptorType, binding.stageFlags);
-                    break;
-                case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
-                    if (binding.count == 1)
-                    {
-                        builder.bindImage(binding.binding, (VkDescriptorImageInfo*)binding.data, binding.descriptorType, binding.stageFlags);
-                    }
-                    else
+                const VkDescriptorBufferInfo* info = (const VkDescriptorBufferInfo*)binding.data;
+                key.words.push_back((uint64_t)info->buffer);
+                key.words.push_back(info->offset);
+                key.words.push_back(info->range);
+                resources.push_back((uint64_t)info->buffer);
+                break;
+            }
+            case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+            case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+                if(binding.count == 1)
+                {
+                    addImageInfo(*(const VkDescriptorImageInfo*)binding.data);
+                }
+                else
+                {
+                    for(const auto& info : *(const std::vector<VkDescriptorImageInfo>*)binding.data)
                     {
-                        builder.bindImageArray(binding.binding, (std::vector<VkDescriptorImageInfo>*)binding.data, binding.count, binding.descriptorType, binding.stageFlags);
+                        addImageInfo(info);
                     }
-                    break;
-                case VK_DESCRIPTOR_TYPE_SAMPLER:
-                    builder.bindImageSampler(binding.binding, (VkDescriptorImageInfo*)binding.data, binding.stageFlags);
-                    break;
-                default:
-                    throw std::runtime_error("Invalid descriptor type");
-            }
+                }
+                break;
+            case VK_DESCRIPTOR_TYPE_SAMPLER:
+                addImageInfo(*(const VkDescriptorImageInfo*)binding.data);
+                break;
+            default:
+                throw std::runtime_error("Invalid descriptor type");
         }
-        VkDescriptorSet descriptorSet;
-        builder.build(descriptorSet);
-        dSets.push_back(descriptorSet);
     }
 
-    _descriptorSets[id] = dSets;
+    return key;
+}
 
-    return id;
+void frame_manager::invalidateDescriptorSets(uint64_t resource)
+{
+    // Most destroyed resources (staging buffers...) were never bound to a cached set
+    if(_referencedResources.find(resource) == _referencedResources.end())
+    {
+        return;
+    }
+
+    for(auto it = _descriptorSetCache.begin(); it != _descriptorSetCache.end(); )
+    {
+        std::vector<uint64_t>& resources = it->second.resources;
+        if(std::find(resources.begin(), resources.end(), resource) == resources.end())
+        {
+            ++it;
+            continue;
+        }
+
+        VkDescriptorSet staleSet = it->second.set;
+
+        // Release the references held by the stale set
+        for(uint64_t referenced : resources)
+        {
+            if(--_referencedResources[referenced] == 0)
+            {
+                _referencedResources.erase(referenced);
+            }
+        }
+
+        // Compiled requests using the set are stale as well, their ids are remembered so using them fails loudly
+        for(auto request = _descriptorSets.begin(); request != _descriptorSets.end(); )
+        {
+            if(std::find(request->second.begin(), request->second.end(), staleSet) != request->second.end())
+            {
+                _staleDescriptorSets.insert(request->first);
+                request = _descriptorSets.erase(request);
+            }
+            else
+            {
+                ++request;
+            }
+        }
+
+        // Frames still in flight may have the set bound
+        _retiredDescriptorSets.push_back({staleSet, getSettingsData(_core->getRegistry()).framesInFlight});
+        it = _descriptorSetCache.erase(it);
+    }
 }
 
 descriptorSets& frame_manager::getDescriptorSet(boost::uuids::uuid id)
 {
-    return _descriptorSets[id];
+    auto it = _descriptorSets.find(id);
+    if(it == _descriptorSets.end())
+    {
+        if(_staleDescriptorSets.count(id))
+        {
+            throw std::runtime_error("Descriptor set references a destroyed resource, it must be compiled again");
+        }
+        throw std::runtime_error("Unknown descriptor set id");
+    }
+
+    return it->second;
+}
+
+void frame_manager::freeRetiredDescriptorSets(bool all)
+{
+    // One frame fence is waited on per call, after framesInFlight of them every frame that saw the set has completed
+    for(auto it = _retiredDescriptorSets.begin(); it != _retiredDescriptorSets.end(); )
+    {
+        if(all || --it->second == 0)
+        {
+            _descriptorAllocator->free(it->first);
+            it = _retiredDescriptorSets.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
 }
 
 void frame_manager::allocateUniformBuffers(uint32_t count)
@@ -117,11 +291,51 @@ DescriptorBuilder frame_manager::getReadyDescriptorBuilder()
     return _descriptorBuilder->begin(_descriptorLayoutCache.get(), _descriptorAllocator.get());
 }
 
+DescriptorBuilder frame_manager::getTransientDescriptorBuilder()
+{
+    return _descriptorBuilder->begin(_descriptorLayoutCache.get(), _transientAllocators[_transientFrame].get(), poolType::POOL_TYPE_TRANSIENT);
+}
+
+void frame_manager::resetTransientDescriptors(uint32_t frame)
+{
+    _transientAllocators[frame]->resetPools();
+    _transientFrame = frame;
+
+    freeRetiredDescriptorSets(false);
+}
+
+DescriptorAllocator::Stats frame_manager::getTransientDescriptorStats() const
+{
+    DescriptorAllocator::Stats stats;
+
+    for(const auto& allocator : _transientAllocators)
+    {
+        const DescriptorAllocator::Stats& frameStats = allocator->getStats();
+        stats.totalAllocations += frameStats.totalAllocations;
+        stats.pools += frameStats.pools;
+        stats.resets += frameStats.resets;
+    }
+
+    // Live sets are the ones of the frame currently being recorded
+    if(!_transientAllocators.empty())
+    {
+        stats.allocations = _transientAllocators[_transientFrame]->getStats().allocations;
+    }
+
+    return stats;
+}
+
 void frame_manager::cleanup()
 {
     // Free the uniform buffers
     _core->getMemorySystem().freeBuffer(_bufferDescriptorSets.buffer);
 
+    // The device is idle, retired sets can go right away
+    if(_descriptorAllocator)
+    {
+        freeRetiredDescriptorSets(true);
+    }
+
     // Free the descriptor sets allocator and layout cache
     if(_descriptorLayoutCache)
     {
@@ -132,6 +346,11 @@ void frame_manager::cleanup()
     {
         _descriptorAllocator->cleanup();
     }
+
+    for(auto& allocator : _transientAllocators)
+    {
+        allocator->cleanup();
+    }
 }
 
 void frame_manager::updateModelMatrices(uint32_t currentImage)
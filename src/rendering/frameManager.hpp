@@ -9,6 +9,7 @@
 
 #include <vector>
 #include <memory>
+#include <unordered_set>
 
 // Third-party headers
 #include <boost/uuid/uuid.hpp>  // UUID's for descriptor sets
@@ -58,6 +59,28 @@ using descriptorSetBindings = std::vector<descriptorBindingData>;
 // One descriptor set for each frame in flight
 using descriptorSets = std::vector<VkDescriptorSet>;
 
+// Everything a built descriptor set depends on: layout bindings and the handles/ranges written into them
+struct descriptorSetKey
+{
+    std::vector<uint64_t> words;
+
+    bool operator==(const descriptorSetKey& other) const { return words == other.words; }
+};
+
+struct descriptorSetKeyHash
+{
+    std::size_t operator()(const descriptorSetKey& key) const
+    {
+        return boost::hash_range(key.words.begin(), key.words.end());
+    }
+};
+
+struct cachedDescriptorSet
+{
+    VkDescriptorSet set;
+    std::vector<uint64_t> resources;        // buffers, views and samplers referenced by the set
+};
+
 class frame_manager
 {
 public:
@@ -65,8 +88,15 @@ public:
 
     void initDescriptorBuilder();
 
+    // Identical binding requests return the same id and the same, already built, descriptor sets
     boost::uuids::uuid compileDescriptorSet(std::vector<descriptorSetBindings>& bindings);
     descriptorSets& getDescriptorSet(boost::uuids::uuid id);
+    VkDescriptorSet getCachedDescriptorSet(const descriptorSetBindings& bindings);
+
+    // Drops every cached set referencing a buffer, image view or sampler that is being destroyed
+    // Compiled ids using them become stale, getDescriptorSet throws on them until they are compiled again
+    // The sets themselves are freed once every frame in flight that may have bound them has completed
+    void invalidateDescriptorSets(uint64_t resource);
 
     void allocateUniformBuffers(uint32_t count = 1);
     void updateUniformBuffers(uint32_t currentImage);
@@ -75,8 +105,14 @@ public:
     VkDescriptorSet& getDescriptorSet(descriptorSetType type, uint32_t index);
 
     DescriptorBuilder getReadyDescriptorBuilder();
+    // Sets that only live until the current frame in flight completes (bakes, one-off passes)
+    DescriptorBuilder getTransientDescriptorBuilder();
+    // Called once the frame's fence has signalled, recycles every transient set of that frame at once
+    void resetTransientDescriptors(uint32_t frame);
+    DescriptorAllocator::Stats getTransientDescriptorStats() const;
 
     std::unique_ptr<DescriptorAllocator>& getDescriptorAllocator() { return _descriptorAllocator; }
+    std::unique_ptr<DescriptorLayoutCache>& getDescriptorLayoutCache() { return _descriptorLayoutCache; }
 
     void cleanup();
 
@@ -93,10 +129,24 @@ private:
     std::vector<VkDescriptorImageInfo> _textureCubemapDescriptorSets;
 
     std::unordered_map<boost::uuids::uuid, descriptorSets, boost::hash<boost::uuids::uuid> > _descriptorSets;
+    std::unordered_set<boost::uuids::uuid, boost::hash<boost::uuids::uuid> > _staleDescriptorSets;
+
+    // Invalidated sets, with the number of frame fences left to wait for before they can be freed
+    std::vector<std::pair<VkDescriptorSet, uint32_t>> _retiredDescriptorSets;
+    void freeRetiredDescriptorSets(bool all);
+
+    // Content keyed cache of single sets, plus how many cached sets reference each resource
+    descriptorSetKey makeDescriptorSetKey(const descriptorSetBindings& bindings, std::vector<uint64_t>& resources) const;
+    std::unordered_map<descriptorSetKey, cachedDescriptorSet, descriptorSetKeyHash> _descriptorSetCache;
+    std::unordered_map<uint64_t, uint32_t> _referencedResources;
 
     std::unique_ptr<DescriptorBuilder> _descriptorBuilder;
 
     std::unique_ptr<DescriptorLayoutCache> _descriptorLayoutCache;
     std::unique_ptr<DescriptorAllocator> _descriptorAllocator;
+
+    // One linear arena per frame in flight
+    std::vector<std::unique_ptr<DescriptorAllocator>> _transientAllocators;
+    uint32_t _transientFrame = 0;
     rendering_system* _core;
 };  
\ No newline at end of file
@@ -4,6 +4,8 @@
 // First-party includes
 #include "helpers/RootDir.hpp"
 
+#include <algorithm>
+
 namespace 
 {
     unsigned int nextId = 0;
@@ -16,38 +18,116 @@ model_mesh_library::model_mesh_library(rendering_system* core)  :
     ;
 }
 
-entt::entity model_mesh_library::createModel(entt::registry& registry, const std::string& path)
+entt::entity model_mesh_library::createModel(entt::registry& registry, const std::string& path, bool optimizeMeshes, bool keepGeometry)
 {
-    entt::entity modelEntity = _core->getScene()->newEntity();
     std::string absolutePath = ROOT_DIR + path; 
 
     std::string name = absolutePath.substr(absolutePath.find_last_of('/') + 1);
     name = name.substr(0, name.find_last_of('.'));     // Remove the file extension
 
     // If the meshes are already loaded, do not load them again
-    if(_loadedModelPaths.find(absolutePath) == _loadedModelPaths.end())
+    // Imports and requests that don't fit the loaded meshes throw before the entity exists
+    if(_loadedModelPaths.find(absolutePath) == _loadedModelPaths.end() && !_factory.isImporting(absolutePath))
     {
-        Model& newModel = registry.emplace<Model>(modelEntity, _factory.importFromFile(absolutePath));
+        Model newModel = _factory.importFromFile(absolutePath, optimizeMeshes, keepGeometry);
         newModel.name = name;
         newModel.id = nextId++;
         _loadedModelPaths.insert(absolutePath);
+
+        entt::entity modelEntity = _core->getScene()->newEntity();
+        registry.emplace<Model>(modelEntity, newModel);
+        return modelEntity;
     }
-    else
+
+    _factory.reuseImport(absolutePath, optimizeMeshes, keepGeometry);
+
+    // Imported asynchronously for other entities, this one can't wait for update so the import is finished here
+    if(_factory.isImporting(absolutePath))
     {
+        _factory.finishImport(absolutePath);
+        _loadedModelPaths.insert(absolutePath);
+    }
+
+    entt::entity modelEntity = _core->getScene()->newEntity();
+    registry.emplace<Model>(modelEntity, Model{nextId++, absolutePath, getMeshes(absolutePath), name});
+
+    return modelEntity;
+}
+
+entt::entity model_mesh_library::createModelAsync(entt::registry& registry, const std::string& path, bool optimizeMeshes, bool keepGeometry)
+{
+    std::string absolutePath = ROOT_DIR + path; 
+
+    std::string name = absolutePath.substr(absolutePath.find_last_of('/') + 1);
+    name = name.substr(0, name.find_last_of('.'));     // Remove the file extension
+
+    if(_loadedModelPaths.find(absolutePath) != _loadedModelPaths.end())
+    {
+        _factory.reuseImport(absolutePath, optimizeMeshes, keepGeometry);
+
+        entt::entity modelEntity = _core->getScene()->newEntity();
         registry.emplace<Model>(modelEntity, Model{nextId++, absolutePath, getMeshes(absolutePath), name});
+        return modelEntity;
     }
 
+    // Entities asking for a model that is already importing wait on the same import
+    _factory.beginImport(absolutePath, optimizeMeshes, keepGeometry);
+
+    entt::entity modelEntity = _core->getScene()->newEntity();
+    registry.emplace<PendingModel>(modelEntity, PendingModel{absolutePath, name});
+
     return modelEntity;
 }
 
-entt::entity model_mesh_library::createModelFromMesh(entt::registry& registry, const std::string& name, const Mesh& meshData )
+void model_mesh_library::update(entt::registry& registry)
+{
+    std::vector<std::string> finished;
+    std::vector<std::string> failed;
+    _factory.updateImports(finished, failed);
+
+    if(finished.empty() && failed.empty())
+    {
+        return;
+    }
+
+    for(const std::string& absolutePath : finished)
+    {
+        _loadedModelPaths.insert(absolutePath);
+    }
+
+    auto view = registry.view<PendingModel>();
+    std::vector<entt::entity> resolved;
+
+    for(auto entity : view)
+    {
+        const PendingModel& pending = view.get<PendingModel>(entity);
+
+        if(std::find(finished.begin(), finished.end(), pending.path) != finished.end())
+        {
+            registry.emplace<Model>(entity, Model{nextId++, pending.path, getMeshes(pending.path), pending.name});
+            resolved.push_back(entity);
+        }
+        // Entities of models that failed to import are kept, they just never get drawn
+        else if(std::find(failed.begin(), failed.end(), pending.path) != failed.end())
+        {
+            resolved.push_back(entity);
+        }
+    }
+
+    for(auto entity : resolved)
+    {
+        registry.remove<PendingModel>(entity);
+    }
+}
+
+entt::entity model_mesh_library::createModelFromMesh(entt::registry& registry, const std::string& name, const meshGeometry& geometry)
 {
     entt::entity modelEntity = _core->getScene()->newEntity();
 
     if(_loadedModelPaths.find(name) == _loadedModelPaths.end())
     {
         _meshes[name] = std::make_shared<std::vector<Mesh>>();
-        Model& newModel = registry.emplace<Model>(modelEntity, _factory.importFromMeshData(name, meshData));
+        Model& newModel = registry.emplace<Model>(modelEntity, _factory.importFromMeshData(name, geometry));
         _loadedModelPaths.insert(name);
     }
     else
@@ -58,14 +138,14 @@ entt::entity model_mesh_library::createModelFromMesh(entt::registry& registry, c
     return modelEntity;
 }
 
- Model model_mesh_library::createModelFromMesh(const std::string& name, const Mesh& meshData )
+ Model model_mesh_library::createModelFromMesh(const std::string& name, const meshGeometry& geometry)
 {
     Model result;
 
     if(_loadedModelPaths.find(name) == _loadedModelPaths.end())
     {
         _meshes[name] = std::make_shared<std::vector<Mesh>>();
-        result = _factory.importFromMeshData(name, meshData);
+        result = _factory.importFromMeshData(name, geometry);
         _loadedModelPaths.insert(name);
     }
     else
@@ -78,16 +158,50 @@ entt::entity model_mesh_library::createModelFromMesh(entt::registry& registry, c
 
 void model_mesh_library::cleanup()
 {
+    _factory.cleanup();
+
     for(auto& mesh : _meshes)
     {
         for(auto& meshData : *mesh.second)
         {
             _core->getMemorySystem().freeBuffer(meshData.vertexBuffer);
             _core->getMemorySystem().freeBuffer(meshData.indexBuffer);
+            if(meshData.meshletBuffer.buffer != VK_NULL_HANDLE)
+            {
+                _core->getMemorySystem().freeBuffer(meshData.meshletBuffer);
+            }
         }
     }
 }
 
+void model_mesh_library::unloadModel(const std::string& path)
+{
+    std::string absolutePath = ROOT_DIR + path;
+
+    auto meshes = _meshes.find(absolutePath);
+    if(meshes == _meshes.end())
+    {
+        return;
+    }
+
+    vkDeviceWaitIdle(_core->getLogicalDevice());
+
+    for(auto& meshData : *meshes->second)
+    {
+        _core->getMemorySystem().freeBuffer(meshData.vertexBuffer);
+        _core->getMemorySystem().freeBuffer(meshData.indexBuffer);
+        if(meshData.meshletBuffer.buffer != VK_NULL_HANDLE)
+        {
+            _core->getMemorySystem().freeBuffer(meshData.meshletBuffer);
+        }
+    }
+    _meshes.erase(meshes);
+    _loadedModelPaths.erase(absolutePath);
+
+    // Texture decodes still queued for slots this frees are dropped
+    _factory.forgetModel(absolutePath);
+}
+
 bool model_mesh_library::isLoaded(const std::string& path) const
 {
     return std::find(_loadedModelPaths.begin(), _loadedModelPaths.end(), path) != _loadedModelPaths.end();
@@ -21,13 +21,25 @@ class model_mesh_library
 public:
     model_mesh_library(rendering_system* core);
 
-    entt::entity createModel(entt::registry& registry, const std::string& path);
-    entt::entity createModelFromMesh(entt::registry& registry, const std::string& name, const Mesh& meshData);
-    Model createModelFromMesh(const std::string& name, const Mesh& meshData);
+    // keepGeometry leaves a CPU copy of every mesh in Mesh::geometry, see ModelImporter::importFromFile
+    entt::entity createModel(entt::registry& registry, const std::string& path, bool optimizeMeshes = true, bool keepGeometry = false);
+    // Returns right away with a PendingModel on the entity, the Model replaces it once update sees the import finish
+    entt::entity createModelAsync(entt::registry& registry, const std::string& path, bool optimizeMeshes = true, bool keepGeometry = false);
+    entt::entity createModelFromMesh(entt::registry& registry, const std::string& name, const meshGeometry& geometry);
+    Model createModelFromMesh(const std::string& name, const meshGeometry& geometry);
 
     std::shared_ptr<std::vector<Mesh>> getMeshes(const std::string& path);
     bool isLoaded(const std::string& path) const;
 
+    // Frees the meshes of a model file and drops its texture references, entities still using it must be gone
+    void unloadModel(const std::string& path);
+
+    // ACMR and vertex counts of the models optimized at import this run, by absolute path
+    const std::unordered_map<std::string, meshOptimizationReport>& getOptimizationReports() const { return _factory.getOptimizationReports(); }
+
+    // Once per frame on the main thread, advances the imports in flight and hands finished models to their entities
+    void update(entt::registry& registry);
+
     void cleanup();
 
 private:
@@ -35,6 +47,7 @@ private:
 
     std::unordered_map<std::string, std::shared_ptr<std::vector<Mesh>>> _meshes;
     std::set<std::string> _loadedModelPaths;
+    std::unordered_map<std::string, std::vector<uint32_t>> _modelTextures;    // shared texture references held by each model file
 
     rendering_system* _core;
 };
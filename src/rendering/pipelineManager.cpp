@@ -2,12 +2,14 @@
 
 #include "rendering/rendering.hpp"
 #include "rendering/shaderManager.hpp"
-#include "rendering/resources/vertex.hpp"
+#include "rendering/resources/vertexLayout.hpp"
 #include "util/physicalDeviceHelper.hpp"
 
 #include "spirv_cross.hpp"
 
+#include <algorithm>
 #include <iostream>
+#include <map>
 
 
 pipeline_system::pipeline_system(rendering_system* core) :
@@ -21,23 +23,42 @@ void pipeline_system::init()
     initializeRenderPasses();
 }
 
-void pipeline_system::createPipeline(std::string shaderProgramName, E_RenderPassType renderPassType)
+void pipeline_system::createPipeline(std::string shaderProgramName, E_RenderPassType renderPassType, const specializationConstants& baseSpecialization, std::string pipelineName, E_VertexLayout vertexLayout)
 {
     if(renderPassType == E_RenderPassType::SIZE)
     {
         throw std::runtime_error("Invalid render pass type");
     }
 
+    if(pipelineName.empty())
+    {
+        pipelineName = shaderProgramName;
+    }
+
     shader_system& shaderManager = _core->getShaderSystem();
     auto shaderProgram = shaderManager.getShaderProgram(shaderProgramName);
 
-    createShaderStagesInfo(shaderProgram);
+    // The shaders default to the standard layout, other layouts tell them how to decode their inputs
+    specializationConstants specialization = baseSpecialization;
+    if(vertexLayout != E_VertexLayout::STANDARD)
+    {
+        specialization.set(SPEC_CONSTANT_VERTEX_LAYOUT, static_cast<uint32_t>(vertexLayout));
+    }
+
+    // Specialization constants, shared by all the stages
+    VkSpecializationInfo specializationInfo{};
+    specializationInfo.mapEntryCount = static_cast<uint32_t>(specialization.entries.size());
+    specializationInfo.pMapEntries = specialization.entries.data();
+    specializationInfo.dataSize = specialization.data.size();
+    specializationInfo.pData = specialization.data.data();
+
+    createShaderStagesInfo(shaderProgram, specialization.empty() ? nullptr : &specializationInfo);
 
     VkGraphicsPipelineCreateInfo pipelineInfo = {};
     pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
     pipelineInfo.stageCount = _shaderStages.size();
     pipelineInfo.pStages = _shaderStages.data();
-    pipelineInfo.pVertexInputState = &createVertexInputInfo();
+    pipelineInfo.pVertexInputState = &createVertexInputInfo(vertexLayout);
     pipelineInfo.pInputAssemblyState = &createInputAssemblyInfo();
     pipelineInfo.pViewportState = &createViewportStateInfo();
     pipelineInfo.pRasterizationState = &createRasterizerInfo();
@@ -45,14 +66,14 @@ void pipeline_system::createPipeline(std::string shaderProgramName, E_RenderPass
     pipelineInfo.pDepthStencilState = &createDepthStencilInfo(); // Optional
     pipelineInfo.pColorBlendState = &createColorBlendingInfo();
     pipelineInfo.pDynamicState = &createDynamicStateInfo(); // Optional
-    pipelineInfo.layout = generatePipelineLayout(shaderProgram);
+    pipelineInfo.layout = generatePipelineLayout(shaderProgram, specialization);
     pipelineInfo.renderPass = _renderPass[renderPassType];
     pipelineInfo.subpass = 0;
 
     shaderPipeline shaderPipeline;
 
     VkResult result = vkCreateGraphicsPipelines(_core->getLogicalDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &shaderPipeline.pipeline);
-    shaderPipeline.layout = _pipelineLayout;
+    shaderPipeline.layout = pipelineInfo.layout;
 
     if(result != VK_SUCCESS)
     {
@@ -60,20 +81,64 @@ void pipeline_system::createPipeline(std::string shaderProgramName, E_RenderPass
     }
     else
     {
-        _pipelines[shaderProgramName] = shaderPipeline;
+        _pipelines[pipelineName] = shaderPipeline;
     }
 
     
 }
 
+void pipeline_system::createComputePipeline(std::string shaderProgramName, const specializationConstants& specialization, std::string pipelineName)
+{
+    if(pipelineName.empty())
+    {
+        pipelineName = shaderProgramName;
+    }
+
+    auto shaderProgram = _core->getShaderSystem().getShaderProgram(shaderProgramName);
+    const shaderModule& computeShader = shaderProgram.shaders[static_cast<int>(shaderType::COMPUTE)];
+
+    if(computeShader.VKmodule == VK_NULL_HANDLE)
+    {
+        throw std::runtime_error("Shader program has no compute shader: " + shaderProgramName);
+    }
+
+    VkSpecializationInfo specializationInfo{};
+    specializationInfo.mapEntryCount = static_cast<uint32_t>(specialization.entries.size());
+    specializationInfo.pMapEntries = specialization.entries.data();
+    specializationInfo.dataSize = specialization.data.size();
+    specializationInfo.pData = specialization.data.data();
+
+    VkComputePipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.stage = createShaderStagesInfo(shaderProgram, specialization.empty() ? nullptr : &specializationInfo).front();
+    pipelineInfo.layout = generatePipelineLayout(shaderProgram, specialization);
+
+    shaderPipeline shaderPipeline;
+    shaderPipeline.layout = pipelineInfo.layout;
+
+    if(vkCreateComputePipelines(_core->getLogicalDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &shaderPipeline.pipeline) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create compute pipeline: " + pipelineName);
+    }
+
+    _pipelines[pipelineName] = shaderPipeline;
+}
+
 void pipeline_system::cleanup()
 {
     for (auto& pipeline : _pipelines)
     {
         vkDestroyPipeline(_core->getLogicalDevice(), pipeline.second.pipeline, nullptr);
-        vkDestroyPipelineLayout(_core->getLogicalDevice(), pipeline.second.layout, nullptr);
     }
 
+    // Layouts are shared between pipelines, destroy each one once
+    for (auto& layout : _pipelineLayoutCache)
+    {
+        vkDestroyPipelineLayout(_core->getLogicalDevice(), layout.second, nullptr);
+    }
+    _pipelineLayoutCache.clear();
+    _reflectionCache.clear();
+
 
     for(auto& renderPass : _renderPass)
     {
@@ -94,30 +159,112 @@ shaderPipeline& pipeline_system::getPipeline(std::string name)
 
 namespace
 {
-    // Struct to hold information about a shader resource
-    struct ShaderResource {
-        uint32_t set;
-        uint32_t binding;
-        spirv_cross::SPIRType::BaseType type;
-        // Add more information as needed
+    // Number of descriptors in a binding
+    // Arrays sized by a specialization constant report the constant's default value and its id through specConstantID
+    uint32_t getDescriptorCount(const spirv_cross::Compiler& comp, const spirv_cross::SPIRType& type, bool& isSpecConstant, uint32_t& specConstantID)
+    {
+        isSpecConstant = false;
+
+        if(type.array.empty())
+        {
+            return 1;
+        }
+
+        if(type.array_size_literal[0])
+        {
+            return type.array[0];
+        }
+
+        isSpecConstant = true;
+        specConstantID = comp.get_decoration(type.array[0], spv::DecorationSpecId);
+
+        return comp.get_constant(type.array[0]).scalar();
+    }
+
+    void hashCombine(size_t& seed, uint64_t value)
+    {
+        seed ^= std::hash<uint64_t>()(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    }
+}
+
+const shaderReflection& pipeline_system::reflectShaderModule(const shaderModule& shader)
+{
+    auto it = _reflectionCache.find(shader.VKmodule);
+    if(it != _reflectionCache.end())
+    {
+        return it->second;
+    }
+
+    shaderReflection reflection;
+    VkShaderStageFlags stage = _core->getShaderSystem().getVkShaderStageFlagBits(shader.type);
+
+    spirv_cross::Compiler comp(shader.code); 
+    spirv_cross::ShaderResources resources = comp.get_shader_resources();
+
+    // Push constants, a stage can only declare a single block
+    for (auto& resource : resources.push_constant_buffers) 
+    {
+        reflection.pushConstantSize = comp.get_declared_struct_size(comp.get_type(resource.base_type_id));
+    }
+
+    auto addBinding = [&](const spirv_cross::Resource& resource, VkDescriptorType descriptorType)
+    {
+        shaderReflection::binding binding;
+        binding.set = comp.get_decoration(resource.id, spv::DecorationDescriptorSet);
+        binding.layoutBinding.binding = comp.get_decoration(resource.id, spv::DecorationBinding);
+        binding.layoutBinding.descriptorType = descriptorType;
+        binding.layoutBinding.descriptorCount = getDescriptorCount(comp, comp.get_type(resource.type_id), binding.countIsSpecConstant, binding.countSpecConstantID);
+        binding.layoutBinding.stageFlags = stage;
+        binding.layoutBinding.pImmutableSamplers = nullptr;
+
+        reflection.bindings.push_back(binding);
     };
+
+    // Uniform buffers
+    for (auto& resource : resources.uniform_buffers) 
+    {
+        addBinding(resource, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
+    }
+
+    // Sampled images
+    for (auto& resource : resources.sampled_images) 
+    {
+        addBinding(resource, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+    }
+
+    // Texture images
+    for (auto& resource : resources.separate_images)
+    {
+        addBinding(resource, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE);
+    }
+
+    // Sampler
+    for (auto& resource : resources.separate_samplers)
+    {
+        addBinding(resource, VK_DESCRIPTOR_TYPE_SAMPLER);
+    }
+
+    // Storage images
+    for (auto& resource : resources.storage_images)
+    {
+        addBinding(resource, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE);
+    }
+
+    // Storage buffers
+    for (auto& resource : resources.storage_buffers)
+    {
+        addBinding(resource, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+    }
+
+    return _reflectionCache[shader.VKmodule] = std::move(reflection);
 }
 
-VkPipelineLayout pipeline_system::generatePipelineLayout(const shaderProgram& program)
+VkPipelineLayout pipeline_system::generatePipelineLayout(const shaderProgram& program, const specializationConstants& specialization)
 {
-    // Get max number of descriptor sets from the physical device
-    VkPhysicalDeviceProperties properties;
-    vkGetPhysicalDeviceProperties(_core->getPhysicalDevice(), &properties);
-    uint32_t maxSets = properties.limits.maxBoundDescriptorSets;
-
-    // Create a vector of descriptor set layouts for each set
-    std::vector<std::vector<VkDescriptorSetLayoutBinding>> descriptorSetLayoutBindings;
-    descriptorSetLayoutBindings.resize(maxSets);
+    // Bindings of every set, ordered by set index
+    std::map<uint32_t, std::vector<VkDescriptorSetLayoutBinding>> descriptorSetLayoutBindings;
     // Same for push constant ranges
-    std::vector<VkPushConstantRange> pushConstantRanges_VERTEX;
-    std::vector<VkPushConstantRange> pushConstantRanges_FRAGMENT;
-
-    std::set<uint32_t> descriptorSetsUsed;
+    std::vector<VkPushConstantRange> pushConstantRanges;
 
     // Iterate over all shaders in the program (vertex, fragment, etc.)
     for (auto& shader : program.shaders)
@@ -127,140 +274,86 @@ VkPipelineLayout pipeline_system::generatePipelineLayout(const shaderProgram& pr
             continue;
         }
 
-        // Load the SPIR-V code for this shader
-        std::vector<uint32_t> spirv = shader.code;
-        spirv_cross::Compiler comp(std::move(spirv)); 
-
-        spirv_cross::ShaderResources resources = comp.get_shader_resources();
+        const shaderReflection& reflection = reflectShaderModule(shader);
+        VkShaderStageFlags stage = _core->getShaderSystem().getVkShaderStageFlagBits(shader.type);
 
-        // Push constants for vertex shader
-        for (auto& resource : resources.push_constant_buffers) 
+        if(reflection.pushConstantSize > 0)
         {
             VkPushConstantRange pushConstantRange{};
-            pushConstantRange.stageFlags = _core->getShaderSystem().getVkShaderStageFlagBits(shader.type);
+            pushConstantRange.stageFlags = stage;
 
-            if(pushConstantRange.stageFlags != VK_SHADER_STAGE_VERTEX_BIT)
+            if(stage == VK_SHADER_STAGE_VERTEX_BIT)
             {
-                continue;
+                pushConstantRange.offset = PUSH_CONSTANT_VERTEX_OFFSET;
+                pushConstantRange.size = reflection.pushConstantSize;
+                pushConstantRanges.push_back(pushConstantRange);
+            }
+            else if(stage == VK_SHADER_STAGE_FRAGMENT_BIT)
+            {
+                pushConstantRange.offset = PUSH_CONSTANT_FRAGMENT_OFFSET;
+                pushConstantRange.size = reflection.pushConstantSize % PUSH_CONSTANT_FRAGMENT_OFFSET;
+                pushConstantRanges.push_back(pushConstantRange);
+            }
+            else if(stage == VK_SHADER_STAGE_COMPUTE_BIT)
+            {
+                pushConstantRange.offset = PUSH_CONSTANT_COMPUTE_OFFSET;
+                pushConstantRange.size = reflection.pushConstantSize;
+                pushConstantRanges.push_back(pushConstantRange);
             }
-
-            pushConstantRange.offset = pushConstantRanges_VERTEX.empty() ? PUSH_CONSTANT_VERTEX_OFFSET : pushConstantRanges_VERTEX.back().offset + pushConstantRanges_VERTEX.back().size;
-            pushConstantRange.size = comp.get_declared_struct_size(comp.get_type(resource.base_type_id));
-
-            pushConstantRanges_VERTEX.push_back(pushConstantRange);
         }
 
-        // Push constants for the fragment shader
-        for(auto& resource : resources.push_constant_buffers)
+        for(const auto& binding : reflection.bindings)
         {
-            VkPushConstantRange pushConstantRange{};
-            pushConstantRange.stageFlags = _core->getShaderSystem().getVkShaderStageFlagBits(shader.type);
+            VkDescriptorSetLayoutBinding layoutBinding = binding.layoutBinding;
 
-            if(pushConstantRange.stageFlags != VK_SHADER_STAGE_FRAGMENT_BIT)
+            // Use the pipeline's value for arrays sized by an overridden specialization constant
+            if(binding.countIsSpecConstant)
             {
-                continue;
+                specialization.get(binding.countSpecConstantID, layoutBinding.descriptorCount);
             }
 
-            pushConstantRange.offset = pushConstantRanges_FRAGMENT.empty() ? PUSH_CONSTANT_FRAGMENT_OFFSET : pushConstantRanges_FRAGMENT.back().offset + pushConstantRanges_FRAGMENT.back().size;
-            pushConstantRange.size = comp.get_declared_struct_size(comp.get_type(resource.base_type_id));
-            pushConstantRange.size = pushConstantRange.size % PUSH_CONSTANT_FRAGMENT_OFFSET;
-            pushConstantRanges_FRAGMENT.push_back(pushConstantRange);
-        }
+            // Bindings shared between stages are merged into a single binding
+            std::vector<VkDescriptorSetLayoutBinding>& setBindings = descriptorSetLayoutBindings[binding.set];
+            auto existing = std::find_if(setBindings.begin(), setBindings.end(), [&](const VkDescriptorSetLayoutBinding& b) { return b.binding == layoutBinding.binding; });
 
-        // Uniform buffers
-        for (auto& resource : resources.uniform_buffers) 
-        {
-            uint32_t set = comp.get_decoration(resource.id, spv::DecorationDescriptorSet);
-            VkDescriptorSetLayoutBinding layoutBinding{};
-            layoutBinding.binding = comp.get_decoration(resource.id, spv::DecorationBinding);
-            layoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-            layoutBinding.descriptorCount = 1;
-            layoutBinding.stageFlags = _core->getShaderSystem().getVkShaderStageFlagBits(shader.type);
-
-            descriptorSetsUsed.insert(set);
-            descriptorSetLayoutBindings[set].push_back(layoutBinding);
-        }
-
-        // Sampled images
-        for (auto& resource : resources.sampled_images) 
-        {
-            uint32_t set = comp.get_decoration(resource.id, spv::DecorationDescriptorSet);
-            VkDescriptorSetLayoutBinding layoutBinding{};
-            layoutBinding.binding = comp.get_decoration(resource.id, spv::DecorationBinding);
-            layoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-            layoutBinding.descriptorCount = 1;
-            layoutBinding.stageFlags = _core->getShaderSystem().getVkShaderStageFlagBits(shader.type);
-            
-            descriptorSetsUsed.insert(set);
-            descriptorSetLayoutBindings[set].push_back(layoutBinding);
+            if(existing != setBindings.end())
+            {
+                existing->stageFlags |= layoutBinding.stageFlags;
+            }
+            else
+            {
+                setBindings.push_back(layoutBinding);
+            }
         }
+    }
 
-        // Texture images
-        for (auto& resource : resources.separate_images)
-        {
-            uint32_t set = comp.get_decoration(resource.id, spv::DecorationDescriptorSet);
-
-            const spirv_cross::SPIRType &type = comp.get_type(resource.type_id);
-
-            VkDescriptorSetLayoutBinding layoutBinding{};
-            layoutBinding.binding = comp.get_decoration(resource.id, spv::DecorationBinding);
-            layoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
-            layoutBinding.descriptorCount = type.array[0];
-            layoutBinding.stageFlags = _core->getShaderSystem().getVkShaderStageFlagBits(shader.type);
+    // Set layouts come from the shared cache, so sets built elsewhere with the same bindings are compatible
+    uint32_t setCount = descriptorSetLayoutBindings.empty() ? 0 : descriptorSetLayoutBindings.rbegin()->first + 1;
+    std::vector<VkDescriptorSetLayout> descriptorSetLayouts(setCount);
 
-            descriptorSetsUsed.insert(set);
-            descriptorSetLayoutBindings[set].push_back(layoutBinding);
-        }
+    for(uint32_t set = 0; set < setCount; set++)
+    {
+        std::vector<VkDescriptorSetLayoutBinding>& bindings = descriptorSetLayoutBindings[set];
 
-        // Sampler
-        for (auto& resource : resources.separate_samplers)
+        // Shaders sampling the bindless heap share the texture system's update-after-bind layout
+        if(set == kBindlessTextureSet && !bindings.empty())
         {
-            uint32_t set = comp.get_decoration(resource.id, spv::DecorationDescriptorSet);
-
-            VkDescriptorSetLayoutBinding layoutBinding{};
-            layoutBinding.binding = comp.get_decoration(resource.id, spv::DecorationBinding);
-            layoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
-            layoutBinding.descriptorCount = 1;
-            layoutBinding.stageFlags = _core->getShaderSystem().getVkShaderStageFlagBits(shader.type);
-
-            descriptorSetsUsed.insert(set);
-            descriptorSetLayoutBindings[set].push_back(layoutBinding);
+            descriptorSetLayouts[set] = _core->getTextureSystem().getBindlessDescriptorLayout();
+            continue;
         }
 
-    }
-
-    std::vector<VkDescriptorSetLayout> descriptorSetLayouts;
-    descriptorSetLayouts.resize(descriptorSetsUsed.size());
-
-    for(auto& set : descriptorSetsUsed)
-    {
         VkDescriptorSetLayoutCreateInfo layoutInfo{};
         layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-        layoutInfo.bindingCount = static_cast<uint32_t>(descriptorSetLayoutBindings[set].size());
-        layoutInfo.pBindings = descriptorSetLayoutBindings[set].data();
-        if(vkCreateDescriptorSetLayout(_core->getLogicalDevice(), &layoutInfo, nullptr, &descriptorSetLayouts[set]) != VK_SUCCESS)
-        {
-            std::cerr << "Failed to create descriptor set layout" << std::endl;
-        }
-    }
+        layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+        layoutInfo.pBindings = bindings.data();
 
-    std::vector<VkPushConstantRange> allPushConstantRanges;
-    allPushConstantRanges.reserve(pushConstantRanges_VERTEX.size() + pushConstantRanges_FRAGMENT.size());
-    allPushConstantRanges.insert(allPushConstantRanges.end(), pushConstantRanges_VERTEX.begin(), pushConstantRanges_VERTEX.end());
-    allPushConstantRanges.insert(allPushConstantRanges.end(), pushConstantRanges_FRAGMENT.begin(), pushConstantRanges_FRAGMENT.end());
-
-    VkPipelineLayout pipelineLayout = createPipelineLayout(descriptorSetLayouts, allPushConstantRanges);
-
-    for(auto& descriptorSetLayout : descriptorSetLayouts)
-    {
-        vkDestroyDescriptorSetLayout(_core->getLogicalDevice(), descriptorSetLayout, nullptr);
+        descriptorSetLayouts[set] = _core->getFrameManager().getDescriptorLayoutCache()->createDescriptorLayout(&layoutInfo);
     }
 
-    return pipelineLayout;
-    
+    return createPipelineLayout(descriptorSetLayouts, pushConstantRanges);
 }
 
-std::vector<VkPipelineShaderStageCreateInfo> pipeline_system::createShaderStagesInfo(const shaderProgram& program)
+std::vector<VkPipelineShaderStageCreateInfo> pipeline_system::createShaderStagesInfo(const shaderProgram& program, const VkSpecializationInfo* specializationInfo)
 {
     shader_system& shaderManager = _core->getShaderSystem();
 
@@ -277,6 +370,7 @@ std::vector<VkPipelineShaderStageCreateInfo> pipeline_system::createShaderStages
         shaderStageInfo.stage = shaderManager.getVkShaderStageFlagBits(shader.type);
         shaderStageInfo.module = shader.VKmodule;
         shaderStageInfo.pName = "main"; // entry point function for the shader
+        shaderStageInfo.pSpecializationInfo = specializationInfo;
 
         _shaderStages.push_back(shaderStageInfo);
     }
@@ -284,19 +378,10 @@ std::vector<VkPipelineShaderStageCreateInfo> pipeline_system::createShaderStages
     return _shaderStages;
 }
 
-VkPipelineVertexInputStateCreateInfo& pipeline_system::createVertexInputInfo()
+VkPipelineVertexInputStateCreateInfo& pipeline_system::createVertexInputInfo(E_VertexLayout vertexLayout)
 {
-    // VkPipelineVertexInputStateCreateInfo temp{};
-
-    // temp.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-    // temp.vertexBindingDescriptionCount = 1;
-    // temp.pVertexBindingDescriptions = &Vertex::getBindingDescription();
-    // temp.vertexAttributeDescriptionCount = static_cast<uint32_t>(Vertex::getAttributeDescriptions().size());;
-    // temp.pVertexAttributeDescriptions = Vertex::getAttributeDescriptions().data();
-
-
-    _bindingDescription = Vertex::getBindingDescription();
-    _attributeDescriptions = Vertex::getAttributeDescriptions();
+    _bindingDescription = vertexLayout::getBindingDescription(vertexLayout);
+    _attributeDescriptions = vertexLayout::getAttributeDescriptions(vertexLayout);
 
     VkPipelineVertexInputStateCreateInfo temp{};
     temp.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
@@ -433,9 +518,17 @@ VkPipelineColorBlendStateCreateInfo& pipeline_system::createColorBlendingInfo()
     return _colorBlending;
 }
 
-VkPipelineLayout& pipeline_system::createPipelineLayout(const std::vector<VkDescriptorSetLayout>& descriptorSetLayout, const std::vector<VkPushConstantRange>& pushConstantRanges)
+VkPipelineLayout pipeline_system::createPipelineLayout(const std::vector<VkDescriptorSetLayout>& descriptorSetLayout, const std::vector<VkPushConstantRange>& pushConstantRanges)
 {
-    
+    PipelineLayoutInfo layoutInfo{descriptorSetLayout, pushConstantRanges};
+
+    // Try to grab from cache
+    auto it = _pipelineLayoutCache.find(layoutInfo);
+    if(it != _pipelineLayoutCache.end())
+    {
+        return it->second;
+    }
+
     VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
     pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
     pipelineLayoutInfo.setLayoutCount = descriptorSetLayout.size();
@@ -443,12 +536,52 @@ VkPipelineLayout& pipeline_system::createPipelineLayout(const std::vector<VkDesc
     pipelineLayoutInfo.pushConstantRangeCount = static_cast<uint32_t>(pushConstantRanges.size());
     pipelineLayoutInfo.pPushConstantRanges = pushConstantRanges.data();
 
-    if(vkCreatePipelineLayout(_core->getLogicalDevice(), &pipelineLayoutInfo, nullptr, &_pipelineLayout) != VK_SUCCESS)
+    VkPipelineLayout pipelineLayout;
+    if(vkCreatePipelineLayout(_core->getLogicalDevice(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create pipeline layout");
+    }
+
+    // Add to cache
+    _pipelineLayoutCache[layoutInfo] = pipelineLayout;
+    return pipelineLayout;
+}
+
+bool pipeline_system::PipelineLayoutInfo::operator==(const PipelineLayoutInfo& other) const
+{
+    if(setLayouts != other.setLayouts || pushConstantRanges.size() != other.pushConstantRanges.size())
+    {
+        return false;
+    }
+
+    for(size_t i = 0; i < pushConstantRanges.size(); i++)
+    {
+        if( pushConstantRanges[i].stageFlags != other.pushConstantRanges[i].stageFlags ||
+            pushConstantRanges[i].offset != other.pushConstantRanges[i].offset ||
+            pushConstantRanges[i].size != other.pushConstantRanges[i].size)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+size_t pipeline_system::PipelineLayoutInfo::hash() const
+{
+    size_t result = std::hash<size_t>()(setLayouts.size());
+
+    for(const VkDescriptorSetLayout& layout : setLayouts)
+    {
+        hashCombine(result, reinterpret_cast<uint64_t>(layout));
+    }
+
+    for(const VkPushConstantRange& range : pushConstantRanges)
     {
-        std::cerr << "Failed to create pipeline layout" << std::endl;
+        hashCombine(result, static_cast<uint64_t>(range.stageFlags) | static_cast<uint64_t>(range.offset) << 16 | static_cast<uint64_t>(range.size) << 40);
     }
 
-    return _pipelineLayout;
+    return result;
 }
 
 void pipeline_system::initializeRenderPasses()
@@ -474,7 +607,7 @@ void pipeline_system::initializeRenderPasses()
         depthAttachment.format = findDepthFormat(_core->getPhysicalDevice());
         depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
         depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-        depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;            // reduced into the depth pyramid after the pass
         depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
         depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
         depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
@@ -567,10 +700,10 @@ void pipeline_system::initializeRenderPasses()
     }
 
     {
-        // CUBE_MAP renderpass
+        // CUBE_MAP renderpass, environment and irradiance bakes keep their HDR range
 
         VkAttachmentDescription colorAttachmentCube{};
-        colorAttachmentCube.format = VK_FORMAT_R8G8B8A8_SRGB;
+        colorAttachmentCube.format = VK_FORMAT_R16G16B16A16_SFLOAT;
         colorAttachmentCube.samples = VK_SAMPLE_COUNT_1_BIT;
         colorAttachmentCube.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
         colorAttachmentCube.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
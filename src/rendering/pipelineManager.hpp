@@ -3,18 +3,27 @@
 // GLFW
 #include "wrapper/glfw.hpp"
 #include "rendering/descriptors/descriptorBuilder.hpp"
+#include "rendering/resources/vertexLayout.hpp"
 
 #include <string>
 #include <unordered_map>
 #include <vector>
 #include <array>
 #include <memory>
+#include <cstring>
 
 class rendering_system;
 struct shaderProgram;
+struct shaderModule;
 
 const unsigned int PUSH_CONSTANT_VERTEX_OFFSET = 0;
+const unsigned int PUSH_CONSTANT_VERTEX_DEQUANTIZATION_OFFSET = 16;     // vertexQuantization of compact meshes
 const unsigned int PUSH_CONSTANT_FRAGMENT_OFFSET = 128;
+const unsigned int PUSH_CONSTANT_COMPUTE_OFFSET = 0;
+
+// Specialization constant ids, must match the constant_id layout qualifiers in the shaders
+const uint32_t SPEC_CONSTANT_SAMPLE_COUNT = 1;
+const uint32_t SPEC_CONSTANT_VERTEX_LAYOUT = 2;        // E_VertexLayout, set by createPipeline
 
 enum class E_RenderPassType : unsigned int
 {
@@ -30,6 +39,63 @@ struct shaderPipeline
     VkPipelineLayout layout;
 };
 
+// Specialization constant values applied to every stage of a pipeline
+// Stages that do not declare a given constant id simply ignore it
+struct specializationConstants
+{
+    template<typename T>
+    specializationConstants& set(uint32_t constantID, const T& value)
+    {
+        static_assert(sizeof(T) == sizeof(uint32_t), "Specialization constants must be 32 bit scalars");
+
+        VkSpecializationMapEntry entry{};
+        entry.constantID = constantID;
+        entry.offset = static_cast<uint32_t>(data.size());
+        entry.size = sizeof(T);
+        entries.push_back(entry);
+
+        data.resize(data.size() + sizeof(T));
+        std::memcpy(data.data() + entry.offset, &value, sizeof(T));
+
+        return *this;
+    }
+
+    // Fetches the raw value of a constant, returns false if the pipeline does not override it
+    bool get(uint32_t constantID, uint32_t& value) const
+    {
+        for(const auto& entry : entries)
+        {
+            if(entry.constantID == constantID)
+            {
+                std::memcpy(&value, data.data() + entry.offset, sizeof(uint32_t));
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool empty() const { return entries.empty(); }
+
+    std::vector<VkSpecializationMapEntry> entries;
+    std::vector<uint8_t> data;
+};
+
+// Resources a single shader module declares, reflected once and shared by every pipeline using the module
+struct shaderReflection
+{
+    struct binding
+    {
+        uint32_t set = 0;
+        VkDescriptorSetLayoutBinding layoutBinding{};
+        // Arrays sized by a specialization constant, descriptorCount holds the constant's default value
+        bool countIsSpecConstant = false;
+        uint32_t countSpecConstantID = 0;
+    };
+
+    std::vector<binding> bindings;
+    uint32_t pushConstantSize = 0;
+};
+
 struct bindingSlot
 {
     uint32_t binding;
@@ -43,7 +109,18 @@ public:
     pipeline_system(rendering_system* core);
 
     void init();
-    void createPipeline(std::string shaderProgramName, E_RenderPassType renderPassType = E_RenderPassType::COLOR_DEPTH);
+    // Creates a pipeline from a shader program, stored under pipelineName (defaults to the program name)
+    // Different specializations of the same program must be given different pipeline names
+    // The vertex input state follows vertexLayout, which is also handed to the shaders as SPEC_CONSTANT_VERTEX_LAYOUT
+    void createPipeline(    std::string shaderProgramName, 
+                            E_RenderPassType renderPassType = E_RenderPassType::COLOR_DEPTH, 
+                            const specializationConstants& specialization = {}, 
+                            std::string pipelineName = "",
+                            E_VertexLayout vertexLayout = E_VertexLayout::STANDARD);
+    // Same for programs made of a single compute shader
+    void createComputePipeline( std::string shaderProgramName,
+                                const specializationConstants& specialization = {},
+                                std::string pipelineName = "");
 
     void cleanup();
 
@@ -52,17 +129,21 @@ public:
 
 private:
     // Generate the pipeline layout from reflection on the SPIR-V code
-    VkPipelineLayout generatePipelineLayout(const shaderProgram& program);
+    VkPipelineLayout generatePipelineLayout(const shaderProgram& program, const specializationConstants& specialization);
+
+    // Reflection results, one per shader module
+    const shaderReflection& reflectShaderModule(const shaderModule& shader);
+    std::unordered_map<VkShaderModule, shaderReflection> _reflectionCache;
 
     // Creates the shader stages info for the pipeline (how many shaders, which shaders, etc.)
-    std::vector<VkPipelineShaderStageCreateInfo> createShaderStagesInfo(const shaderProgram& program);
+    std::vector<VkPipelineShaderStageCreateInfo> createShaderStagesInfo(const shaderProgram& program, const VkSpecializationInfo* specializationInfo);
     std::vector<VkPipelineShaderStageCreateInfo> _shaderStages;
 
     // Defines the layout of the vertex data that will be passed to the vertex shader
-    VkPipelineVertexInputStateCreateInfo& createVertexInputInfo();
+    VkPipelineVertexInputStateCreateInfo& createVertexInputInfo(E_VertexLayout vertexLayout);
     VkPipelineVertexInputStateCreateInfo _vertexInputInfo;
     VkVertexInputBindingDescription _bindingDescription;
-    std::array<VkVertexInputAttributeDescription, 5> _attributeDescriptions;
+    std::vector<VkVertexInputAttributeDescription> _attributeDescriptions;
 
     // Defines which primitive type the input assembly stage will use (point, line, triangle, etc.)
     VkPipelineInputAssemblyStateCreateInfo& createInputAssemblyInfo();
@@ -95,8 +176,27 @@ private:
     VkPipelineColorBlendAttachmentState _colorBlendAttachment;
 
     // Defines the layout of the descriptor sets that will be used in the pipeline
-    VkPipelineLayout& createPipelineLayout(const std::vector<VkDescriptorSetLayout>& descriptorSetLayout, const std::vector<VkPushConstantRange>& pushConstantRanges);
-    VkPipelineLayout _pipelineLayout;
+    // Layouts are deduplicated, pipelines with the same set layouts and push constant ranges share one
+    VkPipelineLayout createPipelineLayout(const std::vector<VkDescriptorSetLayout>& descriptorSetLayout, const std::vector<VkPushConstantRange>& pushConstantRanges);
+
+    struct PipelineLayoutInfo
+    {
+        std::vector<VkDescriptorSetLayout> setLayouts;
+        std::vector<VkPushConstantRange> pushConstantRanges;
+
+        bool operator==(const PipelineLayoutInfo& other) const;
+
+        size_t hash() const;
+    };
+
+    struct PipelineLayoutHash
+    {
+        std::size_t operator()(const PipelineLayoutInfo& k) const{
+            return k.hash();
+        }
+    };
+
+    std::unordered_map<PipelineLayoutInfo, VkPipelineLayout, PipelineLayoutHash> _pipelineLayoutCache;
 
     // Defines the render passes that the pipeline will be used with
     void initializeRenderPasses();
@@ -48,13 +48,14 @@ void DestroyDebugUtilsMessengerEXT(VkInstance instance, VkDebugUtilsMessengerEXT
 rendering_system::rendering_system(std::shared_ptr<Scene> scene)    :
     _scene(scene),
     _memory(this, scene->getRegistry(), _device),
-    _commandBuffer(this, _graphicsQueue, _presentationQueue),
+    _commandBuffer(this, _graphicsQueue, _presentationQueue, _transferQueue),
     _texture(this),
     _shaders(this), 
     _pipelines(this),
     _swapChains(this, _surface, _presentationQueue),
     _modelLibrary(this), 
     _frames(this), 
+    _clusterCulling(this),
     _imGUI(this)
 {
     init();
@@ -118,6 +119,7 @@ void rendering_system::initRender()
 
     // Resource initialization
     _texture.init();
+    _clusterCulling.init();
 
     _strategyChain = std::make_shared<PBSShadingStrategyChain>(this);    
 }
@@ -147,12 +149,27 @@ void rendering_system::createLogicalDevice()
         queueCreateInfos.push_back(queueCreateInfo);
     }
 
+    VkPhysicalDeviceFeatures supportedFeatures;
+    vkGetPhysicalDeviceFeatures(_physicalDevice, &supportedFeatures);
+
     VkPhysicalDeviceFeatures deviceFeatures{};
     deviceFeatures.samplerAnisotropy = VK_TRUE;
-
+    // BCn textures, loading one on a device without support throws
+    deviceFeatures.textureCompressionBC = supportedFeatures.textureCompressionBC;
+    // Compute mip generation, falls back to blits when missing
+    deviceFeatures.shaderStorageImageWriteWithoutFormat = supportedFeatures.shaderStorageImageWriteWithoutFormat;
+    deviceFeatures.shaderStorageImageArrayDynamicIndexing = supportedFeatures.shaderStorageImageArrayDynamicIndexing;
+    // Virtual texture feedback is written from fragment shaders, basic.frag always does so
+    deviceFeatures.fragmentStoresAndAtomics = VK_TRUE;
+
+    // Bindless texture heap: unsized arrays, non-uniform indexing, sparse slots and writes while the heap is bound
     VkPhysicalDeviceDescriptorIndexingFeatures descriptorIndexingFeatures{};
     descriptorIndexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
     descriptorIndexingFeatures.runtimeDescriptorArray = VK_TRUE;
+    descriptorIndexingFeatures.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+    descriptorIndexingFeatures.descriptorBindingPartiallyBound = VK_TRUE;
+    descriptorIndexingFeatures.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+    descriptorIndexingFeatures.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
 
     VkDeviceCreateInfo createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -161,8 +178,26 @@ void rendering_system::createLogicalDevice()
     createInfo.pQueueCreateInfos = queueCreateInfos.data();
     createInfo.pEnabledFeatures = &deviceFeatures;
 
-    createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-    createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+    // Optional extensions
+    std::vector<const char*> enabledExtensions = deviceExtensions;
+
+    uint32_t extensionCount;
+    vkEnumerateDeviceExtensionProperties(_physicalDevice, nullptr, &extensionCount, nullptr);
+    std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+    vkEnumerateDeviceExtensionProperties(_physicalDevice, nullptr, &extensionCount, availableExtensions.data());
+
+    for(const auto& extension : availableExtensions)
+    {
+        // Texture streaming sizes itself to the heap budgets
+        if(std::string(extension.extensionName) == VK_EXT_MEMORY_BUDGET_EXTENSION_NAME)
+        {
+            enabledExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+            _memoryBudgetSupported = true;
+        }
+    }
+
+    createInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+    createInfo.ppEnabledExtensionNames = enabledExtensions.data();
 
     if(enableValidationLayers){
         createInfo.enabledLayerCount = static_cast<uint32_t>(validationLayers.size());
@@ -293,6 +328,7 @@ void rendering_system::cleanup()
 {
     vkDeviceWaitIdle(_device);
 
+    _clusterCulling.cleanup();
     _imGUI.cleanup();
     _swapChains.cleanup();
     _texture.cleanup();
@@ -311,8 +347,8 @@ void rendering_system::cleanup()
         }
     }
 
-    _commandBuffer.cleanup();
     _modelLibrary.cleanup();
+    _commandBuffer.cleanup();
     _frames.cleanup();
     _pipelines.cleanup();
     _shaders.cleanup();
@@ -342,10 +378,21 @@ bool rendering_system::isDeviceSuitable(VkPhysicalDevice device)
     SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device);
     swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
 
-    VkPhysicalDeviceFeatures supportedFeatures;
-    vkGetPhysicalDeviceFeatures(device, &supportedFeatures);
+    VkPhysicalDeviceDescriptorIndexingFeatures descriptorIndexingFeatures{};
+    descriptorIndexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+
+    VkPhysicalDeviceFeatures2 supportedFeatures{};
+    supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    supportedFeatures.pNext = &descriptorIndexingFeatures;
+    vkGetPhysicalDeviceFeatures2(device, &supportedFeatures);
+
+    bool bindlessSupported =    descriptorIndexingFeatures.runtimeDescriptorArray &&
+                                descriptorIndexingFeatures.shaderSampledImageArrayNonUniformIndexing &&
+                                descriptorIndexingFeatures.descriptorBindingPartiallyBound &&
+                                descriptorIndexingFeatures.descriptorBindingSampledImageUpdateAfterBind &&
+                                descriptorIndexingFeatures.descriptorBindingUpdateUnusedWhilePending;
 
-    return indices.isComplete() && extensionsSupported && swapChainAdequate && supportedFeatures.samplerAnisotropy;
+    return indices.isComplete() && extensionsSupported && swapChainAdequate && supportedFeatures.features.samplerAnisotropy && supportedFeatures.features.fragmentStoresAndAtomics && bindlessSupported;
 }
 
 bool rendering_system::checkDeviceExtensionSupport(VkPhysicalDevice device)
@@ -16,12 +16,15 @@
 #include "rendering/pipelineManager.hpp"
 #include "rendering/swapChainManager.hpp"
 #include "rendering/frameManager.hpp"
+#include "rendering/clusterCulling.hpp"
 #include "GUI/imGUIHandler.hpp"
 #include "rendering/strategy/SChain.hpp"
 
 #include "rendering/descriptors/layoutCache.hpp"
 #include "rendering/descriptors/descriptorAllocator.hpp"
 
+#include "util/threadPool.hpp"
+
 
 #ifdef NDEBUG
 const bool enableValidationLayers = false;
@@ -67,11 +70,18 @@ public:
     command_buffer_system& getCommandBufferSystem() { return _commandBuffer; }      // command buffer system getter
     swap_chain_system& getSwapChainSystem() { return _swapChains; }                 // swap chain system getter
     frame_manager& getFrameManager() { return _frames; }                            // frame manager getter
+    cluster_culling_system& getClusterCullingSystem() { return _clusterCulling; }   // cluster culling system getter
 
     model_mesh_library& getModelMeshLibrary() { return _modelLibrary; }             // model mesh library getter
 
     imGUI_handler& getImGUIHandler() { return _imGUI; }                             // imGUI handler getter
 
+    thread_pool& getThreadPool() { return _threadPool; }                            // worker thread pool getter
+
+    std::shared_ptr<StrategyChain> getStrategyChain() { return _strategyChain; }    // strategy chain getter
+
+    bool hasMemoryBudget() const { return _memoryBudgetSupported; }                 // VK_EXT_memory_budget enabled
+
 private:
     // Initialization
     void init();
@@ -121,6 +131,8 @@ private:
     pipeline_system _pipelines;                             // pipeline system
     swap_chain_system _swapChains;                          // swap chain system
     frame_manager _frames;                                  // frame manager
+    cluster_culling_system _clusterCulling;                 // cluster culling system
+    thread_pool _threadPool;                                // CPU side worker threads
 
     // Initialization variables
     GLFWwindow* _window;                                    // glfw window
@@ -137,4 +149,5 @@ private:
     VkSurfaceKHR _surface;                                  // surface
 
     bool _framebufferResized = false;                       // framebuffer resized flag
+    bool _memoryBudgetSupported = false;                    // heap budgets can be queried
 };
\ No newline at end of file
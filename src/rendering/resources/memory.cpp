@@ -2,6 +2,7 @@
 
 #include "core/settings.hpp"
 #include "rendering/rendering.hpp"
+#include "util/physicalDeviceHelper.hpp"
 
 
 memory_system::memory_system(rendering_system* core, entt::registry& registry, VkDevice& logicalDevice) : 
@@ -12,7 +13,7 @@ memory_system::memory_system(rendering_system* core, entt::registry& registry, V
     ;
 }
 
-memoryBuffer memory_system::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties)
+memoryBuffer memory_system::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, bool sharedWithTransferQueue)
 {
     memoryBuffer buffer;
 
@@ -22,6 +23,19 @@ memoryBuffer memory_system::createBuffer(VkDeviceSize size, VkBufferUsageFlags u
     bufferInfo.usage = usage;
     bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
+    // The transfer family never doubles as the graphics family, see findQueueFamilies
+    uint32_t queueFamilies[2];
+    if(sharedWithTransferQueue)
+    {
+        QueueFamilyIndices indices = findQueueFamilies(_core->getPhysicalDevice(), _core->getSurface());
+        queueFamilies[0] = indices.graphicsFamily.value();
+        queueFamilies[1] = indices.transferFamily.value();
+
+        bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        bufferInfo.queueFamilyIndexCount = 2;
+        bufferInfo.pQueueFamilyIndices = queueFamilies;
+    }
+
     if(vkCreateBuffer(_core->getLogicalDevice(), &bufferInfo, nullptr, &buffer.buffer) != VK_SUCCESS)
     {
         throw std::runtime_error("Failed to create buffer");
@@ -51,13 +65,18 @@ memoryBuffer memory_system::createBuffer(VkDeviceSize size, VkBufferUsageFlags u
     // Device local memory is memory that is local to the GPU and is the fastest memory to access. We want the vertex buffer to be in device local memory. Device local memory is not accesible by the CPU.
 memoryBuffer memory_system::createVertexBuffer(std::vector<Vertex> vertices)
 {
-    VkDeviceSize bufferSize = sizeof(vertices[0]) * vertices.size();
+    return createVertexBuffer(vertices.data(), vertices.size());
+}
+
+memoryBuffer memory_system::createVertexBuffer(const Vertex* vertices, size_t count)
+{
+    VkDeviceSize bufferSize = sizeof(Vertex) * count;
 
     memoryBuffer stagingBuffer = createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
 
     void* data;
     vkMapMemory(_core->getLogicalDevice(), stagingBuffer.memory, 0, bufferSize, 0, &data);
-    memcpy(data, vertices.data(), (size_t) bufferSize);
+    memcpy(data, vertices, (size_t) bufferSize);
     vkUnmapMemory(_core->getLogicalDevice(), stagingBuffer.memory);
 
     memoryBuffer vertexBuffer = createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
@@ -71,13 +90,18 @@ memoryBuffer memory_system::createVertexBuffer(std::vector<Vertex> vertices)
 
 memoryBuffer memory_system::createIndexBuffer(std::vector<uint32_t> indices)
 {
-    VkDeviceSize bufferSize = sizeof(indices[0]) * indices.size();
+    return createIndexBuffer(indices.data(), indices.size());
+}
+
+memoryBuffer memory_system::createIndexBuffer(const uint32_t* indices, size_t count, VkIndexType indexType)
+{
+    VkDeviceSize bufferSize = getIndexBufferSize(count, indexType);
 
     memoryBuffer stagingBuffer = createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
 
     void* data;
     vkMapMemory(_core->getLogicalDevice(), stagingBuffer.memory, 0, bufferSize, 0, &data);
-    memcpy(data, indices.data(), (size_t) bufferSize);
+    writeIndices(data, indices, count, indexType);
     vkUnmapMemory(_core->getLogicalDevice(), stagingBuffer.memory);
 
     memoryBuffer indexBuffer = createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
@@ -89,6 +113,38 @@ memoryBuffer memory_system::createIndexBuffer(std::vector<uint32_t> indices)
     return indexBuffer;
 }
 
+VkIndexType memory_system::getIndexType(size_t vertexCount)
+{
+    return vertexCount <= 65536 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+}
+
+VkDeviceSize memory_system::getIndexBufferSize(size_t indexCount, VkIndexType indexType)
+{
+    VkDeviceSize size = indexCount * (indexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t));
+    return (size + 3) & ~VkDeviceSize(3);
+}
+
+void memory_system::writeIndices(void* destination, const uint32_t* indices, size_t count, VkIndexType indexType)
+{
+    if(indexType == VK_INDEX_TYPE_UINT32)
+    {
+        memcpy(destination, indices, count * sizeof(uint32_t));
+        return;
+    }
+
+    uint16_t* shortIndices = static_cast<uint16_t*>(destination);
+    for(size_t i = 0; i < count; i++)
+    {
+        shortIndices[i] = static_cast<uint16_t>(indices[i]);
+    }
+
+    // The padding, if any, reads as a zero index
+    if(count % 2 != 0)
+    {
+        shortIndices[count] = 0;
+    }
+}
+
 std::vector<memoryBuffer> memory_system::createUniformBuffers(uint32_t size, uint32_t count)
 {
     std::vector<memoryBuffer> buffers(count);
@@ -120,6 +176,8 @@ uint32_t memory_system::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlag
 
 void memory_system::freeBuffer(VkBuffer buffer, VkDeviceMemory memory)
 {
+    _core->getFrameManager().invalidateDescriptorSets((uint64_t)buffer);
+
     vkDestroyBuffer(_core->getLogicalDevice(), buffer, nullptr);
     vkFreeMemory(_core->getLogicalDevice(), memory, nullptr);
 }
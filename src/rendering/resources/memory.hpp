@@ -29,12 +29,21 @@ class memory_system
 public:
     memory_system(rendering_system* core, entt::registry& registry, VkDevice& logicalDevice);
 
-    // Buffer creation
-    memoryBuffer createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties);
+    // Buffer creation, shared buffers are filled by the transfer queue and read by the graphics queue without an ownership transfer
+    memoryBuffer createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, bool sharedWithTransferQueue = false);
 
     // Buffer resource creation
     memoryBuffer createVertexBuffer(std::vector<Vertex> vertices);
     memoryBuffer createIndexBuffer(std::vector<uint32_t> indices);
+    // Same, straight from memory the caller owns, such as a file mapping
+    memoryBuffer createVertexBuffer(const Vertex* vertices, size_t count);
+    memoryBuffer createIndexBuffer(const uint32_t* indices, size_t count, VkIndexType indexType = VK_INDEX_TYPE_UINT32);
+
+    // 16 bit indices whenever they can address every vertex
+    static VkIndexType getIndexType(size_t vertexCount);
+    // Padded to 4 bytes so compute shaders can read 16 bit index buffers as pairs of indices
+    static VkDeviceSize getIndexBufferSize(size_t indexCount, VkIndexType indexType);
+    static void writeIndices(void* destination, const uint32_t* indices, size_t count, VkIndexType indexType);
 
     // In order to make it work for any type of object, we need to use templates
     // Maybe this function cannot be templated and it should take the size as a parameter
@@ -8,19 +8,72 @@
 #include <memory>
 
 // First party includes
-#include "rendering/resources/vertex.hpp"
+#include "rendering/resources/vertexLayout.hpp"
 #include "rendering/resources/memory.hpp"
 #include "rendering/resources/texture.hpp"
 
+// Levels of detail share the vertex buffer, each one is a range of the index buffer
+const size_t kMaxLodCount = 4;
+
+struct meshLod
+{
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+    float error = 0.0f;                 // distance in model units the simplified surface may stray from the full one
+};
+
+// Cluster of consecutive triangles of the full level of detail, culled as a whole by cluster_culling_system
+// Matches the Meshlet struct of the culling shader, std430
+struct meshlet
+{
+    float center[3] = {0.0f, 0.0f, 0.0f};      // bounding sphere in model space
+    float radius = 0.0f;
+    float coneAxis[3] = {0.0f, 0.0f, 0.0f};    // the triangles face within the normal cone around the axis
+    float coneCutoff = 1.0f;                    // sine of the cone's half angle, 1 never culls
+    uint32_t firstIndex = 0;
+    uint32_t triangleCount = 0;
+    uint32_t padding[2] = {0, 0};
+};
+static_assert(sizeof(meshlet) == 48, "meshlet must match the culling shader");
+
+const uint32_t kNoClusterDraw = ~0u;
+
+// CPU side geometry of a mesh, what its buffers are uploaded from
+struct meshGeometry
+{
+    std::vector<Vertex> vertices;       // full precision, whatever layout the vertex buffer uses
+    std::vector<uint32_t> indices;      // every level of detail
+    std::vector<meshlet> meshlets;
+};
+
 struct Mesh
 {
-    std::vector<Vertex> vertexData;
     memoryBuffer vertexBuffer;
-    std::vector<unsigned int> indexData;
     memoryBuffer indexBuffer;
+    uint32_t vertexCount = 0;
+    uint32_t indexCount = 0;            // every level of detail
+    VkIndexType indexType = VK_INDEX_TYPE_UINT32;  // 16 bit for meshes of up to 65536 vertices, see memory_system::getIndexType
+
+    // Full mesh first, coarser levels after it, empty for meshes that were never simplified
+    std::vector<meshLod> lods;
+
+    // Clusters covering the full level of detail, meshletBuffer holds them for the culling pass
+    uint32_t meshletCount = 0;
+    memoryBuffer meshletBuffer{};
+
+    // Format of vertexBuffer
+    E_VertexLayout vertexLayout = E_VertexLayout::STANDARD;
+    vertexQuantization quantization;
 
     std::array<unsigned int, static_cast<size_t>(E_TextureType::SIZE)> textureIndices = {0};
 
+    // Bounding sphere in model space
+    glm::vec3 boundsCenter = glm::vec3(0.0f);
+    float boundsRadius = 0.0f;
+
+    // Dropped once the buffers are uploaded, unless the import asked to keep it (physics, picking)
+    std::shared_ptr<const meshGeometry> geometry;
+
     std::string path; 
 };
 
@@ -35,5 +88,18 @@ struct Model
     std::string name;
 
     glm::mat4 modelMatrix = glm::mat4(1.0f);
-};	
 
+    // Level of detail drawn for every mesh, picked each frame from the projected error, empty draws the full meshes
+    std::vector<uint8_t> meshLods;
+
+    // Indirect draw of every mesh in the cluster culled index stream, kNoClusterDraw draws the mesh's own index buffer
+    std::vector<uint32_t> meshClusterDraws;
+};
+
+// Stands in for the Model of an entity whose file is still being imported, swapped for the Model once the meshes are on the GPU
+struct PendingModel
+{
+    std::string path;
+
+    std::string name;
+};
@@ -5,9 +5,6 @@
 
 #include <array>
 
-struct VkVertexInputBindingDescription;
-struct VkVertexInputAttributeDescription;
-
 struct Vertex{
     glm::vec3 Position;
     glm::vec3 Normal;
@@ -15,10 +12,6 @@ struct Vertex{
     glm::vec3 Color;
     glm::vec3 Tangent;
 
-    static VkVertexInputBindingDescription getBindingDescription();
-    
-    static std::array<VkVertexInputAttributeDescription, 5> getAttributeDescriptions();
-
     bool operator==(const Vertex& other) const;
 };
 
@@ -0,0 +1,169 @@
+#include "rendering/resources/vertexLayout.hpp"
+
+#include "util/halfFloat.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <stdexcept>
+
+namespace
+{
+    const float kUnorm16Max = 65535.0f;
+    const float kSnorm16Max = 32767.0f;
+
+    // Indexed by E_VertexLayout, the locations match the vertex shader inputs
+    const std::array<vertexLayoutDescriptor, static_cast<size_t>(E_VertexLayout::SIZE)> kLayouts = {{
+        {
+            sizeof(Vertex),
+            {
+                {0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, Position)},
+                {1, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, Normal)},
+                {2, VK_FORMAT_R32G32_SFLOAT, offsetof(Vertex, TexCoords)},
+                {3, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, Color)},
+                {4, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, Tangent)}
+            }
+        },
+        {
+            sizeof(CompactVertex),
+            {
+                {0, VK_FORMAT_R16G16B16A16_UNORM, offsetof(CompactVertex, position)},
+                {1, VK_FORMAT_R16G16_SNORM, offsetof(CompactVertex, normal)},
+                {2, VK_FORMAT_R16G16_SFLOAT, offsetof(CompactVertex, texCoords)},
+                {4, VK_FORMAT_R16G16_SNORM, offsetof(CompactVertex, tangent)}
+            }
+        }
+    }};
+
+    int16_t toSnorm16(float value)
+    {
+        return static_cast<int16_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * kSnorm16Max));
+    }
+
+    float signNotZero(float value)
+    {
+        return value >= 0.0f ? 1.0f : -1.0f;
+    }
+}
+
+namespace vertexLayout
+{
+    const vertexLayoutDescriptor& getDescriptor(E_VertexLayout layout)
+    {
+        if(layout == E_VertexLayout::SIZE)
+        {
+            throw std::runtime_error("Invalid vertex layout");
+        }
+
+        return kLayouts[static_cast<size_t>(layout)];
+    }
+
+    VkVertexInputBindingDescription getBindingDescription(E_VertexLayout layout)
+    {
+        VkVertexInputBindingDescription bindingDescription{};
+        bindingDescription.binding = 0;
+        bindingDescription.stride = getDescriptor(layout).stride;
+        bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+        return bindingDescription;
+    }
+
+    std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions(E_VertexLayout layout)
+    {
+        const vertexLayoutDescriptor& descriptor = getDescriptor(layout);
+
+        std::vector<VkVertexInputAttributeDescription> attributeDescriptions(descriptor.attributes.size());
+        for(size_t i = 0; i < descriptor.attributes.size(); i++)
+        {
+            attributeDescriptions[i].binding = 0;
+            attributeDescriptions[i].location = descriptor.attributes[i].location;
+            attributeDescriptions[i].format = descriptor.attributes[i].format;
+            attributeDescriptions[i].offset = descriptor.attributes[i].offset;
+        }
+
+        return attributeDescriptions;
+    }
+
+    void encodeOctahedral(const glm::vec3& direction, int16_t encoded[2])
+    {
+        float length = std::abs(direction.x) + std::abs(direction.y) + std::abs(direction.z);
+        if(length == 0.0f)
+        {
+            encoded[0] = 0;
+            encoded[1] = 0;
+            return;
+        }
+
+        // Project onto the octahedron, the lower half folds over the diagonals
+        glm::vec2 octahedral = glm::vec2(direction.x, direction.y) / length;
+        if(direction.z < 0.0f)
+        {
+            octahedral = glm::vec2((1.0f - std::abs(octahedral.y)) * signNotZero(octahedral.x),
+                                   (1.0f - std::abs(octahedral.x)) * signNotZero(octahedral.y));
+        }
+
+        encoded[0] = toSnorm16(octahedral.x);
+        encoded[1] = toSnorm16(octahedral.y);
+    }
+
+    glm::vec3 decodeOctahedral(const int16_t encoded[2])
+    {
+        glm::vec3 direction = glm::vec3(std::max(encoded[0] / kSnorm16Max, -1.0f), std::max(encoded[1] / kSnorm16Max, -1.0f), 0.0f);
+        direction.z = 1.0f - std::abs(direction.x) - std::abs(direction.y);
+
+        float fold = std::max(-direction.z, 0.0f);
+        direction.x += direction.x >= 0.0f ? -fold : fold;
+        direction.y += direction.y >= 0.0f ? -fold : fold;
+
+        return glm::normalize(direction);
+    }
+
+    vertexQuantization compactVertices(const Vertex* vertices, size_t count, std::vector<CompactVertex>& compact)
+    {
+        vertexQuantization quantization;
+        compact.resize(count);
+        if(count == 0)
+        {
+            return quantization;
+        }
+
+        // 1 - Bounding box of the positions, a flat axis keeps a zero scale
+        glm::vec3 minimum = vertices[0].Position;
+        glm::vec3 maximum = minimum;
+        for(size_t i = 1; i < count; i++)
+        {
+            minimum = glm::min(minimum, vertices[i].Position);
+            maximum = glm::max(maximum, vertices[i].Position);
+        }
+
+        glm::vec3 extent = maximum - minimum;
+        glm::vec3 inverseExtent;
+        for(int axis = 0; axis < 3; axis++)
+        {
+            inverseExtent[axis] = extent[axis] > 0.0f ? kUnorm16Max / extent[axis] : 0.0f;
+        }
+
+        quantization.scale = glm::vec4(extent, 1.0f);
+        quantization.offset = glm::vec4(minimum, 0.0f);
+
+        // 2 - Pack every vertex
+        for(size_t i = 0; i < count; i++)
+        {
+            const Vertex& vertex = vertices[i];
+            CompactVertex& packed = compact[i];
+
+            glm::vec3 position = glm::clamp((vertex.Position - minimum) * inverseExtent, glm::vec3(0.0f), glm::vec3(kUnorm16Max));
+            packed.position[0] = static_cast<uint16_t>(std::lround(position.x));
+            packed.position[1] = static_cast<uint16_t>(std::lround(position.y));
+            packed.position[2] = static_cast<uint16_t>(std::lround(position.z));
+            packed.position[3] = static_cast<uint16_t>(kUnorm16Max);
+
+            encodeOctahedral(vertex.Normal, packed.normal);
+            encodeOctahedral(vertex.Tangent, packed.tangent);
+
+            packed.texCoords[0] = halfFloat::fromFloat(vertex.TexCoords.x);
+            packed.texCoords[1] = halfFloat::fromFloat(vertex.TexCoords.y);
+        }
+
+        return quantization;
+    }
+}
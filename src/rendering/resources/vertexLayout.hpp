@@ -0,0 +1,66 @@
+#pragma once
+
+#include "wrapper/glfw.hpp"
+#include "wrapper/glm.hpp"
+
+#include "rendering/resources/vertex.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Vertex buffer formats a pipeline can be built for, the vertex input state is generated from the layout's descriptor
+enum class E_VertexLayout : unsigned int
+{
+    STANDARD,                   // Vertex, 32 bit floats, 56 bytes
+    COMPACT,                    // CompactVertex, quantised, 20 bytes
+    SIZE
+};
+
+// Compact vertex, positions are unorm16 within the mesh bounds, normals and tangents are octahedral snorm16, texture coordinates are half floats
+// The material colour is not stored, location 3 is left out of the layout
+struct CompactVertex
+{
+    uint16_t position[4];       // w is always 1
+    int16_t normal[2];
+    uint16_t texCoords[2];
+    int16_t tangent[2];
+};
+static_assert(sizeof(CompactVertex) == 20, "CompactVertex must be tightly packed");
+
+// Maps the stored positions of a compact mesh back to model space, position = offset + scale * stored
+// Pushed to the vertex stage at PUSH_CONSTANT_VERTEX_DEQUANTIZATION_OFFSET
+struct vertexQuantization
+{
+    glm::vec4 scale = glm::vec4(1.0f);
+    glm::vec4 offset = glm::vec4(0.0f);
+};
+
+struct vertexAttribute
+{
+    uint32_t location;
+    VkFormat format;
+    uint32_t offset;
+};
+
+struct vertexLayoutDescriptor
+{
+    uint32_t stride;
+    std::vector<vertexAttribute> attributes;
+};
+
+namespace vertexLayout
+{
+    const vertexLayoutDescriptor& getDescriptor(E_VertexLayout layout);
+
+    // Single binding 0 at vertex rate
+    VkVertexInputBindingDescription getBindingDescription(E_VertexLayout layout);
+    std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions(E_VertexLayout layout);
+
+    // Octahedral encoding of a unit vector, zero vectors encode as +Z
+    void encodeOctahedral(const glm::vec3& direction, int16_t encoded[2]);
+    glm::vec3 decodeOctahedral(const int16_t encoded[2]);
+
+    // Quantises a mesh's vertices against their bounding box
+    vertexQuantization compactVertices(const Vertex* vertices, size_t count, std::vector<CompactVertex>& compact);
+}
@@ -1,6 +1,9 @@
 #include "rendering/shaderManager.hpp"
 
 #include "rendering/rendering.hpp"
+#include "core/settings.hpp"
+
+#include <spirv-tools/optimizer.hpp>
 
 #include <filesystem>
 #include <fstream>
@@ -10,14 +13,24 @@
 
 namespace
 {
-    const std::set<std::string> shaderExtensions = { ".vert", ".frag", ".geom", ".tesc", ".tese"};
+    const std::set<std::string> shaderExtensions = { ".vert", ".frag", ".geom", ".tesc", ".tese", ".comp"};
 
     const std::unordered_map<shaderType, std::string> shaderFileNames = {
         {shaderType::VERTEX, "vert.spv"},
         {shaderType::FRAGMENT, "frag.spv"},
         {shaderType::GEOMETRY, "geom.spv"},
         {shaderType::TESSELATION_CONTROL, "tesc.spv"},
-        {shaderType::TESSELATION_EVALUATION, "tese.spv"}
+        {shaderType::TESSELATION_EVALUATION, "tese.spv"},
+        {shaderType::COMPUTE, "comp.spv"}
+    };
+
+    const std::unordered_map<shaderType, std::string> optimizedShaderFileNames = {
+        {shaderType::VERTEX, "vert.opt.spv"},
+        {shaderType::FRAGMENT, "frag.opt.spv"},
+        {shaderType::GEOMETRY, "geom.opt.spv"},
+        {shaderType::TESSELATION_CONTROL, "tesc.opt.spv"},
+        {shaderType::TESSELATION_EVALUATION, "tese.opt.spv"},
+        {shaderType::COMPUTE, "comp.opt.spv"}
     };
 
 }
@@ -59,11 +72,14 @@ void shader_system::scanFolderRecursive(const std::string& path)
         }
     }
 
+    // Compute programs are a single compute shader
+    bool isComputeProgram = shaderFilenames.size() == 1 && unusedExtensions.find(".comp") == unusedExtensions.end();
+
     // After evaluating all the entries in the directory, 
     // ch-eck if at least vertex and fragment shaders are present
-    if(     unusedExtensions.size() <  2 || 
+    if(     !isComputeProgram && (unusedExtensions.size() <  2 || 
             unusedExtensions.find(".vert") != unusedExtensions.end() || 
-            unusedExtensions.find(".frag") != unusedExtensions.end())
+            unusedExtensions.find(".frag") != unusedExtensions.end()))
     {
         std::stringstream ss;
         ss << "Missing required shaders for shader program: " << shaderProgramName << std::endl;
@@ -126,6 +142,9 @@ shaderModule shader_system::compileShader(const std::string& path)
     case shaderType::TESSELATION_EVALUATION:
         stage = EShLangTessEvaluation;
         break;
+    case shaderType::COMPUTE:
+        stage = EShLangCompute;
+        break;
     default:
         throw std::runtime_error("Unknown shader type for file: " + path);
         break;
@@ -186,12 +205,15 @@ shaderModule shader_system::compileShader(const std::string& path)
         throw std::runtime_error(ss.str());
     }
 
-    // Save the SPIR-V to a file
-    std::filesystem::path spvPath(path.c_str());
-    module.name = spvPath.stem().string();
+    // Optimize before caching so later runs load the optimized code straight from disk
+    if(getSettingsData(_core->getRegistry()).optimizeShaders)
+    {
+        optimizeSPIRV(module.code, path);
+    }
 
-    spvPath = spvPath.parent_path();
-    spvPath /= shaderFileNames.at(module.type);
+    // Save the SPIR-V to a file
+    module.name = getShaderName(path);
+    std::filesystem::path spvPath = getSPIRVPath(path);
 
     std::ofstream file(spvPath, std::ios::binary);
     if(!file.is_open())
@@ -203,17 +225,8 @@ shaderModule shader_system::compileShader(const std::string& path)
 
     glslang::FinalizeProcess();
 
-
     // Create the vulkan shader module
-    VkShaderModuleCreateInfo createInfo{};
-    createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    createInfo.codeSize = module.code.size() * sizeof(uint32_t);
-    createInfo.pCode = module.code.data();
-
-    if(vkCreateShaderModule(_core->getLogicalDevice(), &createInfo, nullptr, &module.VKmodule) != VK_SUCCESS)
-    {
-        throw std::runtime_error("Failed to create shader module!");
-    }
+    module.VKmodule = createVkShaderModule(module.code);
 
     return module;
 }
@@ -221,15 +234,11 @@ shaderModule shader_system::compileShader(const std::string& path)
 shaderModule shader_system::loadShader(const std::string& path)
 {
     shaderModule module;
+    module.type = getShaderType(path);
+    module.name = getShaderName(path);
 
-    // Check file extension
-    if(path.find(".spv") == std::string::npos)
-    {
-        throw std::runtime_error("Non-standard extension for file: " + path);
-    }
-
-    // Load the shader from the .spv file
-    std::vector<char> SPVcode = readSPIRVFile(path);
+    // Load the shader from the cached .spv file that belongs to this source file
+    std::vector<char> SPVcode = readSPIRVFile(getSPIRVPath(path).string());
 
     // Calculate the number of uint32_t elements needed to hold the data
     size_t numUint32Elements = SPVcode.size() / sizeof(uint32_t);
@@ -241,15 +250,7 @@ shaderModule shader_system::loadShader(const std::string& path)
     std::memcpy(module.code.data(), SPVcode.data(), SPVcode.size());
 
     // Create the vulkan shader module
-    VkShaderModuleCreateInfo createInfo{};
-    createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    createInfo.codeSize = module.code.size() * sizeof(uint32_t);
-    createInfo.pCode = module.code.data();
-
-    if(vkCreateShaderModule(_core->getLogicalDevice(), &createInfo, nullptr, &module.VKmodule) != VK_SUCCESS)
-    {
-        throw std::runtime_error("Failed to create shader module!");
-    }
+    module.VKmodule = createVkShaderModule(module.code);
 
     return module;
 }
@@ -289,6 +290,9 @@ VkShaderStageFlagBits shader_system::getVkShaderStageFlagBits(shaderType type) c
     case shaderType::TESSELATION_EVALUATION:
         return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
         break;
+    case shaderType::COMPUTE:
+        return VK_SHADER_STAGE_COMPUTE_BIT;
+        break;
     default:
         return VK_SHADER_STAGE_ALL;
         break;
@@ -352,8 +356,7 @@ std::vector<char> shader_system::readSPIRVFile(const std::string& filename) cons
 
 bool shader_system::deleteOldShaderFile(const std::string& path)
 {
-    std::filesystem::path sourcePath(path);
-    std::filesystem::path spvPath(sourcePath.stem().string() + ".spv");
+    std::filesystem::path spvPath = getSPIRVPath(path);
 
     if(std::filesystem::exists(spvPath))
     {
@@ -366,7 +369,7 @@ bool shader_system::deleteOldShaderFile(const std::string& path)
 bool shader_system::isCompileNecessary(const std::string& path)
 {
     std::filesystem::path sourcePath(path);
-    std::filesystem::path spvPath(sourcePath.stem().string() + ".spv");
+    std::filesystem::path spvPath = getSPIRVPath(path);
 
     if(!std::filesystem::exists(spvPath))
     {
@@ -381,6 +384,57 @@ bool shader_system::isCompileNecessary(const std::string& path)
     return false;
 }
 
+void shader_system::optimizeSPIRV(std::vector<uint32_t>& code, const std::string& path) const
+{
+    spvtools::Optimizer optimizer(SPV_ENV_VULKAN_1_3);
+
+    optimizer.SetMessageConsumer([&path](spv_message_level_t level, const char*, const spv_position_t&, const char* message)
+    {
+        if(level <= SPV_MSG_ERROR)
+        {
+            std::cerr << "spirv-opt (" << path << "): " << message << std::endl;
+        }
+    });
+
+    // Specialization constants are left untouched by these passes so pipelines can still override them
+    optimizer.RegisterPerformancePasses();
+
+    std::vector<uint32_t> optimized;
+    if(!optimizer.Run(code.data(), code.size(), &optimized))
+    {
+        std::cerr << "Failed to optimize SPIR-V for file: " << path << ", using unoptimized code" << std::endl;
+        return;
+    }
+
+    code = std::move(optimized);
+}
+
+std::filesystem::path shader_system::getSPIRVPath(const std::string& path) const
+{
+    std::filesystem::path spvPath(path);
+    shaderType type = getShaderType(path);
+
+    spvPath = spvPath.parent_path();
+    spvPath /= getSettingsData(_core->getRegistry()).optimizeShaders ? optimizedShaderFileNames.at(type) : shaderFileNames.at(type);
+
+    return spvPath;
+}
+
+VkShaderModule shader_system::createVkShaderModule(const std::vector<uint32_t>& code) const
+{
+    VkShaderModuleCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    createInfo.codeSize = code.size() * sizeof(uint32_t);
+    createInfo.pCode = code.data();
+
+    VkShaderModule shaderModule;
+    if(vkCreateShaderModule(_core->getLogicalDevice(), &createInfo, nullptr, &shaderModule) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create shader module!");
+    }
+
+    return shaderModule;
+}
 
 shaderType shader_system::getShaderType(const std::string& path) const
 {
@@ -404,6 +458,10 @@ shaderType shader_system::getShaderType(const std::string& path) const
     {
         return shaderType::TESSELATION_EVALUATION;
     }
+    else if(path.find(".comp") != std::string::npos)
+    {
+        return shaderType::COMPUTE;
+    }
     else
     {
         throw std::runtime_error("Non-standard extension / unknown shader type for file: " + path);
@@ -8,6 +8,7 @@
 #include <SPIRV/GlslangToSpv.h>
 #include <SPIRV/spirv.hpp>
 
+#include <filesystem>
 #include <unordered_map>
 #include <string>
 #include <vector>
@@ -20,7 +21,8 @@ enum class shaderType
     FRAGMENT,
     GEOMETRY,
     TESSELATION_CONTROL,
-    TESSELATION_EVALUATION
+    TESSELATION_EVALUATION,
+    COMPUTE
 };
 struct shaderModule
 {
@@ -34,7 +36,7 @@ struct shaderModule
 struct shaderProgram
 {
     std::string name;
-    std::array<shaderModule, 5> shaders;
+    std::array<shaderModule, 6> shaders;
 };
 
 // For clarification, a shader is a singular shader file, while a shader program is a collection of shaders that are linked together
@@ -63,6 +65,12 @@ private:
     bool deleteOldShaderFile(const std::string& path);
     bool isCompileNecessary(const std::string& path);
 
+    // Runs the spirv-opt performance passes over the code, leaves it untouched if optimization fails
+    void optimizeSPIRV(std::vector<uint32_t>& code, const std::string& path) const;
+    // Location of the cached SPIR-V for a GLSL source file, optimized and unoptimized code are cached separately
+    std::filesystem::path getSPIRVPath(const std::string& path) const;
+    VkShaderModule createVkShaderModule(const std::vector<uint32_t>& code) const;
+
     shaderType getShaderType(const std::string& path) const;
     std::string getShaderName(const std::string& path) const;
 
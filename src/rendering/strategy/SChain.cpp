@@ -61,6 +61,11 @@ void StrategyChain::beginRenderPass()
     // Get the current frame
     _currentFrame = _core->getSwapChainSystem().getNextImageIndex();
 
+    // Residency changes happen before anything of this frame is recorded
+    _core->getTextureSystem().getStreamer().update();
+    _core->getTextureSystem().getVirtualTextures().update(_currentFrame);
+    _core->getModelMeshLibrary().update(_core->getRegistry());
+
     // Signal frame Start to imGUI
     _core->getImGUIHandler().onFrameStart();
 
@@ -70,8 +75,15 @@ void StrategyChain::beginRenderPass()
     VkFramebuffer framebuffer = _core->getSwapChainSystem().getSwapChain().Framebuffers[_currentFrame];
     VkExtent2D extent = _core->getSwapChainSystem().getSwapChain().Extent;
 
-    _core->getCommandBufferSystem().beginRecordingCommandBuffer(commandBuffer, renderPassType, framebuffer, extent);
+    _core->getCommandBufferSystem().beginCommandBuffer(commandBuffer);
+
+    // Compute work the render pass depends on
+    for(auto& node : _nodes)
+    {
+        node->runBeforeRenderPass();
+    }
 
+    _core->getCommandBufferSystem().beginRenderPass(commandBuffer, renderPassType, framebuffer, extent);
 }
 
 void StrategyChain::endRenderPass()
@@ -81,7 +93,18 @@ void StrategyChain::endRenderPass()
 
     // End the command buffer
     VkCommandBuffer commandBuffer = _core->getSwapChainSystem().getCommandBuffer(_currentFrame);
-    _core->getCommandBufferSystem().endRecordingCommandBuffer(commandBuffer);
+    _core->getCommandBufferSystem().endRenderPass(commandBuffer);
+
+    // Pages sampled this frame are read back once its fence signals
+    _core->getTextureSystem().getVirtualTextures().recordFeedbackBarrier(commandBuffer);
+
+    // Compute work that reads what the render pass wrote
+    for(auto& node : _nodes)
+    {
+        node->runAfterRenderPass();
+    }
+
+    _core->getCommandBufferSystem().endCommandBuffer(commandBuffer);
 
     std::vector<VkSemaphore> imageAvailableSemaphores;
     imageAvailableSemaphores.push_back(_core->getSwapChainSystem().getImageAvailableSemaphore(_currentFrame));
@@ -107,21 +130,7 @@ PBSShadingStrategyChain::PBSShadingStrategyChain(rendering_system* engine) : Str
 
 bool PBSShadingStrategyChain::reserveResources()
 {
-
-    auto skyboxViews = _core->getRegistry().view<Skybox>();
-
-    Skybox& skybox = skyboxViews.get<Skybox>(*skyboxViews.begin());
-
-    // Create diffuse irradiance map
-    skybox.irradianceMap = _core->getTextureSystem().bakeIrradianceDiffuseLightmap(skybox.texture, true);
-
-    // Create pre-filtered specular map
-    
-    skybox.prefilteredMap = _core->getTextureSystem().bakeIrradianceSpecularLightmap(skybox.texture, true);
-
-    // Create BRDF LUT
-    _core->getTextureSystem().bakeBRDF_LUT(true);
-    
+    // Irradiance, pre-filtered specular and BRDF LUT maps are baked along with the skybox cubemap, see createSkybox
     return true;
 }
 
@@ -6,6 +6,19 @@
 #include "rendering/resources/memory.hpp"
 
 #include "ECS/components/skybox.hpp"
+#include "ECS/components/camera.hpp"
+
+#include <algorithm>
+#include <array>
+
+namespace
+{
+    // Opaque pipeline of every vertex layout, indexed by E_VertexLayout
+    const std::array<const char*, static_cast<size_t>(E_VertexLayout::SIZE)> kOpaquePipelineNames = {"basic", "basicCompact"};
+
+    // Largest simplification error, in pixels, a level of detail may show on screen
+    const float kMaxLodScreenError = 1.0f;
+}
 
 StrategyNode::StrategyNode(const StrategyChain* chain) : _chain(chain)
 {
@@ -36,6 +49,8 @@ void RenderSkyboxNode::run()
     // Descriptor sets
     // MVP matrices
     request.descriptorSets.push_back(_chain->core()->getFrameManager().getDescriptorSet(_ds)[currentFrame]);
+    // Bindless texture heap
+    request.descriptorSets.push_back(_chain->core()->getTextureSystem().getBindlessDescriptorSet());
 
     // Push constants
     auto skyboxEntities = _chain->core()->getRegistry().view<Skybox>();
@@ -82,14 +97,6 @@ void RenderSkyboxNode::prepare()
         sampler.data = &_chain->core()->getTextureSystem().getTextureSamplerDescriptor();
         singleFrameBindings.push_back(sampler);
 
-        descriptorBindingData textureCubemap;
-        textureCubemap.binding = 2;
-        textureCubemap.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
-        textureCubemap.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-        textureCubemap.data = &_chain->core()->getTextureSystem().aggregateDescriptorTextureInfos(E_TextureType::CUBEMAP , kCubemapArraySize);
-        textureCubemap.count = kCubemapArraySize;
-        singleFrameBindings.push_back(textureCubemap);
-
         allFramesBindings.push_back(singleFrameBindings);
     }
     _ds = _chain->core()->getFrameManager().compileDescriptorSet(allFramesBindings);
@@ -102,53 +109,177 @@ RenderOpaqueNode::RenderOpaqueNode(const StrategyChain* chain) : StrategyNode(ch
     ;
 }
 
-void RenderOpaqueNode::run()
+void RenderOpaqueNode::runBeforeRenderPass()
 {
     uint32_t currentFrame = _chain->currentFrame();
-
-    // Render request struct populating
-    renderRequest request;
-    request.commandBuffer = _chain->core()->getSwapChainSystem().getCommandBuffer(currentFrame);
-    request.renderPass = E_RenderPassType::COLOR_DEPTH;
-    request.framebuffer = _chain->core()->getSwapChainSystem().getFramebuffer(currentFrame);
-    request.extent = _chain->core()->getSwapChainSystem().getSwapChain().Extent;
-    request.pipeline = _chain->core()->getPipelineSystem().getPipeline("basic");
     _chain->core()->getFrameManager().updateUniformBuffers(currentFrame);
-    request.useTextureLibraryBinds = true;
-
-    // Descriptor sets
-    request.descriptorSets.push_back(_chain->core()->getFrameManager().getDescriptorSet(_ds)[currentFrame]); 
 
     // Gather models
     auto allModelsView = _chain->core()->getRegistry().view<Model>();
 
-    // Reserve space for models and per model push constants so that pointers don't get invalidated later
-    request.models.reserve(allModelsView.size());
-    request.perModelPC.reserve(allModelsView.size());
-
-    // Gather models
+    _models.clear();
+    _models.reserve(allModelsView.size());
     for(auto& entity : allModelsView)
     {
-        request.models.push_back(_chain->core()->getRegistry().get<Model>(entity));
+        _models.push_back(_chain->core()->getRegistry().get<Model>(entity));
     }
 
-    // Push constants
-    for(int i = 0; i < request.models.size(); ++i)
+    viewMetrics view = measureView(_models);
+    requestTextureResolutions(_models, view);
+    selectLevelsOfDetail(_models, view);
+
+    // The meshes drawn at full detail are drawn from the culled index stream
+    _chain->core()->getClusterCullingSystem().cullModels(_chain->core()->getSwapChainSystem().getCommandBuffer(currentFrame), currentFrame, _models);
+}
+
+void RenderOpaqueNode::run()
+{
+    uint32_t currentFrame = _chain->currentFrame();
+    cluster_culling_system& clusterCulling = _chain->core()->getClusterCullingSystem();
+
+    // One request per vertex layout, the pipelines share their layout so the descriptor sets are bound once
+    for(size_t layout = 0; layout < kOpaquePipelineNames.size(); layout++)
     {
-        PushConstant perModel_pc;
-        perModel_pc.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-        perModel_pc.data = &request.models[i].id;
-        perModel_pc.size = sizeof(request.models[i].id);
-        perModel_pc.offset = PUSH_CONSTANT_VERTEX_OFFSET;
-        request.perModelPC.push_back(perModel_pc);
+        // Render request struct populating
+        renderRequest request;
+        request.commandBuffer = _chain->core()->getSwapChainSystem().getCommandBuffer(currentFrame);
+        request.renderPass = E_RenderPassType::COLOR_DEPTH;
+        request.framebuffer = _chain->core()->getSwapChainSystem().getFramebuffer(currentFrame);
+        request.extent = _chain->core()->getSwapChainSystem().getSwapChain().Extent;
+        request.pipeline = _chain->core()->getPipelineSystem().getPipeline(kOpaquePipelineNames[layout]);
+        request.vertexLayout = static_cast<E_VertexLayout>(layout);
+        request.useTextureLibraryBinds = true;
+        request.clusterIndexBuffer = clusterCulling.getIndexBuffer(currentFrame);
+        request.clusterDrawBuffer = clusterCulling.getDrawBuffer(currentFrame);
+
+        // Descriptor sets
+        request.descriptorSets.push_back(_chain->core()->getFrameManager().getDescriptorSet(_ds)[currentFrame]); 
+        request.descriptorSets.push_back(_chain->core()->getTextureSystem().getBindlessDescriptorSet());
+
+        // Every mesh of a model is imported in the same layout
+        for(const Model& model : _models)
+        {
+            if(!model.meshes->empty() && model.meshes->front().vertexLayout == request.vertexLayout)
+            {
+                request.models.push_back(model);
+            }
+        }
+
+        if(request.models.empty())
+        {
+            continue;
+        }
+
+        // Push constants, reserved up front so that pointers don't get invalidated later
+        request.perModelPC.reserve(request.models.size());
+        for(int i = 0; i < request.models.size(); ++i)
+        {
+            PushConstant perModel_pc;
+            perModel_pc.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+            perModel_pc.data = &request.models[i].id;
+            perModel_pc.size = sizeof(request.models[i].id);
+            perModel_pc.offset = PUSH_CONSTANT_VERTEX_OFFSET;
+            request.perModelPC.push_back(perModel_pc);
+        }
+
+        _chain->core()->getCommandBufferSystem().recordCommandBuffer(request);
     }
+}
 
-    _chain->core()->getCommandBufferSystem().recordCommandBuffer(request);
+void RenderOpaqueNode::runAfterRenderPass()
+{
+    // Next frame's occlusion culling tests against this frame's depth
+    _chain->core()->getClusterCullingSystem().buildDepthPyramid(_chain->core()->getSwapChainSystem().getCommandBuffer(_chain->currentFrame()), _chain->currentFrame());
+}
+
+RenderOpaqueNode::viewMetrics RenderOpaqueNode::measureView(const std::vector<Model>& models) const
+{
+    entt::registry& registry = _chain->core()->getRegistry();
+    entt::entity camera = _chain->core()->getScene()->getActiveCamera();
+
+    viewMetrics view;
+    view.cameraPosition = registry.get<position>(camera).value;
+    view.pixelsPerUnit = registry.get<MVPMatrix>(camera).projection[1][1] * 0.5f * _chain->core()->getSwapChainSystem().getSwapChain().Extent.height;
+
+    view.modelScales.reserve(models.size());
+    for(const Model& model : models)
+    {
+        view.modelScales.push_back(std::max({glm::length(glm::vec3(model.modelMatrix[0])), glm::length(glm::vec3(model.modelMatrix[1])), glm::length(glm::vec3(model.modelMatrix[2]))}));
+    }
+    return view;
+}
+
+void RenderOpaqueNode::requestTextureResolutions(const std::vector<Model>& models, const viewMetrics& view) const
+{
+    texture_streamer& streamer = _chain->core()->getTextureSystem().getStreamer();
+
+    for(size_t m = 0; m < models.size(); m++)
+    {
+        const Model& model = models[m];
+        float scale = view.modelScales[m];
+
+        for(const Mesh& mesh : *model.meshes)
+        {
+            glm::vec3 center = glm::vec3(model.modelMatrix * glm::vec4(mesh.boundsCenter, 1.0f));
+            float radius = mesh.boundsRadius * scale;
+            float distance = std::max(glm::length(center - view.cameraPosition) - radius, 0.1f);
+
+            // Assumes the UVs span the mesh once, good enough to pick a mip level
+            float screenPixels = 2.0f * radius * view.pixelsPerUnit / distance;
+
+            for(unsigned int id : mesh.textureIndices)
+            {
+                streamer.requestResolution(id, screenPixels);
+            }
+        }
+    }
+}
+
+void RenderOpaqueNode::selectLevelsOfDetail(std::vector<Model>& models, const viewMetrics& view)
+{
+    _lodStats = lodStats();
+
+    for(size_t m = 0; m < models.size(); m++)
+    {
+        Model& model = models[m];
+        float scale = view.modelScales[m];
+
+        model.meshLods.assign(model.meshes->size(), 0);
+
+        for(size_t i = 0; i < model.meshes->size(); i++)
+        {
+            const Mesh& mesh = (*model.meshes)[i];
+            if(mesh.lods.empty())
+            {
+                _lodStats.trianglesRendered += mesh.indexCount / 3;
+                _lodStats.trianglesAvailable += mesh.indexCount / 3;
+                continue;
+            }
+
+            glm::vec3 center = glm::vec3(model.modelMatrix * glm::vec4(mesh.boundsCenter, 1.0f));
+            float distance = std::max(glm::length(center - view.cameraPosition) - mesh.boundsRadius * scale, 0.1f);
+            float pixelsPerModelUnit = scale * view.pixelsPerUnit / distance;
+
+            // The errors grow with the level, stop at the first one that would show
+            uint8_t level = 0;
+            while(level + 1u < mesh.lods.size() && mesh.lods[level + 1].error * pixelsPerModelUnit <= kMaxLodScreenError)
+            {
+                level++;
+            }
+
+            model.meshLods[i] = level;
+            _lodStats.trianglesRendered += mesh.lods[level].indexCount / 3;
+            _lodStats.trianglesAvailable += mesh.lods[0].indexCount / 3;
+        }
+    }
 }
 
 void RenderOpaqueNode::prepare()
 {
-   _chain->core()->getPipelineSystem().createPipeline("basic");
+    for(size_t layout = 0; layout < kOpaquePipelineNames.size(); layout++)
+    {
+        _chain->core()->getPipelineSystem().createPipeline("basic", E_RenderPassType::COLOR_DEPTH, {}, kOpaquePipelineNames[layout], static_cast<E_VertexLayout>(layout));
+    }
 
     unsigned int framesinFlight = getSettingsData(_chain->core()->getScene()->getRegistry()).framesInFlight;
 
@@ -179,13 +310,29 @@ void RenderOpaqueNode::prepare()
         sampler.data = &_chain->core()->getTextureSystem().getTextureSamplerDescriptor();
         singleFrameBindings.push_back(sampler);
 
-        descriptorBindingData textureDiffuse;
-        textureDiffuse.binding = 3;
-        textureDiffuse.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
-        textureDiffuse.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-        textureDiffuse.data = &_chain->core()->getTextureSystem().aggregateDescriptorTextureInfos(E_TextureType::DIFFUSE , kTextureArraySize);
-        textureDiffuse.count = kTextureArraySize;
-        singleFrameBindings.push_back(textureDiffuse);
+        // Virtual textures, the page table is shared and every frame in flight writes its own feedback
+        virtual_texture_system& virtualTextures = _chain->core()->getTextureSystem().getVirtualTextures();
+
+        descriptorBindingData virtualTextureInfo;
+        virtualTextureInfo.binding = 3;
+        virtualTextureInfo.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        virtualTextureInfo.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+        virtualTextureInfo.data = &virtualTextures.getInfoDescriptor();
+        singleFrameBindings.push_back(virtualTextureInfo);
+
+        descriptorBindingData pageTable;
+        pageTable.binding = 4;
+        pageTable.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        pageTable.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+        pageTable.data = &virtualTextures.getPageTableDescriptor();
+        singleFrameBindings.push_back(pageTable);
+
+        descriptorBindingData feedback;
+        feedback.binding = 5;
+        feedback.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        feedback.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+        feedback.data = &virtualTextures.getFeedbackDescriptor(static_cast<uint32_t>(i));
+        singleFrameBindings.push_back(feedback);
 
         allFramesBindings.push_back(singleFrameBindings);
     }
@@ -2,6 +2,10 @@
 
 #include <boost/uuid/uuid.hpp>  // UUID's for descriptor sets
 
+#include <vector>
+
+#include "rendering/resources/model.hpp"
+
 class StrategyChain;
 
 class StrategyNode
@@ -10,6 +14,9 @@ public:
     StrategyNode(const StrategyChain* chain);
     virtual void run() = 0;
     virtual void prepare() {};
+    // Recorded into the frame's command buffer outside of the render pass
+    virtual void runBeforeRenderPass() {};
+    virtual void runAfterRenderPass() {};
 protected:
     const StrategyChain* _chain;
 };
@@ -29,10 +36,37 @@ class RenderOpaqueNode : public StrategyNode
 {
 public:
     RenderOpaqueNode(const StrategyChain* chain);
+    void runBeforeRenderPass() override;
     void run() override;
+    void runAfterRenderPass() override;
     void prepare() override;
+
+    // Triangles of the last frame, drawn at the picked levels of detail and at full detail
+    struct lodStats
+    {
+        size_t trianglesRendered = 0;
+        size_t trianglesAvailable = 0;
+    };
+    const lodStats& getLodStats() const { return _lodStats; }
+
 private:
+    // Camera terms shared by the screen size estimates of a frame
+    struct viewMetrics
+    {
+        glm::vec3 cameraPosition;
+        float pixelsPerUnit; // Pixels covered by one world unit at distance 1
+        std::vector<float> modelScales; // Largest axis scale of every model, in the order of the models
+    };
+    viewMetrics measureView(const std::vector<Model>& models) const;
+
+    // Texture streaming feedback from the projected size of every mesh
+    void requestTextureResolutions(const std::vector<Model>& models, const viewMetrics& view) const;
+    // Coarsest level of detail of every mesh whose error projects to less than kMaxLodScreenError pixels
+    void selectLevelsOfDetail(std::vector<Model>& models, const viewMetrics& view);
+
     boost::uuids::uuid _ds; // One descriptor set per frame in flight
+    lodStats _lodStats;
+    std::vector<Model> _models; // Models of the frame being recorded, with their levels of detail and cluster draws
 };
 
 class renderGUIOnFrameStartNode : public StrategyNode
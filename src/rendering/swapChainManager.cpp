@@ -21,6 +21,9 @@ uint32_t swap_chain_system::getNextImageIndex()
     // Reset the signalled fence
     vkResetFences(_core->getLogicalDevice(), 1, &_swapChain.inFlightFences[_swapChain.currentFrame]);
 
+    // The GPU is done with this frame, its transient descriptor sets can be recycled
+    _core->getFrameManager().resetTransientDescriptors(_swapChain.currentFrame);
+
     // Aquire the next image from the swap chain extension
     VkResult result = vkAcquireNextImageKHR(
         _core->getLogicalDevice(),
@@ -158,7 +161,14 @@ void swap_chain_system::createDepthResources()
 {
     VkFormat depthFormat = findDepthFormat(_core->getPhysicalDevice());
 
-    _swapChain.depthImage = _core->getTextureSystem().createImage(_swapChain.Extent.width, _swapChain.Extent.height, 1, depthFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    // The cluster culling pass builds its depth pyramid from the depth buffer
+    VkImageUsageFlags usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+    if(canSampleDepthFormat(_core->getPhysicalDevice()))
+    {
+        usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
+    }
+
+    _swapChain.depthImage = _core->getTextureSystem().createImage(_swapChain.Extent.width, _swapChain.Extent.height, 1, depthFormat, VK_IMAGE_TILING_OPTIMAL, usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
     _swapChain.depthImage.imageView = _core->getTextureSystem().createImageView(_swapChain.depthImage.image, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT, 0,1, VK_IMAGE_VIEW_TYPE_2D);
 
@@ -5,13 +5,115 @@
 #include "helpers/RootDir.hpp"
 
 #include "util/VertexShapes.hpp"
+#include "util/blockCompression.hpp"
+#include "util/halfFloat.hpp"
+#include "util/hash.hpp"
 #include "ECS/components/spatial.hpp"
 
+#include <algorithm>
 #include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+    // Importance sampling counts baked into the IBL pipelines as specialization constants
+    const uint32_t kSpecularIrradianceSampleCount = 4096;
+    const uint32_t kBRDFLUTSampleCount = 1024;
+
+    // HDR sources and the environment bakes rendered from them, renderable and filterable everywhere
+    const VkFormat kHDRFormat = VK_FORMAT_R16G16B16A16_SFLOAT;
+    // Baked environment maps are only ever sampled again, the disk cache keeps them shared exponent when the device can sample that
+    const VkFormat kHDRSampledFormat = VK_FORMAT_E5B9G9R9_UFLOAT_PACK32;
+
+    // IBL bake outputs, the LUT is R8G8B8A8_SRGB and the cubemaps kHDRFormat
+    const uint32_t kCubemapSize = 2048;
+    const uint32_t kIrradianceDiffuseSize = 256;
+    const uint32_t kIrradianceSpecularSize = 1024;
+    const uint32_t kIrradianceSpecularMips = 5;         // roughness levels past the base one
+    const uint32_t kBRDFLUTSize = 512;
+
+    // Baked maps are cached on disk, bump the version whenever a bake shader changes its output
+    const uint32_t kBakeCacheVersion = 2;
+    const int kBakeCacheZstdLevel = 3;
+
+    // Timestamp pairs per bake submission: cubemap, both lightmaps and the LUT
+    const uint32_t kBakeMaxStages = 4;
+
+    // Limits of res/shaders/spd: 64x64 texel tiles and at most 64x64 of them, mips 1 to 12 as storage images
+    const uint32_t kSPDTileSize = 64;
+    const uint32_t kSPDMaxExtent = 4096;
+    const uint32_t kSPDMaxMips = 12;
+    // Counter plus one mip 6 texel per workgroup, see the Scratch block of the shader
+    const VkDeviceSize kSPDScratchSize = 16 + 16 * (kSPDMaxExtent / kSPDTileSize) * (kSPDMaxExtent / kSPDTileSize);
+
+    struct spdPushConstants
+    {
+        uint32_t width;
+        uint32_t height;
+        uint32_t mipCount;
+        uint32_t workGroupsX;
+        uint32_t workGroupCount;
+        uint32_t isSRGB;
+    };
+
+    // Half float levels to shared exponent, alpha is dropped
+    ktx2Texture packSharedExponent(const ktx2Texture& texture)
+    {
+        ktx2Texture packed;
+        packed.format = VK_FORMAT_E5B9G9R9_UFLOAT_PACK32;
+        packed.width = texture.width;
+        packed.height = texture.height;
+        packed.faces = texture.faces;
+
+        std::vector<uint16_t> halves;
+        std::vector<float> floats;
+        for(size_t level = 0; level < texture.levels.size(); level++)
+        {
+            size_t texels = texture.levels[level].uncompressedSize / (4 * sizeof(uint16_t));
+
+            halves.resize(texels * 4);
+            floats.resize(texels * 4);
+            ktx2::copyLevel(texture, level, halves.data());
+            halfFloat::toFloats(halves.data(), floats.data(), floats.size());
+
+            uint64_t offset = packed.data.size();
+            packed.data.resize(offset + texels * sizeof(uint32_t));
+            halfFloat::packE5B9G9R9(floats.data(), reinterpret_cast<uint32_t*>(packed.data.data() + offset), texels);
+            packed.levels.push_back({offset, texels * sizeof(uint32_t), texels * sizeof(uint32_t)});
+        }
+
+        return packed;
+    }
+
+    bool isSRGBFormat(VkFormat format)
+    {
+        return format == VK_FORMAT_R8G8B8A8_SRGB || format == VK_FORMAT_B8G8R8A8_SRGB;
+    }
+
+    // sRGB formats can't be storage images, the shader writes through a UNORM view and encodes itself
+    VkFormat getStorageFormat(VkFormat format)
+    {
+        switch(format)
+        {
+            case VK_FORMAT_R8G8B8A8_SRGB:
+                return VK_FORMAT_R8G8B8A8_UNORM;
+            case VK_FORMAT_B8G8R8A8_SRGB:
+                return VK_FORMAT_B8G8R8A8_UNORM;
+            default:
+                return format;
+        }
+    }
+}
 
 texture_system::texture_system(rendering_system* rendering) :
     _core(rendering),
-    _mipLevels(1)
+    _mipLevels(1),
+    _streamer(rendering),
+    _virtualTextures(rendering)
 {
     ;
 }
@@ -19,8 +121,27 @@ texture_system::texture_system(rendering_system* rendering) :
 void texture_system::init()
 {
     initTextureSampler();
+    initBindlessHeap();
+    initMipMapGeneration();
+    _streamer.init();
+    _virtualTextures.init();
+
+    // Slot 0 of the 2D heap, meshes without a texture point at it
     createTexture(ROOT_DIR + std::string("/res/missingTexture.png"),E_TextureType::DIFFUSE , true);
-    createTexture(ROOT_DIR + std::string("/res/missingTexture.png"),E_TextureType::CUBEMAP , true);
+}
+
+void texture_system::initBindlessHeap()
+{
+    // The heap starts empty, partially bound arrays don't need placeholder padding
+    bool success = _core->getFrameManager().getReadyDescriptorBuilder()
+        .reserveImageArray(kBindlessTexture2DBinding, kTextureArraySize, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_SHADER_STAGE_ALL)
+        .reserveImageArray(kBindlessTextureCubeBinding, kCubemapArraySize, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_SHADER_STAGE_ALL)
+        .buildBindless(_bindlessDescriptorSet, _bindlessDescriptorLayout);
+
+    if(!success)
+    {
+        throw std::runtime_error("Failed to allocate the bindless texture heap");
+    }
 }
 
 void texture_system::initTextureSampler()
@@ -75,6 +196,7 @@ image texture_system::createImage(uint32_t width, uint32_t height, uint32_t mipL
     img.width = width;
     img.height = height;
     img.mipLevels = mipLevels;
+    img.format = format;
 
     img.layout = VK_IMAGE_LAYOUT_UNDEFINED;
 
@@ -109,6 +231,12 @@ image texture_system::createImage(uint32_t width, uint32_t height, uint32_t mipL
     imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
     imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
+    // Storage writes to sRGB images go through a UNORM view
+    if((usage & VK_IMAGE_USAGE_STORAGE_BIT) && isSRGBFormat(format))
+    {
+        imageInfo.flags |= VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT | VK_IMAGE_CREATE_EXTENDED_USAGE_BIT;
+    }
+
     // Create the image
     if(vkCreateImage(_core->getLogicalDevice(), &imageInfo, nullptr, &img.image) != VK_SUCCESS)
     {
@@ -141,11 +269,17 @@ image texture_system::createTexture(const std::string& path, E_TextureType type,
 {
     image img;
 
+    // Offline compressed textures, see tools/textureCompressor
+    if(ktx2::isKTX2File(path))
+    {
+        return createTexture(ktx2::load(path), type, addToCache);
+    }
+
     // check if the image ends with .hdr
     if(path.substr(path.find_last_of(".") + 1) == "hdr")
     {
         loadedImageDataHDR imgData = STB_load_image_HDR(path);
-        img = createTexture(imgData, VK_FORMAT_R32G32B32A32_SFLOAT, type, addToCache);
+        img = createTexture(imgData, kHDRFormat, type, addToCache);
     }
     else
     {
@@ -181,14 +315,11 @@ image texture_system::createTexture(const loadedImageDataRGB imgData, VkFormat f
 
     free_image(imgData.data);
 
-    img = createImage(imgData.width, imgData.height, img.mipLevels, format, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    img = createImage(imgData.width, imgData.height, img.mipLevels, format, VK_IMAGE_TILING_OPTIMAL, getMipMapUsage(format, imgData.width, imgData.height) | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
     transitionImageLayout(img, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
     copyBufferToImage(stagingBuffer.buffer, img.image, static_cast<uint32_t>(imgData.width), static_cast<uint32_t>(imgData.height));
-    if(img.mipLevels > 1)
-    {
-        generateMipMaps(img.image, format, imgData.width, imgData.height, img.mipLevels);
-    }
+    generateMipMaps(img, format);
 
     _core->getMemorySystem().freeBuffer(stagingBuffer);
 
@@ -219,8 +350,14 @@ image texture_system::createTexture(const loadedImageDataHDR imgData, VkFormat f
         throw std::runtime_error("Image data is null");
     }
 
-    // Calculate memory size of the image, 4 bytes per pixel
-    VkDeviceSize imageSize = imgData.width * imgData.height * 4 * sizeof(float);
+    if(format != VK_FORMAT_R32G32B32A32_SFLOAT && format != VK_FORMAT_R16G16B16A16_SFLOAT)
+    {
+        throw std::runtime_error("HDR images upload as 32 or 16 bit floats");
+    }
+
+    // Calculate memory size of the image, 4 channels per pixel
+    size_t channelCount = static_cast<size_t>(imgData.width) * imgData.height * 4;
+    VkDeviceSize imageSize = channelCount * (format == VK_FORMAT_R16G16B16A16_SFLOAT ? sizeof(uint16_t) : sizeof(float));
 
     // Calculate the number of mip levels based on the image dimensions
     img.mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(imgData.width, imgData.height)))) + 1;
@@ -229,28 +366,56 @@ image texture_system::createTexture(const loadedImageDataHDR imgData, VkFormat f
 
     void* data;
     vkMapMemory(_core->getLogicalDevice(), stagingBuffer.memory, 0, imageSize, 0, &data);
-    memcpy(data, imgData.data, static_cast<size_t>(imageSize));
+    // Half floats are converted straight into staging memory
+    if(format == VK_FORMAT_R16G16B16A16_SFLOAT)
+    {
+        halfFloat::fromFloats(imgData.data, static_cast<uint16_t*>(data), channelCount);
+    }
+    else
+    {
+        memcpy(data, imgData.data, static_cast<size_t>(imageSize));
+    }
     vkUnmapMemory(_core->getLogicalDevice(), stagingBuffer.memory);
 
     free_image(imgData.data);
 
-    img = createImage(imgData.width, imgData.height, img.mipLevels, format, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    img = createImage(imgData.width, imgData.height, img.mipLevels, format, VK_IMAGE_TILING_OPTIMAL, getMipMapUsage(format, imgData.width, imgData.height) | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
     transitionImageLayout(img, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
     copyBufferToImage(stagingBuffer.buffer, img.image, static_cast<uint32_t>(imgData.width), static_cast<uint32_t>(imgData.height));
-    if(img.mipLevels > 1)
+    generateMipMaps(img, format);
+
+    _core->getMemorySystem().freeBuffer(stagingBuffer);
+
+    // Populate the image view
+    createTextureImageView(img, format, type);
+
+    // Populate the descriptor image info
+    img.descriptor.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    img.descriptor.imageView = img.imageView;
+    img.descriptor.sampler = _textureSampler;
+
+    // Add to _textures
+    if(addToCache)
     {
-        generateMipMaps(img.image, format, imgData.width, imgData.height, img.mipLevels);
+        addTextureToCache(type, img);
     }
-    else
+
+    return img;
+}
+
+image texture_system::createTexture(const ktx2Texture& texture, E_TextureType type, bool addToCache)
+{
+    bool isCubeMap = texture.faces == 6;
+    if(isCubeMap)
     {
-        transitionImageLayout(img, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        type = E_TextureType::CUBEMAP;
     }
 
-    _core->getMemorySystem().freeBuffer(stagingBuffer);
+    image img = uploadTextureLevels(texture, 0);
 
     // Populate the image view
-    createTextureImageView(img, format, type);
+    createTextureImageView(img, texture.format, type);
 
     // Populate the descriptor image info
     img.descriptor.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
@@ -266,11 +431,330 @@ image texture_system::createTexture(const loadedImageDataHDR imgData, VkFormat f
     return img;
 }
 
-image texture_system::bakeCubemap(const std::string& filePath, bool addToCache)
+image texture_system::uploadTextureLevels(const ktx2Texture& texture, uint32_t firstLevel)
+{
+    if(firstLevel >= texture.levels.size())
+    {
+        throw std::runtime_error("Texture has no mip levels");
+    }
+
+    // Compressed formats can't be blitted, so every mip level comes from the file
+    VkFormatProperties formatProperties;
+    vkGetPhysicalDeviceFormatProperties(_core->getPhysicalDevice(), texture.format, &formatProperties);
+
+    if(!(formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT))
+    {
+        throw std::runtime_error("Texture format is not supported by the device");
+    }
+
+    bool isCubeMap = texture.faces == 6;
+
+    // Every level goes into one staging buffer, offsets respect the texel block alignment
+    VkDeviceSize alignment = std::max<VkDeviceSize>(ktx2::getFormatBlockBytes(texture.format), 4);
+    std::vector<VkDeviceSize> stagingOffsets;
+    VkDeviceSize stagingSize = 0;
+    for(size_t level = firstLevel; level < texture.levels.size(); level++)
+    {
+        stagingSize = (stagingSize + alignment - 1) / alignment * alignment;
+        stagingOffsets.push_back(stagingSize);
+        stagingSize += texture.levels[level].uncompressedSize;
+    }
+
+    memoryBuffer stagingBuffer = _core->getMemorySystem().createBuffer(stagingSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+    void* data;
+    vkMapMemory(_core->getLogicalDevice(), stagingBuffer.memory, 0, stagingSize, 0, &data);
+    // Levels go straight from the file mapping into staging memory
+    for(size_t level = firstLevel; level < texture.levels.size(); level++)
+    {
+        ktx2::copyLevel(texture, level, static_cast<uint8_t*>(data) + stagingOffsets[level - firstLevel]);
+    }
+    vkUnmapMemory(_core->getLogicalDevice(), stagingBuffer.memory);
+
+    // Level firstLevel of the file is level 0 of the image
+    uint32_t mipLevels = static_cast<uint32_t>(texture.levels.size()) - firstLevel;
+    uint32_t width = std::max(texture.width >> firstLevel, 1u);
+    uint32_t height = std::max(texture.height >> firstLevel, 1u);
+    image img = createImage(width, height, mipLevels, texture.format, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, isCubeMap);
+
+    // One region per level, faces of a level are tightly packed one after the other
+    std::vector<VkBufferImageCopy> regions;
+    for(uint32_t level = 0; level < mipLevels; level++)
+    {
+        VkBufferImageCopy region = {};
+        region.bufferOffset = stagingOffsets[level];
+        region.bufferRowLength = 0;
+        region.bufferImageHeight = 0;
+
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = level;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = texture.faces;
+
+        region.imageOffset = {0, 0, 0};
+        region.imageExtent = {std::max(width >> level, 1u), std::max(height >> level, 1u), 1};
+
+        regions.push_back(region);
+    }
+
+    transitionImageLayout(img, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+
+    VkCommandBuffer commandBuffer = _core->getCommandBufferSystem().beginSingleTimeCommands();
+    vkCmdCopyBufferToImage(commandBuffer, stagingBuffer.buffer, img.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(regions.size()), regions.data());
+    _core->getCommandBufferSystem().endSingleTimeCommands(commandBuffer);
+
+    transitionImageLayout(img, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+    _core->getMemorySystem().freeBuffer(stagingBuffer);
+
+    return img;
+}
+
+uint32_t texture_system::reserveTexture(E_TextureType type)
 {
-    image img = createTexture(filePath, E_TextureType::DIFFUSE, false);
+    uint32_t slot = allocateBindlessSlot(type);
+
+    // Point the slot at the missing texture so it is safe to sample before the upload lands
+    if(type != E_TextureType::CUBEMAP && !_textures[E_TextureType::DIFFUSE]->empty())
+    {
+        image placeholder = _textures[E_TextureType::DIFFUSE]->front();
+        placeholder.type = type;
+        placeholder.id = slot;
+        writeBindlessSlot(placeholder);
+    }
+
+    return slot;
+}
+
+void texture_system::createTextures(std::vector<pendingTexture>& batch)
+{
+    if(batch.empty())
+    {
+        return;
+    }
+
+    // 1 - Pack every image into one staging buffer
+    std::vector<VkDeviceSize> stagingOffsets;
+    VkDeviceSize stagingSize = 0;
+    for(const pendingTexture& texture : batch)
+    {
+        if(texture.imgData.data == nullptr)
+        {
+            throw std::runtime_error("Image data is null");
+        }
+
+        stagingOffsets.push_back(stagingSize);
+        stagingSize += static_cast<VkDeviceSize>(texture.imgData.width) * texture.imgData.height * 4;
+    }
+
+    memoryBuffer stagingBuffer = _core->getMemorySystem().createBuffer(stagingSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+    void* data;
+    vkMapMemory(_core->getLogicalDevice(), stagingBuffer.memory, 0, stagingSize, 0, &data);
+    for(size_t i = 0; i < batch.size(); i++)
+    {
+        const loadedImageDataRGB& imgData = batch[i].imgData;
+        memcpy(static_cast<uint8_t*>(data) + stagingOffsets[i], imgData.data, static_cast<size_t>(imgData.width) * imgData.height * 4);
+        free_image(imgData.data);
+        batch[i].imgData.data = nullptr;
+    }
+    vkUnmapMemory(_core->getLogicalDevice(), stagingBuffer.memory);
+
+    // 2 - Record every copy and mip chain into a single command buffer
+    std::vector<image> images;
+    VkCommandBuffer commandBuffer = _core->getCommandBufferSystem().beginSingleTimeCommands();
+
+    for(size_t i = 0; i < batch.size(); i++)
+    {
+        const pendingTexture& texture = batch[i];
+        uint32_t width = static_cast<uint32_t>(texture.imgData.width);
+        uint32_t height = static_cast<uint32_t>(texture.imgData.height);
+        uint32_t mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(width, height)))) + 1;
+
+        image img = createImage(width, height, mipLevels, texture.format, VK_IMAGE_TILING_OPTIMAL, getMipMapUsage(texture.format, width, height) | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+        VkImageMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = img.image;
+        barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, mipLevels, 0, 1};
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        VkBufferImageCopy region = {};
+        region.bufferOffset = stagingOffsets[i];
+        region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+        region.imageOffset = {0, 0, 0};
+        region.imageExtent = {width, height, 1};
+
+        vkCmdCopyBufferToImage(commandBuffer, stagingBuffer.buffer, img.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+        img.layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        images.push_back(img);
+    }
+
+    // Every mip chain of the batch is generated in the same submission
+    std::vector<image*> mipMapped;
+    for(image& img : images)
+    {
+        mipMapped.push_back(&img);
+    }
+    mipGenerationBatch mipBatch = recordMipMaps(commandBuffer, mipMapped);
+
+    _core->getCommandBufferSystem().endSingleTimeCommands(commandBuffer);
+    _core->getMemorySystem().freeBuffer(stagingBuffer);
+    releaseMipGenerationBatch(mipBatch);
+
+    // 3 - Views and heap slots, the reserved slots switch from the placeholder to the real texture
+    for(size_t i = 0; i < batch.size(); i++)
+    {
+        image& img = images[i];
+        createTextureImageView(img, batch[i].format);
+
+        img.descriptor.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        img.descriptor.imageView = img.imageView;
+        img.descriptor.sampler = _textureSampler;
+
+        addTextureToCache(batch[i].type, img, batch[i].id);
+    }
+}
+
+environmentMaps texture_system::bakeEnvironment(const std::string& filePath, uint64_t cacheKey, bool addToCache, bool bakeLighting)
+{
+    environmentMaps maps;
+
+    // 0 - Whatever the disk cache or the source file already holds is not baked again
+    std::string cubemapPath = getBakeCachePath(cacheKey, "cubemap", {kBakeCacheVersion, kCubemapSize, 1, 0, kHDRFormat});
+    std::string diffusePath = getBakeCachePath(cacheKey, "irradianceDiffuse", {kBakeCacheVersion, kIrradianceDiffuseSize, 1, 0, kHDRFormat});
+    std::string specularPath = getBakeCachePath(cacheKey, "irradianceSpecular", {kBakeCacheVersion, kIrradianceSpecularSize, kIrradianceSpecularMips, kSpecularIrradianceSampleCount, kHDRFormat});
+    std::string brdfLUTPath = getBakeCachePath(hash::xxHash64(std::string("brdfLUT")), "brdfLUT", {kBakeCacheVersion, kBRDFLUTSize, 1, kBRDFLUTSampleCount, VK_FORMAT_R8G8B8A8_SRGB});
 
-    return bakeCubemapFromFlat(img, addToCache);
+    ktx2Texture texture;
+    bool bakeCubemap = true;
+    if(ktx2::isKTX2File(filePath))
+    {
+        texture = ktx2::load(filePath);
+        if(texture.faces == 6)
+        {
+            maps.cubemap = createTexture(texture, E_TextureType::CUBEMAP, false);
+            bakeCubemap = false;
+        }
+    }
+    if(bakeCubemap && loadBakedTexture(cubemapPath, E_TextureType::CUBEMAP, false, maps.cubemap))
+    {
+        bakeCubemap = false;
+    }
+
+    bool bakeDiffuse = bakeLighting && !loadBakedTexture(diffusePath, E_TextureType::CUBEMAP, false, maps.irradianceMap);
+    bool bakeSpecular = bakeLighting && !loadBakedTexture(specularPath, E_TextureType::CUBEMAP, false, maps.prefilteredMap);
+    bool bakeLUT = bakeLighting && !loadBakedTexture(ROOT_DIR + std::string("/res/brdfLUT.ktx2"), E_TextureType::DIFFUSE, false, maps.brdfLUT) &&
+                   !loadBakedTexture(brdfLUTPath, E_TextureType::DIFFUSE, false, maps.brdfLUT);
+
+    // 1 - Everything left goes into one command buffer
+    if(bakeCubemap || bakeDiffuse || bakeSpecular || bakeLUT)
+    {
+        bakeBatch batch = beginBake();
+
+        // The LUT depends on nothing, it overlaps with the cubemap
+        if(bakeLUT)
+        {
+            maps.brdfLUT = recordBRDF_LUT(batch);
+        }
+
+        if(bakeCubemap)
+        {
+            image flatImg = texture.levels.empty() ? createTexture(filePath, E_TextureType::DIFFUSE, false) : createTexture(texture, E_TextureType::DIFFUSE, false);
+            batch.sources.push_back(flatImg);
+
+            maps.cubemap = recordCubemap(batch, flatImg);
+            // Both lightmaps sample the cubemap, the only dependency in the graph
+            recordBakeBarrier(batch, maps.cubemap);
+        }
+
+        // Diffuse and specular only read the cubemap, nothing orders them against each other
+        if(bakeDiffuse)
+        {
+            maps.irradianceMap = recordIrradianceDiffuse(batch, maps.cubemap);
+        }
+        if(bakeSpecular)
+        {
+            maps.prefilteredMap = recordIrradianceSpecular(batch, maps.cubemap);
+        }
+
+        submitBake(batch);
+    }
+
+    // 2 - Heap slots in the usual order, cubemaps first
+    if(addToCache)
+    {
+        addTextureToCache(E_TextureType::CUBEMAP, maps.cubemap);
+        if(bakeLighting)
+        {
+            addTextureToCache(E_TextureType::CUBEMAP, maps.irradianceMap);
+            addTextureToCache(E_TextureType::CUBEMAP, maps.prefilteredMap);
+            addTextureToCache(E_TextureType::DIFFUSE, maps.brdfLUT);
+        }
+    }
+
+    // 3 - Fresh bakes go to the disk cache for the next run
+    if(bakeCubemap)
+    {
+        storeBakedTexture(cubemapPath, maps.cubemap);
+    }
+    if(bakeDiffuse)
+    {
+        storeBakedTexture(diffusePath, maps.irradianceMap);
+    }
+    if(bakeSpecular)
+    {
+        storeBakedTexture(specularPath, maps.prefilteredMap);
+    }
+    if(bakeLUT)
+    {
+        storeBakedTexture(brdfLUTPath, maps.brdfLUT);
+    }
+
+    return maps;
+}
+
+image texture_system::bakeCubemap(const std::string& filePath, bool addToCache, uint64_t cacheKey)
+{
+    // Cubemap files are ready to use as they are
+    ktx2Texture texture;
+    if(ktx2::isKTX2File(filePath))
+    {
+        texture = ktx2::load(filePath);
+        if(texture.faces == 6)
+        {
+            return createTexture(texture, E_TextureType::CUBEMAP, addToCache);
+        }
+    }
+
+    // A previous run already converted this source
+    std::string cachePath = getBakeCachePath(cacheKey, "cubemap", {kBakeCacheVersion, kCubemapSize, 1, 0, kHDRFormat});
+    image img;
+    if(loadBakedTexture(cachePath, E_TextureType::CUBEMAP, addToCache, img))
+    {
+        return img;
+    }
+
+    if(texture.levels.empty())
+    {
+        img = bakeCubemapFromFlat(createTexture(filePath, E_TextureType::DIFFUSE, false), addToCache);
+    }
+    else
+    {
+        img = bakeCubemapFromFlat(createTexture(texture, E_TextureType::DIFFUSE, false), addToCache);
+    }
+
+    storeBakedTexture(cachePath, img);
+
+    return img;
 }
 
 image texture_system::bakeCubemapFromFlat(image flatImg, bool addToCache)
@@ -281,14 +765,243 @@ image texture_system::bakeCubemapFromFlat(image flatImg, bool addToCache)
         throw std::runtime_error("Image is not valid");
     }
 
+    bakeBatch batch = beginBake();
+    batch.sources.push_back(flatImg);
+
+    image img = recordCubemap(batch, flatImg);
+
+    submitBake(batch);
+
+    if(addToCache)
+    {
+        addTextureToCache(E_TextureType::CUBEMAP, img);
+    }
+
+    return img;
+}
+
+image texture_system::bakeIrradianceDiffuseLightmap(image img, bool addToCache, uint64_t cacheKey)
+{
+    // 0 - Check if the image is valid
+    if(img.image == VK_NULL_HANDLE)
+    {
+        throw std::runtime_error("Image is not valid");
+    }
+
+    std::string cachePath = getBakeCachePath(cacheKey, "irradianceDiffuse", {kBakeCacheVersion, kIrradianceDiffuseSize, 1, 0, kHDRFormat});
+    image lightmap;
+    if(loadBakedTexture(cachePath, E_TextureType::CUBEMAP, addToCache, lightmap))
+    {
+        return lightmap;
+    }
+
+    bakeBatch batch = beginBake();
+    lightmap = recordIrradianceDiffuse(batch, img);
+    submitBake(batch);
+
+    if(addToCache)
+    {
+        addTextureToCache(E_TextureType::CUBEMAP, lightmap);
+    }
+
+    storeBakedTexture(cachePath, lightmap);
+
+    return lightmap;
+}
+
+image texture_system::bakeIrradianceSpecularLightmap(image img, bool addToCache, uint64_t cacheKey)
+{
+    // 0 - Check if the image is valid
+    if(img.image == VK_NULL_HANDLE)
+    {
+        throw std::runtime_error("Image is not valid");
+    }
+
+    std::string cachePath = getBakeCachePath(cacheKey, "irradianceSpecular", {kBakeCacheVersion, kIrradianceSpecularSize, kIrradianceSpecularMips, kSpecularIrradianceSampleCount, kHDRFormat});
+    image lightMap;
+    if(loadBakedTexture(cachePath, E_TextureType::CUBEMAP, addToCache, lightMap))
+    {
+        return lightMap;
+    }
+
+    bakeBatch batch = beginBake();
+    lightMap = recordIrradianceSpecular(batch, img);
+    submitBake(batch);
+
+    if(addToCache)
+    {
+        addTextureToCache(E_TextureType::CUBEMAP, lightMap);
+    }
+
+    storeBakedTexture(cachePath, lightMap);
+
+    return lightMap;
+}
+
+image texture_system::bakeBRDF_LUT(bool addToCache)
+{
+    // The LUT doesn't depend on the scene, a precomputed one ships with the engine (tools/textureCompressor --brdf-lut)
+    std::string shippedPath = ROOT_DIR + std::string("/res/brdfLUT.ktx2");
+    std::string cachePath = getBakeCachePath(hash::xxHash64(std::string("brdfLUT")), "brdfLUT", {kBakeCacheVersion, kBRDFLUTSize, 1, kBRDFLUTSampleCount, VK_FORMAT_R8G8B8A8_SRGB});
+
+    image brdfLUT;
+    if(loadBakedTexture(shippedPath, E_TextureType::DIFFUSE, addToCache, brdfLUT) || loadBakedTexture(cachePath, E_TextureType::DIFFUSE, addToCache, brdfLUT))
+    {
+        return brdfLUT;
+    }
+
+    bakeBatch batch = beginBake();
+    brdfLUT = recordBRDF_LUT(batch);
+    submitBake(batch);
+
+    if(addToCache)
+    {
+        addTextureToCache(E_TextureType::DIFFUSE, brdfLUT);
+    }
+
+    storeBakedTexture(cachePath, brdfLUT);
+
+    return brdfLUT;
+}
+
+texture_system::bakeBatch texture_system::beginBake()
+{
+    bakeBatch batch;
+
+    batch.commandBuffer = _core->getCommandBufferSystem().generateCommandBuffer();
+    _core->getCommandBufferSystem().beginCommandBuffer(batch.commandBuffer);
+
+    VkFenceCreateInfo fenceInfo{};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+    vkCreateFence(_core->getLogicalDevice(), &fenceInfo, nullptr, &batch.fence);
+
+    // Two timestamps around every stage, when the graphics queue can write them
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(_core->getPhysicalDevice(), &properties);
+
+    if(properties.limits.timestampComputeAndGraphics)
+    {
+        VkQueryPoolCreateInfo queryPoolInfo{};
+        queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        queryPoolInfo.queryCount = kBakeMaxStages * 2;
+
+        if(vkCreateQueryPool(_core->getLogicalDevice(), &queryPoolInfo, nullptr, &batch.timestamps) == VK_SUCCESS)
+        {
+            vkCmdResetQueryPool(batch.commandBuffer, batch.timestamps, 0, queryPoolInfo.queryCount);
+            batch.timestampPeriod = properties.limits.timestampPeriod;
+        }
+        else
+        {
+            batch.timestamps = VK_NULL_HANDLE;
+        }
+    }
+
+    return batch;
+}
+
+void texture_system::beginBakeStage(bakeBatch& batch, const std::string& name)
+{
+    if(batch.timestamps != VK_NULL_HANDLE && batch.stages.size() < kBakeMaxStages)
+    {
+        vkCmdWriteTimestamp(batch.commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, batch.timestamps, static_cast<uint32_t>(batch.stages.size()) * 2);
+    }
+    batch.stages.push_back(name);
+}
+
+void texture_system::endBakeStage(bakeBatch& batch)
+{
+    if(batch.timestamps != VK_NULL_HANDLE && batch.stages.size() <= kBakeMaxStages)
+    {
+        vkCmdWriteTimestamp(batch.commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, batch.timestamps, static_cast<uint32_t>(batch.stages.size()) * 2 - 1);
+    }
+}
+
+void texture_system::recordBakeBarrier(bakeBatch& batch, const image& img)
+{
+    // The render pass already left the image shader readable, only the writes have to become visible
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = img.image;
+    barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, img.mipLevels, 0, img.layers};
+    barrier.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+    vkCmdPipelineBarrier(batch.commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+void texture_system::submitBake(bakeBatch& batch)
+{
+    // 1 - One submission for the whole graph
+    vkEndCommandBuffer(batch.commandBuffer);
+    _core->getCommandBufferSystem().submitCommandBuffer(batch.commandBuffer, batch.fence);
+    vkWaitForFences(_core->getLogicalDevice(), 1, &batch.fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+
+    // 2 - Stages overlap on the GPU, the total is the span from the first start to the last end
+    if(batch.timestamps != VK_NULL_HANDLE && !batch.stages.empty())
+    {
+        uint32_t stageCount = std::min(static_cast<uint32_t>(batch.stages.size()), kBakeMaxStages);
+        std::vector<uint64_t> ticks(stageCount * 2);
+
+        if(vkGetQueryPoolResults(_core->getLogicalDevice(), batch.timestamps, 0, stageCount * 2, ticks.size() * sizeof(uint64_t), ticks.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT) == VK_SUCCESS)
+        {
+            auto toMilliseconds = [&batch](uint64_t begin, uint64_t end)
+            {
+                return static_cast<double>(end - begin) * batch.timestampPeriod / 1e6;
+            };
+
+            // Shown in the performance panel
+            _bakeTimings.clear();
+
+            uint64_t first = ticks[0];
+            uint64_t last = ticks[1];
+            for(uint32_t i = 0; i < stageCount; i++)
+            {
+                _bakeTimings.push_back({batch.stages[i], toMilliseconds(ticks[i * 2], ticks[i * 2 + 1])});
+                first = std::min(first, ticks[i * 2]);
+                last = std::max(last, ticks[i * 2 + 1]);
+            }
+            _bakeTimings.push_back({"total", toMilliseconds(first, last)});
+        }
+    }
+
+    // 3 - Cleanup
+    if(batch.timestamps != VK_NULL_HANDLE)
+    {
+        vkDestroyQueryPool(_core->getLogicalDevice(), batch.timestamps, nullptr);
+    }
+    vkDestroyFence(_core->getLogicalDevice(), batch.fence, nullptr);
+    _core->getCommandBufferSystem().freeCommandBuffers(batch.commandBuffer);
+
+    for(VkFramebuffer framebuffer : batch.framebuffers)
+    {
+        vkDestroyFramebuffer(_core->getLogicalDevice(), framebuffer, nullptr);
+    }
+    for(VkImageView imageView : batch.views)
+    {
+        vkDestroyImageView(_core->getLogicalDevice(), imageView, nullptr);
+    }
+    for(image& source : batch.sources)
+    {
+        cleanupImage(source);
+    }
+}
+
+image texture_system::recordCubemap(bakeBatch& batch, const image& flatImg)
+{
     // 1 - Create Cubemap image
-    uint32_t size_width = 2048;
-    uint32_t size_height = 2048;
+    uint32_t size_width = kCubemapSize;
+    uint32_t size_height = kCubemapSize;
 
-    image img = createImage(size_width, size_height, 1, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true);
+    image img = createImage(size_width, size_height, 1, kHDRFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true);
 
     // 2 - Create Cubemap image view
-    createImageView(img, true, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, VK_IMAGE_VIEW_TYPE_CUBE);
+    createImageView(img, true, kHDRFormat, VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, VK_IMAGE_VIEW_TYPE_CUBE);
 
     // 3 - Populate the descriptor image info
     img.descriptor.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
@@ -315,8 +1028,9 @@ image texture_system::bakeCubemapFromFlat(image flatImg, bool addToCache)
     {
         throw std::runtime_error("Failed to create framebuffer!");
     }
+    batch.framebuffers.push_back(framebuffer);
 
-    // 5 - Render the cubemap
+    // 5 - Fetch the equirectangular to cubemap pipeline
     shaderPipeline cubemapPipeline;
     try{
         cubemapPipeline = _core->getPipelineSystem().getPipeline("equi2cube");
@@ -327,24 +1041,20 @@ image texture_system::bakeCubemapFromFlat(image flatImg, bool addToCache)
         cubemapPipeline = _core->getPipelineSystem().getPipeline("equi2cube");
     }
 
+    // 6 - Setup the rendering request for the cubemap
     renderRequest requestInfo;
-    requestInfo.commandBuffer = _core->getCommandBufferSystem().generateCommandBuffer();
+    requestInfo.commandBuffer = batch.commandBuffer;
     requestInfo.renderPass = E_RenderPassType::CUBE_MAP;
     requestInfo.framebuffer = framebuffer;
     requestInfo.extent = {size_width, size_height};
     requestInfo.pipeline = cubemapPipeline;
 
-    VkFenceCreateInfo fenceInfo{};
-    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-    fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-    vkCreateFence(_core->getLogicalDevice(), &fenceInfo, nullptr, &requestInfo.fence);
-
     requestInfo.viewport = {0.0f, 0.0f, static_cast<float>(size_width), static_cast<float>(size_height), 0.0f, 1.0f};
     requestInfo.scissor = {{0, 0}, {size_width, size_height}};
 
     VkDescriptorSet textureDescriptorSet;
     // Populate the descriptor image info
-    _core->getFrameManager().getReadyDescriptorBuilder()
+    _core->getFrameManager().getTransientDescriptorBuilder()
         .bindImage(0, &flatImg.descriptor, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
         .build(textureDescriptorSet);
 
@@ -366,45 +1076,26 @@ image texture_system::bakeCubemapFromFlat(image flatImg, bool addToCache)
         requestInfo.perModelPC.push_back(pcModel);
     }
 
-    // 6 - Record the command buffer
-    _core->getCommandBufferSystem().beginRecordingCommandBuffer(requestInfo.commandBuffer, requestInfo.renderPass, requestInfo.framebuffer, requestInfo.extent);
+    // 7 - Record the render pass
+    beginBakeStage(batch, "cubemap");
+    _core->getCommandBufferSystem().beginRenderPass(batch.commandBuffer, requestInfo.renderPass, requestInfo.framebuffer, requestInfo.extent);
     _core->getCommandBufferSystem().recordCommandBuffer(requestInfo);
-    vkWaitForFences(_core->getLogicalDevice(), 1, &requestInfo.fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
-    _core->getCommandBufferSystem().endRecordingCommandBuffer(requestInfo.commandBuffer);
-    _core->getCommandBufferSystem().submitCommandBuffer(requestInfo.commandBuffer, requestInfo.fence);
-
-    // 7 - Add to cache
-    if(addToCache)
-    {
-        addTextureToCache(E_TextureType::CUBEMAP, img);
-    }
-
-    // 8 - Cleanup
-    vkWaitForFences(_core->getLogicalDevice(), 1, &requestInfo.fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
-    cleanupImage(flatImg);
-    _core->getCommandBufferSystem().freeCommandBuffers(requestInfo.commandBuffer);
-    vkDestroyFramebuffer(_core->getLogicalDevice(), framebuffer, nullptr);
-    vkDestroyFence(_core->getLogicalDevice(), requestInfo.fence, nullptr);
+    _core->getCommandBufferSystem().endRenderPass(batch.commandBuffer);
+    endBakeStage(batch);
 
     return img;
 }
 
-image texture_system::bakeIrradianceDiffuseLightmap(image img, bool addToCache)
+image texture_system::recordIrradianceDiffuse(bakeBatch& batch, const image& img)
 {
-    // 0 - Check if the image is valid
-    if(img.image == VK_NULL_HANDLE)
-    {
-        throw std::runtime_error("Image is not valid");
-    }
-
     // 1 - Create Irradiance Lightmap image
-    uint32_t size_width = 256;
-    uint32_t size_height = 256;
+    uint32_t size_width = kIrradianceDiffuseSize;
+    uint32_t size_height = kIrradianceDiffuseSize;
 
-    image lightmap = createImage(size_width, size_height, 1, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true);
+    image lightmap = createImage(size_width, size_height, 1, kHDRFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true);
 
     // 2 - Create Irradiance Lightmap image view
-    createImageView(lightmap, true, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, VK_IMAGE_VIEW_TYPE_CUBE);
+    createImageView(lightmap, true, kHDRFormat, VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, VK_IMAGE_VIEW_TYPE_CUBE);
 
     // 3 - Populate the descriptor image info
     lightmap.descriptor.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
@@ -431,6 +1122,7 @@ image texture_system::bakeIrradianceDiffuseLightmap(image img, bool addToCache)
     {
         throw std::runtime_error("Failed to create framebuffer!");
     }
+    batch.framebuffers.push_back(framebuffer);
 
     // 5 - Fetch the diffuse irradiance lightmap pipeline
     shaderPipeline lightmapPipeline;
@@ -445,23 +1137,18 @@ image texture_system::bakeIrradianceDiffuseLightmap(image img, bool addToCache)
 
     // 6a - Setup the rendering request for the lightmap
     renderRequest requestInfo;
-    requestInfo.commandBuffer = _core->getCommandBufferSystem().generateCommandBuffer();
+    requestInfo.commandBuffer = batch.commandBuffer;
     requestInfo.renderPass = E_RenderPassType::CUBE_MAP;
     requestInfo.framebuffer = framebuffer;
     requestInfo.extent = {size_width, size_height};
     requestInfo.pipeline = lightmapPipeline;
 
-    VkFenceCreateInfo fenceInfo{};
-    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-    fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-    vkCreateFence(_core->getLogicalDevice(), &fenceInfo, nullptr, &requestInfo.fence);
-
     requestInfo.viewport = {0.0f, 0.0f, static_cast<float>(size_width), static_cast<float>(size_height), 0.0f, 1.0f};
     requestInfo.scissor = {{0, 0}, {size_width, size_height}};
 
     // 6b - Populate the descriptor image info
     VkDescriptorSet textureDescriptorSet;
-    _core->getFrameManager().getReadyDescriptorBuilder()
+    _core->getFrameManager().getTransientDescriptorBuilder()
         .bindImage(0, &img.descriptor, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
         .build(textureDescriptorSet);
 
@@ -471,9 +1158,6 @@ image texture_system::bakeIrradianceDiffuseLightmap(image img, bool addToCache)
     Model cube = _core->getModelMeshLibrary().createModelFromMesh("cube", shapes::cube::mesh(glm::vec3(1.0f)));
     requestInfo.models = std::vector<Model>(6, cube);
 
-    // 7 - Record the command buffer
-    _core->getCommandBufferSystem().beginRecordingCommandBuffer(requestInfo.commandBuffer, requestInfo.renderPass, requestInfo.framebuffer, requestInfo.extent);
-
     int faces[] = {0, 1, 2, 3, 4, 5};
 
     for (int i = 0; i < 6; i++)
@@ -485,64 +1169,49 @@ image texture_system::bakeIrradianceDiffuseLightmap(image img, bool addToCache)
         pcModel.offset = PUSH_CONSTANT_VERTEX_OFFSET;
         requestInfo.perModelPC.push_back(pcModel);
     }
-    _core->getCommandBufferSystem().recordCommandBuffer(requestInfo);
-    _core->getCommandBufferSystem().endRecordingCommandBuffer(requestInfo.commandBuffer);
-    _core->getCommandBufferSystem().submitCommandBuffer(requestInfo.commandBuffer, requestInfo.fence);
-
-    // 8 - Add to cache
-    if(addToCache)
-    {
-        addTextureToCache(E_TextureType::CUBEMAP, lightmap);
-    }
-
-    // 9 - Cleanup
-    vkWaitForFences(_core->getLogicalDevice(), 1, &requestInfo.fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
-    vkDestroyFence(_core->getLogicalDevice(), requestInfo.fence, nullptr);
-    vkDestroyFramebuffer(_core->getLogicalDevice(), framebuffer, nullptr);
 
+    // 7 - Record the render pass
+    beginBakeStage(batch, "irradianceDiffuse");
+    _core->getCommandBufferSystem().beginRenderPass(batch.commandBuffer, requestInfo.renderPass, requestInfo.framebuffer, requestInfo.extent);
+    _core->getCommandBufferSystem().recordCommandBuffer(requestInfo);
+    _core->getCommandBufferSystem().endRenderPass(batch.commandBuffer);
+    endBakeStage(batch);
 
     return lightmap;
 }
 
-image texture_system::bakeIrradianceSpecularLightmap(image img, bool addToCache)
+image texture_system::recordIrradianceSpecular(bakeBatch& batch, const image& img)
 {
-    // 0 - Check if the image is valid
-    if(img.image == VK_NULL_HANDLE)
-    {
-        throw std::runtime_error("Image is not valid");
-    }
-
     // 1 - Create Specular Lightmap image
-    uint32_t size_width = 1024;
-    uint32_t size_height = 1024;
+    uint32_t size_width = kIrradianceSpecularSize;
+    uint32_t size_height = kIrradianceSpecularSize;
 
-    uint32_t mipLevels = 5;
+    uint32_t mipLevels = kIrradianceSpecularMips;
 
-    std::vector<uint32_t> size_widths(mipLevels, size_width);
-    std::vector<uint32_t> size_heights(mipLevels, size_height);
+    std::vector<uint32_t> size_widths(mipLevels + 1, size_width);
+    std::vector<uint32_t> size_heights(mipLevels + 1, size_height);
 
     for(int i = 1; i <= mipLevels; i++)
     {
         size_widths[i] = size_width / pow(2, i);
         size_heights[i] = size_height / pow(2, i);
     }
-    
 
-    image lightMap = createImage(size_width, size_height, mipLevels + 1, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true);
+    image lightMap = createImage(size_width, size_height, mipLevels + 1, kHDRFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true);
 
     // 2 - Create Specular Lightmap image views
 
-    std::vector<VkImageView> imageViews;
-
     // Create one imageview for each miplevel so we can attach them seperately to the framebuffer
     // and render to them one at a time
+    std::vector<VkImageView> imageViews;
     for (int z(0) ; z <= mipLevels ; z++)
     {
-        imageViews.push_back(createImageView(lightMap, false, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT, z, 1, VK_IMAGE_VIEW_TYPE_CUBE));
+        imageViews.push_back(createImageView(lightMap, false, kHDRFormat, VK_IMAGE_ASPECT_COLOR_BIT, z, 1, VK_IMAGE_VIEW_TYPE_CUBE));
     }
+    batch.views.insert(batch.views.end(), imageViews.begin(), imageViews.end());
 
     // Also create a general imageview for the lightmap for when it is used as a texture in a shader
-    createImageView(lightMap, true, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT, 0, mipLevels + 1, VK_IMAGE_VIEW_TYPE_CUBE);
+    createImageView(lightMap, true, kHDRFormat, VK_IMAGE_ASPECT_COLOR_BIT, 0, mipLevels + 1, VK_IMAGE_VIEW_TYPE_CUBE);
 
     // 3 - Populate the descriptor image info
     lightMap.descriptor.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
@@ -555,7 +1224,7 @@ image texture_system::bakeIrradianceSpecularLightmap(image img, bool addToCache)
     for (int z(0) ; z <= mipLevels ; ++z)
     {
         VkFramebuffer framebuffer;
-        
+
         std::array<VkImageView, 1> attachments = {
             imageViews[z]
         };
@@ -576,6 +1245,7 @@ image texture_system::bakeIrradianceSpecularLightmap(image img, bool addToCache)
 
         framebuffers.push_back(framebuffer);
     }
+    batch.framebuffers.insert(batch.framebuffers.end(), framebuffers.begin(), framebuffers.end());
 
     // 5 - Fetch the specular irradiance lightmap pipeline
     shaderPipeline lightmapPipeline;
@@ -584,38 +1254,21 @@ image texture_system::bakeIrradianceSpecularLightmap(image img, bool addToCache)
     }
     catch(const std::exception& e)
     {
-        _core->getPipelineSystem().createPipeline("irradianceSpecular", E_RenderPassType::CUBE_MAP);
+        _core->getPipelineSystem().createPipeline(  "irradianceSpecular", 
+                                                    E_RenderPassType::CUBE_MAP, 
+                                                    specializationConstants().set(SPEC_CONSTANT_SAMPLE_COUNT, kSpecularIrradianceSampleCount));
         lightmapPipeline = _core->getPipelineSystem().getPipeline("irradianceSpecular");
     }
 
     // 6a - Setup the rendering request for the lightmap
-    renderRequest requestInfo;
-    requestInfo.commandBuffer = _core->getCommandBufferSystem().generateCommandBuffer();
-    requestInfo.renderPass = E_RenderPassType::CUBE_MAP;
-    requestInfo.pipeline = lightmapPipeline;
-
-    VkFenceCreateInfo fenceInfo{};
-    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-    fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-    vkCreateFence(_core->getLogicalDevice(), &fenceInfo, nullptr, &requestInfo.fence);
-
-    // ViewPorts and Scissors
-
-    std::vector<VkViewport> viewports;
-    std::vector<VkRect2D> scissors;
-
-    for (int z(0) ; z <= mipLevels ; z++)
-    {
-        VkViewport viewport = {0.0f, 0.0f, static_cast<float>(size_widths[z]), static_cast<float>(size_heights[z]), 0.0f, 1.0f};
-        viewports.push_back(viewport);
-
-        VkRect2D scissor = {{0, 0}, {size_widths[z], size_heights[z]}};
-        scissors.push_back(scissor);
-    }
+    renderRequest requestInfo;
+    requestInfo.commandBuffer = batch.commandBuffer;
+    requestInfo.renderPass = E_RenderPassType::CUBE_MAP;
+    requestInfo.pipeline = lightmapPipeline;
 
     // 6b - Populate the descriptor image info
     VkDescriptorSet textureDescriptorSet;
-    _core->getFrameManager().getReadyDescriptorBuilder()
+    _core->getFrameManager().getTransientDescriptorBuilder()
         .bindImage(0, &img.descriptor, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
         .build(textureDescriptorSet);
 
@@ -625,8 +1278,6 @@ image texture_system::bakeIrradianceSpecularLightmap(image img, bool addToCache)
     Model cube = _core->getModelMeshLibrary().createModelFromMesh("cube", shapes::cube::mesh(glm::vec3(1.0f)));
     requestInfo.models = std::vector<Model>(6, cube);
 
-    // 7 - Record the command buffer
-
     int faces[] = {0, 1, 2, 3, 4, 5};
 
     for(int i = 0; i < 6; i++)
@@ -639,13 +1290,14 @@ image texture_system::bakeIrradianceSpecularLightmap(image img, bool addToCache)
         requestInfo.perModelPC.push_back(pcModel);
     }
 
+    // 7 - Record one render pass per roughness level, each writes its own mip so none waits on another
+    beginBakeStage(batch, "irradianceSpecular");
     for(int currentMipLevel = 0; currentMipLevel <= mipLevels; currentMipLevel++)
     {
-
         requestInfo.extent = {size_widths[currentMipLevel], size_heights[currentMipLevel]};
 
-        requestInfo.viewport = viewports[currentMipLevel];
-        requestInfo.scissor = scissors[currentMipLevel];
+        requestInfo.viewport = {0.0f, 0.0f, static_cast<float>(size_widths[currentMipLevel]), static_cast<float>(size_heights[currentMipLevel]), 0.0f, 1.0f};
+        requestInfo.scissor = {{0, 0}, {size_widths[currentMipLevel], size_heights[currentMipLevel]}};
 
         requestInfo.framebuffer = framebuffers[currentMipLevel];
 
@@ -656,44 +1308,23 @@ image texture_system::bakeIrradianceSpecularLightmap(image img, bool addToCache)
         pcLightmap.offset = PUSH_CONSTANT_FRAGMENT_OFFSET;
         requestInfo.generalPC = pcLightmap;
 
-        _core->getCommandBufferSystem().beginRecordingCommandBuffer(requestInfo.commandBuffer, requestInfo.renderPass, requestInfo.framebuffer, requestInfo.extent);
+        _core->getCommandBufferSystem().beginRenderPass(batch.commandBuffer, requestInfo.renderPass, requestInfo.framebuffer, requestInfo.extent);
         _core->getCommandBufferSystem().recordCommandBuffer(requestInfo);
-        _core->getCommandBufferSystem().endRecordingCommandBuffer(requestInfo.commandBuffer);
-        _core->getCommandBufferSystem().submitCommandBuffer(requestInfo.commandBuffer, requestInfo.fence);
-        vkWaitForFences(_core->getLogicalDevice(), 1, &requestInfo.fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
-    }
-
-    // 8 - Add to cache
-    if(addToCache)
-    {
-        addTextureToCache(E_TextureType::CUBEMAP, lightMap);
-    }
-
-    // 9 - Cleanup
-    vkWaitForFences(_core->getLogicalDevice(), 1, &requestInfo.fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
-    vkDestroyFence(_core->getLogicalDevice(), requestInfo.fence, nullptr);
-    for (auto framebuffer : framebuffers)
-    {
-        vkDestroyFramebuffer(_core->getLogicalDevice(), framebuffer, nullptr);
-    }
-    for (auto imageView : imageViews)
-    {
-        vkDestroyImageView(_core->getLogicalDevice(), imageView, nullptr);
+        _core->getCommandBufferSystem().endRenderPass(batch.commandBuffer);
     }
-
+    endBakeStage(batch);
 
     return lightMap;
 }
 
-image texture_system::bakeBRDF_LUT(bool addToCache)
+image texture_system::recordBRDF_LUT(bakeBatch& batch)
 {
-    
     // 0 - Define the image size
-    uint32_t size_width = 512;
-    uint32_t size_height = 512;
+    uint32_t size_width = kBRDFLUTSize;
+    uint32_t size_height = kBRDFLUTSize;
 
-    // 1 - Create the image
-    image brdfLUT = createImage(size_width, size_height, 1, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true);
+    // 1 - Create the image, a single layer so the readback stores one face like the shipped LUT
+    image brdfLUT = createImage(size_width, size_height, 1, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false);
 
     // 2 - Create the image view
     createImageView(brdfLUT, true, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, VK_IMAGE_VIEW_TYPE_2D);
@@ -723,6 +1354,7 @@ image texture_system::bakeBRDF_LUT(bool addToCache)
     {
         throw std::runtime_error("Failed to create framebuffer!");
     }
+    batch.framebuffers.push_back(framebuffer);
 
     // 5 - Fetch the BRDF LUT pipeline
     shaderPipeline brdfLUTPipeline;
@@ -731,23 +1363,20 @@ image texture_system::bakeBRDF_LUT(bool addToCache)
     }
     catch(const std::exception& e)
     {
-        _core->getPipelineSystem().createPipeline("brdfLUT", E_RenderPassType::COLOR);
+        _core->getPipelineSystem().createPipeline(  "brdfLUT", 
+                                                    E_RenderPassType::COLOR, 
+                                                    specializationConstants().set(SPEC_CONSTANT_SAMPLE_COUNT, kBRDFLUTSampleCount));
         brdfLUTPipeline = _core->getPipelineSystem().getPipeline("brdfLUT");
     }
 
     // 6 - Setup the rendering request for the BRDF LUT
     renderRequest requestInfo;
-    requestInfo.commandBuffer = _core->getCommandBufferSystem().generateCommandBuffer();
+    requestInfo.commandBuffer = batch.commandBuffer;
     requestInfo.renderPass = E_RenderPassType::COLOR;
     requestInfo.framebuffer = framebuffer;
     requestInfo.extent = {size_width, size_height};
     requestInfo.pipeline = brdfLUTPipeline;
 
-    VkFenceCreateInfo fenceInfo{};
-    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-    fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-    vkCreateFence(_core->getLogicalDevice(), &fenceInfo, nullptr, &requestInfo.fence);
-
     // Viewport and Scissor
     requestInfo.viewport = {0.0f, 0.0f, static_cast<float>(size_width), static_cast<float>(size_height), 0.0f, 1.0f};
     requestInfo.scissor = {{0, 0}, {size_width, size_height}};
@@ -756,24 +1385,171 @@ image texture_system::bakeBRDF_LUT(bool addToCache)
     Model quad = _core->getModelMeshLibrary().createModelFromMesh("quad", shapes::quad::mesh());
     requestInfo.models = std::vector<Model>(1, quad);
 
-    // 7 - Record the command buffer
-    _core->getCommandBufferSystem().beginRecordingCommandBuffer(requestInfo.commandBuffer, requestInfo.renderPass, requestInfo.framebuffer, requestInfo.extent);
+    // 7 - Record the render pass
+    beginBakeStage(batch, "brdfLUT");
+    _core->getCommandBufferSystem().beginRenderPass(batch.commandBuffer, requestInfo.renderPass, requestInfo.framebuffer, requestInfo.extent);
     _core->getCommandBufferSystem().recordCommandBuffer(requestInfo);
-    _core->getCommandBufferSystem().endRecordingCommandBuffer(requestInfo.commandBuffer);
-    _core->getCommandBufferSystem().submitCommandBuffer(requestInfo.commandBuffer, requestInfo.fence);
+    _core->getCommandBufferSystem().endRenderPass(batch.commandBuffer);
+    endBakeStage(batch);
 
-    // 8 - Add to cache
-    if(addToCache)
+    return brdfLUT;
+}
+
+uint64_t texture_system::getSourceKey(const std::string& filePath) const
+{
+    // Relative paths are resolved the same way the image loaders do
+    std::ifstream file(filePath, std::ios::binary);
+    if(!file.is_open())
     {
-        addTextureToCache(E_TextureType::DIFFUSE, brdfLUT);
+        file.open(ROOT_DIR + filePath, std::ios::binary);
+    }
+    if(!file.is_open())
+    {
+        return 0;
+    }
+
+    std::vector<char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return hash::xxHash64(bytes.data(), bytes.size());
+}
+
+ktx2Texture texture_system::readbackTexture(const image& img)
+{
+    ktx2Texture texture;
+    texture.format = img.format;
+    texture.width = img.width;
+    texture.height = img.height;
+    texture.faces = img.layers;
+
+    // 1 - Level sizes, faces of a level are packed one after the other
+    VkDeviceSize alignment = std::max<VkDeviceSize>(ktx2::getFormatBlockBytes(img.format), 4);
+    VkDeviceSize bufferSize = 0;
+    for(uint32_t level = 0; level < img.mipLevels; level++)
+    {
+        uint32_t width = std::max(img.width >> level, 1u);
+        uint32_t height = std::max(img.height >> level, 1u);
+
+        VkDeviceSize faceSize = blockCompression::isBlockCompressed(img.format) ?
+            blockCompression::getCompressedSize(img.format, width, height) :
+            static_cast<VkDeviceSize>(width) * height * ktx2::getFormatBlockBytes(img.format);
+
+        bufferSize = (bufferSize + alignment - 1) / alignment * alignment;
+        texture.levels.push_back({bufferSize, faceSize * img.layers, faceSize * img.layers});
+        bufferSize += faceSize * img.layers;
     }
 
-    // 9 - Cleanup
-    vkWaitForFences(_core->getLogicalDevice(), 1, &requestInfo.fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
-    vkDestroyFence(_core->getLogicalDevice(), requestInfo.fence, nullptr);
-    vkDestroyFramebuffer(_core->getLogicalDevice(), framebuffer, nullptr);
+    memoryBuffer readbackBuffer = _core->getMemorySystem().createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
 
-    return brdfLUT;
+    // 2 - Copy every level out, the image is left shader readable as it was found
+    std::vector<VkBufferImageCopy> regions;
+    for(uint32_t level = 0; level < img.mipLevels; level++)
+    {
+        VkBufferImageCopy region = {};
+        region.bufferOffset = texture.levels[level].offset;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = level;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = img.layers;
+        region.imageExtent = {std::max(img.width >> level, 1u), std::max(img.height >> level, 1u), 1};
+        regions.push_back(region);
+    }
+
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = img.image;
+    barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, img.mipLevels, 0, img.layers};
+    barrier.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+    VkCommandBuffer commandBuffer = _core->getCommandBufferSystem().beginSingleTimeCommands();
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+    vkCmdCopyImageToBuffer(commandBuffer, img.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readbackBuffer.buffer, static_cast<uint32_t>(regions.size()), regions.data());
+
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    _core->getCommandBufferSystem().endSingleTimeCommands(commandBuffer);
+
+    // 3 - Into host memory
+    texture.data.resize(bufferSize);
+    void* data;
+    vkMapMemory(_core->getLogicalDevice(), readbackBuffer.memory, 0, bufferSize, 0, &data);
+    memcpy(texture.data.data(), data, bufferSize);
+    vkUnmapMemory(_core->getLogicalDevice(), readbackBuffer.memory);
+
+    _core->getMemorySystem().freeBuffer(readbackBuffer);
+
+    return texture;
+}
+
+std::string texture_system::getBakeCachePath(uint64_t cacheKey, const std::string& name, const bakeParameters& parameters) const
+{
+    // Without a source key there is nothing to tell two sources apart, such bakes aren't cached
+    if(cacheKey == 0)
+    {
+        return std::string();
+    }
+
+    std::ostringstream path;
+    path << ROOT_DIR << "/cache/ibl/" << name << "_" << std::hex << std::setw(16) << std::setfill('0') << hash::xxHash64(&parameters, sizeof(parameters), cacheKey) << ".ktx2";
+    return path.str();
+}
+
+bool texture_system::loadBakedTexture(const std::string& path, E_TextureType type, bool addToCache, image& img)
+{
+    if(path.empty() || !std::filesystem::exists(path))
+    {
+        return false;
+    }
+
+    // A stale or damaged cache file is baked again
+    try
+    {
+        img = createTexture(ktx2::load(path), type, addToCache);
+    }
+    catch(const std::exception& e)
+    {
+        std::cerr << "Failed to load baked texture " << path << ": " << e.what() << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+void texture_system::storeBakedTexture(const std::string& path, const image& img)
+{
+    if(path.empty())
+    {
+        return;
+    }
+
+    // Only a cache, failing to write it just means baking again next time
+    try
+    {
+        ktx2Texture texture = readbackTexture(img);
+
+        // A quarter of the size of 32 bit floats, the range and precision lightmaps need
+        VkFormatProperties formatProperties;
+        vkGetPhysicalDeviceFormatProperties(_core->getPhysicalDevice(), kHDRSampledFormat, &formatProperties);
+        if(texture.format == VK_FORMAT_R16G16B16A16_SFLOAT && (formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT))
+        {
+            texture = packSharedExponent(texture);
+        }
+
+        std::filesystem::create_directories(std::filesystem::path(path).parent_path());
+        ktx2::save(path, texture, kBakeCacheZstdLevel);
+    }
+    catch(const std::exception& e)
+    {
+        std::cerr << "Failed to store baked texture " << path << ": " << e.what() << std::endl;
+    }
 }
 
 VkImageView texture_system::createImageView(image& img, bool updateImageAttribute, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t baseMipLevel, uint32_t mipLevels, VkImageViewType viewType)
@@ -834,43 +1610,6 @@ VkImageView texture_system::createTextureImageView(image& img, VkFormat format,
     return createdImageView;
 }
 
-std::vector<VkDescriptorImageInfo>& texture_system::aggregateDescriptorTextureInfos(E_TextureType type, size_t returnVectorSize)
-{
-    if(_textures.find(type) == _textures.end())
-    {
-        throw std::runtime_error("Texture type not found in cache");
-    }
-
-    if(_textures.at(type)->empty())
-    {
-        throw std::runtime_error("Texture cache is empty");
-    }
-
-    if(_textures.at(type)->size() > returnVectorSize)
-    {
-        throw std::runtime_error("The number of textures in cache set exceeds the maximum number of textures allowed by argument");
-    }
-
-    std::vector<VkDescriptorImageInfo> imageInfos;
-
-    for(auto& texture : *_textures.at(type))
-    {
-        imageInfos.push_back(texture.descriptor);
-    }
-
-    if (imageInfos.size() < returnVectorSize)
-    {
-        for(size_t i = imageInfos.size(); i < returnVectorSize; i++)
-        {
-            imageInfos.push_back(_textures[type]->at(0).descriptor);
-        }
-    }
-
-    _textureDescriptors[type] = imageInfos;
-
-    return _textureDescriptors[type];
-}
-
 void texture_system::copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height)
 {
     VkCommandBuffer commandBuffer = _core->getCommandBufferSystem().beginSingleTimeCommands();
@@ -982,6 +1721,8 @@ void texture_system::transitionImageLayout(image& image, VkImageLayout newLayout
 
 void texture_system::cleanupImage(image& img)
 {
+    _core->getFrameManager().invalidateDescriptorSets((uint64_t)img.imageView);
+
     vkDestroyImageView(_core->getLogicalDevice(), img.imageView, nullptr);
     vkDestroyImage(_core->getLogicalDevice(), img.image, nullptr);
     vkFreeMemory(_core->getLogicalDevice(), img.memory, nullptr);
@@ -996,13 +1737,20 @@ void texture_system::cleanup()
             cleanupImage(img);
         }
     }
+    _streamer.cleanup();
+    _virtualTextures.cleanup();
 
+    _core->getFrameManager().invalidateDescriptorSets((uint64_t)_textureSampler);
     vkDestroySampler(_core->getLogicalDevice(), _textureSampler, nullptr);
 }
 
 void texture_system::addTextureToCache(const E_TextureType type , image& img)
 {
+    addTextureToCache(type, img, allocateBindlessSlot(type));
+}
 
+void texture_system::addTextureToCache(const E_TextureType type, image& img, uint32_t slot)
+{
     if(img.descriptor.imageView == VK_NULL_HANDLE)
     {
         throw std::runtime_error("Cannot add image to cache because view is null");
@@ -1017,16 +1765,349 @@ void texture_system::addTextureToCache(const E_TextureType type , image& img)
     {
         _textures[type] = std::make_shared<std::vector<image>>();
     }
-    img.id = _textures[type]->size();
+
+    // The id is the texture's slot in the bindless heap, only that slot gets written
+    img.type = type;
+    img.id = slot;
+    writeBindlessSlot(img);
+
     _textures[type]->push_back(img);
 }
 
+uint32_t texture_system::allocateBindlessSlot(const E_TextureType type)
+{
+    if(type == E_TextureType::CUBEMAP)
+    {
+        if(_nextTextureCubeSlot >= kCubemapArraySize)
+        {
+            throw std::runtime_error("Bindless heap is out of cubemap slots");
+        }
+        return _nextTextureCubeSlot++;
+    }
+
+    if(!_freeTexture2DSlots.empty())
+    {
+        uint32_t slot = _freeTexture2DSlots.back();
+        _freeTexture2DSlots.pop_back();
+        return slot;
+    }
+
+    if(_nextTexture2DSlot >= kTextureArraySize)
+    {
+        throw std::runtime_error("Bindless heap is out of texture slots");
+    }
+    return _nextTexture2DSlot++;
+}
+
+bool texture_system::acquireTexture(uint64_t key, uint32_t& id)
+{
+    auto it = _sharedTextureSlots.find(key);
+    if(it == _sharedTextureSlots.end())
+    {
+        return false;
+    }
+
+    id = it->second;
+    _sharedTextures[id].references++;
+    return true;
+}
+
+void texture_system::registerTexture(uint64_t key, uint32_t id)
+{
+    _sharedTextureSlots[key] = id;
+    _sharedTextures[id] = {key, 1};
+}
+
+void texture_system::releaseTexture(uint32_t id)
+{
+    auto it = _sharedTextures.find(id);
+    if(it == _sharedTextures.end() || --it->second.references > 0)
+    {
+        return;
+    }
+
+    _sharedTextureSlots.erase(it->second.key);
+    _sharedTextures.erase(it);
+
+    // Nothing can sample the slot while it points at a destroyed image
+    vkDeviceWaitIdle(_core->getLogicalDevice());
+
+    if(_streamer.isStreamed(id))
+    {
+        _streamer.releaseTexture(id);
+    }
+
+    for(auto& [type, textures] : _textures)
+    {
+        if(type == E_TextureType::CUBEMAP)
+        {
+            continue;
+        }
+
+        auto img = std::find_if(textures->begin(), textures->end(), [id](const image& img) { return img.id == id; });
+        if(img != textures->end())
+        {
+            cleanupImage(*img);
+            textures->erase(img);
+            break;
+        }
+    }
+
+    // The slot samples the missing texture until it is handed out again
+    image placeholder = _textures[E_TextureType::DIFFUSE]->front();
+    placeholder.id = id;
+    writeBindlessSlot(placeholder);
+
+    _freeTexture2DSlots.push_back(id);
+}
+
+bool texture_system::isTextureHeld(uint32_t id) const
+{
+    return _sharedTextures.count(id) > 0;
+}
+
+void texture_system::writeBindlessSlot(const image& img)
+{
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = _bindlessDescriptorSet;
+    write.dstBinding = img.type == E_TextureType::CUBEMAP ? kBindlessTextureCubeBinding : kBindlessTexture2DBinding;
+    write.dstArrayElement = img.id;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+    write.pImageInfo = &img.descriptor;
+
+    // Update after bind, safe while frames in flight have the heap bound
+    vkUpdateDescriptorSets(_core->getLogicalDevice(), 1, &write, 0, nullptr);
+}
+
 bool texture_system::hasStencilComponent(VkFormat format) const
 {
     return format == VK_FORMAT_D32_SFLOAT_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT;
 }
 
-void texture_system::generateMipMaps(VkImage& image, VkFormat format, uint32_t width, uint32_t height, uint32_t mipLevels, uint32_t layerCount)
+void texture_system::initMipMapGeneration()
+{
+    VkPhysicalDeviceFeatures features;
+    vkGetPhysicalDeviceFeatures(_core->getPhysicalDevice(), &features);
+
+    // The shader writes every mip through a dynamically indexed array of unformatted storage images
+    _computeMipMaps = features.shaderStorageImageWriteWithoutFormat && features.shaderStorageImageArrayDynamicIndexing;
+
+    if(_computeMipMaps)
+    {
+        _core->getPipelineSystem().createComputePipeline("spd");
+    }
+}
+
+bool texture_system::canGenerateMipMapsOnGPU(VkFormat format, uint32_t width, uint32_t height) const
+{
+    if(!_computeMipMaps || width > kSPDMaxExtent || height > kSPDMaxExtent)
+    {
+        return false;
+    }
+
+    VkFormatProperties formatProperties;
+    vkGetPhysicalDeviceFormatProperties(_core->getPhysicalDevice(), getStorageFormat(format), &formatProperties);
+
+    return formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT;
+}
+
+VkImageUsageFlags texture_system::getMipMapUsage(VkFormat format, uint32_t width, uint32_t height) const
+{
+    VkImageUsageFlags usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+
+    if(canGenerateMipMapsOnGPU(format, width, height))
+    {
+        usage |= VK_IMAGE_USAGE_STORAGE_BIT;
+    }
+
+    return usage;
+}
+
+void texture_system::generateMipMaps(image& img, VkFormat format)
+{
+    img.format = format;
+
+    VkCommandBuffer commandBuffer = _core->getCommandBufferSystem().beginSingleTimeCommands();
+    mipGenerationBatch batch = recordMipMaps(commandBuffer, {&img});
+    _core->getCommandBufferSystem().endSingleTimeCommands(commandBuffer);
+
+    releaseMipGenerationBatch(batch);
+}
+
+texture_system::mipGenerationBatch texture_system::recordMipMaps(VkCommandBuffer commandBuffer, const std::vector<image*>& images)
+{
+    mipGenerationBatch batch;
+
+    // Images the compute path can't take are blitted level by level
+    std::vector<image*> computeImages;
+    for(image* img : images)
+    {
+        if(img->mipLevels > 1 && canGenerateMipMapsOnGPU(img->format, img->width, img->height))
+        {
+            computeImages.push_back(img);
+        }
+        else
+        {
+            recordBlitMipMaps(commandBuffer, img->image, img->format, img->width, img->height, img->mipLevels, img->layers);
+        }
+        img->layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        img->descriptor.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    }
+
+    if(computeImages.empty())
+    {
+        return batch;
+    }
+
+    // 1 - One scratch slice per image, the counters have to start at zero
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(_core->getPhysicalDevice(), &properties);
+    VkDeviceSize alignment = properties.limits.minStorageBufferOffsetAlignment;
+    VkDeviceSize sliceSize = (kSPDScratchSize + alignment - 1) / alignment * alignment;
+
+    batch.scratch = _core->getMemorySystem().createBuffer(sliceSize * computeImages.size(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    vkCmdFillBuffer(commandBuffer, batch.scratch.buffer, 0, VK_WHOLE_SIZE, 0);
+
+    // 2 - Mip 0 becomes readable, the other levels writable
+    VkBufferMemoryBarrier scratchBarrier{};
+    scratchBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    scratchBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    scratchBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    scratchBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    scratchBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    scratchBarrier.buffer = batch.scratch.buffer;
+    scratchBarrier.offset = 0;
+    scratchBarrier.size = VK_WHOLE_SIZE;
+
+    std::vector<VkImageMemoryBarrier> barriers;
+    for(image* img : computeImages)
+    {
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = img->image;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+
+        barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        barriers.push_back(barrier);
+
+        barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 1, img->mipLevels - 1, 0, 1};
+        barrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+        barriers.push_back(barrier);
+    }
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+        0, nullptr,
+        1, &scratchBarrier,
+        static_cast<uint32_t>(barriers.size()), barriers.data());
+
+    // 3 - One dispatch per image
+    shaderPipeline& pipeline = _core->getPipelineSystem().getPipeline("spd");
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.pipeline);
+
+    for(size_t i = 0; i < computeImages.size(); i++)
+    {
+        image& img = *computeImages[i];
+        uint32_t mipCount = std::min(img.mipLevels, kSPDMaxMips + 1);
+
+        VkDescriptorImageInfo sourceInfo{};
+        sourceInfo.sampler = _textureSampler;
+        sourceInfo.imageView = createImageView(img.image, img.format, VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, VK_IMAGE_VIEW_TYPE_2D);
+        sourceInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        batch.views.push_back(sourceInfo.imageView);
+
+        // Unused elements repeat the last mip, the shader never writes past mipCount
+        std::vector<VkDescriptorImageInfo> mipInfos(kSPDMaxMips);
+        for(uint32_t mip = 1; mip <= kSPDMaxMips; mip++)
+        {
+            VkDescriptorImageInfo& mipInfo = mipInfos[mip - 1];
+            mipInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+            if(mip < mipCount)
+            {
+                mipInfo.imageView = createImageView(img.image, getStorageFormat(img.format), VK_IMAGE_ASPECT_COLOR_BIT, mip, 1, VK_IMAGE_VIEW_TYPE_2D);
+                batch.views.push_back(mipInfo.imageView);
+            }
+            else
+            {
+                mipInfo.imageView = mipInfos[mipCount - 2].imageView;
+            }
+        }
+
+        VkDescriptorBufferInfo scratchInfo{};
+        scratchInfo.buffer = batch.scratch.buffer;
+        scratchInfo.offset = sliceSize * i;
+        scratchInfo.range = kSPDScratchSize;
+
+        VkDescriptorSet descriptorSet;
+        _core->getFrameManager().getTransientDescriptorBuilder()
+            .bindImage(0, &sourceInfo, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT)
+            .bindImageArray(1, &mipInfos, kSPDMaxMips, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT)
+            .bindBuffer(2, &scratchInfo, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+            .build(descriptorSet);
+
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.layout, 0, 1, &descriptorSet, 0, nullptr);
+
+        spdPushConstants constants{};
+        constants.width = img.width;
+        constants.height = img.height;
+        constants.mipCount = mipCount;
+        constants.workGroupsX = (img.width + kSPDTileSize - 1) / kSPDTileSize;
+        constants.workGroupCount = constants.workGroupsX * ((img.height + kSPDTileSize - 1) / kSPDTileSize);
+        constants.isSRGB = isSRGBFormat(img.format) ? 1 : 0;
+
+        vkCmdPushConstants(commandBuffer, pipeline.layout, VK_SHADER_STAGE_COMPUTE_BIT, PUSH_CONSTANT_COMPUTE_OFFSET, sizeof(constants), &constants);
+        vkCmdDispatch(commandBuffer, constants.workGroupsX, constants.workGroupCount / constants.workGroupsX, 1);
+    }
+
+    // 4 - Generated levels become shader readable
+    barriers.clear();
+    for(image* img : computeImages)
+    {
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = img->image;
+        barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 1, img->mipLevels - 1, 0, 1};
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        barriers.push_back(barrier);
+    }
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+        0, nullptr,
+        0, nullptr,
+        static_cast<uint32_t>(barriers.size()), barriers.data());
+
+    return batch;
+}
+
+void texture_system::releaseMipGenerationBatch(mipGenerationBatch& batch)
+{
+    for(VkImageView view : batch.views)
+    {
+        vkDestroyImageView(_core->getLogicalDevice(), view, nullptr);
+    }
+    batch.views.clear();
+
+    if(batch.scratch.buffer != VK_NULL_HANDLE)
+    {
+        _core->getMemorySystem().freeBuffer(batch.scratch);
+        batch.scratch = {};
+    }
+}
+
+void texture_system::recordBlitMipMaps(VkCommandBuffer commandBuffer, VkImage& image, VkFormat format, uint32_t width, uint32_t height, uint32_t mipLevels, uint32_t layerCount)
 {
     // check if linear blitting is supported
     VkFormatProperties formatProperties;
@@ -1037,8 +2118,6 @@ void texture_system::generateMipMaps(VkImage& image, VkFormat format, uint32_t w
         throw std::runtime_error("Texture image format does not support linear blitting!");
     }
 
-    VkCommandBuffer commandBuffer = _core->getCommandBufferSystem().beginSingleTimeCommands();
-
     VkImageMemoryBarrier barrier = {};
     barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
     barrier.image = image;
@@ -1128,7 +2207,4 @@ void texture_system::generateMipMaps(VkImage& image, VkFormat format, uint32_t w
         0, nullptr,
         1, &barrier
     );
-
-    _core->getCommandBufferSystem().endSingleTimeCommands(commandBuffer);
 }
-
@@ -8,12 +8,43 @@
 #include <memory>
 
 #include "rendering/resources/texture.hpp"
+#include "rendering/resources/memory.hpp"
 #include "util/imageData.hpp"
+#include "util/ktx2.hpp"
+#include "rendering/textureStreamer.hpp"
+#include "rendering/virtualTexture.hpp"
 
 class rendering_system;
 
+// Decoded image waiting to be uploaded into a reserved heap slot
+struct pendingTexture
+{
+    loadedImageDataRGB imgData = {nullptr, 0, 0, 0};
+    VkFormat format = VK_FORMAT_R8G8B8A8_SRGB;
+    E_TextureType type = E_TextureType::DIFFUSE;
+    uint32_t id = 0;
+};
+
+// GPU time of one stage of the last IBL bake, the whole span of the submission is the "total" stage
+struct bakeStageTiming
+{
+    std::string stage;
+    double milliseconds;
+};
+
+// Image based lighting maps of one environment
+struct environmentMaps
+{
+    image cubemap;
+    image irradianceMap;
+    image prefilteredMap;
+    image brdfLUT;
+};
+
 class texture_system
 {
+    friend class texture_streamer;
+    friend class virtual_texture_system;
 public:
     texture_system(rendering_system* rendering);
 
@@ -30,50 +61,169 @@ public:
     image createTexture(const std::string& filePath, E_TextureType type = E_TextureType::DIFFUSE, bool addToCache = true);
     image createTexture(const loadedImageDataRGB, VkFormat format, E_TextureType type = E_TextureType::DIFFUSE,  bool addToCache = true);
     image createTexture(const loadedImageDataHDR, VkFormat format, E_TextureType type = E_TextureType::DIFFUSE,  bool addToCache = true);
+    // Pre-mipmapped (usually block compressed) textures, cubemap files produce cubemap images
+    image createTexture(const ktx2Texture& texture, E_TextureType type = E_TextureType::DIFFUSE, bool addToCache = true);
+
+    // Hands out a heap slot before the texture exists, it samples the missing texture until uploaded
+    uint32_t reserveTexture(E_TextureType type = E_TextureType::DIFFUSE);
+    // Uploads into reserved slots, the whole batch shares one staging buffer and one submission
+    void createTextures(std::vector<pendingTexture>& batch);
+
+    // Content keyed index of shared textures, keys are hashes of the source (see util/hash.hpp)
+    // A hit takes a reference and returns the existing heap slot
+    bool acquireTexture(uint64_t key, uint32_t& id);
+    // Indexes a freshly created or reserved texture, the caller holds the first reference
+    void registerTexture(uint64_t key, uint32_t id);
+    // The last reference destroys the texture and returns its slot to the heap
+    void releaseTexture(uint32_t id);
+    // False once the last reference is gone, the slot may then be handed out to another texture
+    bool isTextureHeld(uint32_t id) const;
+
+    // Whole IBL bake graph in one submission: equirect -> cubemap -> irradiance and prefiltered mips, next to the LUT
+    // Maps already in the disk cache are loaded instead, GPU time of every stage is measured with timestamps
+    // Without bakeLighting only the cubemap is made, the lighting maps are left empty
+    environmentMaps bakeEnvironment(const std::string& filePath, uint64_t cacheKey = 0, bool addToCache = true, bool bakeLighting = true);
+    // Stage timings of the last bake that ran on the GPU, empty when the device can't write timestamps
+    const std::vector<bakeStageTiming>& getBakeTimings() const { return _bakeTimings; }
 
     // Cubemaps
-    image bakeCubemap(const std::string& filePath, bool addToCache = true);
+    // Bakes with a cacheKey (see getSourceKey) are stored under cache/ibl and loaded from there on later runs
+    image bakeCubemap(const std::string& filePath, bool addToCache = true, uint64_t cacheKey = 0);
     image bakeCubemapFromFlat(image img, bool addToCache = true);
 
-    // Lightmaps
-    image bakeIrradianceDiffuseLightmap(image img, bool addToCache = true);
-    image bakeIrradianceSpecularLightmap(image img, bool addToCache = true);
+    // Lightmaps, cacheKey identifies the environment they were baked from
+    image bakeIrradianceDiffuseLightmap(image img, bool addToCache = true, uint64_t cacheKey = 0);
+    image bakeIrradianceSpecularLightmap(image img, bool addToCache = true, uint64_t cacheKey = 0);
 
-    // BRDF LUT
+    // BRDF LUT, res/brdfLUT.ktx2 when it ships with the engine
     image bakeBRDF_LUT(bool addToCache = true);
     image* getBRDF_LUT();
 
+    // Content hash of a source file, 0 when it can't be read
+    uint64_t getSourceKey(const std::string& filePath) const;
+    // Copies a shader readable image back to the host, every level and face
+    ktx2Texture readbackTexture(const image& img);
+
     // ImageViews
     VkImageView createImageView(image& img, bool updateImageAttribute ,VkFormat format, VkImageAspectFlags aspectFlags, uint32_t baseMiplevel, uint32_t mipLevels, VkImageViewType viewType);
     VkImageView createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t baseMipLevel, uint32_t mipLevels, VkImageViewType viewType);
     VkImageView createTextureImageView(image& img, VkFormat format = VK_FORMAT_R8G8B8A8_SRGB, E_TextureType type = E_TextureType::DIFFUSE);
 
-    // Descriptor sets
-    std::vector<VkDescriptorImageInfo>& aggregateDescriptorTextureInfos(E_TextureType type,  size_t returnVectorSize);
+    // Bindless texture heap, cached textures are written into it as they are created
+    VkDescriptorSet& getBindlessDescriptorSet() { return _bindlessDescriptorSet; }
+    VkDescriptorSetLayout getBindlessDescriptorLayout() const { return _bindlessDescriptorLayout; }
 
     // Exists temporarily as some older code depends on overloading with a different signature
     void copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height);
 
     void transitionImageLayout(image& image, VkImageLayout newLayout);
 
+    // Mip chains are built by a single compute dispatch per image (res/shaders/spd), blits are the fallback
+    // Mip 0 must hold the data and every level must be in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, all end up shader readable
+    void generateMipMaps(image& img, VkFormat format);
+    // Usage flags an image needs to have its mips generated
+    VkImageUsageFlags getMipMapUsage(VkFormat format, uint32_t width, uint32_t height) const;
+
+    // Residency of textures streamed from KTX2 files
+    texture_streamer& getStreamer() { return _streamer; }
+    // Page streamed textures larger than VRAM, sampled through a page table
+    virtual_texture_system& getVirtualTextures() { return _virtualTextures; }
+
     // Resource release functions
     void cleanup();
     void cleanupImage(image& img);
 
 private:
 
+    void initBindlessHeap();
+    // Levels [firstLevel, end) of a KTX2 texture, without view or heap slot
+    image uploadTextureLevels(const ktx2Texture& texture, uint32_t firstLevel);
     void addTextureToCache(const E_TextureType type, image& img);
+    void addTextureToCache(const E_TextureType type, image& img, uint32_t slot);
+    uint32_t allocateBindlessSlot(const E_TextureType type);
+    void writeBindlessSlot(const image& img);
     bool hasStencilComponent(VkFormat format) const;
-    void generateMipMaps(VkImage& image, VkFormat format, uint32_t texWidth, uint32_t texHeight, uint32_t mipLevels, uint32_t layerCount = 1);
+
+    // On disk cache of baked maps, everything a bake depends on besides its source goes into the file name
+    struct bakeParameters
+    {
+        uint32_t version;
+        uint32_t size;
+        uint32_t mips;
+        uint32_t sampleCount;
+        uint32_t format;
+    };
+
+    // Bakes are recorded into one command buffer, framebuffers and views live until it has executed
+    struct bakeBatch
+    {
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+        VkFence fence = VK_NULL_HANDLE;
+        VkQueryPool timestamps = VK_NULL_HANDLE;    // null when the queue can't write timestamps
+        float timestampPeriod = 1.0f;               // nanoseconds per tick
+        std::vector<std::string> stages;
+        std::vector<VkFramebuffer> framebuffers;
+        std::vector<VkImageView> views;
+        std::vector<image> sources;                 // inputs destroyed after the submission
+    };
+
+    bakeBatch beginBake();
+    void beginBakeStage(bakeBatch& batch, const std::string& name);
+    void endBakeStage(bakeBatch& batch);
+    // Makes a baked image's color writes visible to later bakes sampling it
+    void recordBakeBarrier(bakeBatch& batch, const image& img);
+    void submitBake(bakeBatch& batch);
+
+    image recordCubemap(bakeBatch& batch, const image& flatImg);
+    image recordIrradianceDiffuse(bakeBatch& batch, const image& img);
+    image recordIrradianceSpecular(bakeBatch& batch, const image& img);
+    image recordBRDF_LUT(bakeBatch& batch);
+
+    std::string getBakeCachePath(uint64_t cacheKey, const std::string& name, const bakeParameters& parameters) const;
+    bool loadBakedTexture(const std::string& path, E_TextureType type, bool addToCache, image& img);
+    void storeBakedTexture(const std::string& path, const image& img);
+
+    // Compute mip generation, everything recorded for a batch is released once it has been submitted
+    struct mipGenerationBatch
+    {
+        memoryBuffer scratch{};
+        std::vector<VkImageView> views;
+    };
+
+    void initMipMapGeneration();
+    bool canGenerateMipMapsOnGPU(VkFormat format, uint32_t width, uint32_t height) const;
+    mipGenerationBatch recordMipMaps(VkCommandBuffer commandBuffer, const std::vector<image*>& images);
+    void releaseMipGenerationBatch(mipGenerationBatch& batch);
+    void recordBlitMipMaps(VkCommandBuffer commandBuffer, VkImage& image, VkFormat format, uint32_t texWidth, uint32_t texHeight, uint32_t mipLevels, uint32_t layerCount = 1);
 
     std::unordered_map<E_TextureType, std::shared_ptr<std::vector<image>>> _textures;
-    std::unordered_map<E_TextureType, std::vector<VkDescriptorImageInfo>> _textureDescriptors;
+
+    // Global heap, 2D textures and cubemaps are indexed separately
+    VkDescriptorSet _bindlessDescriptorSet = VK_NULL_HANDLE;
+    VkDescriptorSetLayout _bindlessDescriptorLayout = VK_NULL_HANDLE;
+    uint32_t _nextTexture2DSlot = 0;
+    uint32_t _nextTextureCubeSlot = 0;
+    std::vector<uint32_t> _freeTexture2DSlots;              // released slots, reused before the heap grows
+
+    // Shared texture index, 2D heap slot -> key and reference count
+    struct sharedTexture
+    {
+        uint64_t key;
+        uint32_t references;
+    };
+    std::unordered_map<uint64_t, uint32_t> _sharedTextureSlots;
+    std::unordered_map<uint32_t, sharedTexture> _sharedTextures;
 
     uint32_t _mipLevels = 1;                                // mip levels
+    bool _computeMipMaps = false;                           // device can run the SPD downsampler
     VkSampler _textureSampler;
     VkDescriptorImageInfo _textureSamplerDescriptor;
 
     image* _brdfLUT_id = nullptr;
+    std::vector<bakeStageTiming> _bakeTimings;
+
+    texture_streamer _streamer;
+    virtual_texture_system _virtualTextures;
 
     rendering_system* _core;
 };  
\ No newline at end of file
@@ -0,0 +1,282 @@
+#include "rendering/textureStreamer.hpp"
+
+#include "rendering/rendering.hpp"
+#include "core/settings.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // Levels at or below this size stay resident for the texture's whole life
+    const uint32_t kTailExtent = 64;
+    // Textures nobody asked for in this many frames drop back to their tail
+    const uint64_t kStaleFrames = 120;
+    // Every residency change is its own upload, this caps the stall per frame
+    const size_t kMaxChangesPerUpdate = 2;
+    // Share of the free driver reported budget streaming may use, the rest is headroom
+    const VkDeviceSize kBudgetPercent = 80;
+}
+
+texture_streamer::texture_streamer(rendering_system* core) :
+    _core(core)
+{
+    ;
+}
+
+void texture_streamer::init()
+{
+    _configuredBudget = static_cast<VkDeviceSize>(getSettingsData(_core->getRegistry()).textureBudgetMB) * 1024 * 1024;
+}
+
+uint32_t texture_streamer::streamTexture(const ktx2Texture& texture, E_TextureType type)
+{
+    texture_system& textures = _core->getTextureSystem();
+
+    // Cubemaps and textures without a mip chain are loaded whole
+    if(texture.faces != 1 || texture.levels.size() < 2 || type == E_TextureType::CUBEMAP)
+    {
+        return textures.createTexture(texture, type).id;
+    }
+
+    streamedTexture streamed;
+    streamed.source = texture;
+    streamed.tailMip = static_cast<uint32_t>(texture.levels.size()) - 1;
+    for(uint32_t level = 0; level < texture.levels.size(); level++)
+    {
+        if(std::max(texture.width >> level, texture.height >> level) <= kTailExtent)
+        {
+            streamed.tailMip = level;
+            break;
+        }
+    }
+    streamed.residentMip = streamed.tailMip;
+    streamed.requestedMip = streamed.tailMip;
+    streamed.lastRequestFrame = _frame;
+
+    // Only the tail goes up now, finer levels follow once something asks for them
+    streamed.img = textures.uploadTextureLevels(texture, streamed.residentMip);
+    textures.createTextureImageView(streamed.img, texture.format, type);
+
+    streamed.img.descriptor.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    streamed.img.descriptor.imageView = streamed.img.imageView;
+    streamed.img.descriptor.sampler = textures.getTextureSampler();
+
+    streamed.img.type = type;
+    streamed.img.id = textures.allocateBindlessSlot(type);
+    textures.writeBindlessSlot(streamed.img);
+
+    _residentBytes += getResidentSize(streamed, streamed.residentMip);
+
+    uint32_t id = streamed.img.id;
+    _textures[id] = std::move(streamed);
+
+    return id;
+}
+
+bool texture_streamer::isStreamed(uint32_t id) const
+{
+    return _textures.find(id) != _textures.end();
+}
+
+void texture_streamer::releaseTexture(uint32_t id)
+{
+    auto it = _textures.find(id);
+    if(it == _textures.end())
+    {
+        return;
+    }
+
+    _residentBytes -= getResidentSize(it->second, it->second.residentMip);
+    _core->getTextureSystem().cleanupImage(it->second.img);
+    _textures.erase(it);
+}
+
+void texture_streamer::requestResolution(uint32_t id, float screenPixels)
+{
+    auto it = _textures.find(id);
+    if(it == _textures.end())
+    {
+        return;
+    }
+
+    // Levels finer than one texel per pixel would only be minified away
+    const ktx2Texture& source = it->second.source;
+    float texels = static_cast<float>(std::max(source.width, source.height));
+    float mip = screenPixels > 1.0f ? std::floor(std::log2(texels / screenPixels)) : static_cast<float>(it->second.tailMip);
+
+    requestMip(id, static_cast<uint32_t>(std::max(mip, 0.0f)));
+}
+
+void texture_streamer::requestMip(uint32_t id, uint32_t mip)
+{
+    auto it = _textures.find(id);
+    if(it == _textures.end())
+    {
+        return;
+    }
+
+    streamedTexture& texture = it->second;
+    mip = std::min(mip, texture.tailMip);
+
+    // Within a frame the finest request wins, a new frame starts over
+    if(texture.lastRequestFrame != _frame)
+    {
+        texture.requestedMip = mip;
+        texture.lastRequestFrame = _frame;
+    }
+    else
+    {
+        texture.requestedMip = std::min(texture.requestedMip, mip);
+    }
+}
+
+void texture_streamer::update()
+{
+    struct residencyTarget
+    {
+        streamedTexture* texture;
+        uint32_t mip;
+    };
+
+    // 1 - What every texture would like resident
+    std::vector<residencyTarget> targets;
+    VkDeviceSize targetBytes = 0;
+
+    for(auto& [id, texture] : _textures)
+    {
+        uint32_t mip = _frame - texture.lastRequestFrame > kStaleFrames ? texture.tailMip : texture.requestedMip;
+
+        // Refinement goes one level per change, the coarse levels show up first
+        if(mip < texture.residentMip)
+        {
+            mip = texture.residentMip - 1;
+        }
+
+        targets.push_back({&texture, mip});
+        targetBytes += getResidentSize(texture, mip);
+    }
+
+    // 2 - Over budget, the least recently requested textures give up their finest levels first
+    std::sort(targets.begin(), targets.end(), [](const residencyTarget& a, const residencyTarget& b)
+    {
+        return a.texture->lastRequestFrame < b.texture->lastRequestFrame;
+    });
+
+    VkDeviceSize budget = getBudget();
+    for(residencyTarget& target : targets)
+    {
+        while(targetBytes > budget && target.mip < target.texture->tailMip)
+        {
+            targetBytes -= getResidentSize(*target.texture, target.mip) - getResidentSize(*target.texture, target.mip + 1);
+            target.mip++;
+        }
+    }
+
+    // 3 - Apply, evictions first so refinements land in the memory they free
+    std::stable_sort(targets.begin(), targets.end(), [](const residencyTarget& a, const residencyTarget& b)
+    {
+        return (a.mip > a.texture->residentMip) > (b.mip > b.texture->residentMip);
+    });
+
+    size_t changes = 0;
+    for(residencyTarget& target : targets)
+    {
+        if(changes == kMaxChangesPerUpdate)
+        {
+            break;
+        }
+
+        if(target.mip != target.texture->residentMip)
+        {
+            setResidentMip(*target.texture, target.mip);
+            changes++;
+        }
+    }
+
+    _frame++;
+}
+
+VkDeviceSize texture_streamer::getBudget() const
+{
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties{};
+    budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+    VkPhysicalDeviceMemoryProperties2 memoryProperties{};
+    memoryProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+    memoryProperties.pNext = _core->hasMemoryBudget() ? &budgetProperties : nullptr;
+
+    vkGetPhysicalDeviceMemoryProperties2(_core->getPhysicalDevice(), &memoryProperties);
+
+    VkDeviceSize heapSize = 0;
+    VkDeviceSize heapBudget = 0;
+    VkDeviceSize heapUsage = 0;
+    for(uint32_t i = 0; i < memoryProperties.memoryProperties.memoryHeapCount; i++)
+    {
+        if(memoryProperties.memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+        {
+            heapSize += memoryProperties.memoryProperties.memoryHeaps[i].size;
+            heapBudget += budgetProperties.heapBudget[i];
+            heapUsage += budgetProperties.heapUsage[i];
+        }
+    }
+
+    VkDeviceSize available;
+    if(_core->hasMemoryBudget())
+    {
+        // Whatever else lives on the GPU stays, streamed textures compete for the rest
+        VkDeviceSize otherUsage = heapUsage > _residentBytes ? heapUsage - _residentBytes : 0;
+        available = heapBudget > otherUsage ? (heapBudget - otherUsage) * kBudgetPercent / 100 : 0;
+    }
+    else
+    {
+        // No budget to read, assume half of device local memory is ours
+        available = heapSize / 2;
+    }
+
+    return _configuredBudget == 0 ? available : std::min(available, _configuredBudget);
+}
+
+VkDeviceSize texture_streamer::getResidentSize(const streamedTexture& texture, uint32_t firstMip) const
+{
+    VkDeviceSize size = 0;
+    for(size_t level = firstMip; level < texture.source.levels.size(); level++)
+    {
+        size += texture.source.levels[level].uncompressedSize;
+    }
+    return size;
+}
+
+void texture_streamer::setResidentMip(streamedTexture& texture, uint32_t mip)
+{
+    texture_system& textures = _core->getTextureSystem();
+
+    // Levels are read back from the file mapping, coarser levels included
+    image img = textures.uploadTextureLevels(texture.source, mip);
+    textures.createTextureImageView(img, texture.source.format, texture.img.type);
+
+    img.descriptor.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    img.descriptor.imageView = img.imageView;
+    img.descriptor.sampler = textures.getTextureSampler();
+    img.type = texture.img.type;
+    img.id = texture.img.id;
+
+    // The upload waited for the graphics queue to drain, no frame can still be sampling the old image
+    textures.writeBindlessSlot(img);
+    textures.cleanupImage(texture.img);
+
+    _residentBytes = _residentBytes - getResidentSize(texture, texture.residentMip) + getResidentSize(texture, mip);
+
+    texture.img = img;
+    texture.residentMip = mip;
+}
+
+void texture_streamer::cleanup()
+{
+    for(auto& [id, texture] : _textures)
+    {
+        _core->getTextureSystem().cleanupImage(texture.img);
+    }
+    _textures.clear();
+    _residentBytes = 0;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+// GLFW
+#include "wrapper/glfw.hpp"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "rendering/resources/texture.hpp"
+#include "util/ktx2.hpp"
+
+class rendering_system;
+
+// A texture whose finest mip levels are only resident while something on screen needs them
+struct streamedTexture
+{
+    ktx2Texture source;                 // keeps the file mapped, levels are read back from it on demand
+    image img;                          // holds levels [residentMip, source.levels.size()) of the file
+    uint32_t residentMip = 0;           // min LOD clamp, the finest level on the GPU
+    uint32_t tailMip = 0;               // coarsest residency, always loaded
+    uint32_t requestedMip = 0;          // finest level asked for since the last update
+    uint64_t lastRequestFrame = 0;
+};
+
+class texture_streamer
+{
+public:
+    texture_streamer(rendering_system* core);
+
+    void init();
+
+    // Creates the texture with only its small mip tail resident, returns its heap slot
+    uint32_t streamTexture(const ktx2Texture& texture, E_TextureType type = E_TextureType::DIFFUSE);
+    bool isStreamed(uint32_t id) const;
+    // Destroys the texture, its heap slot is left to the caller
+    void releaseTexture(uint32_t id);
+
+    // Feedback, the texture covers about screenPixels pixels along its largest axis
+    void requestResolution(uint32_t id, float screenPixels);
+    void requestMip(uint32_t id, uint32_t mip);
+
+    // Once per frame: drops stale requests, evicts down to the budget and refines one level at a time
+    void update();
+
+    // Bytes of streamed texture memory allowed on the GPU
+    VkDeviceSize getBudget() const;
+    VkDeviceSize getResidentBytes() const { return _residentBytes; }
+
+    void cleanup();
+
+private:
+    VkDeviceSize getResidentSize(const streamedTexture& texture, uint32_t firstMip) const;
+    void setResidentMip(streamedTexture& texture, uint32_t mip);
+
+    std::unordered_map<uint32_t, streamedTexture> _textures;   // keyed by heap slot
+
+    VkDeviceSize _residentBytes = 0;
+    VkDeviceSize _configuredBudget = 0;                          // 0 when only the driver budget applies
+    uint64_t _frame = 0;
+
+    rendering_system* _core;
+};
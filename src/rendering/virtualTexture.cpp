@@ -0,0 +1,435 @@
+#include "rendering/virtualTexture.hpp"
+
+#include "rendering/rendering.hpp"
+#include "core/settings.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace
+{
+    // Physical atlas, kAtlasPages x kAtlasPages slots of kPageStride texels (120 payload + 2 * 4 border)
+    const uint32_t kAtlasPages = 32;
+    const uint32_t kPageStride = 128;
+    const VkFormat kAtlasFormat = VK_FORMAT_R8G8B8A8_SRGB;
+
+    // Shared by every virtual texture, sizes the shader storage buffers
+    const uint32_t kMaxVirtualTextures = 64;
+    const uint32_t kMaxVirtualPages = 1 << 18;
+
+    // Every upload waits for the queue, this caps the stall per frame
+    const size_t kMaxPageUploadsPerUpdate = 16;
+
+    const uint32_t kNotResident = ~0u;
+
+    // Mirrors struct VirtualTexture in res/shaders/basic/basic.frag
+    struct virtualTextureInfo
+    {
+        uint32_t pageTableBase;
+        uint32_t atlas;
+        uint32_t width;
+        uint32_t height;
+        uint32_t mipCount;
+        uint32_t pageSize;
+        uint32_t border;
+        uint32_t padding;
+    };
+
+    // Page table entry: atlas slot column, row and the mip level the slot holds
+    uint32_t packPageEntry(uint32_t slot, uint32_t mip)
+    {
+        return (slot % kAtlasPages) | (slot / kAtlasPages) << 12 | mip << 24;
+    }
+}
+
+virtual_texture_system::virtual_texture_system(rendering_system* core) :
+    _core(core)
+{
+    ;
+}
+
+void virtual_texture_system::init()
+{
+    memory_system& memory = _core->getMemorySystem();
+    VkMemoryPropertyFlags hostVisible = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+    VkDeviceSize infoSize = kMaxVirtualTextures * sizeof(virtualTextureInfo);
+    _infoBuffer = memory.createBuffer(infoSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, hostVisible);
+    _infoBuffer.descriptorInfo = {_infoBuffer.buffer, 0, infoSize};
+    vkMapMemory(_core->getLogicalDevice(), _infoBuffer.memory, 0, infoSize, 0, &_infoBuffer.mappedTo);
+    std::memset(_infoBuffer.mappedTo, 0, infoSize);
+
+    VkDeviceSize pageTableSize = kMaxVirtualPages * sizeof(uint32_t);
+    _pageTableBuffer = memory.createBuffer(pageTableSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, hostVisible);
+    _pageTableBuffer.descriptorInfo = {_pageTableBuffer.buffer, 0, pageTableSize};
+    vkMapMemory(_core->getLogicalDevice(), _pageTableBuffer.memory, 0, pageTableSize, 0, &_pageTableBuffer.mappedTo);
+    std::memset(_pageTableBuffer.mappedTo, 0, pageTableSize);
+
+    // One bit per page table entry, a frame's bits are read back once its fence has signaled
+    VkDeviceSize feedbackSize = kMaxVirtualPages / 32 * sizeof(uint32_t);
+    unsigned int framesInFlight = getSettingsData(_core->getRegistry()).framesInFlight;
+    for(unsigned int i = 0; i < framesInFlight; i++)
+    {
+        memoryBuffer feedback = memory.createBuffer(feedbackSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, hostVisible);
+        feedback.descriptorInfo = {feedback.buffer, 0, feedbackSize};
+        vkMapMemory(_core->getLogicalDevice(), feedback.memory, 0, feedbackSize, 0, &feedback.mappedTo);
+        std::memset(feedback.mappedTo, 0, feedbackSize);
+        _feedbackBuffers.push_back(feedback);
+    }
+}
+
+void virtual_texture_system::createAtlas()
+{
+    texture_system& textures = _core->getTextureSystem();
+
+    _atlas = textures.createImage(kAtlasPages * kPageStride, kAtlasPages * kPageStride, 1, kAtlasFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    textures.createTextureImageView(_atlas, kAtlasFormat, E_TextureType::DIFFUSE);
+    textures.transitionImageLayout(_atlas, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+    _atlas.descriptor.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    _atlas.descriptor.imageView = _atlas.imageView;
+    _atlas.descriptor.sampler = textures.getTextureSampler();
+
+    _atlas.type = E_TextureType::DIFFUSE;
+    _atlas.id = textures.allocateBindlessSlot(E_TextureType::DIFFUSE);
+    textures.writeBindlessSlot(_atlas);
+
+    _pages.resize(kAtlasPages * kAtlasPages);
+    for(uint32_t slot = kAtlasPages * kAtlasPages; slot-- > 0;)
+    {
+        _freeSlots.push_back(slot);
+    }
+
+    _hasAtlas = true;
+}
+
+uint32_t virtual_texture_system::createVirtualTexture(const std::string& filePath)
+{
+    auto existing = _texturePaths.find(filePath);
+    if(existing != _texturePaths.end())
+    {
+        return existing->second | kVirtualTextureBit;
+    }
+
+    virtualTexture texture;
+    texture.source = vtex::load(filePath);
+
+    const virtualTextureFile& source = texture.source;
+    if(source.format != kAtlasFormat || source.getPageStride() != kPageStride)
+    {
+        throw std::runtime_error("Virtual texture pages don't match the atlas: " + filePath);
+    }
+    if(_textures.size() == kMaxVirtualTextures || _nextPageTableEntry + source.getPageCount() > kMaxVirtualPages)
+    {
+        throw std::runtime_error("Out of virtual texture page table space: " + filePath);
+    }
+
+    if(!_hasAtlas)
+    {
+        createAtlas();
+    }
+
+    texture.pageTableBase = _nextPageTableEntry;
+    texture.slots.assign(source.getPageCount(), kNotResident);
+    _nextPageTableEntry += source.getPageCount();
+
+    uint32_t index = static_cast<uint32_t>(_textures.size());
+
+    virtualTextureInfo info{};
+    info.pageTableBase = texture.pageTableBase;
+    info.atlas = _atlas.id;
+    info.width = source.width;
+    info.height = source.height;
+    info.mipCount = source.mipCount;
+    info.pageSize = source.pageSize;
+    info.border = source.border;
+    static_cast<virtualTextureInfo*>(_infoBuffer.mappedTo)[index] = info;
+
+    _textures.push_back(std::move(texture));
+    _texturePaths[filePath] = index;
+
+    // The last mip is a single page, everything falls back to it until finer pages arrive
+    pageRequest tail{index, _textures[index].source.getPageCount() - 1, _textures[index].source.mipCount - 1};
+    uint32_t slot = acquireSlot();
+    if(slot == kNotResident)
+    {
+        throw std::runtime_error("Virtual texture atlas is full of pinned pages: " + filePath);
+    }
+    uploadPages({tail}, {slot});
+    _pages[slot].pinned = true;
+
+    writePageTable(_textures[index]);
+
+    return index | kVirtualTextureBit;
+}
+
+void virtual_texture_system::update(uint32_t frame)
+{
+    if(_textures.empty())
+    {
+        _frame++;
+        return;
+    }
+
+    // 1 - Pages the frame sampled, each one brings its coarser ancestors along
+    uint32_t* feedback = static_cast<uint32_t*>(_feedbackBuffers[frame].mappedTo);
+    uint32_t feedbackWords = (_nextPageTableEntry + 31) / 32;
+
+    std::vector<pageRequest> missing;
+    std::unordered_set<uint64_t> missingKeys;
+    for(uint32_t word = 0; word < feedbackWords; word++)
+    {
+        uint32_t bits = feedback[word];
+        while(bits != 0)
+        {
+            uint32_t bit = 0;
+            while(!(bits & (1u << bit)))
+            {
+                bit++;
+            }
+            bits &= bits - 1;
+
+            uint32_t entry = word * 32 + bit;
+            auto owner = std::upper_bound(_textures.begin(), _textures.end(), entry, [](uint32_t value, const virtualTexture& texture)
+            {
+                return value < texture.pageTableBase;
+            });
+            uint32_t textureIndex = static_cast<uint32_t>(owner - _textures.begin()) - 1;
+            virtualTexture& texture = _textures[textureIndex];
+
+            for(uint32_t page = entry - texture.pageTableBase; page != kNotResident; page = getParentPage(texture.source, page))
+            {
+                uint32_t slot = texture.slots[page];
+                if(slot != kNotResident)
+                {
+                    // Ancestors of a resident page were already visited by an earlier request or the tail
+                    if(_pages[slot].lastUsedFrame == _frame)
+                    {
+                        break;
+                    }
+                    _pages[slot].lastUsedFrame = _frame;
+                }
+                else if(missingKeys.insert(static_cast<uint64_t>(textureIndex) << 32 | page).second)
+                {
+                    missing.push_back({textureIndex, page, getPageMip(texture.source, page)});
+                }
+            }
+        }
+    }
+    std::memset(feedback, 0, feedbackWords * sizeof(uint32_t));
+
+    // 2 - Coarse pages first so the fallback improves a level at a time
+    std::stable_sort(missing.begin(), missing.end(), [](const pageRequest& a, const pageRequest& b)
+    {
+        return a.mip > b.mip;
+    });
+
+    std::vector<pageRequest> uploads;
+    std::vector<uint32_t> slots;
+    for(const pageRequest& request : missing)
+    {
+        if(uploads.size() == kMaxPageUploadsPerUpdate)
+        {
+            break;
+        }
+
+        uint32_t slot = acquireSlot();
+        if(slot == kNotResident)
+        {
+            break;
+        }
+        uploads.push_back(request);
+        slots.push_back(slot);
+    }
+
+    // 3 - Upload, then point the page tables at the new pages
+    if(!uploads.empty())
+    {
+        uploadPages(uploads, slots);
+    }
+
+    for(virtualTexture& texture : _textures)
+    {
+        if(texture.dirty)
+        {
+            writePageTable(texture);
+        }
+    }
+
+    _frame++;
+}
+
+uint32_t virtual_texture_system::acquireSlot()
+{
+    if(!_freeSlots.empty())
+    {
+        uint32_t slot = _freeSlots.back();
+        _freeSlots.pop_back();
+        _pages[slot].lastUsedFrame = _frame;
+        return slot;
+    }
+
+    // Least recently used page nothing asked for this frame
+    uint32_t victim = kNotResident;
+    for(uint32_t slot = 0; slot < _pages.size(); slot++)
+    {
+        const physicalPage& page = _pages[slot];
+        if(page.pinned || page.lastUsedFrame == _frame)
+        {
+            continue;
+        }
+        if(victim == kNotResident || page.lastUsedFrame < _pages[victim].lastUsedFrame)
+        {
+            victim = slot;
+        }
+    }
+
+    if(victim != kNotResident)
+    {
+        virtualTexture& owner = _textures[_pages[victim].texture];
+        owner.slots[_pages[victim].page] = kNotResident;
+        owner.dirty = true;
+
+        // Taken for this frame's uploads, later evictions look elsewhere
+        _pages[victim].lastUsedFrame = _frame;
+    }
+
+    return victim;
+}
+
+void virtual_texture_system::uploadPages(const std::vector<pageRequest>& requests, const std::vector<uint32_t>& slots)
+{
+    size_t pageBytes = static_cast<size_t>(kPageStride) * kPageStride * 4;
+    VkDeviceSize stagingSize = requests.size() * pageBytes;
+
+    memoryBuffer stagingBuffer = _core->getMemorySystem().createBuffer(stagingSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+    void* data;
+    vkMapMemory(_core->getLogicalDevice(), stagingBuffer.memory, 0, stagingSize, 0, &data);
+
+    // Pages go straight from the file mapping into staging memory, one region each
+    std::vector<VkBufferImageCopy> regions;
+    for(size_t i = 0; i < requests.size(); i++)
+    {
+        std::memcpy(static_cast<uint8_t*>(data) + i * pageBytes, _textures[requests[i].texture].source.getPage(requests[i].page), pageBytes);
+
+        VkBufferImageCopy region = {};
+        region.bufferOffset = i * pageBytes;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = 0;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = 1;
+        region.imageOffset = {static_cast<int32_t>(slots[i] % kAtlasPages * kPageStride), static_cast<int32_t>(slots[i] / kAtlasPages * kPageStride), 0};
+        region.imageExtent = {kPageStride, kPageStride, 1};
+        regions.push_back(region);
+
+        physicalPage& page = _pages[slots[i]];
+        page.texture = requests[i].texture;
+        page.page = requests[i].page;
+        page.lastUsedFrame = _frame;
+        page.pinned = false;
+
+        _textures[requests[i].texture].slots[requests[i].page] = slots[i];
+        _textures[requests[i].texture].dirty = true;
+    }
+    vkUnmapMemory(_core->getLogicalDevice(), stagingBuffer.memory);
+
+    // Evicted slots are overwritten here, the barrier waits for every earlier frame still sampling them
+    texture_system& textures = _core->getTextureSystem();
+    textures.transitionImageLayout(_atlas, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+
+    VkCommandBuffer commandBuffer = _core->getCommandBufferSystem().beginSingleTimeCommands();
+    vkCmdCopyBufferToImage(commandBuffer, stagingBuffer.buffer, _atlas.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(regions.size()), regions.data());
+    _core->getCommandBufferSystem().endSingleTimeCommands(commandBuffer);
+
+    textures.transitionImageLayout(_atlas, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+    _core->getMemorySystem().freeBuffer(stagingBuffer);
+}
+
+void virtual_texture_system::writePageTable(virtualTexture& texture)
+{
+    const virtualTextureFile& source = texture.source;
+    uint32_t* table = static_cast<uint32_t*>(_pageTableBuffer.mappedTo) + texture.pageTableBase;
+
+    // Coarse to fine, a page that isn't resident borrows the entry its parent ended up with
+    for(uint32_t mip = source.mipCount; mip-- > 0;)
+    {
+        for(uint32_t page = source.firstPage[mip]; page < source.firstPage[mip] + source.pagesX[mip] * source.pagesY[mip]; page++)
+        {
+            uint32_t slot = texture.slots[page];
+            uint32_t parent = getParentPage(source, page);
+
+            if(slot != kNotResident)
+            {
+                table[page] = packPageEntry(slot, mip);
+            }
+            else if(parent != kNotResident)
+            {
+                table[page] = table[parent];
+            }
+        }
+    }
+
+    texture.dirty = false;
+}
+
+uint32_t virtual_texture_system::getPageMip(const virtualTextureFile& file, uint32_t page) const
+{
+    uint32_t mip = 0;
+    while(mip + 1 < file.mipCount && page >= file.firstPage[mip + 1])
+    {
+        mip++;
+    }
+    return mip;
+}
+
+uint32_t virtual_texture_system::getParentPage(const virtualTextureFile& file, uint32_t page) const
+{
+    uint32_t mip = getPageMip(file, page);
+    if(mip + 1 == file.mipCount)
+    {
+        return kNotResident;
+    }
+
+    uint32_t local = page - file.firstPage[mip];
+    uint32_t x = std::min((local % file.pagesX[mip]) / 2, file.pagesX[mip + 1] - 1);
+    uint32_t y = std::min((local / file.pagesX[mip]) / 2, file.pagesY[mip + 1] - 1);
+
+    return file.getPageIndex(mip + 1, x, y);
+}
+
+void virtual_texture_system::recordFeedbackBarrier(VkCommandBuffer commandBuffer) const
+{
+    // The buffers are coherent, the fence wait in front of update() only needs the writes to reach the host domain
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+void virtual_texture_system::cleanup()
+{
+    if(_hasAtlas)
+    {
+        _core->getTextureSystem().cleanupImage(_atlas);
+        _hasAtlas = false;
+    }
+    _textures.clear();
+    _texturePaths.clear();
+    _pages.clear();
+    _freeSlots.clear();
+
+    memory_system& memory = _core->getMemorySystem();
+    memory.freeBuffer(_infoBuffer);
+    memory.freeBuffer(_pageTableBuffer);
+    for(memoryBuffer& feedback : _feedbackBuffers)
+    {
+        memory.freeBuffer(feedback);
+    }
+    _feedbackBuffers.clear();
+}
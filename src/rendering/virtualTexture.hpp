@@ -0,0 +1,94 @@
+#pragma once
+
+// GLFW
+#include "wrapper/glfw.hpp"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "rendering/resources/texture.hpp"
+#include "rendering/resources/memory.hpp"
+#include "util/virtualTextureFile.hpp"
+
+class rendering_system;
+
+// A texture of any size, only the pages something on screen sampled are kept in the physical atlas
+struct virtualTexture
+{
+    virtualTextureFile source;          // keeps the file mapped, pages are read back from it on demand
+    uint32_t pageTableBase = 0;         // first entry of the texture in the shared page table
+    std::vector<uint32_t> slots;        // atlas slot of every page, kNotResident when it isn't loaded
+    bool dirty = true;                  // page table entries need to be rebuilt
+};
+
+class virtual_texture_system
+{
+public:
+    // Mesh texture indices with this bit set name a virtual texture instead of a heap slot
+    static const uint32_t kVirtualTextureBit = 0x80000000u;
+
+    virtual_texture_system(rendering_system* core);
+
+    void init();
+
+    // Maps a .vtex file and makes its coarsest page resident, returns the flagged index meshes sample it through
+    uint32_t createVirtualTexture(const std::string& filePath);
+
+    // Once per frame, after the frame's fence: reads what the frame asked for and streams missing pages coarse first
+    void update(uint32_t frame);
+    // After the frame's render pass, makes the fragment shader feedback writes visible to update()
+    void recordFeedbackBarrier(VkCommandBuffer commandBuffer) const;
+
+    // Shader inputs, set 0 bindings 3 (texture info), 4 (page table) and 5 (feedback of one frame)
+    const VkDescriptorBufferInfo& getInfoDescriptor() const { return _infoBuffer.descriptorInfo; }
+    const VkDescriptorBufferInfo& getPageTableDescriptor() const { return _pageTableBuffer.descriptorInfo; }
+    const VkDescriptorBufferInfo& getFeedbackDescriptor(uint32_t frame) const { return _feedbackBuffers[frame].descriptorInfo; }
+
+    void cleanup();
+
+private:
+    // Occupant of one atlas slot
+    struct physicalPage
+    {
+        uint32_t texture = 0;
+        uint32_t page = 0;
+        uint64_t lastUsedFrame = 0;
+        bool pinned = false;            // coarsest pages are never evicted
+    };
+
+    struct pageRequest
+    {
+        uint32_t texture;
+        uint32_t page;
+        uint32_t mip;
+    };
+
+    void createAtlas();
+    uint32_t acquireSlot();
+    void uploadPages(const std::vector<pageRequest>& requests, const std::vector<uint32_t>& slots);
+    void writePageTable(virtualTexture& texture);
+
+    uint32_t getPageMip(const virtualTextureFile& file, uint32_t page) const;
+    uint32_t getParentPage(const virtualTextureFile& file, uint32_t page) const;
+
+    std::vector<virtualTexture> _textures;
+    std::unordered_map<std::string, uint32_t> _texturePaths;
+    uint32_t _nextPageTableEntry = 0;
+
+    // Physical atlas, square pages of the same stride in every file
+    image _atlas{};
+    bool _hasAtlas = false;
+    std::vector<physicalPage> _pages;
+    std::vector<uint32_t> _freeSlots;
+
+    // Host visible and persistently mapped
+    memoryBuffer _infoBuffer{};
+    memoryBuffer _pageTableBuffer{};
+    std::vector<memoryBuffer> _feedbackBuffers;  // one per frame in flight
+
+    uint64_t _frame = 0;
+
+    rendering_system* _core;
+};
@@ -17,7 +17,7 @@ namespace
     //     1.0f, -1.0f, 0.0f, 1.0f, 0.0f,
     // };
 
-    Mesh quadMesh;
+    meshGeometry quadMesh;
     bool quadMesh_init = false;
 
     Model quadModel;
@@ -37,7 +37,7 @@ namespace
         1.0f, 0.0f
     };
 
-    std::vector<unsigned int> quadIndices = {
+    std::vector<uint32_t> quadIndices = {
         0, 2, 1,
         2, 3, 1
     };
@@ -59,7 +59,7 @@ namespace
          1.0f,  1.0f,  1.0f         // 7 Back-top-right
     };
 
-    std::vector<unsigned int> cubeIndices = {
+    std::vector<uint32_t> cubeIndices = {
         0, 2, 1, 2, 0, 3, // Front face
         4, 5, 6, 6, 7, 4, // Back face
         0, 7, 3, 7, 0, 4, // Top face
@@ -68,7 +68,7 @@ namespace
         3, 6, 2, 6, 3, 7  // Right face
     };
 
-    std::vector<unsigned int> cubeIndicesFlipped = {
+    std::vector<uint32_t> cubeIndicesFlipped = {
         0, 1, 2, 2, 3, 0, // Front face
         4, 6, 5, 6, 4, 7, // Back face
         0, 3, 7, 7, 4, 0, // Top face
@@ -146,7 +146,7 @@ namespace shapes
 {
     namespace quad
     {
-        Mesh mesh()
+        meshGeometry mesh()
         {
             if (!quadMesh_init)
             {
@@ -156,11 +156,9 @@ namespace shapes
                     Vertex vertex;
                     vertex.Position = glm::vec3(quadVertices[i*3], quadVertices[i*3 + 1], quadVertices[i*3 + 2]);
                     vertex.TexCoords = glm::vec2(quadVertices[i*2], quadVertices[i*2 + 1]);
-                    quadMesh.vertexData.push_back(vertex);
+                    quadMesh.vertices.push_back(vertex);
                 }
-                quadMesh.indexData = quadIndices;
-
-                quadMesh.path = "Quad";
+                quadMesh.indices = quadIndices;
             }
             return quadMesh;
         }
@@ -177,18 +175,12 @@ namespace shapes
                 cubeModel.path = "Cube";
                 cubeModel.name = "Cube";
 
+                // CPU only, nothing is uploaded
                 Mesh cubeMesh;
-
-                unsigned int cubeVerticesSize = cubeVertices.size();
-
-                for (unsigned int i = 0; i < cubeVertices.size(); i += 3)
-                {
-                    Vertex vertex;
-                    vertex.Position = glm::vec3(cubeVertices[i] , cubeVertices[i + 1], cubeVertices[i + 2]);
-                    vertex.Color = glm::vec3(color[0], color[1], color[2]);
-                    cubeMesh.vertexData.push_back(vertex);
-                }
-                cubeMesh.indexData = cubeIndices;
+                std::shared_ptr<const meshGeometry> geometry = std::make_shared<meshGeometry>(mesh(color));
+                cubeMesh.vertexCount = static_cast<uint32_t>(geometry->vertices.size());
+                cubeMesh.indexCount = static_cast<uint32_t>(geometry->indices.size());
+                cubeMesh.geometry = geometry;
                 cubeMesh.path = "Cube";
                 cubeModel.meshes = std::make_shared<std::vector<Mesh>>();
                 cubeModel.meshes->push_back(cubeMesh);
@@ -198,20 +190,18 @@ namespace shapes
             return cubeModel;
         }
 
-        Mesh mesh(const glm::vec3& color)
+        meshGeometry mesh(const glm::vec3& color)
         {
-            Mesh cubeMesh;
+            meshGeometry cubeMesh;
 
             for (unsigned int i = 0; i < cubeVertices.size(); i += 3)
             {
                 Vertex vertex;
                 vertex.Position = glm::vec3(cubeVertices[i], cubeVertices[i + 1], cubeVertices[i + 2]);
                 vertex.Color = glm::vec3(color[0], color[1], color[2]);
-                cubeMesh.vertexData.push_back(vertex);
+                cubeMesh.vertices.push_back(vertex);
             }
-            cubeMesh.indexData = cubeIndices;
-
-            cubeMesh.path = "Cube";
+            cubeMesh.indices = cubeIndices;
 
             return cubeMesh;
         }
@@ -220,20 +210,18 @@ namespace shapes
 
     namespace cube_flipped
     {
-        Mesh mesh(const glm::vec3& color)
+        meshGeometry mesh(const glm::vec3& color)
         {
-            Mesh cubeMesh;
+            meshGeometry cubeMesh;
 
             for (unsigned int i = 0; i < cubeVertices.size(); i += 3)
             {
                 Vertex vertex;
                 vertex.Position = glm::vec3(cubeVertices[i], cubeVertices[i + 1], cubeVertices[i + 2]);
                 vertex.Color = glm::vec3(color[0], color[1], color[2]);
-                cubeMesh.vertexData.push_back(vertex);
+                cubeMesh.vertices.push_back(vertex);
             }
-            cubeMesh.indexData = cubeIndicesFlipped;
-
-            cubeMesh.path = "CubeFlipped";
+            cubeMesh.indices = cubeIndicesFlipped;
 
             return cubeMesh;
         }
@@ -6,25 +6,25 @@
 #include <array>
 
 struct Model;
-struct Mesh;
+struct meshGeometry;
 
 namespace shapes
 {
     namespace quad
     {
         Model model();
-        Mesh mesh();
+        meshGeometry mesh();
     }
 
     namespace cube
     {
         Model model(const glm::vec3& pos = glm::vec3(0.0f), const glm::vec3& color = {1.0f, 1.0f, 1.0f});
-        Mesh mesh(const glm::vec3& color = {1.0f, 1.0f, 1.0f});
+        meshGeometry mesh(const glm::vec3& color = {1.0f, 1.0f, 1.0f});
     }
 
     namespace cube_flipped
     {
-        Mesh mesh(const glm::vec3& color = {1.0f, 1.0f, 1.0f});
+        meshGeometry mesh(const glm::vec3& color = {1.0f, 1.0f, 1.0f});
     }
 
     namespace sphere
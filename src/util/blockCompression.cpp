@@ -0,0 +1,973 @@
+#include "util/blockCompression.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+    // Interpolation weights shared by BC6H and BC7 4 bit indices
+    const int kWeights4[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+    // Number of least squares refinement passes run after the initial principal axis fit
+    const int kRefinementPasses = 2;
+
+    // Packs values LSB first, the bit order used by every BCn format
+    struct bitWriter
+    {
+        uint8_t* data;
+        uint32_t position = 0;
+
+        void write(uint32_t value, uint32_t bits)
+        {
+            for(uint32_t i = 0; i < bits; i++)
+            {
+                if((value >> i) & 1u)
+                {
+                    data[position >> 3] |= static_cast<uint8_t>(1u << (position & 7u));
+                }
+                position++;
+            }
+        }
+    };
+
+    // Endpoints along the principal axis of the block's colors
+    template<int N>
+    void fitPrincipalAxis(const float pixels[16][N], float lo[N], float hi[N])
+    {
+        float mean[N] = {};
+        for(int i = 0; i < 16; i++)
+        {
+            for(int c = 0; c < N; c++)
+            {
+                mean[c] += pixels[i][c] / 16.0f;
+            }
+        }
+
+        float covariance[N][N] = {};
+        for(int i = 0; i < 16; i++)
+        {
+            for(int a = 0; a < N; a++)
+            {
+                for(int b = 0; b < N; b++)
+                {
+                    covariance[a][b] += (pixels[i][a] - mean[a]) * (pixels[i][b] - mean[b]);
+                }
+            }
+        }
+
+        // Power iteration, seeded with the bounding box diagonal
+        float axis[N];
+        for(int c = 0; c < N; c++)
+        {
+            float minValue = pixels[0][c];
+            float maxValue = pixels[0][c];
+            for(int i = 1; i < 16; i++)
+            {
+                minValue = std::min(minValue, pixels[i][c]);
+                maxValue = std::max(maxValue, pixels[i][c]);
+            }
+            axis[c] = maxValue - minValue;
+        }
+
+        for(int iteration = 0; iteration < 8; iteration++)
+        {
+            float next[N] = {};
+            float length = 0.0f;
+            for(int a = 0; a < N; a++)
+            {
+                for(int b = 0; b < N; b++)
+                {
+                    next[a] += covariance[a][b] * axis[b];
+                }
+                length = std::max(length, std::fabs(next[a]));
+            }
+
+            if(length < 1e-12f)
+            {
+                break;
+            }
+
+            for(int c = 0; c < N; c++)
+            {
+                axis[c] = next[c] / length;
+            }
+        }
+
+        float axisLength = 0.0f;
+        for(int c = 0; c < N; c++)
+        {
+            axisLength += axis[c] * axis[c];
+        }
+
+        // Flat block
+        if(axisLength < 1e-12f)
+        {
+            for(int c = 0; c < N; c++)
+            {
+                lo[c] = hi[c] = mean[c];
+            }
+            return;
+        }
+
+        axisLength = std::sqrt(axisLength);
+        for(int c = 0; c < N; c++)
+        {
+            axis[c] /= axisLength;
+        }
+
+        float minT = 0.0f;
+        float maxT = 0.0f;
+        for(int i = 0; i < 16; i++)
+        {
+            float t = 0.0f;
+            for(int c = 0; c < N; c++)
+            {
+                t += (pixels[i][c] - mean[c]) * axis[c];
+            }
+            minT = std::min(minT, t);
+            maxT = std::max(maxT, t);
+        }
+
+        for(int c = 0; c < N; c++)
+        {
+            lo[c] = mean[c] + axis[c] * minT;
+            hi[c] = mean[c] + axis[c] * maxT;
+        }
+    }
+
+    // Solves for the endpoints that best reproduce the block given fixed interpolation weights
+    template<int N>
+    bool refineEndpoints(const float pixels[16][N], const float weights[16], float lo[N], float hi[N])
+    {
+        float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+        float ax[N] = {};
+        float bx[N] = {};
+
+        for(int i = 0; i < 16; i++)
+        {
+            float b = weights[i];
+            float a = 1.0f - b;
+
+            aa += a * a;
+            ab += a * b;
+            bb += b * b;
+
+            for(int c = 0; c < N; c++)
+            {
+                ax[c] += a * pixels[i][c];
+                bx[c] += b * pixels[i][c];
+            }
+        }
+
+        float determinant = aa * bb - ab * ab;
+        if(std::fabs(determinant) < 1e-6f)
+        {
+            return false;
+        }
+
+        for(int c = 0; c < N; c++)
+        {
+            lo[c] = (ax[c] * bb - bx[c] * ab) / determinant;
+            hi[c] = (bx[c] * aa - ax[c] * ab) / determinant;
+        }
+        return true;
+    }
+
+    template<int N>
+    int nearestPaletteEntry(const float pixel[N], const float palette[][N], int paletteSize, float& error)
+    {
+        int best = 0;
+        error = 1e30f;
+
+        for(int p = 0; p < paletteSize; p++)
+        {
+            float distance = 0.0f;
+            for(int c = 0; c < N; c++)
+            {
+                float d = pixel[c] - palette[p][c];
+                distance += d * d;
+            }
+
+            if(distance < error)
+            {
+                error = distance;
+                best = p;
+            }
+        }
+        return best;
+    }
+
+    //// BC1
+
+    struct bc1Candidate
+    {
+        uint16_t color0 = 0;
+        uint16_t color1 = 0;
+        uint8_t indices[16] = {};
+        float error = 1e30f;
+    };
+
+    uint16_t packRGB565(const float color[3])
+    {
+        int r = std::clamp(static_cast<int>(std::lround(color[0] * 31.0f / 255.0f)), 0, 31);
+        int g = std::clamp(static_cast<int>(std::lround(color[1] * 63.0f / 255.0f)), 0, 63);
+        int b = std::clamp(static_cast<int>(std::lround(color[2] * 31.0f / 255.0f)), 0, 31);
+        return static_cast<uint16_t>(r << 11 | g << 5 | b);
+    }
+
+    void unpackRGB565(uint16_t packed, float color[3])
+    {
+        int r = (packed >> 11) & 31;
+        int g = (packed >> 5) & 63;
+        int b = packed & 31;
+        color[0] = static_cast<float>(r << 3 | r >> 2);
+        color[1] = static_cast<float>(g << 2 | g >> 4);
+        color[2] = static_cast<float>(b << 3 | b >> 2);
+    }
+
+    bc1Candidate evaluateBC1(const float pixels[16][3], const float lo[3], const float hi[3])
+    {
+        bc1Candidate candidate;
+        candidate.color0 = packRGB565(hi);
+        candidate.color1 = packRGB565(lo);
+
+        // Four color mode needs color0 > color1, equal endpoints collapse to index 0
+        if(candidate.color0 < candidate.color1)
+        {
+            std::swap(candidate.color0, candidate.color1);
+        }
+
+        float palette[4][3];
+        unpackRGB565(candidate.color0, palette[0]);
+        unpackRGB565(candidate.color1, palette[1]);
+        for(int c = 0; c < 3; c++)
+        {
+            palette[2][c] = std::floor((2.0f * palette[0][c] + palette[1][c]) / 3.0f);
+            palette[3][c] = std::floor((palette[0][c] + 2.0f * palette[1][c]) / 3.0f);
+        }
+
+        int paletteSize = candidate.color0 == candidate.color1 ? 1 : 4;
+
+        candidate.error = 0.0f;
+        for(int i = 0; i < 16; i++)
+        {
+            float error;
+            candidate.indices[i] = static_cast<uint8_t>(nearestPaletteEntry<3>(pixels[i], palette, paletteSize, error));
+            candidate.error += error;
+        }
+        return candidate;
+    }
+
+    void encodeBC1Color(const uint8_t rgba[64], uint8_t out[8])
+    {
+        float pixels[16][3];
+        for(int i = 0; i < 16; i++)
+        {
+            for(int c = 0; c < 3; c++)
+            {
+                pixels[i][c] = rgba[i * 4 + c];
+            }
+        }
+
+        float lo[3], hi[3];
+        fitPrincipalAxis<3>(pixels, lo, hi);
+        bc1Candidate best = evaluateBC1(pixels, lo, hi);
+
+        // Palette position of each index in the four color mode
+        const float indexWeights[4] = {0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f};
+
+        for(int pass = 0; pass < kRefinementPasses && best.color0 != best.color1; pass++)
+        {
+            float weights[16];
+            for(int i = 0; i < 16; i++)
+            {
+                weights[i] = indexWeights[best.indices[i]];
+            }
+
+            // Weights run from color0 (0) to color1 (1)
+            if(!refineEndpoints<3>(pixels, weights, hi, lo))
+            {
+                break;
+            }
+
+            bc1Candidate candidate = evaluateBC1(pixels, lo, hi);
+            if(candidate.error >= best.error)
+            {
+                break;
+            }
+            best = candidate;
+        }
+
+        out[0] = static_cast<uint8_t>(best.color0 & 0xFF);
+        out[1] = static_cast<uint8_t>(best.color0 >> 8);
+        out[2] = static_cast<uint8_t>(best.color1 & 0xFF);
+        out[3] = static_cast<uint8_t>(best.color1 >> 8);
+
+        uint32_t indices = 0;
+        for(int i = 0; i < 16; i++)
+        {
+            indices |= static_cast<uint32_t>(best.indices[i]) << (i * 2);
+        }
+        std::memcpy(out + 4, &indices, sizeof(indices));
+    }
+
+    //// BC6H helpers
+
+    // Round to nearest half float bits, negatives and NaNs map to zero as the format is unsigned
+    uint16_t floatToHalfUnsigned(float value)
+    {
+        if(!(value > 0.0f))
+        {
+            return 0;
+        }
+        if(value >= 65504.0f)
+        {
+            return 0x7BFF;
+        }
+
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+
+        int exponent = static_cast<int>((bits >> 23) & 0xFF) - 127 + 15;
+        uint32_t mantissa = bits & 0x7FFFFF;
+
+        if(exponent <= 0)
+        {
+            // Subnormal half
+            if(exponent < -10)
+            {
+                return 0;
+            }
+            mantissa |= 0x800000;
+            uint32_t shift = static_cast<uint32_t>(14 - exponent);
+            uint32_t half = mantissa >> shift;
+            uint32_t remainder = mantissa & ((1u << shift) - 1u);
+            if(remainder > (1u << (shift - 1)) || (remainder == (1u << (shift - 1)) && (half & 1u)))
+            {
+                half++;
+            }
+            return static_cast<uint16_t>(half);
+        }
+
+        uint32_t half = static_cast<uint32_t>(exponent) << 10 | mantissa >> 13;
+        uint32_t remainder = mantissa & 0x1FFF;
+        if(remainder > 0x1000 || (remainder == 0x1000 && (half & 1u)))
+        {
+            half++;
+        }
+        return static_cast<uint16_t>(std::min<uint32_t>(half, 0x7BFF));
+    }
+
+    // Endpoints are stored with 10 bits and expanded to 16 before interpolation
+    int unquantizeBC6H(int value)
+    {
+        if(value == 0)
+        {
+            return 0;
+        }
+        if(value == 1023)
+        {
+            return 0xFFFF;
+        }
+        return ((value << 16) + 0x8000) >> 10;
+    }
+
+    int quantizeBC6H(float value)
+    {
+        int guess = std::clamp(static_cast<int>(value / 64.0f), 0, 1023);
+        int best = guess;
+        float bestError = 1e30f;
+
+        for(int candidate = std::max(guess - 1, 0); candidate <= std::min(guess + 1, 1023); candidate++)
+        {
+            float error = std::fabs(static_cast<float>(unquantizeBC6H(candidate)) - value);
+            if(error < bestError)
+            {
+                bestError = error;
+                best = candidate;
+            }
+        }
+        return best;
+    }
+
+    struct indexedCandidate
+    {
+        int endpoints[2][4] = {};
+        int pbits[2] = {};
+        uint8_t indices[16] = {};
+        float error = 1e30f;
+    };
+
+    // Shared by BC6H and BC7, makes the anchor index MSB zero by swapping the endpoints
+    void fixAnchorIndex(indexedCandidate& candidate, int channels)
+    {
+        if(candidate.indices[0] < 8)
+        {
+            return;
+        }
+
+        for(int c = 0; c < channels; c++)
+        {
+            std::swap(candidate.endpoints[0][c], candidate.endpoints[1][c]);
+        }
+        std::swap(candidate.pbits[0], candidate.pbits[1]);
+
+        for(int i = 0; i < 16; i++)
+        {
+            candidate.indices[i] = static_cast<uint8_t>(15 - candidate.indices[i]);
+        }
+    }
+
+    indexedCandidate evaluateBC6H(const float pixels[16][3], const float lo[3], const float hi[3])
+    {
+        indexedCandidate candidate;
+
+        float palette[16][3];
+        int expanded[2][3];
+        for(int c = 0; c < 3; c++)
+        {
+            candidate.endpoints[0][c] = quantizeBC6H(lo[c]);
+            candidate.endpoints[1][c] = quantizeBC6H(hi[c]);
+            expanded[0][c] = unquantizeBC6H(candidate.endpoints[0][c]);
+            expanded[1][c] = unquantizeBC6H(candidate.endpoints[1][c]);
+        }
+
+        for(int p = 0; p < 16; p++)
+        {
+            for(int c = 0; c < 3; c++)
+            {
+                palette[p][c] = static_cast<float>((expanded[0][c] * (64 - kWeights4[p]) + expanded[1][c] * kWeights4[p] + 32) >> 6);
+            }
+        }
+
+        candidate.error = 0.0f;
+        for(int i = 0; i < 16; i++)
+        {
+            float error;
+            candidate.indices[i] = static_cast<uint8_t>(nearestPaletteEntry<3>(pixels[i], palette, 16, error));
+            candidate.error += error;
+        }
+        return candidate;
+    }
+
+    //// BC7 helpers
+
+    // 7 bit endpoint with a unique pbit, picks the pbit that lands closest to the target color
+    void quantizeBC7Endpoint(const float color[4], int endpoint[4], int& pbit)
+    {
+        float bestError = 1e30f;
+
+        for(int p = 0; p < 2; p++)
+        {
+            int candidate[4];
+            float error = 0.0f;
+            for(int c = 0; c < 4; c++)
+            {
+                candidate[c] = std::clamp(static_cast<int>(std::lround((color[c] - p) / 2.0f)), 0, 127);
+                float d = static_cast<float>(candidate[c] << 1 | p) - color[c];
+                error += d * d;
+            }
+
+            if(error < bestError)
+            {
+                bestError = error;
+                pbit = p;
+                std::copy(candidate, candidate + 4, endpoint);
+            }
+        }
+    }
+
+    indexedCandidate evaluateBC7(const float pixels[16][4], const float lo[4], const float hi[4])
+    {
+        indexedCandidate candidate;
+        quantizeBC7Endpoint(lo, candidate.endpoints[0], candidate.pbits[0]);
+        quantizeBC7Endpoint(hi, candidate.endpoints[1], candidate.pbits[1]);
+
+        float palette[16][4];
+        for(int p = 0; p < 16; p++)
+        {
+            for(int c = 0; c < 4; c++)
+            {
+                int e0 = candidate.endpoints[0][c] << 1 | candidate.pbits[0];
+                int e1 = candidate.endpoints[1][c] << 1 | candidate.pbits[1];
+                palette[p][c] = static_cast<float>((e0 * (64 - kWeights4[p]) + e1 * kWeights4[p] + 32) >> 6);
+            }
+        }
+
+        candidate.error = 0.0f;
+        for(int i = 0; i < 16; i++)
+        {
+            float error;
+            candidate.indices[i] = static_cast<uint8_t>(nearestPaletteEntry<4>(pixels[i], palette, 16, error));
+            candidate.error += error;
+        }
+        return candidate;
+    }
+
+    // Principal axis fit followed by least squares passes, keeps whichever candidate has the lowest error
+    template<int N, typename Evaluate>
+    indexedCandidate fitIndexedBlock(const float pixels[16][N], Evaluate evaluate)
+    {
+        float lo[N], hi[N];
+        fitPrincipalAxis<N>(pixels, lo, hi);
+        indexedCandidate best = evaluate(pixels, lo, hi);
+
+        for(int pass = 0; pass < kRefinementPasses; pass++)
+        {
+            float weights[16];
+            for(int i = 0; i < 16; i++)
+            {
+                weights[i] = kWeights4[best.indices[i]] / 64.0f;
+            }
+
+            if(!refineEndpoints<N>(pixels, weights, lo, hi))
+            {
+                break;
+            }
+
+            indexedCandidate candidate = evaluate(pixels, lo, hi);
+            if(candidate.error >= best.error)
+            {
+                break;
+            }
+            best = candidate;
+        }
+
+        return best;
+    }
+
+    //// Mip generation helpers
+
+    float srgbToLinear(float value)
+    {
+        return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+    }
+
+    float linearToSrgb(float value)
+    {
+        return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+    }
+
+    uint8_t toUnorm8(float value)
+    {
+        return static_cast<uint8_t>(std::clamp(static_cast<int>(std::lround(value * 255.0f)), 0, 255));
+    }
+
+    // Gathers a 4x4 block, coordinates past the edge are clamped
+    template<typename T>
+    void fetchBlock(const T* rgba, uint32_t width, uint32_t height, uint32_t blockX, uint32_t blockY, T block[64])
+    {
+        for(uint32_t y = 0; y < 4; y++)
+        {
+            uint32_t sourceY = std::min(blockY * 4 + y, height - 1);
+            for(uint32_t x = 0; x < 4; x++)
+            {
+                uint32_t sourceX = std::min(blockX * 4 + x, width - 1);
+                const T* texel = rgba + (static_cast<size_t>(sourceY) * width + sourceX) * 4;
+                std::copy(texel, texel + 4, block + (y * 4 + x) * 4);
+            }
+        }
+    }
+}
+
+namespace blockCompression
+{
+    void encodeBC1Block(const uint8_t rgba[64], uint8_t out[8])
+    {
+        encodeBC1Color(rgba, out);
+    }
+
+    void encodeBC4Block(const uint8_t values[16], uint8_t out[8])
+    {
+        uint8_t minValue = values[0];
+        uint8_t maxValue = values[0];
+        for(int i = 1; i < 16; i++)
+        {
+            minValue = std::min(minValue, values[i]);
+            maxValue = std::max(maxValue, values[i]);
+        }
+
+        // Eight value mode, endpoint 0 has to be the larger one
+        float palette[8][1];
+        palette[0][0] = maxValue;
+        palette[1][0] = minValue;
+        for(int i = 2; i < 8; i++)
+        {
+            palette[i][0] = std::floor(((8 - i) * maxValue + (i - 1) * minValue) / 7.0f);
+        }
+
+        out[0] = maxValue;
+        out[1] = minValue;
+
+        uint64_t indices = 0;
+        for(int i = 0; i < 16; i++)
+        {
+            float value[1] = {static_cast<float>(values[i])};
+            float error;
+            uint64_t index = maxValue == minValue ? 0 : static_cast<uint64_t>(nearestPaletteEntry<1>(value, palette, 8, error));
+            indices |= index << (i * 3);
+        }
+
+        for(int i = 0; i < 6; i++)
+        {
+            out[2 + i] = static_cast<uint8_t>(indices >> (i * 8));
+        }
+    }
+
+    void encodeBC3Block(const uint8_t rgba[64], uint8_t out[16])
+    {
+        uint8_t alpha[16];
+        for(int i = 0; i < 16; i++)
+        {
+            alpha[i] = rgba[i * 4 + 3];
+        }
+
+        encodeBC4Block(alpha, out);
+        encodeBC1Color(rgba, out + 8);
+    }
+
+    void encodeBC5Block(const uint8_t rgba[64], uint8_t out[16])
+    {
+        uint8_t red[16];
+        uint8_t green[16];
+        for(int i = 0; i < 16; i++)
+        {
+            red[i] = rgba[i * 4 + 0];
+            green[i] = rgba[i * 4 + 1];
+        }
+
+        encodeBC4Block(red, out);
+        encodeBC4Block(green, out + 8);
+    }
+
+    void encodeBC7Block(const uint8_t rgba[64], uint8_t out[16])
+    {
+        float pixels[16][4];
+        for(int i = 0; i < 16; i++)
+        {
+            for(int c = 0; c < 4; c++)
+            {
+                pixels[i][c] = rgba[i * 4 + c];
+            }
+        }
+
+        indexedCandidate best = fitIndexedBlock<4>(pixels, evaluateBC7);
+        fixAnchorIndex(best, 4);
+
+        std::memset(out, 0, 16);
+        bitWriter writer{out};
+
+        // Mode 6
+        writer.write(1u << 6, 7);
+
+        for(int c = 0; c < 4; c++)
+        {
+            writer.write(best.endpoints[0][c], 7);
+            writer.write(best.endpoints[1][c], 7);
+        }
+        writer.write(best.pbits[0], 1);
+        writer.write(best.pbits[1], 1);
+
+        for(int i = 0; i < 16; i++)
+        {
+            writer.write(best.indices[i], i == 0 ? 3 : 4);
+        }
+    }
+
+    void encodeBC6HBlock(const float rgba[64], uint8_t out[16])
+    {
+        // Work in the expanded 16 bit domain the hardware interpolates in
+        float pixels[16][3];
+        for(int i = 0; i < 16; i++)
+        {
+            for(int c = 0; c < 3; c++)
+            {
+                pixels[i][c] = floatToHalfUnsigned(rgba[i * 4 + c]) * 64.0f / 31.0f;
+            }
+        }
+
+        indexedCandidate best = fitIndexedBlock<3>(pixels, evaluateBC6H);
+        fixAnchorIndex(best, 3);
+
+        std::memset(out, 0, 16);
+        bitWriter writer{out};
+
+        // Mode 11, one region with untransformed 10 bit endpoints
+        writer.write(0x03, 5);
+
+        for(int e = 0; e < 2; e++)
+        {
+            for(int c = 0; c < 3; c++)
+            {
+                writer.write(best.endpoints[e][c], 10);
+            }
+        }
+
+        for(int i = 0; i < 16; i++)
+        {
+            writer.write(best.indices[i], i == 0 ? 3 : 4);
+        }
+    }
+
+    bool isBlockCompressed(VkFormat format)
+    {
+        return getBlockSize(format) != 0;
+    }
+
+    bool isHDRFormat(VkFormat format)
+    {
+        return format == VK_FORMAT_BC6H_UFLOAT_BLOCK || format == VK_FORMAT_R32G32B32A32_SFLOAT || format == VK_FORMAT_R16G16B16A16_SFLOAT || format == VK_FORMAT_E5B9G9R9_UFLOAT_PACK32;
+    }
+
+    uint32_t getBlockSize(VkFormat format)
+    {
+        switch(format)
+        {
+            case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+            case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+            case VK_FORMAT_BC4_UNORM_BLOCK:
+                return 8;
+            case VK_FORMAT_BC3_UNORM_BLOCK:
+            case VK_FORMAT_BC3_SRGB_BLOCK:
+            case VK_FORMAT_BC5_UNORM_BLOCK:
+            case VK_FORMAT_BC6H_UFLOAT_BLOCK:
+            case VK_FORMAT_BC7_UNORM_BLOCK:
+            case VK_FORMAT_BC7_SRGB_BLOCK:
+                return 16;
+            default:
+                return 0;
+        }
+    }
+
+    size_t getCompressedSize(VkFormat format, uint32_t width, uint32_t height)
+    {
+        size_t blocksX = (width + 3) / 4;
+        size_t blocksY = (height + 3) / 4;
+        return blocksX * blocksY * getBlockSize(format);
+    }
+
+    VkFormat getCompressedFormat(E_TextureType type, bool isHDR)
+    {
+        if(isHDR)
+        {
+            return VK_FORMAT_BC6H_UFLOAT_BLOCK;
+        }
+
+        switch(type)
+        {
+            case E_TextureType::NORMAL:
+                return VK_FORMAT_BC5_UNORM_BLOCK;
+            case E_TextureType::SPECULAR:
+            case E_TextureType::ROUGHNESS:
+            case E_TextureType::HEIGHT:
+                return VK_FORMAT_BC4_UNORM_BLOCK;
+            case E_TextureType::DIFFUSE:
+            case E_TextureType::LIGHTMAP:
+            case E_TextureType::CUBEMAP:
+            default:
+                return VK_FORMAT_BC7_SRGB_BLOCK;
+        }
+    }
+
+    std::vector<uint8_t> compressImage(const uint8_t* rgba, uint32_t width, uint32_t height, VkFormat format)
+    {
+        uint32_t blockSize = getBlockSize(format);
+        if(blockSize == 0 || format == VK_FORMAT_BC6H_UFLOAT_BLOCK)
+        {
+            throw std::runtime_error("Unsupported block compression format for 8 bit images");
+        }
+
+        uint32_t blocksX = (width + 3) / 4;
+        uint32_t blocksY = (height + 3) / 4;
+        std::vector<uint8_t> compressed(static_cast<size_t>(blocksX) * blocksY * blockSize);
+
+        uint8_t block[64];
+        for(uint32_t by = 0; by < blocksY; by++)
+        {
+            for(uint32_t bx = 0; bx < blocksX; bx++)
+            {
+                fetchBlock(rgba, width, height, bx, by, block);
+                uint8_t* out = compressed.data() + (static_cast<size_t>(by) * blocksX + bx) * blockSize;
+
+                switch(format)
+                {
+                    case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+                    case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+                        encodeBC1Block(block, out);
+                        break;
+                    case VK_FORMAT_BC3_UNORM_BLOCK:
+                    case VK_FORMAT_BC3_SRGB_BLOCK:
+                        encodeBC3Block(block, out);
+                        break;
+                    case VK_FORMAT_BC4_UNORM_BLOCK:
+                    {
+                        uint8_t red[16];
+                        for(int i = 0; i < 16; i++)
+                        {
+                            red[i] = block[i * 4];
+                        }
+                        encodeBC4Block(red, out);
+                        break;
+                    }
+                    case VK_FORMAT_BC5_UNORM_BLOCK:
+                        encodeBC5Block(block, out);
+                        break;
+                    default:
+                        encodeBC7Block(block, out);
+                        break;
+                }
+            }
+        }
+
+        return compressed;
+    }
+
+    std::vector<uint8_t> compressImage(const float* rgba, uint32_t width, uint32_t height, VkFormat format)
+    {
+        if(format != VK_FORMAT_BC6H_UFLOAT_BLOCK)
+        {
+            throw std::runtime_error("Floating point images can only be compressed to BC6H");
+        }
+
+        uint32_t blocksX = (width + 3) / 4;
+        uint32_t blocksY = (height + 3) / 4;
+        std::vector<uint8_t> compressed(static_cast<size_t>(blocksX) * blocksY * 16);
+
+        float block[64];
+        for(uint32_t by = 0; by < blocksY; by++)
+        {
+            for(uint32_t bx = 0; bx < blocksX; bx++)
+            {
+                fetchBlock(rgba, width, height, bx, by, block);
+                encodeBC6HBlock(block, compressed.data() + (static_cast<size_t>(by) * blocksX + bx) * 16);
+            }
+        }
+
+        return compressed;
+    }
+
+    std::vector<std::vector<uint8_t>> generateMipChain(const uint8_t* rgba, uint32_t width, uint32_t height, bool isSRGB, bool isNormalMap)
+    {
+        std::vector<std::vector<uint8_t>> levels;
+        levels.emplace_back(rgba, rgba + static_cast<size_t>(width) * height * 4);
+
+        // Decoding table, sRGB data is filtered in linear space
+        std::array<float, 256> decode;
+        for(int i = 0; i < 256; i++)
+        {
+            decode[i] = isSRGB ? srgbToLinear(i / 255.0f) : i / 255.0f;
+        }
+
+        while(width > 1 || height > 1)
+        {
+            uint32_t nextWidth = std::max(width / 2, 1u);
+            uint32_t nextHeight = std::max(height / 2, 1u);
+
+            const std::vector<uint8_t>& source = levels.back();
+            std::vector<uint8_t> next(static_cast<size_t>(nextWidth) * nextHeight * 4);
+
+            for(uint32_t y = 0; y < nextHeight; y++)
+            {
+                for(uint32_t x = 0; x < nextWidth; x++)
+                {
+                    float sum[4] = {};
+                    for(uint32_t sy = 0; sy < 2; sy++)
+                    {
+                        for(uint32_t sx = 0; sx < 2; sx++)
+                        {
+                            uint32_t sourceX = std::min(x * 2 + sx, width - 1);
+                            uint32_t sourceY = std::min(y * 2 + sy, height - 1);
+                            const uint8_t* texel = source.data() + (static_cast<size_t>(sourceY) * width + sourceX) * 4;
+
+                            for(int c = 0; c < 3; c++)
+                            {
+                                sum[c] += decode[texel[c]];
+                            }
+                            sum[3] += texel[3] / 255.0f;
+                        }
+                    }
+
+                    uint8_t* texel = next.data() + (static_cast<size_t>(y) * nextWidth + x) * 4;
+
+                    if(isNormalMap)
+                    {
+                        float normal[3];
+                        float length = 0.0f;
+                        for(int c = 0; c < 3; c++)
+                        {
+                            normal[c] = sum[c] / 4.0f * 2.0f - 1.0f;
+                            length += normal[c] * normal[c];
+                        }
+                        length = length > 0.0f ? std::sqrt(length) : 1.0f;
+
+                        for(int c = 0; c < 3; c++)
+                        {
+                            texel[c] = toUnorm8((normal[c] / length) * 0.5f + 0.5f);
+                        }
+                    }
+                    else
+                    {
+                        for(int c = 0; c < 3; c++)
+                        {
+                            float value = sum[c] / 4.0f;
+                            texel[c] = toUnorm8(isSRGB ? linearToSrgb(value) : value);
+                        }
+                    }
+                    texel[3] = toUnorm8(sum[3] / 4.0f);
+                }
+            }
+
+            levels.push_back(std::move(next));
+            width = nextWidth;
+            height = nextHeight;
+        }
+
+        return levels;
+    }
+
+    std::vector<std::vector<float>> generateMipChain(const float* rgba, uint32_t width, uint32_t height)
+    {
+        std::vector<std::vector<float>> levels;
+        levels.emplace_back(rgba, rgba + static_cast<size_t>(width) * height * 4);
+
+        while(width > 1 || height > 1)
+        {
+            uint32_t nextWidth = std::max(width / 2, 1u);
+            uint32_t nextHeight = std::max(height / 2, 1u);
+
+            const std::vector<float>& source = levels.back();
+            std::vector<float> next(static_cast<size_t>(nextWidth) * nextHeight * 4);
+
+            for(uint32_t y = 0; y < nextHeight; y++)
+            {
+                for(uint32_t x = 0; x < nextWidth; x++)
+                {
+                    float* texel = next.data() + (static_cast<size_t>(y) * nextWidth + x) * 4;
+                    for(uint32_t sy = 0; sy < 2; sy++)
+                    {
+                        for(uint32_t sx = 0; sx < 2; sx++)
+                        {
+                            uint32_t sourceX = std::min(x * 2 + sx, width - 1);
+                            uint32_t sourceY = std::min(y * 2 + sy, height - 1);
+                            const float* sourceTexel = source.data() + (static_cast<size_t>(sourceY) * width + sourceX) * 4;
+
+                            for(int c = 0; c < 4; c++)
+                            {
+                                texel[c] += sourceTexel[c] * 0.25f;
+                            }
+                        }
+                    }
+                }
+            }
+
+            levels.push_back(std::move(next));
+            width = nextWidth;
+            height = nextHeight;
+        }
+
+        return levels;
+    }
+}
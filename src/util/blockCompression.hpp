@@ -0,0 +1,37 @@
+#pragma once
+
+#include "rendering/resources/texture.hpp"
+
+#include <cstdint>
+#include <vector>
+
+// CPU encoders for the BCn block compressed formats
+// Every block covers 4x4 texels, pixel inputs are row major RGBA
+namespace blockCompression
+{
+    // Single block encoders
+    void encodeBC1Block(const uint8_t rgba[64], uint8_t out[8]);
+    void encodeBC3Block(const uint8_t rgba[64], uint8_t out[16]);
+    void encodeBC4Block(const uint8_t values[16], uint8_t out[8]);
+    void encodeBC5Block(const uint8_t rgba[64], uint8_t out[16]);      // red and green channels
+    void encodeBC7Block(const uint8_t rgba[64], uint8_t out[16]);      // mode 6, single subset RGBA
+    void encodeBC6HBlock(const float rgba[64], uint8_t out[16]);       // mode 11, unsigned half floats, alpha ignored
+
+    // Format helpers
+    bool isBlockCompressed(VkFormat format);
+    bool isHDRFormat(VkFormat format);
+    uint32_t getBlockSize(VkFormat format);                                      // bytes per 4x4 block
+    size_t getCompressedSize(VkFormat format, uint32_t width, uint32_t height);
+
+    // Format picked for each kind of texture, HDR sources always go to BC6H
+    VkFormat getCompressedFormat(E_TextureType type, bool isHDR);
+
+    // Whole image encoders, edge blocks replicate the last row/column
+    std::vector<uint8_t> compressImage(const uint8_t* rgba, uint32_t width, uint32_t height, VkFormat format);
+    std::vector<uint8_t> compressImage(const float* rgba, uint32_t width, uint32_t height, VkFormat format);
+
+    // Box filtered mip chains, level 0 is the source image
+    // sRGB data is averaged in linear space, normal maps are renormalized after every downsample
+    std::vector<std::vector<uint8_t>> generateMipChain(const uint8_t* rgba, uint32_t width, uint32_t height, bool isSRGB, bool isNormalMap);
+    std::vector<std::vector<float>> generateMipChain(const float* rgba, uint32_t width, uint32_t height);
+}
@@ -0,0 +1,210 @@
+#include "util/halfFloat.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__F16C__) || defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#define MANTA_HALF_FLOAT_SSE2
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define MANTA_HALF_FLOAT_NEON
+#endif
+
+namespace
+{
+    // Shared exponent format limits, see the Vulkan specification on VK_FORMAT_E5B9G9R9_UFLOAT_PACK32
+    const int kSharedExponentBias = 15;
+    const int kSharedExponentMax = 31;
+    const int kSharedMantissaBits = 9;
+    const float kSharedMax = static_cast<float>((1 << kSharedMantissaBits) - 1) / (1 << kSharedMantissaBits) * 65536.0f;
+
+#if defined(MANTA_HALF_FLOAT_SSE2) && !defined(__F16C__)
+    // Four floats to half bits at once, the same rounding as the scalar path
+    __m128i fromFloatsSSE2(__m128 values)
+    {
+        const __m128i signMask = _mm_set1_epi32(static_cast<int>(0x80000000u));
+        const __m128i f32Infinity = _mm_set1_epi32(255 << 23);
+        const __m128i f16Max = _mm_set1_epi32((127 + 16) << 23);
+        const __m128i denormalLimit = _mm_set1_epi32(113 << 23);
+        const __m128i denormalMagic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+        const __m128i rebias = _mm_set1_epi32(static_cast<int>(((15u - 127u) << 23) + 0xFFFu));
+        const __m128i one = _mm_set1_epi32(1);
+
+        __m128i bits = _mm_castps_si128(values);
+        __m128i sign = _mm_and_si128(bits, signMask);
+        bits = _mm_xor_si128(bits, sign);
+
+        // Infinity for anything too large, quiet NaN for NaNs
+        __m128i isNaN = _mm_cmpgt_epi32(bits, f32Infinity);
+        __m128i special = _mm_or_si128(_mm_set1_epi32(0x7C00), _mm_and_si128(isNaN, _mm_set1_epi32(0x0200)));
+        __m128i isSpecial = _mm_cmpgt_epi32(bits, _mm_sub_epi32(f16Max, one));
+
+        // Subnormals, the float adder does the rounding
+        __m128i denormal = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(_mm_castsi128_ps(bits), _mm_castsi128_ps(denormalMagic))), denormalMagic);
+        __m128i isDenormal = _mm_cmplt_epi32(bits, denormalLimit);
+
+        // Normals, rebias and round to nearest even
+        __m128i odd = _mm_and_si128(_mm_srli_epi32(bits, 13), one);
+        __m128i normal = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(bits, rebias), odd), 13);
+
+        __m128i result = _mm_or_si128(_mm_and_si128(isDenormal, denormal), _mm_andnot_si128(isDenormal, normal));
+        result = _mm_or_si128(_mm_and_si128(isSpecial, special), _mm_andnot_si128(isSpecial, result));
+        result = _mm_or_si128(result, _mm_srli_epi32(sign, 16));
+
+        // Sign extend so the saturating pack keeps every 16 bit pattern
+        result = _mm_srai_epi32(_mm_slli_epi32(result, 16), 16);
+        return _mm_packs_epi32(result, result);
+    }
+#endif
+}
+
+namespace halfFloat
+{
+    uint16_t fromFloat(float value)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+
+        uint32_t sign = (bits >> 16) & 0x8000;
+        bits &= 0x7FFFFFFF;
+
+        // Infinity and NaN
+        if(bits >= 0x7F800000)
+        {
+            return static_cast<uint16_t>(sign | 0x7C00 | (bits > 0x7F800000 ? 0x0200 : 0));
+        }
+
+        // Overflow rounds to infinity
+        if(bits >= (127 + 16) << 23)
+        {
+            return static_cast<uint16_t>(sign | 0x7C00);
+        }
+
+        // Subnormal half, or zero
+        if(bits < 113 << 23)
+        {
+            float magnitude;
+            std::memcpy(&magnitude, &bits, sizeof(magnitude));
+            return static_cast<uint16_t>(sign | static_cast<uint32_t>(std::nearbyint(magnitude * 16777216.0f)));
+        }
+
+        uint32_t odd = (bits >> 13) & 1;
+        bits += ((15u - 127u) << 23) + 0xFFF + odd;
+        return static_cast<uint16_t>(sign | (bits >> 13));
+    }
+
+    float toFloat(uint16_t value)
+    {
+        uint32_t sign = static_cast<uint32_t>(value & 0x8000) << 16;
+        uint32_t exponent = (value >> 10) & 0x1F;
+        uint32_t mantissa = value & 0x3FF;
+
+        uint32_t bits;
+        if(exponent == 0x1F)
+        {
+            bits = sign | 0x7F800000 | (mantissa << 13);
+        }
+        else if(exponent == 0)
+        {
+            float magnitude = static_cast<float>(mantissa) / 16777216.0f;
+            std::memcpy(&bits, &magnitude, sizeof(bits));
+            bits |= sign;
+        }
+        else
+        {
+            bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+        }
+
+        float result;
+        std::memcpy(&result, &bits, sizeof(result));
+        return result;
+    }
+
+    void fromFloats(const float* src, uint16_t* dst, size_t count)
+    {
+        size_t i = 0;
+
+#if defined(__F16C__)
+        for(; i + 8 <= count; i += 8)
+        {
+            __m128i halves = _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), halves);
+        }
+#elif defined(MANTA_HALF_FLOAT_SSE2)
+        for(; i + 4 <= count; i += 4)
+        {
+            __m128i halves = fromFloatsSSE2(_mm_loadu_ps(src + i));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + i), halves);
+        }
+#elif defined(MANTA_HALF_FLOAT_NEON)
+        for(; i + 4 <= count; i += 4)
+        {
+            vst1_u16(dst + i, vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(src + i))));
+        }
+#endif
+
+        for(; i < count; i++)
+        {
+            dst[i] = fromFloat(src[i]);
+        }
+    }
+
+    void toFloats(const uint16_t* src, float* dst, size_t count)
+    {
+        size_t i = 0;
+
+#if defined(__F16C__)
+        for(; i + 8 <= count; i += 8)
+        {
+            __m128i halves = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(halves));
+        }
+#elif defined(MANTA_HALF_FLOAT_NEON)
+        for(; i + 4 <= count; i += 4)
+        {
+            vst1q_f32(dst + i, vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(src + i))));
+        }
+#endif
+
+        for(; i < count; i++)
+        {
+            dst[i] = toFloat(src[i]);
+        }
+    }
+
+    uint32_t packE5B9G9R9(float r, float g, float b)
+    {
+        // !(x > 0) also catches NaN
+        r = !(r > 0.0f) ? 0.0f : std::min(r, kSharedMax);
+        g = !(g > 0.0f) ? 0.0f : std::min(g, kSharedMax);
+        b = !(b > 0.0f) ? 0.0f : std::min(b, kSharedMax);
+
+        // The largest component picks the exponent, the others lose their low bits
+        float maxComponent = std::max(r, std::max(g, b));
+        int exponent = std::max(-kSharedExponentBias - 1, static_cast<int>(std::floor(std::log2(std::max(maxComponent, 1e-30f))))) + 1 + kSharedExponentBias;
+
+        float scale = std::ldexp(1.0f, exponent - kSharedExponentBias - kSharedMantissaBits);
+        if(static_cast<int>(std::floor(maxComponent / scale + 0.5f)) == (1 << kSharedMantissaBits))
+        {
+            scale *= 2.0f;
+            exponent++;
+        }
+        exponent = std::min(exponent, kSharedExponentMax);
+
+        uint32_t rm = static_cast<uint32_t>(std::floor(r / scale + 0.5f));
+        uint32_t gm = static_cast<uint32_t>(std::floor(g / scale + 0.5f));
+        uint32_t bm = static_cast<uint32_t>(std::floor(b / scale + 0.5f));
+
+        return static_cast<uint32_t>(exponent) << 27 | bm << 18 | gm << 9 | rm;
+    }
+
+    void packE5B9G9R9(const float* rgba, uint32_t* dst, size_t texels)
+    {
+        for(size_t i = 0; i < texels; i++)
+        {
+            dst[i] = packE5B9G9R9(rgba[i * 4], rgba[i * 4 + 1], rgba[i * 4 + 2]);
+        }
+    }
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Conversions to the compact HDR texture formats
+// VK_FORMAT_R16G16B16A16_SFLOAT (IEEE 754 binary16) and VK_FORMAT_E5B9G9R9_UFLOAT_PACK32 (shared exponent)
+namespace halfFloat
+{
+    // Round to nearest even, infinities and NaNs are preserved
+    uint16_t fromFloat(float value);
+    float toFloat(uint16_t value);
+
+    // Bulk conversions used while filling staging buffers, vectorised with F16C, SSE2 or NEON where available
+    void fromFloats(const float* src, uint16_t* dst, size_t count);
+    void toFloats(const uint16_t* src, float* dst, size_t count);
+
+    // Negative and NaN components become 0, anything above the format's range clamps to its maximum
+    uint32_t packE5B9G9R9(float r, float g, float b);
+    // Alpha of every RGBA texel is dropped
+    void packE5B9G9R9(const float* rgba, uint32_t* dst, size_t texels);
+}
@@ -0,0 +1,122 @@
+#include "util/hash.hpp"
+
+#include <cstring>
+
+namespace
+{
+    const uint64_t kPrime1 = 0x9E3779B185EBCA87ULL;
+    const uint64_t kPrime2 = 0xC2B2AE3D27D4EB4FULL;
+    const uint64_t kPrime3 = 0x165667B19E3779F9ULL;
+    const uint64_t kPrime4 = 0x85EBCA77C2B2AE63ULL;
+    const uint64_t kPrime5 = 0x27D4EB2F165667C5ULL;
+
+    uint64_t rotateLeft(uint64_t value, int bits)
+    {
+        return (value << bits) | (value >> (64 - bits));
+    }
+
+    // Little endian reads, memcpy keeps unaligned input legal
+    uint64_t read64(const uint8_t* p)
+    {
+        uint64_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    uint32_t read32(const uint8_t* p)
+    {
+        uint32_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    uint64_t round(uint64_t accumulator, uint64_t lane)
+    {
+        accumulator += lane * kPrime2;
+        accumulator = rotateLeft(accumulator, 31);
+        return accumulator * kPrime1;
+    }
+
+    uint64_t mergeRound(uint64_t accumulator, uint64_t lane)
+    {
+        accumulator ^= round(0, lane);
+        return accumulator * kPrime1 + kPrime4;
+    }
+}
+
+namespace hash
+{
+    uint64_t xxHash64(const void* data, size_t size, uint64_t seed)
+    {
+        const uint8_t* p = static_cast<const uint8_t*>(data);
+        const uint8_t* end = p + size;
+        uint64_t result;
+
+        // 32 byte stripes over four accumulators
+        if(size >= 32)
+        {
+            uint64_t v1 = seed + kPrime1 + kPrime2;
+            uint64_t v2 = seed + kPrime2;
+            uint64_t v3 = seed;
+            uint64_t v4 = seed - kPrime1;
+
+            const uint8_t* limit = end - 32;
+            do
+            {
+                v1 = round(v1, read64(p));
+                v2 = round(v2, read64(p + 8));
+                v3 = round(v3, read64(p + 16));
+                v4 = round(v4, read64(p + 24));
+                p += 32;
+            } while(p <= limit);
+
+            result = rotateLeft(v1, 1) + rotateLeft(v2, 7) + rotateLeft(v3, 12) + rotateLeft(v4, 18);
+            result = mergeRound(result, v1);
+            result = mergeRound(result, v2);
+            result = mergeRound(result, v3);
+            result = mergeRound(result, v4);
+        }
+        else
+        {
+            result = seed + kPrime5;
+        }
+
+        result += static_cast<uint64_t>(size);
+
+        // Tail
+        while(p + 8 <= end)
+        {
+            result ^= round(0, read64(p));
+            result = rotateLeft(result, 27) * kPrime1 + kPrime4;
+            p += 8;
+        }
+
+        if(p + 4 <= end)
+        {
+            result ^= static_cast<uint64_t>(read32(p)) * kPrime1;
+            result = rotateLeft(result, 23) * kPrime2 + kPrime3;
+            p += 4;
+        }
+
+        while(p < end)
+        {
+            result ^= static_cast<uint64_t>(*p) * kPrime5;
+            result = rotateLeft(result, 11) * kPrime1;
+            p++;
+        }
+
+        // Avalanche
+        result ^= result >> 33;
+        result *= kPrime2;
+        result ^= result >> 29;
+        result *= kPrime3;
+        result ^= result >> 32;
+
+        return result;
+    }
+
+    uint64_t xxHash64(const std::string& text, uint64_t seed)
+    {
+        return xxHash64(text.data(), text.size(), seed);
+    }
+}
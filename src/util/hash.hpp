@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// 64 bit xxHash (XXH64), fast non-cryptographic hashing for content keyed caches
+// https://github.com/Cyan4973/xxHash/blob/dev/doc/xxhash_spec.md
+namespace hash
+{
+    uint64_t xxHash64(const void* data, size_t size, uint64_t seed = 0);
+    uint64_t xxHash64(const std::string& text, uint64_t seed = 0);
+}
@@ -33,6 +33,19 @@ loadedImageDataRGB ASSIMP_load_image(const aiTexture* texture)
     return img;
 };
 
+loadedImageDataRGB STB_load_image(const unsigned char* bytes, size_t size)
+{
+    loadedImageDataRGB img;
+    img.data = stbi_load_from_memory(
+        bytes,
+        static_cast<int>(size),
+        &img.width,
+        &img.height,
+        &img.channels,
+        STBI_rgb_alpha);
+    return img;
+}
+
 void free_image(unsigned char* data)
 {
     stbi_image_free(data);
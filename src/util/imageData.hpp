@@ -21,6 +21,9 @@ loadedImageDataHDR STB_load_image_HDR(const std::string &path);
 
 loadedImageDataRGB ASSIMP_load_image(const aiTexture* texture);
 
+// Encoded image bytes, such as an embedded texture kept in a mesh cache
+loadedImageDataRGB STB_load_image(const unsigned char* bytes, size_t size);
+
 void free_image(unsigned char* data);
 
 void free_image(float* data);
\ No newline at end of file
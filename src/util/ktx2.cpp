@@ -0,0 +1,397 @@
+#include "util/ktx2.hpp"
+
+#include "util/blockCompression.hpp"
+
+// Boost
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+// zstd
+#include <zstd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#include <stdexcept>
+
+namespace
+{
+    const uint8_t kIdentifier[12] = {0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+
+    struct ktx2Header
+    {
+        uint8_t identifier[12];
+        uint32_t vkFormat;
+        uint32_t typeSize;
+        uint32_t pixelWidth;
+        uint32_t pixelHeight;
+        uint32_t pixelDepth;
+        uint32_t layerCount;
+        uint32_t faceCount;
+        uint32_t levelCount;
+        uint32_t supercompressionScheme;
+
+        uint32_t dfdByteOffset;
+        uint32_t dfdByteLength;
+        uint32_t kvdByteOffset;
+        uint32_t kvdByteLength;
+        uint64_t sgdByteOffset;
+        uint64_t sgdByteLength;
+    };
+    static_assert(sizeof(ktx2Header) == 80, "KTX2 header must be 80 bytes");
+
+    struct ktx2LevelIndex
+    {
+        uint64_t byteOffset;
+        uint64_t byteLength;
+        uint64_t uncompressedByteLength;
+    };
+
+    // Data format descriptor values, see the Khronos Data Format specification
+    const uint32_t kModelRGBSDA = 1;
+    const uint32_t kModelBC1A = 128;
+    const uint32_t kModelBC3 = 130;
+    const uint32_t kModelBC4 = 131;
+    const uint32_t kModelBC5 = 132;
+    const uint32_t kModelBC6H = 133;
+    const uint32_t kModelBC7 = 134;
+
+    const uint32_t kTransferLinear = 1;
+    const uint32_t kTransferSRGB = 2;
+    const uint32_t kPrimariesBT709 = 1;
+
+    const uint32_t kQualifierLinear = 0x10;
+    const uint32_t kQualifierExponent = 0x20;
+    const uint32_t kQualifierSigned = 0x40;
+    const uint32_t kQualifierFloat = 0x80;
+
+    const uint32_t kChannelAlpha = 15;
+
+    struct dfdSample
+    {
+        uint32_t bitOffset;
+        uint32_t bitLength;
+        uint32_t channel;           // channel id and qualifiers
+        uint32_t lower;
+        uint32_t upper;
+    };
+
+    bool isSRGB(VkFormat format)
+    {
+        return  format == VK_FORMAT_R8G8B8A8_SRGB || format == VK_FORMAT_BC1_RGB_SRGB_BLOCK ||
+                format == VK_FORMAT_BC3_SRGB_BLOCK || format == VK_FORMAT_BC7_SRGB_BLOCK;
+    }
+
+    // Basic descriptor block describing the formats the engine writes
+    std::vector<uint32_t> createDataFormatDescriptor(VkFormat format)
+    {
+        uint32_t model;
+        std::vector<dfdSample> samples;
+        bool blockCompressed = blockCompression::isBlockCompressed(format);
+
+        const uint32_t floatOne = 0x3F800000;
+        const uint32_t floatMinusOne = 0xBF800000;
+
+        switch(format)
+        {
+            case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+            case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+                model = kModelBC1A;
+                samples = {{0, 64, 0, 0, 0xFFFFFFFF}};
+                break;
+            case VK_FORMAT_BC3_UNORM_BLOCK:
+            case VK_FORMAT_BC3_SRGB_BLOCK:
+                model = kModelBC3;
+                samples = {{0, 64, kChannelAlpha | kQualifierLinear, 0, 0xFFFFFFFF}, {64, 64, 0, 0, 0xFFFFFFFF}};
+                break;
+            case VK_FORMAT_BC4_UNORM_BLOCK:
+                model = kModelBC4;
+                samples = {{0, 64, 0, 0, 0xFFFFFFFF}};
+                break;
+            case VK_FORMAT_BC5_UNORM_BLOCK:
+                model = kModelBC5;
+                samples = {{0, 64, 0, 0, 0xFFFFFFFF}, {64, 64, 1, 0, 0xFFFFFFFF}};
+                break;
+            case VK_FORMAT_BC6H_UFLOAT_BLOCK:
+                model = kModelBC6H;
+                samples = {{0, 128, kQualifierFloat, 0, 0x7F800000}};
+                break;
+            case VK_FORMAT_BC7_UNORM_BLOCK:
+            case VK_FORMAT_BC7_SRGB_BLOCK:
+                model = kModelBC7;
+                samples = {{0, 128, 0, 0, 0xFFFFFFFF}};
+                break;
+            case VK_FORMAT_R8G8B8A8_UNORM:
+            case VK_FORMAT_R8G8B8A8_SRGB:
+                model = kModelRGBSDA;
+                samples = {{0, 8, 0, 0, 255}, {8, 8, 1, 0, 255}, {16, 8, 2, 0, 255}, {24, 8, kChannelAlpha | kQualifierLinear, 0, 255}};
+                break;
+            case VK_FORMAT_R16G16B16A16_SFLOAT:
+                model = kModelRGBSDA;
+                for(uint32_t c = 0; c < 4; c++)
+                {
+                    samples.push_back({c * 16, 16, (c == 3 ? kChannelAlpha : c) | kQualifierFloat | kQualifierSigned, floatMinusOne, floatOne});
+                }
+                break;
+            case VK_FORMAT_R32G32B32A32_SFLOAT:
+                model = kModelRGBSDA;
+                for(uint32_t c = 0; c < 4; c++)
+                {
+                    samples.push_back({c * 32, 32, (c == 3 ? kChannelAlpha : c) | kQualifierFloat | kQualifierSigned, floatMinusOne, floatOne});
+                }
+                break;
+            case VK_FORMAT_E5B9G9R9_UFLOAT_PACK32:
+                // A 9 bit mantissa per channel, each paired with the shared 5 bit exponent
+                model = kModelRGBSDA;
+                for(uint32_t c = 0; c < 3; c++)
+                {
+                    samples.push_back({c * 9, 9, c, 0, 8448});
+                    samples.push_back({27, 5, c | kQualifierExponent, 15, 31});
+                }
+                break;
+            default:
+                throw std::runtime_error("No KTX2 data format descriptor for this format");
+        }
+
+        uint32_t blockSize = 24 + 16 * static_cast<uint32_t>(samples.size());
+        uint32_t blockBytes = ktx2::getFormatBlockBytes(format);
+        uint32_t blockDimension = blockCompressed ? 3 : 0;
+
+        std::vector<uint32_t> words;
+        words.push_back(4 + blockSize);                                             // total size
+        words.push_back(0);                                                         // vendor 0, descriptor type 0
+        words.push_back(2 | blockSize << 16);                                       // version 2
+        words.push_back(model | kPrimariesBT709 << 8 | (isSRGB(format) ? kTransferSRGB : kTransferLinear) << 16);
+        words.push_back(blockDimension | blockDimension << 8);                      // 4x4 (stored minus one) or 1x1
+        words.push_back(blockBytes);                                                // bytes in plane 0
+        words.push_back(0);
+
+        for(const dfdSample& sample : samples)
+        {
+            words.push_back(sample.bitOffset | (sample.bitLength - 1) << 16 | sample.channel << 24);
+            words.push_back(0);                                                     // sample position
+            words.push_back(sample.lower);
+            words.push_back(sample.upper);
+        }
+
+        return words;
+    }
+
+    uint64_t alignUp(uint64_t value, uint64_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+}
+
+const uint8_t* ktx2Texture::getBytes() const
+{
+    return mapping ? static_cast<const uint8_t*>(mapping->get_address()) : data.data();
+}
+
+namespace ktx2
+{
+    bool isKTX2File(const std::string& path)
+    {
+        return path.size() > 5 && path.substr(path.find_last_of(".") + 1) == "ktx2";
+    }
+
+    uint32_t getFormatBlockBytes(VkFormat format)
+    {
+        uint32_t blockSize = blockCompression::getBlockSize(format);
+        if(blockSize != 0)
+        {
+            return blockSize;
+        }
+
+        switch(format)
+        {
+            case VK_FORMAT_R8G8B8A8_UNORM:
+            case VK_FORMAT_R8G8B8A8_SRGB:
+                return 4;
+            case VK_FORMAT_R16G16B16A16_SFLOAT:
+                return 8;
+            case VK_FORMAT_R32G32B32A32_SFLOAT:
+                return 16;
+            case VK_FORMAT_E5B9G9R9_UFLOAT_PACK32:
+                return 4;
+            default:
+                throw std::runtime_error("Unsupported KTX2 texture format");
+        }
+    }
+
+    ktx2Texture load(const std::string& path)
+    {
+        namespace bip = boost::interprocess;
+
+        ktx2Texture texture;
+
+        // The mapping lives as long as the texture, pages are faulted in as levels are copied
+        try
+        {
+            bip::file_mapping file(path.c_str(), bip::read_only);
+            texture.mapping = std::make_shared<bip::mapped_region>(file, bip::read_only);
+        }
+        catch(const bip::interprocess_exception&)
+        {
+            throw std::runtime_error("Failed to map KTX2 file: " + path);
+        }
+
+        const uint8_t* bytes = texture.getBytes();
+        size_t fileSize = texture.mapping->get_size();
+
+        if(fileSize < sizeof(ktx2Header))
+        {
+            throw std::runtime_error("KTX2 file is truncated: " + path);
+        }
+
+        ktx2Header header;
+        std::memcpy(&header, bytes, sizeof(header));
+
+        if(std::memcmp(header.identifier, kIdentifier, sizeof(kIdentifier)) != 0)
+        {
+            throw std::runtime_error("Not a KTX2 file: " + path);
+        }
+
+        if(header.supercompressionScheme != kSupercompressionNone && header.supercompressionScheme != kSupercompressionZstd)
+        {
+            throw std::runtime_error("Unsupported KTX2 supercompression scheme: " + path);
+        }
+
+        if(header.pixelDepth > 1 || header.layerCount > 1 || (header.faceCount != 1 && header.faceCount != 6))
+        {
+            throw std::runtime_error("Only 2D textures and cubemaps are supported in KTX2 files: " + path);
+        }
+
+        texture.format = static_cast<VkFormat>(header.vkFormat);
+        texture.width = header.pixelWidth;
+        texture.height = std::max(header.pixelHeight, 1u);
+        texture.faces = header.faceCount;
+        texture.supercompression = header.supercompressionScheme;
+
+        // A level count of 0 asks the loader to generate the mips, the engine only ships full chains
+        uint32_t levelCount = std::max(header.levelCount, 1u);
+
+        if(fileSize < sizeof(ktx2Header) + levelCount * sizeof(ktx2LevelIndex))
+        {
+            throw std::runtime_error("KTX2 level index is truncated: " + path);
+        }
+
+        // Level offsets point straight into the mapped file
+        for(uint32_t i = 0; i < levelCount; i++)
+        {
+            ktx2LevelIndex index;
+            std::memcpy(&index, bytes + sizeof(ktx2Header) + i * sizeof(ktx2LevelIndex), sizeof(index));
+
+            if(index.byteOffset + index.byteLength > fileSize)
+            {
+                throw std::runtime_error("KTX2 level data is out of bounds: " + path);
+            }
+
+            uint64_t uncompressedSize = texture.supercompression == kSupercompressionNone ? index.byteLength : index.uncompressedByteLength;
+            texture.levels.push_back({index.byteOffset, index.byteLength, uncompressedSize});
+        }
+
+        return texture;
+    }
+
+    void copyLevel(const ktx2Texture& texture, size_t level, void* dst)
+    {
+        const ktx2Level& levelInfo = texture.levels[level];
+        const uint8_t* src = texture.getBytes() + levelInfo.offset;
+
+        if(texture.supercompression == kSupercompressionNone)
+        {
+            std::memcpy(dst, src, static_cast<size_t>(levelInfo.size));
+            return;
+        }
+
+        size_t written = ZSTD_decompress(dst, static_cast<size_t>(levelInfo.uncompressedSize), src, static_cast<size_t>(levelInfo.size));
+        if(ZSTD_isError(written) || written != levelInfo.uncompressedSize)
+        {
+            throw std::runtime_error("Failed to decompress KTX2 level");
+        }
+    }
+
+    void save(const std::string& path, const ktx2Texture& texture, int zstdLevel)
+    {
+        uint32_t blockBytes = getFormatBlockBytes(texture.format);
+        uint64_t alignment = std::lcm<uint64_t>(blockBytes, 4);
+        uint32_t levelCount = static_cast<uint32_t>(texture.levels.size());
+        bool supercompress = zstdLevel > 0;
+
+        // Supercompressed levels are byte aligned
+        if(supercompress)
+        {
+            alignment = 1;
+        }
+
+        std::vector<std::vector<uint8_t>> levelBytes(levelCount);
+        for(uint32_t i = 0; i < levelCount; i++)
+        {
+            std::vector<uint8_t> raw(texture.levels[i].uncompressedSize);
+            copyLevel(texture, i, raw.data());
+
+            if(!supercompress)
+            {
+                levelBytes[i] = std::move(raw);
+                continue;
+            }
+
+            levelBytes[i].resize(ZSTD_compressBound(raw.size()));
+            size_t written = ZSTD_compress(levelBytes[i].data(), levelBytes[i].size(), raw.data(), raw.size(), zstdLevel);
+            if(ZSTD_isError(written))
+            {
+                throw std::runtime_error("Failed to compress KTX2 level");
+            }
+            levelBytes[i].resize(written);
+        }
+
+        std::vector<uint32_t> dfd = createDataFormatDescriptor(texture.format);
+
+        ktx2Header header{};
+        std::memcpy(header.identifier, kIdentifier, sizeof(kIdentifier));
+        header.vkFormat = static_cast<uint32_t>(texture.format);
+        // Packed formats are read as one 32 bit word
+        header.typeSize = blockCompression::isBlockCompressed(texture.format) ? 1 : texture.format == VK_FORMAT_E5B9G9R9_UFLOAT_PACK32 ? 4 : blockBytes / 4;
+        header.pixelWidth = texture.width;
+        header.pixelHeight = texture.height;
+        header.pixelDepth = 0;
+        header.layerCount = 0;
+        header.faceCount = texture.faces;
+        header.levelCount = levelCount;
+        header.supercompressionScheme = supercompress ? kSupercompressionZstd : kSupercompressionNone;
+
+        header.dfdByteOffset = static_cast<uint32_t>(sizeof(ktx2Header) + levelCount * sizeof(ktx2LevelIndex));
+        header.dfdByteLength = static_cast<uint32_t>(dfd.size() * sizeof(uint32_t));
+
+        // Smallest level first
+        std::vector<ktx2LevelIndex> index(levelCount);
+        uint64_t offset = header.dfdByteOffset + header.dfdByteLength;
+        for(uint32_t i = levelCount; i-- > 0;)
+        {
+            offset = alignUp(offset, alignment);
+            index[i].byteOffset = offset;
+            index[i].byteLength = levelBytes[i].size();
+            index[i].uncompressedByteLength = texture.levels[i].uncompressedSize;
+            offset += levelBytes[i].size();
+        }
+
+        std::vector<uint8_t> file(offset, 0);
+        std::memcpy(file.data(), &header, sizeof(header));
+        std::memcpy(file.data() + sizeof(header), index.data(), index.size() * sizeof(ktx2LevelIndex));
+        std::memcpy(file.data() + header.dfdByteOffset, dfd.data(), header.dfdByteLength);
+
+        for(uint32_t i = 0; i < levelCount; i++)
+        {
+            std::memcpy(file.data() + index[i].byteOffset, levelBytes[i].data(), levelBytes[i].size());
+        }
+
+        std::ofstream output(path, std::ios::binary);
+        if(!output.is_open())
+        {
+            throw std::runtime_error("Failed to open KTX2 file for writing: " + path);
+        }
+        output.write(reinterpret_cast<const char*>(file.data()), file.size());
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+// GLFW
+#include "wrapper/glfw.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// KTX 2.0 container support, 2D textures and cubemaps, optionally zstd supercompressed
+// https://registry.khronos.org/KTX/specs/2.0/ktxspec.v2.html
+
+namespace boost { namespace interprocess { class mapped_region; } }
+
+struct ktx2Level
+{
+    uint64_t offset = 0;            // byte offset of the level inside the texture bytes
+    uint64_t size = 0;              // stored bytes, every face of the level
+    uint64_t uncompressedSize = 0;  // bytes once supercompression is undone
+};
+
+struct ktx2Texture
+{
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t faces = 1;             // 6 for cubemaps
+    uint32_t supercompression = 0;  // ktx2::kSupercompressionNone or ktx2::kSupercompressionZstd
+
+    std::vector<ktx2Level> levels;  // level 0 is the full resolution image
+
+    // Loaded textures keep the file mapped, textures built in memory own their bytes in data
+    std::shared_ptr<boost::interprocess::mapped_region> mapping;
+    std::vector<uint8_t> data;
+
+    const uint8_t* getBytes() const;
+};
+
+namespace ktx2
+{
+    const uint32_t kSupercompressionNone = 0;
+    const uint32_t kSupercompressionZstd = 2;
+
+    bool isKTX2File(const std::string& path);
+
+    // Maps the file, level contents are only read when they are copied out
+    ktx2Texture load(const std::string& path);
+
+    // Levels are written smallest first, as the specification recommends for streaming
+    // A zstd level above 0 supercompresses every mip level
+    void save(const std::string& path, const ktx2Texture& texture, int zstdLevel = 0);
+
+    // Copies or decompresses a level into dst, which must hold uncompressedSize bytes
+    void copyLevel(const ktx2Texture& texture, size_t level, void* dst);
+
+    // Bytes per texel block, 4x4 blocks for compressed formats and single texels otherwise
+    uint32_t getFormatBlockBytes(VkFormat format);
+}
@@ -0,0 +1,307 @@
+#include "util/meshCache.hpp"
+
+// Boost
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+namespace
+{
+    const char kMagic[4] = {'M', 'M', 'S', 'H'};
+    // Bump whenever the layout of the file or of Vertex changes
+    const uint32_t kVersion = 3;
+    const uint64_t kBlobAlignment = 16;
+
+    struct meshCacheHeader
+    {
+        char magic[4];
+        uint32_t version;
+        uint64_t sourceKey;
+        uint32_t vertexStride;
+        uint32_t meshCount;
+        uint32_t textureCount;
+        uint32_t textureTypeCount;
+        uint64_t meshesOffset;
+        uint64_t texturesOffset;
+        uint64_t reserved[2];
+    };
+    static_assert(sizeof(meshCacheHeader) == 64, "Mesh cache header must be 64 bytes");
+
+    struct meshRecord
+    {
+        uint64_t vertexOffset;
+        uint64_t indexOffset;
+        uint32_t vertexCount;
+        uint32_t indexCount;
+        float boundsCenter[3];
+        float boundsRadius;
+        uint32_t textures[static_cast<size_t>(E_TextureType::SIZE)];
+        uint32_t lodCount;
+        meshLod lods[kMaxLodCount];             // ranges of the index blob
+        uint64_t meshletOffset;
+        uint32_t meshletCount;
+        uint32_t padding;
+    };
+
+    struct textureRecord
+    {
+        uint32_t type;
+        uint32_t pathLength;
+        uint64_t pathOffset;
+        uint64_t embeddedOffset;
+        uint64_t embeddedSize;
+    };
+
+    uint64_t alignUp(uint64_t value, uint64_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    bool inFile(uint64_t offset, uint64_t size, uint64_t fileSize)
+    {
+        return offset <= fileSize && size <= fileSize - offset;
+    }
+}
+
+namespace meshCache
+{
+    bool load(const std::string& path, uint64_t sourceKey, meshCacheFile& cache)
+    {
+        namespace bip = boost::interprocess;
+
+        std::ifstream probe(path, std::ios::binary);
+        if(!probe.is_open())
+        {
+            return false;
+        }
+        probe.close();
+
+        // A damaged cache file is imported again and overwritten
+        try
+        {
+            bip::file_mapping file(path.c_str(), bip::read_only);
+            cache.mapping = std::make_shared<bip::mapped_region>(file, bip::read_only);
+
+            const uint8_t* bytes = static_cast<const uint8_t*>(cache.mapping->get_address());
+            uint64_t fileSize = cache.mapping->get_size();
+
+            meshCacheHeader header;
+            if(fileSize < sizeof(header))
+            {
+                throw std::runtime_error("file is truncated");
+            }
+            std::memcpy(&header, bytes, sizeof(header));
+
+            // Outdated caches are silently replaced
+            if(std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion || header.sourceKey != sourceKey ||
+               header.vertexStride != sizeof(Vertex) || header.textureTypeCount != static_cast<uint32_t>(E_TextureType::SIZE))
+            {
+                cache = meshCacheFile();
+                return false;
+            }
+
+            if(!inFile(header.meshesOffset, static_cast<uint64_t>(header.meshCount) * sizeof(meshRecord), fileSize) ||
+               !inFile(header.texturesOffset, static_cast<uint64_t>(header.textureCount) * sizeof(textureRecord), fileSize))
+            {
+                throw std::runtime_error("file is truncated");
+            }
+
+            cache.textures.resize(header.textureCount);
+            for(uint32_t i = 0; i < header.textureCount; i++)
+            {
+                textureRecord record;
+                std::memcpy(&record, bytes + header.texturesOffset + i * sizeof(textureRecord), sizeof(record));
+
+                if(record.type >= static_cast<uint32_t>(E_TextureType::SIZE) || !inFile(record.pathOffset, record.pathLength, fileSize) || !inFile(record.embeddedOffset, record.embeddedSize, fileSize))
+                {
+                    throw std::runtime_error("texture reference is out of range");
+                }
+
+                materialTextureReference& texture = cache.textures[i];
+                texture.type = static_cast<E_TextureType>(record.type);
+                texture.path.assign(reinterpret_cast<const char*>(bytes + record.pathOffset), record.pathLength);
+                texture.embedded = record.embeddedSize > 0 ? bytes + record.embeddedOffset : nullptr;
+                texture.embeddedSize = record.embeddedSize;
+            }
+
+            cache.meshes.resize(header.meshCount);
+            for(uint32_t i = 0; i < header.meshCount; i++)
+            {
+                meshRecord record;
+                std::memcpy(&record, bytes + header.meshesOffset + i * sizeof(meshRecord), sizeof(record));
+
+                if(!inFile(record.vertexOffset, static_cast<uint64_t>(record.vertexCount) * sizeof(Vertex), fileSize) ||
+                   !inFile(record.indexOffset, static_cast<uint64_t>(record.indexCount) * sizeof(uint32_t), fileSize) ||
+                   !inFile(record.meshletOffset, static_cast<uint64_t>(record.meshletCount) * sizeof(meshlet), fileSize) ||
+                   record.vertexOffset % alignof(Vertex) != 0 || record.indexOffset % alignof(uint32_t) != 0 || record.meshletOffset % alignof(meshlet) != 0)
+                {
+                    throw std::runtime_error("mesh data is out of range");
+                }
+
+                cachedMesh& mesh = cache.meshes[i];
+                mesh.vertices = reinterpret_cast<const Vertex*>(bytes + record.vertexOffset);
+                mesh.vertexCount = record.vertexCount;
+                mesh.indices = reinterpret_cast<const uint32_t*>(bytes + record.indexOffset);
+                mesh.indexCount = record.indexCount;
+                mesh.boundsCenter = glm::vec3(record.boundsCenter[0], record.boundsCenter[1], record.boundsCenter[2]);
+                mesh.boundsRadius = record.boundsRadius;
+
+                // Indices reach the GPU as they are and may be narrowed to 16 bits, out of range ones would fetch past the vertex buffer
+                if(std::any_of(mesh.indices, mesh.indices + mesh.indexCount, [&record](uint32_t index) { return index >= record.vertexCount; }))
+                {
+                    throw std::runtime_error("index is out of range");
+                }
+
+                if(record.lodCount > kMaxLodCount)
+                {
+                    throw std::runtime_error("level of detail count is out of range");
+                }
+                mesh.lods.assign(record.lods, record.lods + record.lodCount);
+                for(const meshLod& lod : mesh.lods)
+                {
+                    if(lod.firstIndex > record.indexCount || lod.indexCount > record.indexCount - lod.firstIndex)
+                    {
+                        throw std::runtime_error("level of detail is out of range");
+                    }
+                }
+
+                mesh.meshlets = reinterpret_cast<const meshlet*>(bytes + record.meshletOffset);
+                mesh.meshletCount = record.meshletCount;
+                for(uint32_t m = 0; m < mesh.meshletCount; m++)
+                {
+                    if(mesh.meshlets[m].firstIndex > record.indexCount || mesh.meshlets[m].triangleCount > (record.indexCount - mesh.meshlets[m].firstIndex) / 3)
+                    {
+                        throw std::runtime_error("meshlet is out of range");
+                    }
+                }
+
+                for(size_t type = 0; type < mesh.textures.size(); type++)
+                {
+                    if(record.textures[type] != kNoTexture && record.textures[type] >= header.textureCount)
+                    {
+                        throw std::runtime_error("texture reference is out of range");
+                    }
+                    mesh.textures[type] = record.textures[type];
+                }
+            }
+        }
+        catch(const std::exception& e)
+        {
+            std::cerr << "Failed to load mesh cache " << path << ": " << e.what() << std::endl;
+            cache = meshCacheFile();
+            return false;
+        }
+
+        return true;
+    }
+
+    void save(const std::string& path, uint64_t sourceKey, const std::vector<cachedMesh>& meshes, const std::vector<materialTextureReference>& textures)
+    {
+        meshCacheHeader header{};
+        std::memcpy(header.magic, kMagic, sizeof(kMagic));
+        header.version = kVersion;
+        header.sourceKey = sourceKey;
+        header.vertexStride = sizeof(Vertex);
+        header.meshCount = static_cast<uint32_t>(meshes.size());
+        header.textureCount = static_cast<uint32_t>(textures.size());
+        header.textureTypeCount = static_cast<uint32_t>(E_TextureType::SIZE);
+        header.meshesOffset = sizeof(meshCacheHeader);
+        header.texturesOffset = header.meshesOffset + meshes.size() * sizeof(meshRecord);
+
+        // 1 - Texture paths and embedded bytes follow the records
+        uint64_t offset = header.texturesOffset + textures.size() * sizeof(textureRecord);
+        std::vector<textureRecord> textureRecords(textures.size());
+        for(size_t i = 0; i < textures.size(); i++)
+        {
+            textureRecords[i].type = static_cast<uint32_t>(textures[i].type);
+            textureRecords[i].pathLength = static_cast<uint32_t>(textures[i].path.size());
+            textureRecords[i].pathOffset = offset;
+            offset += textures[i].path.size();
+
+            textureRecords[i].embeddedOffset = offset;
+            textureRecords[i].embeddedSize = textures[i].embedded ? textures[i].embeddedSize : 0;
+            offset += textureRecords[i].embeddedSize;
+        }
+
+        // 2 - Then every vertex blob, every index blob and every meshlet blob, aligned for straight copies
+        std::vector<meshRecord> meshRecords(meshes.size());
+        for(size_t i = 0; i < meshes.size(); i++)
+        {
+            offset = alignUp(offset, kBlobAlignment);
+            meshRecords[i].vertexOffset = offset;
+            meshRecords[i].vertexCount = meshes[i].vertexCount;
+            offset += meshes[i].vertexCount * sizeof(Vertex);
+        }
+        for(size_t i = 0; i < meshes.size(); i++)
+        {
+            offset = alignUp(offset, kBlobAlignment);
+            meshRecords[i].indexOffset = offset;
+            meshRecords[i].indexCount = meshes[i].indexCount;
+            offset += meshes[i].indexCount * sizeof(uint32_t);
+
+            meshRecords[i].boundsCenter[0] = meshes[i].boundsCenter.x;
+            meshRecords[i].boundsCenter[1] = meshes[i].boundsCenter.y;
+            meshRecords[i].boundsCenter[2] = meshes[i].boundsCenter.z;
+            meshRecords[i].boundsRadius = meshes[i].boundsRadius;
+            std::memcpy(meshRecords[i].textures, meshes[i].textures.data(), sizeof(meshRecords[i].textures));
+
+            meshRecords[i].lodCount = static_cast<uint32_t>(std::min(meshes[i].lods.size(), kMaxLodCount));
+            std::copy(meshes[i].lods.begin(), meshes[i].lods.begin() + meshRecords[i].lodCount, meshRecords[i].lods);
+        }
+        for(size_t i = 0; i < meshes.size(); i++)
+        {
+            offset = alignUp(offset, kBlobAlignment);
+            meshRecords[i].meshletOffset = offset;
+            meshRecords[i].meshletCount = meshes[i].meshletCount;
+            offset += meshes[i].meshletCount * sizeof(meshlet);
+        }
+
+        // 3 - Write everything in file order
+        std::ofstream file(path, std::ios::binary);
+        if(!file)
+        {
+            throw std::runtime_error("Failed to open mesh cache for writing: " + path);
+        }
+
+        auto pad = [&file]()
+        {
+            static const char zeros[kBlobAlignment] = {};
+            uint64_t position = static_cast<uint64_t>(file.tellp());
+            file.write(zeros, static_cast<std::streamsize>(alignUp(position, kBlobAlignment) - position));
+        };
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(meshRecords.data()), static_cast<std::streamsize>(meshRecords.size() * sizeof(meshRecord)));
+        file.write(reinterpret_cast<const char*>(textureRecords.data()), static_cast<std::streamsize>(textureRecords.size() * sizeof(textureRecord)));
+        for(size_t i = 0; i < textures.size(); i++)
+        {
+            file.write(textures[i].path.data(), static_cast<std::streamsize>(textures[i].path.size()));
+            file.write(reinterpret_cast<const char*>(textures[i].embedded), static_cast<std::streamsize>(textureRecords[i].embeddedSize));
+        }
+        for(const cachedMesh& mesh : meshes)
+        {
+            pad();
+            file.write(reinterpret_cast<const char*>(mesh.vertices), static_cast<std::streamsize>(mesh.vertexCount * sizeof(Vertex)));
+        }
+        for(const cachedMesh& mesh : meshes)
+        {
+            pad();
+            file.write(reinterpret_cast<const char*>(mesh.indices), static_cast<std::streamsize>(mesh.indexCount * sizeof(uint32_t)));
+        }
+        for(const cachedMesh& mesh : meshes)
+        {
+            pad();
+            file.write(reinterpret_cast<const char*>(mesh.meshlets), static_cast<std::streamsize>(mesh.meshletCount * sizeof(meshlet)));
+        }
+
+        if(!file)
+        {
+            throw std::runtime_error("Failed to write mesh cache: " + path);
+        }
+    }
+}
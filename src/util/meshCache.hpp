@@ -0,0 +1,65 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "rendering/resources/model.hpp"
+
+// Binary mesh cache (.mmsh), written after a model's first import so later runs skip Assimp
+// Vertex, index and meshlet blobs are stored in GPU layout and are copied from the file mapping into staging memory
+// Indices are kept 32 bit, meshes with few enough vertices narrow them to 16 bit on the way into staging memory
+
+namespace boost { namespace interprocess { class mapped_region; } }
+
+// Material texture of a model, embedded textures point at their encoded bytes
+struct materialTextureReference
+{
+    E_TextureType type = E_TextureType::DIFFUSE;
+    std::string path;                           // as written in the material, relative to the model file
+    const uint8_t* embedded = nullptr;
+    size_t embeddedSize = 0;
+};
+
+// Texture reference of every texture type, kNoTexture where the material has none
+using meshTextureReferences = std::array<uint32_t, static_cast<size_t>(E_TextureType::SIZE)>;
+
+struct cachedMesh
+{
+    const Vertex* vertices = nullptr;           // points into the file mapping, or the geometry of an Assimp import
+    uint32_t vertexCount = 0;
+    const uint32_t* indices = nullptr;
+    uint32_t indexCount = 0;
+
+    glm::vec3 boundsCenter = glm::vec3(0.0f);
+    float boundsRadius = 0.0f;
+
+    std::vector<meshLod> lods;
+
+    const meshlet* meshlets = nullptr;          // clusters of the full level of detail
+    uint32_t meshletCount = 0;
+
+    meshTextureReferences textures;
+};
+
+struct meshCacheFile
+{
+    std::vector<cachedMesh> meshes;
+    std::vector<materialTextureReference> textures;
+
+    // Mesh and embedded texture data stay valid while the file is mapped
+    std::shared_ptr<boost::interprocess::mapped_region> mapping;
+};
+
+namespace meshCache
+{
+    const uint32_t kNoTexture = ~0u;
+
+    // Maps the file, false when it is missing, damaged, from another version or made from a different source
+    bool load(const std::string& path, uint64_t sourceKey, meshCacheFile& cache);
+
+    // Writes what the views point at, the geometry only has to outlive the call
+    void save(const std::string& path, uint64_t sourceKey, const std::vector<cachedMesh>& meshes, const std::vector<materialTextureReference>& textures);
+}
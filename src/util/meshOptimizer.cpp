@@ -0,0 +1,764 @@
+#include "util/meshOptimizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <unordered_map>
+
+namespace
+{
+    const int kNoVertex = -1;
+
+    // Cosine of the largest turn a collapse may give a triangle
+    const float kMaxNormalTurn = 0.25f;
+
+    // Triangles of every vertex, in compressed rows
+    struct vertexAdjacency
+    {
+        std::vector<uint32_t> offsets;          // first entry of each vertex, vertexCount + 1 entries
+        std::vector<uint32_t> triangles;
+    };
+
+    vertexAdjacency buildAdjacency(const std::vector<uint32_t>& indices, size_t vertexCount)
+    {
+        vertexAdjacency adjacency;
+        adjacency.offsets.assign(vertexCount + 1, 0);
+        adjacency.triangles.resize(indices.size());
+
+        for(uint32_t index : indices)
+        {
+            adjacency.offsets[index + 1]++;
+        }
+        std::partial_sum(adjacency.offsets.begin(), adjacency.offsets.end(), adjacency.offsets.begin());
+
+        std::vector<uint32_t> cursor(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+        for(size_t i = 0; i < indices.size(); i++)
+        {
+            adjacency.triangles[cursor[indices[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+
+        return adjacency;
+    }
+
+    // Next fanning vertex: the candidate that stays in the cache longest once its remaining triangles are emitted
+    int getNextVertex(const std::vector<uint32_t>& candidates, const std::vector<uint32_t>& liveTriangles, const std::vector<uint32_t>& cacheTime, uint32_t time, uint32_t cacheSize)
+    {
+        int best = kNoVertex;
+        int bestPriority = -1;
+
+        for(uint32_t vertex : candidates)
+        {
+            if(liveTriangles[vertex] == 0)
+            {
+                continue;
+            }
+
+            // Emitting its triangles pushes at most two new vertices per triangle into the cache
+            int priority = 0;
+            if(time - cacheTime[vertex] + 2 * liveTriangles[vertex] <= cacheSize)
+            {
+                priority = static_cast<int>(time - cacheTime[vertex]);
+            }
+
+            if(priority > bestPriority)
+            {
+                best = static_cast<int>(vertex);
+                bestPriority = priority;
+            }
+        }
+
+        return best;
+    }
+
+    // Weighted sum of squared distances to a set of planes, p'Ap + 2b'p + c
+    struct quadric
+    {
+        double a00 = 0.0, a01 = 0.0, a02 = 0.0, a11 = 0.0, a12 = 0.0, a22 = 0.0;
+        double b0 = 0.0, b1 = 0.0, b2 = 0.0;
+        double c = 0.0;
+        double weight = 0.0;
+
+        void addPlane(const glm::vec3& normal, float distance, float weight)
+        {
+            double x = normal.x, y = normal.y, z = normal.z, d = distance;
+            a00 += weight * x * x; a01 += weight * x * y; a02 += weight * x * z;
+            a11 += weight * y * y; a12 += weight * y * z; a22 += weight * z * z;
+            b0 += weight * x * d; b1 += weight * y * d; b2 += weight * z * d;
+            c += weight * d * d;
+            this->weight += weight;
+        }
+
+        void add(const quadric& other)
+        {
+            a00 += other.a00; a01 += other.a01; a02 += other.a02;
+            a11 += other.a11; a12 += other.a12; a22 += other.a22;
+            b0 += other.b0; b1 += other.b1; b2 += other.b2;
+            c += other.c;
+            weight += other.weight;
+        }
+
+        // Mean squared distance, in squared model units
+        double error(const glm::vec3& point) const
+        {
+            if(weight == 0.0)
+            {
+                return 0.0;
+            }
+
+            double x = point.x, y = point.y, z = point.z;
+            double result = a00 * x * x + a11 * y * y + a22 * z * z + 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z) +
+                            2.0 * (b0 * x + b1 * y + b2 * z) + c;
+            return std::max(result / weight, 0.0);
+        }
+    };
+
+    uint64_t getEdgeKey(uint32_t a, uint32_t b)
+    {
+        return a < b ? (static_cast<uint64_t>(a) << 32) | b : (static_cast<uint64_t>(b) << 32) | a;
+    }
+
+    // Vertices that must keep their place: open and non manifold borders, and attribute seams where several vertices share a position
+    std::vector<bool> findLockedVertices(const std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices)
+    {
+        std::unordered_map<glm::vec3, uint32_t> positions;
+        positions.reserve(vertices.size());
+
+        std::vector<uint32_t> positionIds(vertices.size());
+        std::vector<uint32_t> positionUses;
+        for(size_t i = 0; i < vertices.size(); i++)
+        {
+            auto [it, inserted] = positions.emplace(vertices[i].Position, static_cast<uint32_t>(positionUses.size()));
+            if(inserted)
+            {
+                positionUses.push_back(0);
+            }
+            positionIds[i] = it->second;
+            positionUses[it->second]++;
+        }
+
+        std::vector<bool> locked(vertices.size(), false);
+        for(size_t i = 0; i < vertices.size(); i++)
+        {
+            locked[i] = positionUses[positionIds[i]] > 1;
+        }
+
+        // Edges of a closed manifold surface are shared by exactly two triangles
+        std::unordered_map<uint64_t, uint32_t> edgeUses;
+        edgeUses.reserve(indices.size());
+        for(size_t i = 0; i < indices.size(); i += 3)
+        {
+            for(size_t corner = 0; corner < 3; corner++)
+            {
+                edgeUses[getEdgeKey(positionIds[indices[i + corner]], positionIds[indices[i + (corner + 1) % 3]])]++;
+            }
+        }
+
+        for(size_t i = 0; i < indices.size(); i += 3)
+        {
+            for(size_t corner = 0; corner < 3; corner++)
+            {
+                uint32_t a = indices[i + corner];
+                uint32_t b = indices[i + (corner + 1) % 3];
+                if(edgeUses[getEdgeKey(positionIds[a], positionIds[b])] != 2)
+                {
+                    locked[a] = true;
+                    locked[b] = true;
+                }
+            }
+        }
+
+        return locked;
+    }
+
+    // Moving vertex to target must not turn any of its other triangles over
+    bool collapseFlips(const std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, const vertexAdjacency& adjacency, uint32_t vertex, uint32_t target)
+    {
+        const glm::vec3& destination = vertices[target].Position;
+
+        for(uint32_t entry = adjacency.offsets[vertex]; entry < adjacency.offsets[vertex + 1]; entry++)
+        {
+            const uint32_t* triangle = &indices[adjacency.triangles[entry] * 3];
+            if(triangle[0] == target || triangle[1] == target || triangle[2] == target)
+            {
+                continue;
+            }
+
+            glm::vec3 before[3];
+            glm::vec3 after[3];
+            for(size_t corner = 0; corner < 3; corner++)
+            {
+                before[corner] = vertices[triangle[corner]].Position;
+                after[corner] = triangle[corner] == vertex ? destination : before[corner];
+            }
+
+            glm::vec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+            glm::vec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+            // Turning a triangle more than about 75 degrees is treated as a flip, a few of those in a row could otherwise fold it over
+            if(glm::dot(normalBefore, normalAfter) <= kMaxNormalTurn * glm::length(normalBefore) * glm::length(normalAfter))
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+}
+
+namespace meshOptimizer
+{
+    float computeACMR(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize)
+    {
+        if(indices.size() < 3)
+        {
+            return 0.0f;
+        }
+
+        // A vertex is in the FIFO while fewer than cacheSize misses happened after it went in
+        std::vector<size_t> insertedAt(vertexCount, 0);
+        size_t misses = 0;
+
+        for(uint32_t index : indices)
+        {
+            if(insertedAt[index] == 0 || misses - insertedAt[index] + 1 > cacheSize)
+            {
+                misses++;
+                insertedAt[index] = misses;
+            }
+        }
+
+        return static_cast<float>(misses) / static_cast<float>(indices.size() / 3);
+    }
+
+    void weldVertices(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+    {
+        std::unordered_map<Vertex, uint32_t> unique;
+        unique.reserve(vertices.size());
+
+        std::vector<uint32_t> remap(vertices.size());
+        std::vector<Vertex> welded;
+        welded.reserve(vertices.size());
+
+        for(size_t i = 0; i < vertices.size(); i++)
+        {
+            auto [it, inserted] = unique.emplace(vertices[i], static_cast<uint32_t>(welded.size()));
+            if(inserted)
+            {
+                welded.push_back(vertices[i]);
+            }
+            remap[i] = it->second;
+        }
+
+        for(uint32_t& index : indices)
+        {
+            index = remap[index];
+        }
+        vertices.swap(welded);
+    }
+
+    void optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount, std::vector<size_t>& clusterStarts, uint32_t cacheSize)
+    {
+        clusterStarts.clear();
+
+        size_t triangleCount = indices.size() / 3;
+        if(triangleCount == 0)
+        {
+            return;
+        }
+
+        vertexAdjacency adjacency = buildAdjacency(indices, vertexCount);
+
+        std::vector<uint32_t> liveTriangles(vertexCount);
+        for(size_t vertex = 0; vertex < vertexCount; vertex++)
+        {
+            liveTriangles[vertex] = adjacency.offsets[vertex + 1] - adjacency.offsets[vertex];
+        }
+
+        // Timestamps start far enough in the past that every vertex is a miss
+        std::vector<uint32_t> cacheTime(vertexCount, 0);
+        uint32_t time = cacheSize + 1;
+
+        std::vector<bool> emitted(triangleCount, false);
+        std::vector<uint32_t> deadEnds;
+        std::vector<uint32_t> candidates;
+
+        std::vector<uint32_t> result;
+        result.reserve(indices.size());
+
+        size_t cursor = 0;
+        int fanning = kNoVertex;
+        bool restarted = true;
+
+        while(true)
+        {
+            // 1 - Pick the next fanning vertex, a restart begins a new cluster
+            if(fanning == kNoVertex)
+            {
+                while(!deadEnds.empty() && fanning == kNoVertex)
+                {
+                    uint32_t vertex = deadEnds.back();
+                    deadEnds.pop_back();
+                    if(liveTriangles[vertex] > 0)
+                    {
+                        fanning = static_cast<int>(vertex);
+                    }
+                }
+
+                while(fanning == kNoVertex && cursor < vertexCount)
+                {
+                    if(liveTriangles[cursor] > 0)
+                    {
+                        fanning = static_cast<int>(cursor);
+                    }
+                    cursor++;
+                }
+
+                if(fanning == kNoVertex)
+                {
+                    break;
+                }
+                restarted = true;
+            }
+
+            // 2 - Emit every triangle left around it
+            if(restarted)
+            {
+                clusterStarts.push_back(result.size() / 3);
+                restarted = false;
+            }
+
+            candidates.clear();
+            for(uint32_t entry = adjacency.offsets[fanning]; entry < adjacency.offsets[fanning + 1]; entry++)
+            {
+                uint32_t triangle = adjacency.triangles[entry];
+                if(emitted[triangle])
+                {
+                    continue;
+                }
+                emitted[triangle] = true;
+
+                for(size_t corner = 0; corner < 3; corner++)
+                {
+                    uint32_t vertex = indices[triangle * 3 + corner];
+                    result.push_back(vertex);
+                    deadEnds.push_back(vertex);
+                    candidates.push_back(vertex);
+                    liveTriangles[vertex]--;
+
+                    if(time - cacheTime[vertex] > cacheSize)
+                    {
+                        cacheTime[vertex] = time++;
+                    }
+                }
+            }
+
+            // 3 - Continue from a vertex that is still cached
+            fanning = getNextVertex(candidates, liveTriangles, cacheTime, time, cacheSize);
+        }
+
+        indices.swap(result);
+    }
+
+    void optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, const std::vector<size_t>& clusterStarts)
+    {
+        size_t triangleCount = indices.size() / 3;
+        if(clusterStarts.size() < 2)
+        {
+            return;
+        }
+
+        struct cluster
+        {
+            size_t first;
+            size_t count;
+            glm::vec3 centroid = glm::vec3(0.0f);
+            glm::vec3 normal = glm::vec3(0.0f);
+            float sortKey = 0.0f;
+        };
+
+        std::vector<cluster> clusters;
+        clusters.reserve(clusterStarts.size());
+
+        glm::vec3 meshCentroid = glm::vec3(0.0f);
+        float meshArea = 0.0f;
+
+        // 1 - Area weighted centroid and normal of every cluster
+        for(size_t i = 0; i < clusterStarts.size(); i++)
+        {
+            size_t end = i + 1 < clusterStarts.size() ? clusterStarts[i + 1] : triangleCount;
+            cluster current{clusterStarts[i], end - clusterStarts[i]};
+
+            float area = 0.0f;
+            for(size_t triangle = current.first; triangle < end; triangle++)
+            {
+                const glm::vec3& a = vertices[indices[triangle * 3 + 0]].Position;
+                const glm::vec3& b = vertices[indices[triangle * 3 + 1]].Position;
+                const glm::vec3& c = vertices[indices[triangle * 3 + 2]].Position;
+
+                glm::vec3 cross = glm::cross(b - a, c - a);
+                float triangleArea = glm::length(cross);
+
+                current.centroid += (a + b + c) * (triangleArea / 3.0f);
+                current.normal += cross;
+                area += triangleArea;
+            }
+
+            meshCentroid += current.centroid;
+            meshArea += area;
+
+            if(area > 0.0f)
+            {
+                current.centroid /= area;
+            }
+            clusters.push_back(current);
+        }
+
+        if(meshArea > 0.0f)
+        {
+            meshCentroid /= meshArea;
+        }
+
+        // 2 - Clusters far out and facing away from the centre are the likeliest occluders
+        for(cluster& current : clusters)
+        {
+            float length = glm::length(current.normal);
+            current.sortKey = length > 0.0f ? glm::dot(current.centroid - meshCentroid, current.normal / length) : 0.0f;
+        }
+
+        std::stable_sort(clusters.begin(), clusters.end(), [](const cluster& a, const cluster& b) { return a.sortKey > b.sortKey; });
+
+        std::vector<uint32_t> result;
+        result.reserve(indices.size());
+        for(const cluster& current : clusters)
+        {
+            result.insert(result.end(), indices.begin() + current.first * 3, indices.begin() + (current.first + current.count) * 3);
+        }
+
+        indices.swap(result);
+    }
+
+    void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+    {
+        const uint32_t kUnused = ~0u;
+
+        std::vector<uint32_t> remap(vertices.size(), kUnused);
+        std::vector<Vertex> ordered;
+        ordered.reserve(vertices.size());
+
+        for(uint32_t& index : indices)
+        {
+            if(remap[index] == kUnused)
+            {
+                remap[index] = static_cast<uint32_t>(ordered.size());
+                ordered.push_back(vertices[index]);
+            }
+            index = remap[index];
+        }
+
+        vertices.swap(ordered);
+    }
+
+    std::vector<uint32_t> simplifyMesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& sourceIndices, size_t targetIndexCount, float targetError, float& resultError)
+    {
+        std::vector<uint32_t> indices = sourceIndices;
+        resultError = 0.0f;
+
+        if(indices.size() % 3 != 0)
+        {
+            return indices;
+        }
+
+        std::vector<bool> locked = findLockedVertices(indices, vertices);
+
+        // 1 - Every vertex starts with the area weighted planes of its triangles
+        std::vector<quadric> quadrics(vertices.size());
+        for(size_t i = 0; i < indices.size(); i += 3)
+        {
+            const glm::vec3& a = vertices[indices[i + 0]].Position;
+            const glm::vec3& b = vertices[indices[i + 1]].Position;
+            const glm::vec3& c = vertices[indices[i + 2]].Position;
+
+            glm::vec3 normal = glm::cross(b - a, c - a);
+            float area = glm::length(normal);
+            if(area == 0.0f)
+            {
+                continue;
+            }
+            normal /= area;
+
+            quadric plane;
+            plane.addPlane(normal, -glm::dot(normal, a), area);
+            for(size_t corner = 0; corner < 3; corner++)
+            {
+                quadrics[indices[i + corner]].add(plane);
+            }
+        }
+
+        struct collapse
+        {
+            uint32_t vertex;
+            uint32_t target;
+            double cost;
+        };
+
+        const double maxCost = static_cast<double>(targetError) * targetError;
+        size_t triangleCount = indices.size() / 3;
+
+        std::vector<collapse> collapses;
+        std::vector<uint32_t> remap(vertices.size());
+        std::vector<bool> touched(vertices.size());
+
+        // 2 - Passes of the cheapest independent edge collapses, each vertex moves onto a neighbour so no new attributes are needed
+        while(triangleCount * 3 > targetIndexCount)
+        {
+            vertexAdjacency adjacency = buildAdjacency(indices, vertices.size());
+
+            collapses.clear();
+            for(size_t i = 0; i < indices.size(); i += 3)
+            {
+                for(size_t corner = 0; corner < 3; corner++)
+                {
+                    uint32_t a = indices[i + corner];
+                    uint32_t b = indices[i + (corner + 1) % 3];
+
+                    if(locked[a] && locked[b])
+                    {
+                        continue;
+                    }
+
+                    // The surviving vertex carries the planes of both
+                    quadric merged = quadrics[a];
+                    merged.add(quadrics[b]);
+
+                    if(!locked[a])
+                    {
+                        collapses.push_back({a, b, merged.error(vertices[b].Position)});
+                    }
+                    if(!locked[b])
+                    {
+                        collapses.push_back({b, a, merged.error(vertices[a].Position)});
+                    }
+                }
+            }
+
+            std::sort(collapses.begin(), collapses.end(), [](const collapse& x, const collapse& y) { return x.cost < y.cost; });
+
+            std::iota(remap.begin(), remap.end(), 0);
+            std::fill(touched.begin(), touched.end(), false);
+            size_t collapsed = 0;
+
+            for(const collapse& current : collapses)
+            {
+                if(triangleCount * 3 <= targetIndexCount || current.cost > maxCost)
+                {
+                    break;
+                }
+
+                // Neighbourhoods of one pass never overlap, the adjacency stays valid while the pass runs
+                if(touched[current.vertex] || touched[current.target] || collapseFlips(indices, vertices, adjacency, current.vertex, current.target))
+                {
+                    continue;
+                }
+
+                for(uint32_t entry = adjacency.offsets[current.vertex]; entry < adjacency.offsets[current.vertex + 1]; entry++)
+                {
+                    const uint32_t* triangle = &indices[adjacency.triangles[entry] * 3];
+                    if(triangle[0] == current.target || triangle[1] == current.target || triangle[2] == current.target)
+                    {
+                        triangleCount--;
+                    }
+                    for(size_t corner = 0; corner < 3; corner++)
+                    {
+                        touched[triangle[corner]] = true;
+                    }
+                }
+
+                remap[current.vertex] = current.target;
+                quadrics[current.target].add(quadrics[current.vertex]);
+                resultError = std::max(resultError, static_cast<float>(std::sqrt(current.cost)));
+                collapsed++;
+            }
+
+            if(collapsed == 0)
+            {
+                break;
+            }
+
+            // 3 - Apply the pass, triangles that lost an edge are gone
+            size_t kept = 0;
+            for(size_t i = 0; i < indices.size(); i += 3)
+            {
+                uint32_t a = remap[indices[i + 0]];
+                uint32_t b = remap[indices[i + 1]];
+                uint32_t c = remap[indices[i + 2]];
+                if(a != b && b != c && a != c)
+                {
+                    indices[kept++] = a;
+                    indices[kept++] = b;
+                    indices[kept++] = c;
+                }
+            }
+            indices.resize(kept);
+            triangleCount = kept / 3;
+        }
+
+        return indices;
+    }
+
+    std::vector<meshLod> generateLods(const std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+    {
+        std::vector<meshLod> lods = {{0, static_cast<uint32_t>(indices.size()), 0.0f}};
+
+        while(lods.size() < kMaxLodCount)
+        {
+            meshLod previous = lods.back();
+            if(previous.indexCount / 3 < kMinLodTriangles)
+            {
+                break;
+            }
+
+            // Each level starts from the one before it, so the error bounds add up
+            std::vector<uint32_t> source(indices.begin() + previous.firstIndex, indices.begin() + previous.firstIndex + previous.indexCount);
+            size_t target = static_cast<size_t>(source.size() / 3 * kLodReduction) * 3;
+
+            float error = 0.0f;
+            std::vector<uint32_t> simplified = simplifyMesh(vertices, source, target, std::numeric_limits<float>::max(), error);
+
+            // Locked borders and seams can stall the reduction, a level that barely shrinks is not worth the memory
+            if(simplified.size() > source.size() * kMinLodShrink)
+            {
+                break;
+            }
+
+            std::vector<size_t> clusterStarts;
+            optimizeVertexCache(simplified, vertices.size(), clusterStarts);
+
+            lods.push_back({static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(simplified.size()), previous.error + error});
+            indices.insert(indices.end(), simplified.begin(), simplified.end());
+        }
+
+        return lods;
+    }
+
+    meshOptimizerStats optimizeMesh(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+    {
+        meshOptimizerStats stats;
+        stats.triangleCount = indices.size() / 3;
+        stats.verticesBefore = vertices.size();
+        stats.acmrBefore = computeACMR(indices, vertices.size());
+
+        // Only whole triangles are reordered, stray point and line faces would be split apart
+        if(indices.size() % 3 == 0)
+        {
+            std::vector<size_t> clusterStarts;
+
+            weldVertices(vertices, indices);
+            optimizeVertexCache(indices, vertices.size(), clusterStarts);
+            optimizeOverdraw(indices, vertices, clusterStarts);
+            optimizeVertexFetch(vertices, indices);
+        }
+
+        stats.verticesAfter = vertices.size();
+        stats.acmrAfter = computeACMR(indices, vertices.size());
+
+        return stats;
+    }
+
+    std::vector<meshlet> buildMeshlets(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const meshLod& range)
+    {
+        std::vector<meshlet> meshlets;
+        if(range.indexCount < 3 || range.firstIndex + static_cast<size_t>(range.indexCount) > indices.size())
+        {
+            return meshlets;
+        }
+
+        // 1 - Consecutive triangles until one would overflow the vertex or triangle budget, meshletOf marks the vertices already counted
+        std::vector<uint32_t> meshletOf(vertices.size(), ~0u);
+        uint32_t uniqueVertices = 0;
+        uint32_t end = range.firstIndex + range.indexCount / 3 * 3;
+
+        for(uint32_t index = range.firstIndex; index < end; index += 3)
+        {
+            uint32_t newVertices = 0;
+            for(uint32_t corner = 0; corner < 3; corner++)
+            {
+                newVertices += meshletOf[indices[index + corner]] != meshlets.size() - 1 ? 1 : 0;
+            }
+
+            if(meshlets.empty() || uniqueVertices + newVertices > kMeshletMaxVertices || meshlets.back().triangleCount == kMeshletMaxTriangles)
+            {
+                meshlet cluster;
+                cluster.firstIndex = index;
+                meshlets.push_back(cluster);
+                uniqueVertices = 0;
+            }
+
+            for(uint32_t corner = 0; corner < 3; corner++)
+            {
+                uint32_t& owner = meshletOf[indices[index + corner]];
+                if(owner != meshlets.size() - 1)
+                {
+                    owner = static_cast<uint32_t>(meshlets.size() - 1);
+                    uniqueVertices++;
+                }
+            }
+            meshlets.back().triangleCount++;
+        }
+
+        // 2 - Bounding sphere around the AABB and normal cone of every meshlet
+        for(meshlet& cluster : meshlets)
+        {
+            uint32_t clusterEnd = cluster.firstIndex + cluster.triangleCount * 3;
+
+            glm::vec3 minimum = vertices[indices[cluster.firstIndex]].Position;
+            glm::vec3 maximum = minimum;
+            for(uint32_t index = cluster.firstIndex; index < clusterEnd; index++)
+            {
+                minimum = glm::min(minimum, vertices[indices[index]].Position);
+                maximum = glm::max(maximum, vertices[indices[index]].Position);
+            }
+
+            glm::vec3 center = (minimum + maximum) * 0.5f;
+            float radius = 0.0f;
+            for(uint32_t index = cluster.firstIndex; index < clusterEnd; index++)
+            {
+                radius = std::max(radius, glm::length(vertices[indices[index]].Position - center));
+            }
+
+            // Degenerate triangles are never rasterized and have no say in the cone
+            std::vector<glm::vec3> normals;
+            normals.reserve(cluster.triangleCount);
+            glm::vec3 axis = glm::vec3(0.0f);
+            for(uint32_t index = cluster.firstIndex; index < clusterEnd; index += 3)
+            {
+                const glm::vec3& a = vertices[indices[index]].Position;
+                glm::vec3 normal = glm::cross(vertices[indices[index + 1]].Position - a, vertices[indices[index + 2]].Position - a);
+                float length = glm::length(normal);
+                if(length > 0.0f)
+                {
+                    normals.push_back(normal / length);
+                    axis += normals.back();
+                }
+            }
+
+            float axisLength = glm::length(axis);
+            float minimumDot = axisLength > 0.0f ? 1.0f : -1.0f;
+            axis = axisLength > 0.0f ? axis / axisLength : glm::vec3(0.0f, 0.0f, 1.0f);
+            for(const glm::vec3& normal : normals)
+            {
+                minimumDot = std::min(minimumDot, glm::dot(normal, axis));
+            }
+
+            for(int i = 0; i < 3; i++)
+            {
+                cluster.center[i] = center[i];
+                cluster.coneAxis[i] = axis[i];
+            }
+            cluster.radius = radius;
+            // A cone of half a sphere or wider faces the camera from everywhere
+            cluster.coneCutoff = minimumDot > 0.0f ? std::sqrt(1.0f - minimumDot * minimumDot) : 1.0f;
+        }
+
+        return meshlets;
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "rendering/resources/model.hpp"
+
+// Import time reordering of triangle lists for the post-transform vertex cache, overdraw and vertex fetch, level of detail generation and meshlets
+
+struct meshOptimizerStats
+{
+    size_t triangleCount = 0;
+    size_t verticesBefore = 0;
+    size_t verticesAfter = 0;
+    float acmrBefore = 0.0f;        // average cache miss ratio, transformed vertices per triangle
+    float acmrAfter = 0.0f;
+};
+
+namespace meshOptimizer
+{
+    // FIFO cache size the reordering targets and the statistics simulate
+    const uint32_t kCacheSize = 16;
+
+    // Every level of detail aims for this fraction of the triangles of the one before
+    const float kLodReduction = 0.5f;
+    // A level is dropped when it keeps more than this fraction of the triangles of the one before
+    const float kMinLodShrink = 0.8f;
+    // Meshes this small are not simplified any further
+    const size_t kMinLodTriangles = 64;
+
+    // Meshlet budget, the culling shader copies the triangles of a meshlet with one 128 thread workgroup
+    const uint32_t kMeshletMaxVertices = 64;
+    const uint32_t kMeshletMaxTriangles = 124;
+
+    // Vertices transformed per triangle with a FIFO cache of cacheSize entries, 3 is the worst case
+    float computeACMR(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize = kCacheSize);
+
+    // Merges bitwise identical vertices, triangulated imports otherwise carry three vertices per triangle
+    void weldVertices(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+    // Tipsify (Sander, Nehab and Barczak 2007), clusterStarts receives the first triangle of every run that began at a dead end
+    void optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount, std::vector<size_t>& clusterStarts, uint32_t cacheSize = kCacheSize);
+
+    // Orders the clusters of optimizeVertexCache outside in, so outward facing triangles are drawn first and hide the ones behind them
+    void optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, const std::vector<size_t>& clusterStarts);
+
+    // Renumbers vertices in first use order and drops the unreferenced ones
+    void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+    // All of the above in order
+    meshOptimizerStats optimizeMesh(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+    // Quadric error metric edge collapse (Garland and Heckbert 1997) down to targetIndexCount or until a collapse would exceed targetError
+    // Vertices only move onto their neighbours, borders and attribute seams stay in place, resultError is the largest collapse distance in model units
+    std::vector<uint32_t> simplifyMesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, size_t targetIndexCount, float targetError, float& resultError);
+
+    // Appends up to kMaxLodCount - 1 simplified index lists after the full one, they all index the same vertices
+    std::vector<meshLod> generateLods(const std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+    // Splits a range of the index buffer into meshlets of consecutive triangles, so every meshlet stays a range of the index buffer
+    // The vertex cache order keeps neighbouring triangles together, which keeps the bounds tight
+    std::vector<meshlet> buildMeshlets(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const meshLod& range);
+}
@@ -1,11 +1,202 @@
 #include "util/modelImporter.hpp"
 #include "rendering/modelLibrary.hpp"
 #include "rendering/rendering.hpp"
+#include "core/settings.hpp"
 #include "util/imageData.hpp"
+#include "util/hash.hpp"
+#include "util/meshCache.hpp"
+#include "util/meshOptimizer.hpp"
+#include "util/vertexConversion.hpp"
+
+// First-party includes
+#include "helpers/RootDir.hpp"
 
 // Assimp includes
 #include <assimp/postprocess.h>
 
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <future>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+
+namespace
+{
+    // Decoded textures are uploaded this many at a time, one submission per batch
+    const size_t kTextureUploadBatchSize = 8;
+
+    // Assimp streams are handed to vertexConversion as packed floats
+    static_assert(sizeof(aiVector3D) == 3 * sizeof(float), "Assimp must be built with single precision");
+
+    // Material textures the meshes sample, and the textureIndices entry each one fills
+    const std::array<std::pair<aiTextureType, E_TextureType>, 4> kMaterialTextureTypes = {{
+        {aiTextureType_DIFFUSE, E_TextureType::DIFFUSE},
+        {aiTextureType_SPECULAR, E_TextureType::SPECULAR},
+        {aiTextureType_NORMALS, E_TextureType::NORMAL},
+        {aiTextureType_UNKNOWN, E_TextureType::HEIGHT}
+    }};
+
+    std::string getMaterialTextureKey(aiTextureType type, const std::string& path)
+    {
+        return std::to_string(static_cast<int>(type)) + ":" + path;
+    }
+
+    // Embedded textures are keyed by their bytes, files by their canonical path
+    // The role is part of the key, slots are allocated per texture type and a diffuse map is sampled as sRGB where a normal map is not
+    uint64_t getSharedTextureKey(const uint8_t* embedded, size_t embeddedSize, const std::string& filePath, E_TextureType type)
+    {
+        uint64_t seed = static_cast<uint64_t>(type);
+
+        if(embedded)
+        {
+            return hash::xxHash64(embedded, embeddedSize, seed);
+        }
+
+        std::error_code error;
+        std::filesystem::path canonical = std::filesystem::weakly_canonical(filePath, error);
+        return hash::xxHash64(error ? filePath : canonical.string(), seed);
+    }
+
+    // Sphere around the vertex AABB, loose but cheap
+    void computeBounds(const std::vector<Vertex>& vertices, glm::vec3& center, float& radius)
+    {
+        if(vertices.empty())
+        {
+            return;
+        }
+
+        glm::vec3 minimum = vertices.front().Position;
+        glm::vec3 maximum = minimum;
+        for(const Vertex& vertex : vertices)
+        {
+            minimum = glm::min(minimum, vertex.Position);
+            maximum = glm::max(maximum, vertex.Position);
+        }
+
+        center = (minimum + maximum) * 0.5f;
+        radius = glm::length(maximum - minimum) * 0.5f;
+    }
+
+    // One cache file per source path and optimization setting, so both variants of a model can stay cached
+    std::string getMeshCachePath(const std::string& absolutePath, bool optimizeMeshes)
+    {
+        std::string name = absolutePath.substr(absolutePath.find_last_of("/\\") + 1);
+        name = name.substr(0, name.find_last_of('.'));
+
+        std::ostringstream path;
+        path << ROOT_DIR << "/cache/meshes/" << name << "_" << std::hex << std::setw(16) << std::setfill('0') << hash::xxHash64(absolutePath) << (optimizeMeshes ? "_opt" : "_raw") << ".mmsh";
+        return path.str();
+    }
+
+    // Size and modification time rather than a content hash, hashing would read the whole file the cache is there to skip
+    // Buffers and images a .gltf references are not part of the key, touching the .gltf refreshes its cache
+    // Optimized and unoptimized imports of the same file have different keys
+    uint64_t getMeshSourceKey(const std::string& absolutePath, bool optimizeMeshes)
+    {
+        std::error_code error;
+        uint64_t values[3];
+        values[0] = static_cast<uint64_t>(std::filesystem::file_size(absolutePath, error));
+        if(error)
+        {
+            return 0;
+        }
+        values[1] = static_cast<uint64_t>(std::filesystem::last_write_time(absolutePath, error).time_since_epoch().count());
+        if(error)
+        {
+            return 0;
+        }
+        values[2] = optimizeMeshes ? 1 : 0;
+        return hash::xxHash64(values, sizeof(values));
+    }
+
+    // Totals over every mesh of a model, ACMR weighted by triangle count
+    meshOptimizationReport summarizeOptimization(const std::vector<meshOptimizerStats>& stats)
+    {
+        meshOptimizationReport report;
+
+        for(const meshOptimizerStats& mesh : stats)
+        {
+            report.triangleCount += mesh.triangleCount;
+            report.verticesBefore += mesh.verticesBefore;
+            report.verticesAfter += mesh.verticesAfter;
+            report.acmrBefore += static_cast<double>(mesh.acmrBefore) * mesh.triangleCount;
+            report.acmrAfter += static_cast<double>(mesh.acmrAfter) * mesh.triangleCount;
+        }
+
+        if(report.triangleCount > 0)
+        {
+            report.acmrBefore /= report.triangleCount;
+            report.acmrAfter /= report.triangleCount;
+        }
+
+        return report;
+    }
+}
+
+// Shared with the decode tasks, which may still be running if the import throws
+struct ModelImporter::materialTextureLoad
+{
+    struct entry
+    {
+        const uint8_t* embedded = nullptr;          // embedded textures decode from memory
+        size_t embeddedSize = 0;
+        std::string filePath;                       // external textures decode from disk
+        pendingTexture texture;
+    };
+
+    std::vector<entry> entries;
+
+    // Indices of decoded entries, in completion order
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::vector<size_t> decoded;
+
+    // Main thread only
+    size_t received = 0;
+    std::vector<pendingTexture> batch;
+
+    // Embedded textures point into the importer's scene or the cache mapping
+    std::shared_ptr<const void> source;
+};
+
+struct ModelImporter::importedModel
+{
+    std::vector<meshGeometry> geometry;             // Assimp imports own their geometry, cached ones map it
+    std::vector<cachedMesh> views;                  // geometry and texture references of every mesh, in mesh order
+    std::vector<materialTextureReference> textures;
+
+    // Vertex buffer contents when the meshes go up in the compact layout, in mesh order
+    E_VertexLayout vertexLayout = E_VertexLayout::STANDARD;
+    std::vector<std::vector<CompactVertex>> compactVertices;
+    std::vector<vertexQuantization> quantization;
+
+    // Whatever the views and embedded textures point into
+    std::shared_ptr<Assimp::Importer> importer;
+    meshCacheFile cache;
+
+    // Empty unless the meshes were optimized by this import, cache hits were optimized on an earlier run
+    meshOptimizationReport optimization;
+};
+
+struct ModelImporter::pendingImport
+{
+    std::future<std::shared_ptr<importedModel>> parse;
+
+    // Set once the parse is done, the model stays alive until its copies have executed
+    std::shared_ptr<importedModel> model;
+    std::shared_ptr<std::vector<Mesh>> meshes;
+    std::shared_ptr<materialTextureLoad> textures;
+
+    meshUpload upload;
+    bool keepGeometry = false;
+};
+
 ////////////////// Importing from a model file //////////////////
 
 ModelImporter::ModelImporter(model_mesh_library* core) :
@@ -14,211 +205,940 @@ ModelImporter::ModelImporter(model_mesh_library* core) :
     ;
 }
 
-Model ModelImporter::importFromFile(const std::string& absolutePath)
+Model ModelImporter::importFromFile(const std::string& absolutePath, bool optimizeMeshes, bool keepGeometry)
 {
-    // If the model is not loaded, load it
-    const aiScene* scene = importer.ReadFile(absolutePath, aiProcess_Triangulate | aiProcess_FlipUVs);
+    std::shared_ptr<importedModel> model = parseFile(absolutePath, optimizeMeshes, getVertexLayout());
 
-    if(!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+    // Texture ids are known before any mesh is uploaded, decoding overlaps with the mesh uploads
+    std::shared_ptr<materialTextureLoad> textures;
+    std::shared_ptr<std::vector<Mesh>> meshes;
+    meshUpload upload;
+    try
     {
-        std::runtime_error("ERROR::ASSIMP::" + std::string(importer.GetErrorString()));
+        textures = reserveMaterialTextures(model->textures, absolutePath);
+        textures->source = model;
+        decodeMaterialTextures(textures);
+
+        meshes = createMeshes(*model, absolutePath, keepGeometry);
+
+        upload = submitMeshUploads(*model, *meshes);
+    }
+    catch(...)
+    {
+        abandonMaterialTextures(absolutePath, textures);
+        throw;
     }
+    vkWaitForFences(_meshLibrary->_core->getLogicalDevice(), 1, &upload.fence, VK_TRUE, UINT64_MAX);
+    freeMeshUpload(upload);
+    releaseGeometry(*model);
+
+    _meshLibrary->_meshes[absolutePath] = meshes;
+    _optimizedImports[absolutePath] = optimizeMeshes;
+    publishOptimization(absolutePath, *model);
 
-    // Load the model
-    processNode(scene, scene->mRootNode, absolutePath);
+    uploadMaterialTextures(textures);
 
     return Model{0, absolutePath, _meshLibrary->getMeshes(absolutePath)};
 }
 
-void ModelImporter::processNode(const aiScene* scene, aiNode* node, const std::string& absolutePath)
+std::shared_ptr<ModelImporter::importedModel> ModelImporter::parseFile(const std::string& absolutePath, bool optimizeMeshes, E_VertexLayout vertexLayout) const
 {
-    // All existing meshes
-    auto& allMeshes = _meshLibrary->_meshes;
+    auto model = std::make_shared<importedModel>();
+    model->vertexLayout = vertexLayout;
+
+    // Models imported on an earlier run come straight from their mesh cache, optimized if they were optimized then
+    uint64_t sourceKey = getMeshSourceKey(absolutePath, optimizeMeshes);
+    std::string cachePath = getMeshCachePath(absolutePath, optimizeMeshes);
 
-    for (unsigned int i = 0; i < node->mNumMeshes; i++)
+    if(sourceKey != 0 && meshCache::load(cachePath, sourceKey, model->cache))
     {
-        aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
+        model->views = model->cache.meshes;
+        model->textures = model->cache.textures;
+        packVertices(*model);
+        return model;
+    }
+
+    // One importer per parse, parses of different models run side by side
+    model->importer = std::make_shared<Assimp::Importer>();
+    const aiScene* scene = model->importer->ReadFile(absolutePath, aiProcess_Triangulate | aiProcess_FlipUVs);
+
+    if(!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+    {
+        throw std::runtime_error("ERROR::ASSIMP::" + std::string(model->importer->GetErrorString()));
+    }
 
-        Mesh importedMesh = processMesh(mesh, scene, absolutePath);
+    std::unordered_map<std::string, uint32_t> referenceKeys;
+    model->textures = collectMaterialTextures(scene, referenceKeys);
 
-        if(allMeshes.find(absolutePath) == allMeshes.end())
+    // Load the model, every mesh converts on its own and lands in its traversal slot
+    std::vector<const aiMesh*> assimpMeshes = collectMeshes(scene);
+    model->geometry.resize(assimpMeshes.size());
+    model->views.resize(assimpMeshes.size());
+    std::vector<meshOptimizerStats> stats(assimpMeshes.size());
+
+    _meshLibrary->_core->getThreadPool().parallelFor(assimpMeshes.size(), [&](size_t i)
+    {
+        meshGeometry& geometry = model->geometry[i] = processMesh(assimpMeshes[i], scene);
+        cachedMesh& view = model->views[i];
+
+        computeBounds(geometry.vertices, view.boundsCenter, view.boundsRadius);
+
+        if(optimizeMeshes)
         {
-            allMeshes[absolutePath] = std::make_shared<std::vector<Mesh>>();
+            stats[i] = meshOptimizer::optimizeMesh(geometry.vertices, geometry.indices);
         }
 
-        allMeshes[absolutePath]->push_back(importedMesh);
+        // Unwelded meshes have every vertex on a seam and keep a single level
+        view.lods = meshOptimizer::generateLods(geometry.vertices, geometry.indices);
+        geometry.meshlets = meshOptimizer::buildMeshlets(geometry.vertices, geometry.indices, view.lods.front());
+
+        view.vertices = geometry.vertices.data();
+        view.vertexCount = static_cast<uint32_t>(geometry.vertices.size());
+        view.indices = geometry.indices.data();
+        view.indexCount = static_cast<uint32_t>(geometry.indices.size());
+        view.meshlets = geometry.meshlets.data();
+        view.meshletCount = static_cast<uint32_t>(geometry.meshlets.size());
+        view.textures = getTextureData(scene, assimpMeshes[i], referenceKeys);
+    });
+
+    // Published on the main thread once the import finishes, see getOptimizationReports
+    if(optimizeMeshes)
+    {
+        model->optimization = summarizeOptimization(stats);
     }
 
-    // we then recursively process each of the children nodes
-    for (unsigned int i = 0; i < node->mNumChildren; i++)
+    if(sourceKey != 0)
     {
-        processNode(scene, node->mChildren[i], absolutePath);
+        storeMeshCache(cachePath, sourceKey, *model);
     }
+
+    // The cache keeps full precision vertices, the layout is applied after it is written
+    packVertices(*model);
+
+    return model;
 }
 
-Mesh ModelImporter::processMesh(const aiMesh* assimpMesh, const aiScene* scene, const std::string& absolutePath)
+void ModelImporter::packVertices(importedModel& model) const
 {
-    Mesh importedMesh;
+    if(model.vertexLayout != E_VertexLayout::COMPACT)
+    {
+        return;
+    }
 
-    importedMesh.vertexData = getVertexData(assimpMesh, scene);
-    importedMesh.vertexBuffer = _meshLibrary->_core->getMemorySystem().createVertexBuffer(importedMesh.vertexData);
-    importedMesh.indexData = getIndexData(assimpMesh);
-    importedMesh.indexBuffer = _meshLibrary->_core->getMemorySystem().createIndexBuffer(importedMesh.indexData);
-    importedMesh.textureIndices = getTextureData(scene, assimpMesh);
-
-    importedMesh.path = absolutePath;
-    
-    return importedMesh;
-}
-
-std::vector<Vertex> ModelImporter::getVertexData(const aiMesh* mesh, const aiScene* scene) {
-    std::vector<Vertex> vertices;
-    // VertexData
-    for (unsigned int i = 0; i < mesh->mNumVertices; i++)
-    {
-        Vertex vertex;
-        glm::vec3 vector; // we declare a placeholder vector since assimp uses its own vector class that doesn't directly convert to glm's vec3 class so we transfer the data to this placeholder glm::vec3 first.
-        
-        // Positions
-        vector.x = mesh->mVertices[i].x;
-        vector.y = mesh->mVertices[i].y;
-        vector.z = mesh->mVertices[i].z;
-        vertex.Position = vector;
-        
-        // Normals
-        vector.x = mesh->mNormals[i].x;
-        vector.y = mesh->mNormals[i].y;
-        vector.z = mesh->mNormals[i].z;
-        vertex.Normal = vector;
-        
-        // texture coordinates
-        if (mesh->mTextureCoords[0]) // does the mesh contain texture coordinates?
-        {
-            glm::vec2 vec;
-            // a vertex can contain up to 8 different texture coordinates. We thus make the assumption that we won't
-            // use models where a vertex can have multiple texture coordinates so we always take the first set (0).
-            vec.x = mesh->mTextureCoords[0][i].x;
-            vec.y = mesh->mTextureCoords[0][i].y;
-            vertex.TexCoords = vec;
-        }
-        else
-        {
-            vertex.TexCoords = glm::vec2(0.0f, 0.0f);
-        }
-        
-        // Colors
-        aiColor4D diffuse;
-        aiMaterial* mtl = scene->mMaterials[mesh->mMaterialIndex];
+    model.compactVertices.resize(model.views.size());
+    model.quantization.resize(model.views.size());
 
-        if(AI_SUCCESS == aiGetMaterialColor(mtl, AI_MATKEY_COLOR_DIFFUSE, &diffuse))
+    _meshLibrary->_core->getThreadPool().parallelFor(model.views.size(), [&](size_t i)
+    {
+        model.quantization[i] = vertexLayout::compactVertices(model.views[i].vertices, model.views[i].vertexCount, model.compactVertices[i]);
+    });
+}
+
+E_VertexLayout ModelImporter::getVertexLayout() const
+{
+    return getSettingsData(_meshLibrary->_core->getRegistry()).compactVertices ? E_VertexLayout::COMPACT : E_VertexLayout::STANDARD;
+}
+
+std::vector<const aiMesh*> ModelImporter::collectMeshes(const aiScene* scene) const
+{
+    std::vector<const aiMesh*> meshes;
+    std::vector<const aiNode*> nodes = {scene->mRootNode};
+
+    while(!nodes.empty())
+    {
+        const aiNode* node = nodes.back();
+        nodes.pop_back();
+
+        for (unsigned int i = 0; i < node->mNumMeshes; i++)
         {
-            vector.x = diffuse.r;
-            vector.y = diffuse.g;
-            vector.z = diffuse.b;
+            meshes.push_back(scene->mMeshes[node->mMeshes[i]]);
         }
-        else
+
+        // Children go on the stack last to first so they come off in order
+        for (unsigned int i = node->mNumChildren; i > 0; i--)
         {
-            vector.x = 1.0f;
-            vector.y = 1.0f;
-            vector.z = 1.0f;
+            nodes.push_back(node->mChildren[i - 1]);
         }
-        vertex.Color = vector;
+    }
+
+    return meshes;
+}
+
+meshGeometry ModelImporter::processMesh(const aiMesh* assimpMesh, const aiScene* scene) const
+{
+    meshGeometry geometry;
+
+    geometry.vertices = getVertexData(assimpMesh, scene);
+    geometry.indices = getIndexData(assimpMesh);
+
+    return geometry;
+}
+
+std::shared_ptr<std::vector<Mesh>> ModelImporter::createMeshes(importedModel& model, const std::string& absolutePath, bool keepGeometry) const
+{
+    auto meshes = std::make_shared<std::vector<Mesh>>();
+    meshes->reserve(model.views.size());
+
+    for(size_t i = 0; i < model.views.size(); i++)
+    {
+        const cachedMesh& view = model.views[i];
+
+        Mesh mesh;
+        mesh.vertexCount = view.vertexCount;
+        mesh.indexCount = view.indexCount;
+        mesh.boundsCenter = view.boundsCenter;
+        mesh.boundsRadius = view.boundsRadius;
+        mesh.lods = view.lods;
+        mesh.meshletCount = view.meshletCount;
+        mesh.textureIndices = getTextureIndices(view.textures);
+        mesh.path = absolutePath;
 
-        // Tangents
-        if(mesh->HasTangentsAndBitangents())
+        if(keepGeometry)
         {
-            vector.x = mesh->mTangents[i].x;
-            vector.y = mesh->mTangents[i].y;
-            vector.z = mesh->mTangents[i].z;
-            vertex.Tangent = vector;
+            mesh.geometry = takeGeometry(model, i);
         }
-        else
+
+        mesh.vertexLayout = model.vertexLayout;
+        if(i < model.quantization.size())
         {
-            vertex.Tangent = glm::vec3(0.0f, 0.0f, 0.0f);
+            mesh.quantization = model.quantization[i];
         }
 
-        vertices.push_back(vertex);
+        meshes->push_back(std::move(mesh));
+    }
+
+    return meshes;
+}
+
+std::shared_ptr<meshGeometry> ModelImporter::takeGeometry(importedModel& model, size_t i) const
+{
+    const cachedMesh& view = model.views[i];
+    auto geometry = std::make_shared<meshGeometry>();
+
+    // Assimp geometry is moved, which keeps the storage the view points at, cached geometry is copied out of the mapping
+    if(i < model.geometry.size())
+    {
+        *geometry = std::move(model.geometry[i]);
     }
+    else
+    {
+        geometry->vertices.assign(view.vertices, view.vertices + view.vertexCount);
+        geometry->indices.assign(view.indices, view.indices + view.indexCount);
+        geometry->meshlets.assign(view.meshlets, view.meshlets + view.meshletCount);
+    }
+
+    return geometry;
+}
+
+std::vector<Vertex> ModelImporter::getVertexData(const aiMesh* mesh, const aiScene* scene) const
+{
+    const size_t count = mesh->mNumVertices;
+    std::vector<Vertex> vertices(count);
+
+    // The diffuse colour is a material property, looked up once per mesh
+    glm::vec3 color = glm::vec3(1.0f, 1.0f, 1.0f);
+    aiColor4D diffuse;
+    if(AI_SUCCESS == aiGetMaterialColor(scene->mMaterials[mesh->mMaterialIndex], AI_MATKEY_COLOR_DIFFUSE, &diffuse))
+    {
+        color = glm::vec3(diffuse.r, diffuse.g, diffuse.b);
+    }
+
+    // Missing streams read as zero. Only the first set of texture coordinates is used
+    vertexConversion::sourceStreams streams;
+    streams.positions = mesh->mVertices ? &mesh->mVertices[0].x : nullptr;
+    streams.normals = mesh->mNormals ? &mesh->mNormals[0].x : nullptr;
+    streams.texCoords = mesh->mTextureCoords[0] ? &mesh->mTextureCoords[0][0].x : nullptr;
+    streams.tangents = mesh->HasTangentsAndBitangents() ? &mesh->mTangents[0].x : nullptr;
+
+    vertexConversion::convert(streams, color, vertices.data(), count);
+
     return vertices;
 }
 
-std::vector<unsigned int> ModelImporter::getIndexData(const aiMesh* mesh)
+std::vector<unsigned int> ModelImporter::getIndexData(const aiMesh* mesh) const
 {
     std::vector<unsigned int> indices;
+    indices.reserve(static_cast<size_t>(mesh->mNumFaces) * 3);     // triangulated on import
 
     for (unsigned int i = 0; i < mesh->mNumFaces; i++)
     {
-        aiFace face = mesh->mFaces[i];
-        // retrieve all indices of the face and store them in the indices vector
-        for (unsigned int j = 0; j < face.mNumIndices; j++)
-            indices.push_back(face.mIndices[j]);
+        const aiFace& face = mesh->mFaces[i];
+        indices.insert(indices.end(), face.mIndices, face.mIndices + face.mNumIndices);
     }
 
     return indices;
 }
   
-std::array<unsigned int, static_cast<size_t>(E_TextureType::SIZE)> ModelImporter::getTextureData(const aiScene* scene, const aiMesh* mesh)
+meshTextureReferences ModelImporter::getTextureData(const aiScene* scene, const aiMesh* mesh, const std::unordered_map<std::string, uint32_t>& referenceKeys) const
 {
-    // Fill the initial answer with zeros as that is the index of the placeholder texture
-    std::array<unsigned int, static_cast<size_t>(E_TextureType::SIZE)> textureIndices = {0}; 
+    // Types without a texture sample the placeholder
+    meshTextureReferences references;
+    references.fill(meshCache::kNoTexture);
 
     if(mesh->mMaterialIndex >= 0)
     {
         aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
 
-        textureIndices[static_cast<size_t>(E_TextureType::DIFFUSE)] = loadMaterialTextures(scene, material, aiTextureType_DIFFUSE);
+        for(const auto& [assimpType, type] : kMaterialTextureTypes)
+        {
+            // Same as collectMaterialTextures, only the first texture of each type is used
+            if(material->GetTextureCount(assimpType) == 0)
+            {
+                continue;
+            }
+
+            aiString str;
+            material->GetTexture(assimpType, 0, &str);
+
+            auto it = referenceKeys.find(getMaterialTextureKey(assimpType, str.C_Str()));
+            if(it != referenceKeys.end())
+            {
+                references[static_cast<size_t>(type)] = it->second;
+            }
+        }
+    }
 
-        textureIndices[static_cast<size_t>(E_TextureType::SPECULAR)] = loadMaterialTextures(scene, material, aiTextureType_SPECULAR);
+    return references;
+}
 
-        textureIndices[static_cast<size_t>(E_TextureType::NORMAL)] = loadMaterialTextures(scene, material, aiTextureType_NORMALS);
+std::array<unsigned int, static_cast<size_t>(E_TextureType::SIZE)> ModelImporter::getTextureIndices(const meshTextureReferences& references) const
+{
+    // Fill the initial answer with zeros as that is the index of the placeholder texture
+    std::array<unsigned int, static_cast<size_t>(E_TextureType::SIZE)> textureIndices = {0};
 
-        textureIndices[static_cast<size_t>(E_TextureType::HEIGHT)] = loadMaterialTextures(scene, material, aiTextureType_UNKNOWN);        
+    for(size_t type = 0; type < references.size(); type++)
+    {
+        if(references[type] != meshCache::kNoTexture)
+        {
+            textureIndices[type] = _materialTextureIds[references[type]];
+        }
     }
 
     return textureIndices;
 }
 
-unsigned int ModelImporter::loadMaterialTextures(const aiScene* scene, aiMaterial* mat, aiTextureType type)
-{        
-    for (unsigned int i = 0; i < mat->GetTextureCount(type); i++)
+std::vector<materialTextureReference> ModelImporter::collectMaterialTextures(const aiScene* scene, std::unordered_map<std::string, uint32_t>& referenceKeys) const
+{
+    std::vector<materialTextureReference> references;
+    referenceKeys.clear();
+
+    for(unsigned int m = 0; m < scene->mNumMaterials; m++)
     {
-        aiString str;
-        mat->GetTexture(type, i, &str);
+        aiMaterial* material = scene->mMaterials[m];
 
-        std::string texturePath = str.C_Str();
+        for(const auto& [assimpType, type] : kMaterialTextureTypes)
+        {
+            if(material->GetTextureCount(assimpType) == 0)
+            {
+                continue;
+            }
+
+            aiString str;
+            material->GetTexture(assimpType, 0, &str);
+            std::string texturePath = str.C_Str();
+
+            std::string key = getMaterialTextureKey(assimpType, texturePath);
+            if(texturePath.empty() || referenceKeys.count(key))
+            {
+                continue;
+            }
+
+            materialTextureReference reference;
+            reference.type = type;
+            reference.path = texturePath;
+
+            // Compressed embedded textures store their byte count in mWidth
+            if(const aiTexture* embedded = scene->GetEmbeddedTexture(str.C_Str()))
+            {
+                reference.embedded = reinterpret_cast<const uint8_t*>(embedded->pcData);
+                reference.embeddedSize = embedded->mHeight == 0 ? embedded->mWidth : static_cast<size_t>(embedded->mWidth) * embedded->mHeight * sizeof(aiTexel);
+            }
+
+            referenceKeys[key] = static_cast<uint32_t>(references.size());
+            references.push_back(reference);
+        }
+    }
+
+    return references;
+}
+
+std::shared_ptr<ModelImporter::materialTextureLoad> ModelImporter::reserveMaterialTextures(const std::vector<materialTextureReference>& references, const std::string& absolutePath)
+{
+    auto load = std::make_shared<materialTextureLoad>();
+    texture_system& textures = _meshLibrary->_core->getTextureSystem();
 
-        // Check if the texture has already been loaded
-        if(texturePath.empty())
+    _materialTextureIds.assign(references.size(), 0);
+
+    std::string directory = absolutePath.substr(0, absolutePath.find_last_of("/\\") + 1);
+
+    for(size_t i = 0; i < references.size(); i++)
+    {
+        materialTextureLoad::entry entry;
+        entry.embedded = references[i].embedded;
+        entry.embeddedSize = references[i].embeddedSize;
+        entry.filePath = directory + references[i].path;
+        entry.texture.type = references[i].type;
+
+        // Virtual textures are paged in by their own system, the mesh samples them through a flagged index
+        if(!entry.embedded && vtex::isVirtualTextureFile(entry.filePath))
         {
-            return 0;
+            _materialTextureIds[i] = textures.getVirtualTextures().createVirtualTexture(entry.filePath);
+            continue;
+        }
+
+        // Textures already loaded by this or another model are shared
+        uint64_t sharedKey = getSharedTextureKey(entry.embedded, entry.embeddedSize, entry.filePath, entry.texture.type);
+        uint32_t id;
+        if(!textures.acquireTexture(sharedKey, id))
+        {
+            // Offline compressed textures carry their mip chain, they are streamed instead of decoded
+            if(!entry.embedded && ktx2::isKTX2File(entry.filePath))
+            {
+                id = textures.getStreamer().streamTexture(ktx2::load(entry.filePath), entry.texture.type);
+            }
+            else
+            {
+                id = textures.reserveTexture(entry.texture.type);
+                entry.texture.id = id;
+                load->entries.push_back(entry);
+                _textureDecodes[id] = load;
+            }
+            textures.registerTexture(sharedKey, id);
+        }
+
+        _materialTextureIds[i] = id;
+        _meshLibrary->_modelTextures[absolutePath].push_back(id);
+    }
+
+    return load;
+}
+
+void ModelImporter::releaseMaterialTextures(const std::string& absolutePath)
+{
+    auto held = _meshLibrary->_modelTextures.find(absolutePath);
+    if(held == _meshLibrary->_modelTextures.end())
+    {
+        return;
+    }
+
+    texture_system& textures = _meshLibrary->_core->getTextureSystem();
+
+    // Textures shared with other models survive until their last user is gone
+    for(uint32_t id : held->second)
+    {
+        textures.releaseTexture(id);
+
+        // A freed slot can be handed out again, a decode still on its way must not land in it
+        if(!textures.isTextureHeld(id))
+        {
+            _textureDecodes.erase(id);
+        }
+    }
+    _meshLibrary->_modelTextures.erase(held);
+}
+
+void ModelImporter::abandonMaterialTextures(const std::string& absolutePath, std::shared_ptr<materialTextureLoad> load)
+{
+    releaseMaterialTextures(absolutePath);
+
+    // A slot this load reserved may have been acquired by another model since, which has no decode of its own
+    // The load keeps going, uploadDecodedMaterialTextures skips the slots nobody holds anymore and frees their images
+    if(load)
+    {
+        _textureLoads.push_back(load);
+    }
+}
+
+void ModelImporter::forgetModel(const std::string& absolutePath)
+{
+    releaseMaterialTextures(absolutePath);
+    _optimizationReports.erase(absolutePath);
+    _optimizedImports.erase(absolutePath);
+}
+
+void ModelImporter::decodeMaterialTextures(std::shared_ptr<materialTextureLoad> load)
+{
+    thread_pool& pool = _meshLibrary->_core->getThreadPool();
+
+    for(size_t i = 0; i < load->entries.size(); i++)
+    {
+        pool.submit([load, i]()
+        {
+            materialTextureLoad::entry& entry = load->entries[i];
+
+            entry.texture.imgData = entry.embedded ? STB_load_image(entry.embedded, entry.embeddedSize) : STB_load_image(entry.filePath);
+
+            {
+                std::lock_guard<std::mutex> lock(load->mutex);
+                load->decoded.push_back(i);
+            }
+            load->condition.notify_one();
+        });
+    }
+}
+
+void ModelImporter::uploadMaterialTextures(std::shared_ptr<materialTextureLoad> load)
+{
+    while(!uploadDecodedMaterialTextures(load))
+    {
+        std::unique_lock<std::mutex> lock(load->mutex);
+        load->condition.wait(lock, [&load]() { return !load->decoded.empty(); });
+    }
+}
+
+bool ModelImporter::uploadDecodedMaterialTextures(std::shared_ptr<materialTextureLoad> load)
+{
+    texture_system& textures = _meshLibrary->_core->getTextureSystem();
+
+    std::vector<size_t> decoded;
+    {
+        std::lock_guard<std::mutex> lock(load->mutex);
+        decoded.swap(load->decoded);
+    }
+    load->received += decoded.size();
+
+    for(size_t i : decoded)
+    {
+        pendingTexture& texture = load->entries[i].texture;
+
+        // Undecodable textures keep sampling the missing texture
+        if(texture.imgData.data == nullptr)
+        {
+            std::cerr << "Failed to decode texture: " << load->entries[i].filePath << std::endl;
+            auto owner = _textureDecodes.find(texture.id);
+            if(owner != _textureDecodes.end() && owner->second == load)
+            {
+                _textureDecodes.erase(owner);
+            }
+            continue;
         }
-        
-        // Get the aiTexture
-        const aiTexture* texture = scene->GetEmbeddedTexture(str.C_Str());
+        load->batch.push_back(texture);
+    }
 
-        // Load the texture
-        loadedImageData img = ASSIMP_load_image(texture);
+    // Uploads happen on this thread, the one that owns the Vulkan queues
+    bool complete = load->received == load->entries.size();
+    if(load->batch.size() >= kTextureUploadBatchSize || (complete && !load->batch.empty()))
+    {
+        // Slots given back since the load reserved them may hold another texture by now
+        auto released = std::remove_if(load->batch.begin(), load->batch.end(), [this, &load](const pendingTexture& texture)
+        {
+            auto owner = _textureDecodes.find(texture.id);
+            if(owner != _textureDecodes.end() && owner->second == load)
+            {
+                _textureDecodes.erase(owner);
+                return false;
+            }
+            free_image(texture.imgData.data);
+            return true;
+        });
+        load->batch.erase(released, load->batch.end());
 
-        // Create the texture, and return the index
-        return _meshLibrary->_core->getTextureSystem().createTexture(img, VK_FORMAT_R8G8B8A8_SRGB, _textureTypeMap[type]).id;
+        textures.createTextures(load->batch);
+        load->batch.clear();
     }
-    return -1;
+
+    return complete;
 }
 
 
+////////////////// Importing asynchronously //////////////////
+
+void ModelImporter::beginImport(const std::string& absolutePath, bool optimizeMeshes, bool keepGeometry)
+{
+    // Later requests for the same file share the import in flight
+    if(_imports.count(absolutePath))
+    {
+        reuseImport(absolutePath, optimizeMeshes, keepGeometry);
+        return;
+    }
+
+    // Parsing, vertex conversion and the mesh cache stay off the main thread
+    // The settings are read here, the registry is not touched off the main thread
+    E_VertexLayout vertexLayout = getVertexLayout();
+
+    auto import = std::make_shared<pendingImport>();
+    import->keepGeometry = keepGeometry;
+    import->parse = _meshLibrary->_core->getThreadPool().submit([this, absolutePath, optimizeMeshes, vertexLayout]()
+    {
+        return parseFile(absolutePath, optimizeMeshes, vertexLayout);
+    });
+
+    _imports[absolutePath] = import;
+    _optimizedImports[absolutePath] = optimizeMeshes;
+}
+
+void ModelImporter::reuseImport(const std::string& absolutePath, bool optimizeMeshes, bool keepGeometry)
+{
+    // 1 - The meshes are shared by every entity of the file, they exist in one vertex and triangle order only
+    auto optimized = _optimizedImports.find(absolutePath);
+    if(optimized != _optimizedImports.end() && optimized->second != optimizeMeshes)
+    {
+        throw std::runtime_error("Model " + absolutePath + " is already loaded " + (optimized->second ? "with" : "without") +
+                                 " mesh optimization, unload it before loading it " + (optimizeMeshes ? "with" : "without"));
+    }
+
+    if(!keepGeometry)
+    {
+        return;
+    }
+
+    // 2 - Still importing, the parsed model lives until the upload has finished
+    auto pending = _imports.find(absolutePath);
+    if(pending != _imports.end())
+    {
+        pendingImport& import = *pending->second;
+        import.keepGeometry = true;
+
+        // createMeshes already ran without geometry
+        if(import.meshes)
+        {
+            for(size_t i = 0; i < import.meshes->size(); i++)
+            {
+                if(!(*import.meshes)[i].geometry)
+                {
+                    (*import.meshes)[i].geometry = takeGeometry(*import.model, i);
+                }
+            }
+        }
+        return;
+    }
+
+    // 3 - Loaded and its geometry released, it is read again, from the mesh cache when that is still valid
+    auto loaded = _meshLibrary->_meshes.find(absolutePath);
+    if(loaded == _meshLibrary->_meshes.end())
+    {
+        return;
+    }
+
+    std::vector<Mesh>& meshes = *loaded->second;
+    if(std::all_of(meshes.begin(), meshes.end(), [](const Mesh& mesh) { return mesh.geometry != nullptr; }))
+    {
+        return;
+    }
+
+    std::shared_ptr<importedModel> model = parseFile(absolutePath, optimizeMeshes, E_VertexLayout::STANDARD);
+
+    bool matches = model->views.size() == meshes.size();
+    for(size_t i = 0; matches && i < meshes.size(); i++)
+    {
+        matches = model->views[i].vertexCount == meshes[i].vertexCount && model->views[i].indexCount == meshes[i].indexCount;
+    }
+    if(!matches)
+    {
+        throw std::runtime_error("Model " + absolutePath + " changed on disk since it was loaded, its geometry can't be read again");
+    }
+
+    for(size_t i = 0; i < meshes.size(); i++)
+    {
+        if(!meshes[i].geometry)
+        {
+            meshes[i].geometry = takeGeometry(*model, i);
+        }
+    }
+}
+
+void ModelImporter::finishImport(const std::string& absolutePath)
+{
+    auto pending = _imports.find(absolutePath);
+    if(pending == _imports.end())
+    {
+        return;
+    }
+    // Kept alive past the erase below
+    std::shared_ptr<pendingImport> import = pending->second;
+
+    // 1 - Not picked up by updateImports yet, the copies are recorded here
+    if(!import->model)
+    {
+        try
+        {
+            import->model = import->parse.get();
+            beginMeshUpload(absolutePath, *import);
+        }
+        catch(...)
+        {
+            abandonMaterialTextures(absolutePath, import->textures);
+            _optimizedImports.erase(absolutePath);
+            _failedImports.push_back(absolutePath);
+            _imports.erase(pending);
+            throw;
+        }
+    }
+
+    // 2 - Same as a finished asynchronous import, its textures keep streaming in from updateImports
+    vkWaitForFences(_meshLibrary->_core->getLogicalDevice(), 1, &import->upload.fence, VK_TRUE, UINT64_MAX);
+    completeImport(absolutePath, *import);
+    _finishedImports.push_back(absolutePath);
+    _imports.erase(pending);
+}
+
+void ModelImporter::updateImports(std::vector<std::string>& finished, std::vector<std::string>& failed)
+{
+    VkDevice device = _meshLibrary->_core->getLogicalDevice();
+
+    finished.insert(finished.end(), _finishedImports.begin(), _finishedImports.end());
+    failed.insert(failed.end(), _failedImports.begin(), _failedImports.end());
+    _finishedImports.clear();
+    _failedImports.clear();
+
+    // One model starts uploading per frame, its staging copy happens on this thread
+    bool startedUpload = false;
+
+    for(auto it = _imports.begin(); it != _imports.end();)
+    {
+        const std::string& absolutePath = it->first;
+        pendingImport& import = *it->second;
+
+        // 1 - Parsed on the thread pool, record the copies
+        if(!import.model)
+        {
+            if(startedUpload || import.parse.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            {
+                ++it;
+                continue;
+            }
+
+            try
+            {
+                import.model = import.parse.get();
+            }
+            catch(const std::exception& e)
+            {
+                std::cerr << "Failed to import model " << absolutePath << ": " << e.what() << std::endl;
+                _optimizedImports.erase(absolutePath);
+                failed.push_back(absolutePath);
+                it = _imports.erase(it);
+                continue;
+            }
+
+            try
+            {
+                beginMeshUpload(absolutePath, import);
+            }
+            catch(const std::exception& e)
+            {
+                std::cerr << "Failed to import model " << absolutePath << ": " << e.what() << std::endl;
+                abandonMaterialTextures(absolutePath, import.textures);
+                _optimizedImports.erase(absolutePath);
+                failed.push_back(absolutePath);
+                it = _imports.erase(it);
+                continue;
+            }
+            startedUpload = true;
+            ++it;
+            continue;
+        }
+
+        // 2 - Copies executed, the meshes can be drawn
+        if(vkGetFenceStatus(device, import.upload.fence) != VK_SUCCESS)
+        {
+            ++it;
+            continue;
+        }
+
+        completeImport(absolutePath, import);
+        finished.push_back(absolutePath);
+
+        it = _imports.erase(it);
+    }
+
+    // 3 - Textures follow a batch at a time, until then the meshes sample the missing texture
+    for(auto it = _textureLoads.begin(); it != _textureLoads.end();)
+    {
+        if(uploadDecodedMaterialTextures(*it))
+        {
+            it = _textureLoads.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+void ModelImporter::beginMeshUpload(const std::string& absolutePath, pendingImport& import)
+{
+    importedModel& model = *import.model;
+
+    import.textures = reserveMaterialTextures(model.textures, absolutePath);
+    import.textures->source = import.model;
+    decodeMaterialTextures(import.textures);
+
+    import.meshes = createMeshes(model, absolutePath, import.keepGeometry);
+
+    import.upload = submitMeshUploads(model, *import.meshes);
+}
+
+void ModelImporter::completeImport(const std::string& absolutePath, pendingImport& import)
+{
+    freeMeshUpload(import.upload);
+    releaseGeometry(*import.model);
+
+    _meshLibrary->_meshes[absolutePath] = import.meshes;
+    publishOptimization(absolutePath, *import.model);
+    _textureLoads.push_back(import.textures);
+}
+
+ModelImporter::meshUpload ModelImporter::submitMeshUploads(const importedModel& model, std::vector<Mesh>& meshes)
+{
+    memory_system& memory = _meshLibrary->_core->getMemorySystem();
+    command_buffer_system& commands = _meshLibrary->_core->getCommandBufferSystem();
+
+    meshUpload upload;
+
+    // 1 - Every vertex, index and meshlet blob of the model goes through one staging buffer
+    const VkDeviceSize vertexStride = vertexLayout::getDescriptor(model.vertexLayout).stride;
+
+    VkDeviceSize stagingSize = 0;
+    for(const cachedMesh& view : model.views)
+    {
+        stagingSize += view.vertexCount * vertexStride + memory_system::getIndexBufferSize(view.indexCount, memory_system::getIndexType(view.vertexCount)) + view.meshletCount * sizeof(meshlet);
+    }
+
+    upload.staging = memory.createBuffer(std::max<VkDeviceSize>(stagingSize, 1), VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+    uint8_t* data;
+    vkMapMemory(_meshLibrary->_core->getLogicalDevice(), upload.staging.memory, 0, VK_WHOLE_SIZE, 0, reinterpret_cast<void**>(&data));
+
+    // 2 - The destination buffers are shared with the graphics queue, no ownership transfer is needed afterwards
+    upload.commandBuffer = commands.beginTransferCommands();
+
+    VkDeviceSize offset = 0;
+    for(size_t i = 0; i < model.views.size(); i++)
+    {
+        const cachedMesh& view = model.views[i];
+        Mesh& mesh = meshes[i];
+
+        VkDeviceSize vertexBytes = view.vertexCount * vertexStride;
+        const void* vertices = model.vertexLayout == E_VertexLayout::COMPACT ? static_cast<const void*>(model.compactVertices[i].data()) : view.vertices;
+        std::memcpy(data + offset, vertices, vertexBytes);
+        mesh.vertexBuffer = memory.createBuffer(vertexBytes, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true);
+
+        VkBufferCopy vertexCopy = {offset, 0, vertexBytes};
+        vkCmdCopyBuffer(upload.commandBuffer, upload.staging.buffer, mesh.vertexBuffer.buffer, 1, &vertexCopy);
+        offset += vertexBytes;
+
+        // The cache keeps 32 bit indices, they are narrowed on the way to the staging buffer
+        mesh.indexType = memory_system::getIndexType(view.vertexCount);
+        VkDeviceSize indexBytes = memory_system::getIndexBufferSize(view.indexCount, mesh.indexType);
+        memory_system::writeIndices(data + offset, view.indices, view.indexCount, mesh.indexType);
+        // The culling pass reads the indices of meshes with meshlets
+        mesh.indexBuffer = memory.createBuffer(indexBytes, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true);
+
+        VkBufferCopy indexCopy = {offset, 0, indexBytes};
+        vkCmdCopyBuffer(upload.commandBuffer, upload.staging.buffer, mesh.indexBuffer.buffer, 1, &indexCopy);
+        offset += indexBytes;
+
+        if(view.meshletCount > 0)
+        {
+            VkDeviceSize meshletBytes = view.meshletCount * sizeof(meshlet);
+            std::memcpy(data + offset, view.meshlets, meshletBytes);
+            mesh.meshletBuffer = memory.createBuffer(meshletBytes, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true);
+
+            VkBufferCopy meshletCopy = {offset, 0, meshletBytes};
+            vkCmdCopyBuffer(upload.commandBuffer, upload.staging.buffer, mesh.meshletBuffer.buffer, 1, &meshletCopy);
+            offset += meshletBytes;
+        }
+    }
+
+    vkUnmapMemory(_meshLibrary->_core->getLogicalDevice(), upload.staging.memory);
+
+    upload.fence = commands.submitTransferCommands(upload.commandBuffer);
+
+    return upload;
+}
+
+void ModelImporter::freeMeshUpload(meshUpload& upload)
+{
+    _meshLibrary->_core->getCommandBufferSystem().freeTransferCommands(upload.commandBuffer, upload.fence);
+    _meshLibrary->_core->getMemorySystem().freeBuffer(upload.staging);
+    upload = meshUpload();
+}
+
+void ModelImporter::publishOptimization(const std::string& absolutePath, const importedModel& model)
+{
+    if(model.optimization.triangleCount > 0)
+    {
+        _optimizationReports[absolutePath] = model.optimization;
+    }
+}
+
+void ModelImporter::releaseGeometry(importedModel& model) const
+{
+    // Embedded textures may still be decoding out of the importer or the mapping, those stay
+    model.geometry = std::vector<meshGeometry>();
+    model.compactVertices = std::vector<std::vector<CompactVertex>>();
+    model.views = std::vector<cachedMesh>();
+}
+
+void ModelImporter::cleanup()
+{
+    memory_system& memory = _meshLibrary->_core->getMemorySystem();
+
+    for(auto& [absolutePath, import] : _imports)
+    {
+        // Still parsing, the task holds a pointer to this importer
+        if(!import->model)
+        {
+            import->parse.wait();
+            continue;
+        }
+
+        freeMeshUpload(import->upload);
+
+        for(Mesh& mesh : *import->meshes)
+        {
+            memory.freeBuffer(mesh.vertexBuffer);
+            memory.freeBuffer(mesh.indexBuffer);
+            if(mesh.meshletBuffer.buffer != VK_NULL_HANDLE)
+            {
+                memory.freeBuffer(mesh.meshletBuffer);
+            }
+        }
+    }
+    _imports.clear();
+
+    // Decode tasks hold their own reference to the load
+    _textureLoads.clear();
+    _textureDecodes.clear();
+}
+
+
+////////////////// Mesh cache //////////////////
+
+void ModelImporter::storeMeshCache(const std::string& cachePath, uint64_t sourceKey, const importedModel& model) const
+{
+    // Only a cache, failing to write it just means importing through Assimp again next time
+    try
+    {
+        std::filesystem::create_directories(std::filesystem::path(cachePath).parent_path());
+        meshCache::save(cachePath, sourceKey, model.views, model.textures);
+    }
+    catch(const std::exception& e)
+    {
+        std::cerr << "Failed to store mesh cache " << cachePath << ": " << e.what() << std::endl;
+    }
+}
+
 ////////////////// Importing from vertex data //////////////////
 
-Model ModelImporter::importFromMeshData(const std::string& name, const Mesh& meshData, glm::mat4 modelMatrix)
+Model ModelImporter::importFromMeshData(const std::string& name, const meshGeometry& geometry, glm::mat4 modelMatrix, bool keepGeometry)
 {
     Mesh importedMesh;
 
-    importedMesh.vertexData = meshData.vertexData;
-    importedMesh.vertexBuffer = _meshLibrary->_core->getMemorySystem().createVertexBuffer(importedMesh.vertexData);
-    importedMesh.indexData = meshData.indexData;
-    importedMesh.indexBuffer = _meshLibrary->_core->getMemorySystem().createIndexBuffer(importedMesh.indexData);
-    importedMesh.textureIndices = meshData.textureIndices;
+    computeBounds(geometry.vertices, importedMesh.boundsCenter, importedMesh.boundsRadius);
+    importedMesh.vertexBuffer = _meshLibrary->_core->getMemorySystem().createVertexBuffer(geometry.vertices.data(), geometry.vertices.size());
+    importedMesh.vertexCount = static_cast<uint32_t>(geometry.vertices.size());
+    importedMesh.indexType = memory_system::getIndexType(geometry.vertices.size());
+    importedMesh.indexBuffer = _meshLibrary->_core->getMemorySystem().createIndexBuffer(geometry.indices.data(), geometry.indices.size(), importedMesh.indexType);
+    importedMesh.indexCount = static_cast<uint32_t>(geometry.indices.size());
     importedMesh.path = name;
 
+    if(keepGeometry)
+    {
+        importedMesh.geometry = std::make_shared<meshGeometry>(geometry);
+    }
+
     if(_meshLibrary->_meshes.find(name) == _meshLibrary->_meshes.end())
     {
         _meshLibrary->_meshes[name] = std::make_shared<std::vector<Mesh>>();
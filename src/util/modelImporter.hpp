@@ -2,6 +2,8 @@
 
 #include <vector>
 #include <unordered_map>
+#include <memory>
+#include <string>
 
 // Assimp includes
 #include <assimp/Importer.hpp>
@@ -10,38 +12,125 @@
 #include "rendering/resources/vertex.hpp"
 #include "rendering/resources/texture.hpp"
 #include "rendering/resources/model.hpp"
+#include "util/meshCache.hpp"
 
 class model_mesh_library;
 
+// Effect of the import time index and vertex reordering on one model, ACMR weighted by triangle count
+struct meshOptimizationReport
+{
+    size_t triangleCount = 0;
+    size_t verticesBefore = 0;
+    size_t verticesAfter = 0;
+    double acmrBefore = 0.0;
+    double acmrAfter = 0.0;
+};
+
 class ModelImporter{
 public:
     ModelImporter(model_mesh_library* meshLibrary);
-    Model importFromFile(const std::string& absolutePath);
-    Model importFromMeshData(const std::string& name, const Mesh& meshData,  glm::mat4 modelMatrix = glm::mat4(1.0f));
+    // optimizeMeshes reorders the triangles and vertices of every mesh for the GPU caches, see meshOptimizer.hpp
+    // keepGeometry leaves a CPU copy in Mesh::geometry, otherwise only the GPU buffers remain once uploaded
+    Model importFromFile(const std::string& absolutePath, bool optimizeMeshes = true, bool keepGeometry = false);
+    Model importFromMeshData(const std::string& name, const meshGeometry& geometry, glm::mat4 modelMatrix = glm::mat4(1.0f), bool keepGeometry = false);
+
+    // Asynchronous import, the file is parsed on the thread pool and the meshes go up through the transfer queue
+    void beginImport(const std::string& absolutePath, bool optimizeMeshes = true, bool keepGeometry = false);
+    // Once per frame on the main thread, collects the models whose meshes became drawable and the ones that failed to import
+    void updateImports(std::vector<std::string>& finished, std::vector<std::string>& failed);
+
+    bool isImporting(const std::string& absolutePath) const { return _imports.count(absolutePath) > 0; }
+    // Blocks until the asynchronous import of the file has its meshes uploaded, throws if it fails
+    // The next updateImports still reports it, so the entities waiting on it are resolved there
+    void finishImport(const std::string& absolutePath);
+
+    // Request for a file that is already loaded or importing, its meshes are shared
+    // A different optimizeMeshes throws, geometry asked for after it was released is read again (from the mesh cache when valid)
+    void reuseImport(const std::string& absolutePath, bool optimizeMeshes, bool keepGeometry);
+
+    // Models this run optimized, by path, for the performance panel
+    const std::unordered_map<std::string, meshOptimizationReport>& getOptimizationReports() const { return _optimizationReports; }
+    // Drops what is kept about an unloaded model and its texture references
+    void forgetModel(const std::string& absolutePath);
+
+    // Waits for the parses in flight and frees what unfinished imports hold, the device must be idle
+    void cleanup();
 
 private: 
+    // Everything an import needs from the file, built without touching Vulkan so it can run on a worker thread
+    struct importedModel;
+    std::shared_ptr<importedModel> parseFile(const std::string& absolutePath, bool optimizeMeshes, E_VertexLayout vertexLayout) const;
+    // Vertex buffer contents of every mesh in the model's layout, nothing to do for the standard one
+    void packVertices(importedModel& model) const;
+    // Layout the settings ask imported meshes to be uploaded in, main thread only
+    E_VertexLayout getVertexLayout() const;
+
     // Get data from the assimp struct
-    std::vector<Vertex> getVertexData(const aiMesh* mesh, const aiScene* scene);
-    std::vector<unsigned int> getIndexData(const aiMesh* mesh);
-    std::array<unsigned int, static_cast<size_t>(E_TextureType::SIZE)> getTextureData(const aiScene* scene, const aiMesh* mesh);
-
-    unsigned int loadMaterialTextures(const aiScene* scene, aiMaterial* mat, aiTextureType type);
-
-    // STB calls
-    void processNode(const aiScene* scene, aiNode* node, const std::string& absolutePath);
-    Mesh processMesh(const aiMesh* assimpMesh, const aiScene* scene, const std::string& absolutePath);
-
-    std::unordered_map<aiTextureType, E_TextureType> _textureTypeMap = {
-        {aiTextureType_DIFFUSE, E_TextureType::DIFFUSE},
-        {aiTextureType_SPECULAR, E_TextureType::SPECULAR},
-        {aiTextureType_NORMALS, E_TextureType::NORMAL},
-        {aiTextureType_HEIGHT, E_TextureType::HEIGHT},
-        {aiTextureType_LIGHTMAP, E_TextureType::LIGHTMAP},
-        {aiTextureType_SHININESS, E_TextureType::ROUGHNESS}
+    std::vector<Vertex> getVertexData(const aiMesh* mesh, const aiScene* scene) const;
+    std::vector<unsigned int> getIndexData(const aiMesh* mesh) const;
+    meshTextureReferences getTextureData(const aiScene* scene, const aiMesh* mesh, const std::unordered_map<std::string, uint32_t>& referenceKeys) const;
+
+    // Every material texture of the scene once, in the order the mesh cache stores them, referenceKeys maps texture type and path to the reference index
+    std::vector<materialTextureReference> collectMaterialTextures(const aiScene* scene, std::unordered_map<std::string, uint32_t>& referenceKeys) const;
+    // Heap slots of a mesh's texture references, the missing texture where there is none
+    std::array<unsigned int, static_cast<size_t>(E_TextureType::SIZE)> getTextureIndices(const meshTextureReferences& references) const;
+
+    // Material textures get their heap slots up front, decoding runs on the thread pool
+    struct materialTextureLoad;
+    std::shared_ptr<materialTextureLoad> reserveMaterialTextures(const std::vector<materialTextureReference>& references, const std::string& absolutePath);
+    // Gives back the texture references of a model, unloaded or whose import failed before its meshes were stored
+    void releaseMaterialTextures(const std::string& absolutePath);
+    // Failed import, its decodes still go to the slots other models acquired while they were pending
+    void abandonMaterialTextures(const std::string& absolutePath, std::shared_ptr<materialTextureLoad> load);
+    void decodeMaterialTextures(std::shared_ptr<materialTextureLoad> load);
+    // Blocks until every texture is decoded and uploaded
+    void uploadMaterialTextures(std::shared_ptr<materialTextureLoad> load);
+    // Uploads what has been decoded so far, true once every texture is in
+    bool uploadDecodedMaterialTextures(std::shared_ptr<materialTextureLoad> load);
+
+    // Every mesh the node tree references, in the order a depth first traversal reaches them
+    std::vector<const aiMesh*> collectMeshes(const aiScene* scene) const;
+    meshGeometry processMesh(const aiMesh* assimpMesh, const aiScene* scene) const;
+
+    // Meshes of a parsed model with their texture slots, the buffers are left to the caller
+    std::shared_ptr<std::vector<Mesh>> createMeshes(importedModel& model, const std::string& absolutePath, bool keepGeometry) const;
+    // CPU geometry of mesh i, moved out of an Assimp import or copied out of the mesh cache
+    std::shared_ptr<meshGeometry> takeGeometry(importedModel& model, size_t i) const;
+
+    // Buffers of every mesh of a model, filled by one transfer submission
+    struct meshUpload
+    {
+        memoryBuffer staging{};
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+        VkFence fence = VK_NULL_HANDLE;
     };
+    meshUpload submitMeshUploads(const importedModel& model, std::vector<Mesh>& meshes);
+    // Once the fence has signaled
+    void freeMeshUpload(meshUpload& upload);
+    // Once the meshes are uploaded, drops the CPU geometry the meshes didn't take
+    void releaseGeometry(importedModel& model) const;
+    // Main thread only, the parse fills the report on a worker
+    void publishOptimization(const std::string& absolutePath, const importedModel& model);
+
+    // Binary mesh cache, written after an Assimp import and read instead of the source on later runs
+    void storeMeshCache(const std::string& cachePath, uint64_t sourceKey, const importedModel& model) const;
+
+    // Asynchronous imports in flight, by model path
+    struct pendingImport;
+    void beginMeshUpload(const std::string& absolutePath, pendingImport& import);
+    // Once the upload fence has signaled, hands the meshes to the library and queues the textures
+    void completeImport(const std::string& absolutePath, pendingImport& import);
 
+    std::unordered_map<std::string, std::shared_ptr<pendingImport>> _imports;
+    std::vector<std::string> _finishedImports;                              // finished or failed by finishImport, reported by the next updateImports
+    std::vector<std::string> _failedImports;
+    std::vector<std::shared_ptr<materialTextureLoad>> _textureLoads;       // textures of imported models still decoding
+    std::unordered_map<uint32_t, std::shared_ptr<materialTextureLoad>> _textureDecodes;   // reserved slot -> load that uploads into it, until it does
+    std::unordered_map<std::string, meshOptimizationReport> _optimizationReports;
+    std::unordered_map<std::string, bool> _optimizedImports;                // optimizeMeshes of every model loaded or importing
 
-    Assimp::Importer importer;
+    // Heap slot of every material texture of the model being reserved, by reference index
+    std::vector<unsigned int> _materialTextureIds;
 
     model_mesh_library* _meshLibrary;
 
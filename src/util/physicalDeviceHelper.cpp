@@ -69,4 +69,12 @@ VkFormat findDepthFormat(VkPhysicalDevice device)
     {VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT}, 
     VK_IMAGE_TILING_OPTIMAL, 
     VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
-}
\ No newline at end of file
+}
+
+bool canSampleDepthFormat(VkPhysicalDevice device)
+{
+    VkFormatProperties props;
+    vkGetPhysicalDeviceFormatProperties(device, findDepthFormat(device), &props);
+
+    return (props.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) != 0;
+}
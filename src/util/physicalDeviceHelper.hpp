@@ -20,3 +20,6 @@ QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device, VkSurfaceKHR& surf
 VkFormat findSupportedFormat(VkPhysicalDevice device, const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
 
 VkFormat findDepthFormat(VkPhysicalDevice device);
+
+// Whether the depth buffer can be sampled, the cluster culling pass reduces it into a depth pyramid
+bool canSampleDepthFormat(VkPhysicalDevice device);
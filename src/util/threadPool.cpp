@@ -0,0 +1,124 @@
+#include "util/threadPool.hpp"
+
+#include <algorithm>
+
+namespace
+{
+    // Shared between the caller and the helper tasks of one parallelFor, helpers may outlive the call
+    struct parallelForState
+    {
+        std::function<void(size_t)> body;
+        size_t count = 0;
+
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> done{0};
+
+        std::mutex mutex;
+        std::condition_variable condition;
+        std::exception_ptr error;
+    };
+
+    void runParallelForIndices(parallelForState& state)
+    {
+        for(size_t i = state.next++; i < state.count; i = state.next++)
+        {
+            try
+            {
+                state.body(i);
+            }
+            catch(...)
+            {
+                std::lock_guard<std::mutex> lock(state.mutex);
+                if(!state.error)
+                {
+                    state.error = std::current_exception();
+                }
+            }
+
+            if(++state.done == state.count)
+            {
+                std::lock_guard<std::mutex> lock(state.mutex);
+                state.condition.notify_all();
+            }
+        }
+    }
+}
+
+thread_pool::thread_pool(size_t threadCount)
+{
+    if(threadCount == 0)
+    {
+        threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    for(size_t i = 0; i < threadCount; i++)
+    {
+        _workers.emplace_back(&thread_pool::workerLoop, this);
+    }
+}
+
+thread_pool::~thread_pool()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _condition.notify_all();
+
+    for(std::thread& worker : _workers)
+    {
+        worker.join();
+    }
+}
+
+void thread_pool::parallelFor(size_t count, const std::function<void(size_t)>& body)
+{
+    if(count == 0)
+    {
+        return;
+    }
+
+    auto state = std::make_shared<parallelForState>();
+    state->body = body;
+    state->count = count;
+
+    // One helper per worker at most, the caller covers the rest
+    size_t helpers = std::min(count - 1, _workers.size());
+    for(size_t i = 0; i < helpers; i++)
+    {
+        submit([state]() { runParallelForIndices(*state); });
+    }
+
+    runParallelForIndices(*state);
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->condition.wait(lock, [&state]() { return state->done == state->count; });
+
+    if(state->error)
+    {
+        std::rethrow_exception(state->error);
+    }
+}
+
+void thread_pool::workerLoop()
+{
+    while(true)
+    {
+        std::function<void()> task;
+
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _condition.wait(lock, [this]() { return _stopping || !_tasks.empty(); });
+
+            if(_stopping && _tasks.empty())
+            {
+                return;
+            }
+
+            task = std::move(_tasks.front());
+            _tasks.pop();
+        }
+
+        task();
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads fed from a single task queue
+// Workers never touch Vulkan, they only prepare data for the thread that owns the queues
+class thread_pool
+{
+public:
+    thread_pool(size_t threadCount = 0);        // 0 picks one worker per hardware thread
+    ~thread_pool();
+
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    size_t getThreadCount() const { return _workers.size(); }
+
+    template<typename F>
+    auto submit(F&& task) -> std::future<decltype(task())>
+    {
+        using result_type = decltype(task());
+
+        auto packagedTask = std::make_shared<std::packaged_task<result_type()>>(std::forward<F>(task));
+        std::future<result_type> result = packagedTask->get_future();
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _tasks.emplace([packagedTask]() { (*packagedTask)(); });
+        }
+        _condition.notify_one();
+
+        return result;
+    }
+
+    // Runs body(i) for every i in [0, count) and returns once all of them are done
+    // The calling thread takes indices as well, so nested calls from workers can't deadlock
+    void parallelFor(size_t count, const std::function<void(size_t)>& body);
+
+private:
+    void workerLoop();
+
+    std::vector<std::thread> _workers;
+    std::queue<std::function<void()>> _tasks;
+
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    bool _stopping = false;
+};
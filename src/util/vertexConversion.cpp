@@ -0,0 +1,81 @@
+#include "util/vertexConversion.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#define MANTA_VERTEX_COPY_SSE2
+#endif
+
+namespace
+{
+    // Vertex fields in floats, convert writes them with overlapping vector stores
+    const size_t kPositionOffset = offsetof(Vertex, Position) / sizeof(float);
+    const size_t kNormalOffset = offsetof(Vertex, Normal) / sizeof(float);
+    const size_t kTexCoordsOffset = offsetof(Vertex, TexCoords) / sizeof(float);
+    const size_t kColorOffset = offsetof(Vertex, Color) / sizeof(float);
+    const size_t kTangentOffset = offsetof(Vertex, Tangent) / sizeof(float);
+    static_assert(kNormalOffset == kPositionOffset + 3 && kTexCoordsOffset == kNormalOffset + 3 && kColorOffset == kTexCoordsOffset + 2 &&
+                  kTangentOffset == kColorOffset + 3 && sizeof(Vertex) == (kTangentOffset + 3) * sizeof(float), "Vertex fields must be packed floats in declaration order");
+
+    // Reads three floats of a stream, zero when the stream is missing
+    glm::vec3 readVec3(const float* stream, size_t i)
+    {
+        return stream ? glm::vec3(stream[i * 3], stream[i * 3 + 1], stream[i * 3 + 2]) : glm::vec3(0.0f);
+    }
+
+    // Vertices [first, end) one field at a time
+    void convertRange(const vertexConversion::sourceStreams& streams, const glm::vec3& color, Vertex* vertices, size_t first, size_t end)
+    {
+        for(size_t i = first; i < end; i++)
+        {
+            Vertex& vertex = vertices[i];
+
+            vertex.Position = readVec3(streams.positions, i);
+            vertex.Normal = readVec3(streams.normals, i);
+            vertex.TexCoords = streams.texCoords ? glm::vec2(streams.texCoords[i * 3], streams.texCoords[i * 3 + 1]) : glm::vec2(0.0f);
+            vertex.Color = color;
+            vertex.Tangent = readVec3(streams.tangents, i);
+        }
+    }
+}
+
+namespace vertexConversion
+{
+    void convert(const sourceStreams& streams, const glm::vec3& color, Vertex* vertices, size_t count)
+    {
+        size_t i = 0;
+
+#if defined(MANTA_VERTEX_COPY_SSE2)
+        // One unaligned load and store per attribute, in field order: each store spills a float into the next field, which the next store overwrites
+        // Loads read a float past the element and Tangent spills into the next vertex, so the last vertex is left to the scalar loop
+        const __m128 colorLanes = _mm_setr_ps(color.x, color.y, color.z, 0.0f);
+        const __m128 zero = _mm_setzero_ps();
+
+        for(; i + 1 < count; i++)
+        {
+            float* vertex = reinterpret_cast<float*>(&vertices[i]);
+
+            _mm_storeu_ps(vertex + kPositionOffset, streams.positions ? _mm_loadu_ps(streams.positions + i * 3) : zero);
+            _mm_storeu_ps(vertex + kNormalOffset, streams.normals ? _mm_loadu_ps(streams.normals + i * 3) : zero);
+            _mm_storel_pi(reinterpret_cast<__m64*>(vertex + kTexCoordsOffset), streams.texCoords ? _mm_loadu_ps(streams.texCoords + i * 3) : zero);
+            _mm_storeu_ps(vertex + kColorOffset, colorLanes);
+            _mm_storeu_ps(vertex + kTangentOffset, streams.tangents ? _mm_loadu_ps(streams.tangents + i * 3) : zero);
+        }
+#endif
+
+        convertRange(streams, color, vertices, i, count);
+    }
+
+    void convertScalar(const sourceStreams& streams, const glm::vec3& color, Vertex* vertices, size_t count)
+    {
+        convertRange(streams, color, vertices, 0, count);
+    }
+
+    bool isVectorised()
+    {
+#if defined(MANTA_VERTEX_COPY_SSE2)
+        return true;
+#else
+        return false;
+#endif
+    }
+}
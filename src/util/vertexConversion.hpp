@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+
+#include "rendering/resources/vertex.hpp"
+
+// Import time conversion of per-attribute vertex streams into interleaved Vertex structs
+namespace vertexConversion
+{
+    // Three floats per vertex in every stream, the way Assimp stores them
+    // Null streams read as zero, only the first two floats of a texture coordinate are used
+    struct sourceStreams
+    {
+        const float* positions = nullptr;
+        const float* normals = nullptr;
+        const float* texCoords = nullptr;
+        const float* tangents = nullptr;
+    };
+
+    // Vectorised with SSE2 where available, every vertex gets the same color
+    void convert(const sourceStreams& streams, const glm::vec3& color, Vertex* vertices, size_t count);
+    // Field by field, the reference the vector path must match (see tools/vertexBenchmark)
+    void convertScalar(const sourceStreams& streams, const glm::vec3& color, Vertex* vertices, size_t count);
+
+    // True when convert takes the SSE2 path
+    bool isVectorised();
+}
@@ -0,0 +1,223 @@
+#include "util/virtualTextureFile.hpp"
+
+#include "util/ktx2.hpp"
+
+// Boost
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace
+{
+    const char kMagic[4] = {'M', 'V', 'T', 'X'};
+    const uint32_t kVersion = 1;
+
+    struct vtexHeader
+    {
+        char magic[4];
+        uint32_t version;
+        uint32_t vkFormat;
+        uint32_t width;
+        uint32_t height;
+        uint32_t mipCount;
+        uint32_t pageSize;
+        uint32_t border;
+        uint32_t pageCount;
+        uint32_t reserved[7];
+    };
+    static_assert(sizeof(vtexHeader) == 64, "vtex header must be 64 bytes");
+
+    // Page grid of every mip, the chain ends with the first level covered by one page
+    void computeLayout(virtualTextureFile& texture, uint32_t availableMips)
+    {
+        texture.firstPage.clear();
+        texture.pagesX.clear();
+        texture.pagesY.clear();
+
+        uint32_t pageCount = 0;
+        for(uint32_t mip = 0; mip < availableMips; mip++)
+        {
+            uint32_t levelWidth = std::max(texture.width >> mip, 1u);
+            uint32_t levelHeight = std::max(texture.height >> mip, 1u);
+
+            texture.firstPage.push_back(pageCount);
+            texture.pagesX.push_back((levelWidth + texture.pageSize - 1) / texture.pageSize);
+            texture.pagesY.push_back((levelHeight + texture.pageSize - 1) / texture.pageSize);
+            pageCount += texture.pagesX.back() * texture.pagesY.back();
+
+            if(texture.pagesX.back() == 1 && texture.pagesY.back() == 1)
+            {
+                break;
+            }
+        }
+        texture.mipCount = static_cast<uint32_t>(texture.firstPage.size());
+    }
+}
+
+size_t virtualTextureFile::getPageBytes() const
+{
+    return static_cast<size_t>(getPageStride()) * getPageStride() * ktx2::getFormatBlockBytes(format);
+}
+
+uint32_t virtualTextureFile::getPageCount() const
+{
+    return mipCount == 0 ? 0 : firstPage.back() + pagesX.back() * pagesY.back();
+}
+
+uint32_t virtualTextureFile::getPageIndex(uint32_t mip, uint32_t x, uint32_t y) const
+{
+    return firstPage[mip] + y * pagesX[mip] + x;
+}
+
+const uint8_t* virtualTextureFile::getPage(uint32_t pageIndex) const
+{
+    const uint8_t* pages = mapping ? static_cast<const uint8_t*>(mapping->get_address()) + sizeof(vtexHeader) : data.data();
+    return pages + static_cast<size_t>(pageIndex) * getPageBytes();
+}
+
+namespace vtex
+{
+    bool isVirtualTextureFile(const std::string& path)
+    {
+        return path.size() > 5 && path.substr(path.find_last_of(".") + 1) == "vtex";
+    }
+
+    virtualTextureFile load(const std::string& path)
+    {
+        namespace bip = boost::interprocess;
+
+        virtualTextureFile texture;
+
+        try
+        {
+            bip::file_mapping file(path.c_str(), bip::read_only);
+            texture.mapping = std::make_shared<bip::mapped_region>(file, bip::read_only);
+        }
+        catch(const bip::interprocess_exception&)
+        {
+            throw std::runtime_error("Failed to map virtual texture file: " + path);
+        }
+
+        size_t fileSize = texture.mapping->get_size();
+        if(fileSize < sizeof(vtexHeader))
+        {
+            throw std::runtime_error("Virtual texture file is truncated: " + path);
+        }
+
+        vtexHeader header;
+        std::memcpy(&header, texture.mapping->get_address(), sizeof(header));
+
+        if(std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion)
+        {
+            throw std::runtime_error("Not a supported virtual texture file: " + path);
+        }
+
+        texture.format = static_cast<VkFormat>(header.vkFormat);
+        texture.width = header.width;
+        texture.height = header.height;
+        texture.pageSize = header.pageSize;
+        texture.border = header.border;
+
+        if(texture.width == 0 || texture.height == 0 || texture.pageSize == 0)
+        {
+            throw std::runtime_error("Virtual texture file has no pages: " + path);
+        }
+
+        computeLayout(texture, header.mipCount);
+
+        if(texture.mipCount != header.mipCount || texture.getPageCount() != header.pageCount ||
+           fileSize < sizeof(vtexHeader) + static_cast<size_t>(header.pageCount) * texture.getPageBytes())
+        {
+            throw std::runtime_error("Virtual texture file is truncated: " + path);
+        }
+
+        return texture;
+    }
+
+    virtualTextureFile create(const std::vector<std::vector<uint8_t>>& mips, uint32_t width, uint32_t height, VkFormat format, uint32_t pageSize, uint32_t border)
+    {
+        if(ktx2::getFormatBlockBytes(format) != 4)
+        {
+            throw std::runtime_error("Virtual textures only hold 32 bit texels");
+        }
+
+        virtualTextureFile texture;
+        texture.format = format;
+        texture.width = width;
+        texture.height = height;
+        texture.pageSize = pageSize;
+        texture.border = border;
+
+        computeLayout(texture, static_cast<uint32_t>(mips.size()));
+
+        if(texture.pagesX.back() != 1 || texture.pagesY.back() != 1)
+        {
+            throw std::runtime_error("Mip chain is too short to end in a single page");
+        }
+
+        const uint32_t stride = texture.getPageStride();
+        texture.data.resize(texture.getPageCount() * texture.getPageBytes());
+
+        for(uint32_t mip = 0; mip < texture.mipCount; mip++)
+        {
+            const uint32_t* level = reinterpret_cast<const uint32_t*>(mips[mip].data());
+            int levelWidth = static_cast<int>(std::max(width >> mip, 1u));
+            int levelHeight = static_cast<int>(std::max(height >> mip, 1u));
+
+            for(uint32_t py = 0; py < texture.pagesY[mip]; py++)
+            {
+                for(uint32_t px = 0; px < texture.pagesX[mip]; px++)
+                {
+                    uint32_t* page = reinterpret_cast<uint32_t*>(texture.data.data() + texture.getPageIndex(mip, px, py) * texture.getPageBytes());
+
+                    // The border and anything past the level edge repeat the closest edge texel
+                    int originX = static_cast<int>(px * pageSize) - static_cast<int>(border);
+                    int originY = static_cast<int>(py * pageSize) - static_cast<int>(border);
+                    for(uint32_t y = 0; y < stride; y++)
+                    {
+                        int sourceY = std::clamp(originY + static_cast<int>(y), 0, levelHeight - 1);
+                        for(uint32_t x = 0; x < stride; x++)
+                        {
+                            int sourceX = std::clamp(originX + static_cast<int>(x), 0, levelWidth - 1);
+                            page[y * stride + x] = level[sourceY * levelWidth + sourceX];
+                        }
+                    }
+                }
+            }
+        }
+
+        return texture;
+    }
+
+    void save(const std::string& path, const virtualTextureFile& texture)
+    {
+        vtexHeader header{};
+        std::memcpy(header.magic, kMagic, sizeof(kMagic));
+        header.version = kVersion;
+        header.vkFormat = static_cast<uint32_t>(texture.format);
+        header.width = texture.width;
+        header.height = texture.height;
+        header.mipCount = texture.mipCount;
+        header.pageSize = texture.pageSize;
+        header.border = texture.border;
+        header.pageCount = texture.getPageCount();
+
+        std::ofstream file(path, std::ios::binary);
+        if(!file)
+        {
+            throw std::runtime_error("Failed to open virtual texture file for writing: " + path);
+        }
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(texture.getPage(0)), static_cast<std::streamsize>(header.pageCount * texture.getPageBytes()));
+
+        if(!file)
+        {
+            throw std::runtime_error("Failed to write virtual texture file: " + path);
+        }
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+// GLFW
+#include "wrapper/glfw.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Tiled virtual texture files (.vtex), every mip level is cut into fixed size square pages
+// Pages carry a border of neighbouring texels so filtering never has to read across pages
+
+namespace boost { namespace interprocess { class mapped_region; } }
+
+struct virtualTextureFile
+{
+    VkFormat format = VK_FORMAT_R8G8B8A8_SRGB;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t mipCount = 0;          // the last mip always fits a single page
+    uint32_t pageSize = 120;        // payload texels along a page side
+    uint32_t border = 4;            // texels on each side of the payload
+
+    // Per mip, pages are stored mip by mip in row order
+    std::vector<uint32_t> firstPage;
+    std::vector<uint32_t> pagesX;
+    std::vector<uint32_t> pagesY;
+
+    // Loaded files keep the file mapped, files built in memory own their pages in data
+    std::shared_ptr<boost::interprocess::mapped_region> mapping;
+    std::vector<uint8_t> data;
+
+    uint32_t getPageStride() const { return pageSize + 2 * border; }
+    size_t getPageBytes() const;
+    uint32_t getPageCount() const;
+    uint32_t getPageIndex(uint32_t mip, uint32_t x, uint32_t y) const;
+    // Texels of one page, getPageStride() rows of getPageStride() texels
+    const uint8_t* getPage(uint32_t pageIndex) const;
+};
+
+namespace vtex
+{
+    bool isVirtualTextureFile(const std::string& path);
+
+    // Maps the file, pages are only read when they are copied out
+    virtualTextureFile load(const std::string& path);
+
+    // Cuts an RGBA8 mip chain into bordered pages, edges are clamped
+    // Levels after the first one that fits a single page are dropped
+    virtualTextureFile create(const std::vector<std::vector<uint8_t>>& mips, uint32_t width, uint32_t height, VkFormat format, uint32_t pageSize = 120, uint32_t border = 4);
+
+    void save(const std::string& path, const virtualTextureFile& texture);
+}
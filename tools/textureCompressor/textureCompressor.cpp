@@ -0,0 +1,337 @@
+// Offline texture compressor, turns regular images into mipmapped BCn KTX2 files
+// Usage: MantaTextureCompressor <input> <output.ktx2> [--type diffuse|specular|normal|height|lightmap|roughness] [--format bc1|bc3|bc4|bc5|bc6h|bc7] [--no-mips] [--zstd <level>]
+//        MantaTextureCompressor --brdf-lut <output.ktx2>
+//        MantaTextureCompressor --virtual <input> <output.vtex>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+#include "util/blockCompression.hpp"
+#include "util/ktx2.hpp"
+#include "util/virtualTextureFile.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+    const std::map<std::string, E_TextureType> kTypeNames = {
+        {"diffuse", E_TextureType::DIFFUSE},
+        {"specular", E_TextureType::SPECULAR},
+        {"normal", E_TextureType::NORMAL},
+        {"height", E_TextureType::HEIGHT},
+        {"lightmap", E_TextureType::LIGHTMAP},
+        {"roughness", E_TextureType::ROUGHNESS}
+    };
+
+    void printUsage()
+    {
+        std::cerr << "Usage: MantaTextureCompressor <input> <output.ktx2> [--type diffuse|specular|normal|height|lightmap|roughness] [--format bc1|bc3|bc4|bc5|bc6h|bc7] [--no-mips] [--zstd <level>]" << std::endl;
+        std::cerr << "       MantaTextureCompressor --brdf-lut <output.ktx2>" << std::endl;
+        std::cerr << "       MantaTextureCompressor --virtual <input> <output.vtex>" << std::endl;
+    }
+
+    // Split sum BRDF LUT, a CPU port of res/shaders/brdfLUT so the engine can ship it precomputed
+    // Must match texture_system::bakeBRDF_LUT: 512x512, 1024 samples, R8G8B8A8_SRGB with (scale, bias) in red and green
+    const uint32_t kBRDFLUTSize = 512;
+    const uint32_t kBRDFLUTSampleCount = 1024;
+
+    float radicalInverse(uint32_t bits)
+    {
+        bits = (bits << 16u) | (bits >> 16u);
+        bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+        bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+        bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+        bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+        return static_cast<float>(bits) * 2.3283064365386963e-10f;
+    }
+
+    float geometrySchlickGGX(float NdotV, float roughness)
+    {
+        float k = (roughness * roughness) / 2.0f;
+        return NdotV / (NdotV * (1.0f - k) + k);
+    }
+
+    // Tangent space with N = +Z, so the GGX half vector needs no basis change
+    void integrateBRDF(float NdotV, float roughness, float& scale, float& bias)
+    {
+        const float pi = 3.14159265359f;
+        float V[3] = {std::sqrt(1.0f - NdotV * NdotV), 0.0f, NdotV};
+        float a = roughness * roughness;
+
+        scale = 0.0f;
+        bias = 0.0f;
+        for(uint32_t i = 0; i < kBRDFLUTSampleCount; i++)
+        {
+            float phi = 2.0f * pi * static_cast<float>(i) / static_cast<float>(kBRDFLUTSampleCount);
+            float xi = radicalInverse(i);
+            float cosTheta = std::sqrt((1.0f - xi) / (1.0f + (a * a - 1.0f) * xi));
+            float sinTheta = std::sqrt(1.0f - cosTheta * cosTheta);
+            float H[3] = {std::cos(phi) * sinTheta, std::sin(phi) * sinTheta, cosTheta};
+
+            float VdotH = V[0] * H[0] + V[1] * H[1] + V[2] * H[2];
+            float L[3] = {2.0f * VdotH * H[0] - V[0], 2.0f * VdotH * H[1] - V[1], 2.0f * VdotH * H[2] - V[2]};
+
+            float NdotL = std::max(L[2], 0.0f);
+            float NdotH = std::max(H[2], 0.0f);
+            VdotH = std::max(VdotH, 0.0f);
+
+            if(NdotL > 0.0f)
+            {
+                float G = geometrySchlickGGX(std::max(NdotV, 0.0f), roughness) * geometrySchlickGGX(NdotL, roughness);
+                float visibility = (G * VdotH) / (NdotH * NdotV);
+                float fresnel = std::pow(1.0f - VdotH, 5.0f);
+
+                scale += (1.0f - fresnel) * visibility;
+                bias += fresnel * visibility;
+            }
+        }
+        scale /= static_cast<float>(kBRDFLUTSampleCount);
+        bias /= static_cast<float>(kBRDFLUTSampleCount);
+    }
+
+    uint8_t encodeSRGB(float linear)
+    {
+        linear = std::min(std::max(linear, 0.0f), 1.0f);
+        float encoded = linear <= 0.0031308f ? linear * 12.92f : 1.055f * std::pow(linear, 1.0f / 2.4f) - 0.055f;
+        return static_cast<uint8_t>(encoded * 255.0f + 0.5f);
+    }
+
+    // Texel centers as the bake quad sees them, the top row holds roughness 1
+    ktx2Texture generateBRDFLUT()
+    {
+        ktx2Texture texture;
+        texture.format = VK_FORMAT_R8G8B8A8_SRGB;
+        texture.width = kBRDFLUTSize;
+        texture.height = kBRDFLUTSize;
+        texture.data.resize(static_cast<size_t>(kBRDFLUTSize) * kBRDFLUTSize * 4);
+
+        for(uint32_t y = 0; y < kBRDFLUTSize; y++)
+        {
+            float roughness = 1.0f - (static_cast<float>(y) + 0.5f) / kBRDFLUTSize;
+            for(uint32_t x = 0; x < kBRDFLUTSize; x++)
+            {
+                float NdotV = (static_cast<float>(x) + 0.5f) / kBRDFLUTSize;
+
+                float scale, bias;
+                integrateBRDF(NdotV, roughness, scale, bias);
+
+                uint8_t* texel = texture.data.data() + (static_cast<size_t>(y) * kBRDFLUTSize + x) * 4;
+                texel[0] = encodeSRGB(scale);
+                texel[1] = encodeSRGB(bias);
+                texel[2] = 0;
+                texel[3] = 255;
+            }
+        }
+
+        texture.levels.push_back({0, texture.data.size(), texture.data.size()});
+        return texture;
+    }
+
+    // Keeps the sRGB flavour of the picked format in line with what the texture type expects
+    VkFormat parseFormat(const std::string& name, bool isSRGB)
+    {
+        if(name == "bc1")   return isSRGB ? VK_FORMAT_BC1_RGB_SRGB_BLOCK : VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+        if(name == "bc3")   return isSRGB ? VK_FORMAT_BC3_SRGB_BLOCK : VK_FORMAT_BC3_UNORM_BLOCK;
+        if(name == "bc4")   return VK_FORMAT_BC4_UNORM_BLOCK;
+        if(name == "bc5")   return VK_FORMAT_BC5_UNORM_BLOCK;
+        if(name == "bc6h")  return VK_FORMAT_BC6H_UFLOAT_BLOCK;
+        if(name == "bc7")   return isSRGB ? VK_FORMAT_BC7_SRGB_BLOCK : VK_FORMAT_BC7_UNORM_BLOCK;
+
+        throw std::runtime_error("Unknown format: " + name);
+    }
+
+    void appendLevel(ktx2Texture& texture, const std::vector<uint8_t>& blocks)
+    {
+        ktx2Level level;
+        level.offset = texture.data.size();
+        level.size = blocks.size();
+        level.uncompressedSize = blocks.size();
+        texture.levels.push_back(level);
+        texture.data.insert(texture.data.end(), blocks.begin(), blocks.end());
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if(argc < 3)
+    {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+
+    if(std::string(argv[1]) == "--brdf-lut")
+    {
+        try
+        {
+            ktx2::save(argv[2], generateBRDFLUT());
+        }
+        catch(const std::exception& e)
+        {
+            std::cerr << e.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+
+    // Diffuse textures too large for VRAM, cut into pages the engine streams on demand
+    if(std::string(argv[1]) == "--virtual")
+    {
+        if(argc != 4)
+        {
+            printUsage();
+            return EXIT_FAILURE;
+        }
+
+        try
+        {
+            int width, height, channels;
+            stbi_uc* pixels = stbi_load(argv[2], &width, &height, &channels, STBI_rgb_alpha);
+            if(!pixels)
+            {
+                throw std::runtime_error(std::string("Failed to load image: ") + argv[2]);
+            }
+
+            std::vector<std::vector<uint8_t>> mips = blockCompression::generateMipChain(pixels, width, height, true, false);
+            stbi_image_free(pixels);
+
+            virtualTextureFile texture = vtex::create(mips, width, height, VK_FORMAT_R8G8B8A8_SRGB);
+            vtex::save(argv[3], texture);
+
+            std::cout << argv[3] << ": " << width << "x" << height << ", " << texture.mipCount << " levels, " << texture.getPageCount() << " pages" << std::endl;
+        }
+        catch(const std::exception& e)
+        {
+            std::cerr << e.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+
+    std::string inputPath = argv[1];
+    std::string outputPath = argv[2];
+    E_TextureType type = E_TextureType::DIFFUSE;
+    std::string formatName;
+    bool generateMips = true;
+    int zstdLevel = 0;
+
+    for(int i = 3; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if(arg == "--type" && i + 1 < argc)
+        {
+            auto it = kTypeNames.find(argv[++i]);
+            if(it == kTypeNames.end())
+            {
+                printUsage();
+                return EXIT_FAILURE;
+            }
+            type = it->second;
+        }
+        else if(arg == "--format" && i + 1 < argc)
+        {
+            formatName = argv[++i];
+        }
+        else if(arg == "--zstd" && i + 1 < argc)
+        {
+            zstdLevel = std::stoi(argv[++i]);
+        }
+        else if(arg == "--no-mips")
+        {
+            generateMips = false;
+        }
+        else
+        {
+            printUsage();
+            return EXIT_FAILURE;
+        }
+    }
+
+    try
+    {
+        bool isHDR = stbi_is_hdr(inputPath.c_str());
+        bool isSRGB = type == E_TextureType::DIFFUSE;
+
+        VkFormat format = formatName.empty() ? blockCompression::getCompressedFormat(type, isHDR) : parseFormat(formatName, isSRGB);
+        if(blockCompression::isHDRFormat(format) != isHDR)
+        {
+            throw std::runtime_error("BC6H is only used for HDR sources, and HDR sources only go to BC6H");
+        }
+
+        int width, height, channels;
+        ktx2Texture texture;
+        texture.format = format;
+
+        if(isHDR)
+        {
+            float* pixels = stbi_loadf(inputPath.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+            if(!pixels)
+            {
+                throw std::runtime_error("Failed to load image: " + inputPath);
+            }
+
+            std::vector<std::vector<float>> mips;
+            if(generateMips)
+            {
+                mips = blockCompression::generateMipChain(pixels, width, height);
+            }
+            else
+            {
+                mips.emplace_back(pixels, pixels + static_cast<size_t>(width) * height * 4);
+            }
+            stbi_image_free(pixels);
+
+            for(size_t level = 0; level < mips.size(); level++)
+            {
+                uint32_t levelWidth = std::max(static_cast<uint32_t>(width) >> level, 1u);
+                uint32_t levelHeight = std::max(static_cast<uint32_t>(height) >> level, 1u);
+                appendLevel(texture, blockCompression::compressImage(mips[level].data(), levelWidth, levelHeight, format));
+            }
+        }
+        else
+        {
+            stbi_uc* pixels = stbi_load(inputPath.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+            if(!pixels)
+            {
+                throw std::runtime_error("Failed to load image: " + inputPath);
+            }
+
+            std::vector<std::vector<uint8_t>> mips;
+            if(generateMips)
+            {
+                mips = blockCompression::generateMipChain(pixels, width, height, isSRGB, type == E_TextureType::NORMAL);
+            }
+            else
+            {
+                mips.emplace_back(pixels, pixels + static_cast<size_t>(width) * height * 4);
+            }
+            stbi_image_free(pixels);
+
+            for(size_t level = 0; level < mips.size(); level++)
+            {
+                uint32_t levelWidth = std::max(static_cast<uint32_t>(width) >> level, 1u);
+                uint32_t levelHeight = std::max(static_cast<uint32_t>(height) >> level, 1u);
+                appendLevel(texture, blockCompression::compressImage(mips[level].data(), levelWidth, levelHeight, format));
+            }
+        }
+
+        texture.width = width;
+        texture.height = height;
+
+        ktx2::save(outputPath, texture, zstdLevel);
+
+        std::cout << outputPath << ": " << width << "x" << height << ", " << texture.levels.size() << " levels, " << texture.data.size() << " bytes" << std::endl;
+    }
+    catch(const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,142 @@
+// Microbenchmark of the import time vertex conversion, the vector path of vertexConversion::convert against the scalar one
+// Usage: MantaVertexBenchmark [--vertices <count>] [--runs <count>]
+
+#include "util/vertexConversion.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // About the vertex count of a large scanned model
+    const size_t kDefaultVertexCount = 5000000;
+    const unsigned int kDefaultRuns = 10;
+
+    void printUsage()
+    {
+        std::cerr << "Usage: MantaVertexBenchmark [--vertices <count>] [--runs <count>]" << std::endl;
+    }
+
+    // Best and mean wall time of a conversion over every run, in milliseconds
+    struct timing
+    {
+        double best = 0.0;
+        double mean = 0.0;
+    };
+
+    template<typename Convert>
+    timing measure(Convert convert, unsigned int runs)
+    {
+        // One untimed run so page faults of the output land outside the measurement
+        convert();
+
+        timing result;
+        result.best = std::numeric_limits<double>::max();
+        for(unsigned int run = 0; run < runs; run++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            convert();
+            double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            result.best = std::min(result.best, milliseconds);
+            result.mean += milliseconds / runs;
+        }
+        return result;
+    }
+
+    void printTiming(const std::string& name, const timing& result, size_t vertexCount)
+    {
+        std::cout << name << ": best " << result.best << " ms, mean " << result.mean << " ms, "
+                  << static_cast<double>(vertexCount) / (result.best * 1000.0) << " Mvertices/s" << std::endl;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    size_t vertexCount = kDefaultVertexCount;
+    unsigned int runs = kDefaultRuns;
+
+    try
+    {
+        for(int i = 1; i < argc; i++)
+        {
+            std::string argument = argv[i];
+            if(argument == "--vertices" && i + 1 < argc)
+            {
+                vertexCount = std::stoull(argv[++i]);
+            }
+            else if(argument == "--runs" && i + 1 < argc)
+            {
+                runs = static_cast<unsigned int>(std::stoul(argv[++i]));
+            }
+            else
+            {
+                printUsage();
+                return 1;
+            }
+        }
+    }
+    catch(const std::exception&)
+    {
+        printUsage();
+        return 1;
+    }
+
+    if(vertexCount == 0 || runs == 0)
+    {
+        printUsage();
+        return 1;
+    }
+
+    // 1 - Streams laid out like an Assimp mesh, three floats per vertex and attribute
+    std::mt19937 generator(1234);
+    std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+
+    std::vector<float> positions(vertexCount * 3);
+    std::vector<float> normals(vertexCount * 3);
+    std::vector<float> texCoords(vertexCount * 3);
+    std::vector<float> tangents(vertexCount * 3);
+    for(size_t i = 0; i < vertexCount * 3; i++)
+    {
+        positions[i] = distribution(generator);
+        normals[i] = distribution(generator);
+        texCoords[i] = distribution(generator);
+        tangents[i] = distribution(generator);
+    }
+
+    vertexConversion::sourceStreams streams;
+    streams.positions = positions.data();
+    streams.normals = normals.data();
+    streams.texCoords = texCoords.data();
+    streams.tangents = tangents.data();
+    const glm::vec3 color(0.8f, 0.6f, 0.4f);
+
+    std::vector<Vertex> scalar(vertexCount);
+    std::vector<Vertex> vectorised(vertexCount);
+
+    // 2 - Both paths over the same streams
+    std::cout << "Converting " << vertexCount << " vertices, " << runs << " runs" << std::endl;
+
+    timing scalarTiming = measure([&]() { vertexConversion::convertScalar(streams, color, scalar.data(), vertexCount); }, runs);
+    timing vectorTiming = measure([&]() { vertexConversion::convert(streams, color, vectorised.data(), vertexCount); }, runs);
+
+    printTiming("Scalar", scalarTiming, vertexCount);
+    printTiming(vertexConversion::isVectorised() ? "SSE2" : "Vector path (scalar on this target)", vectorTiming, vertexCount);
+    std::cout << "Speedup: " << scalarTiming.best / vectorTiming.best << "x" << std::endl;
+
+    // 3 - The vector path must write exactly what the scalar one does
+    if(std::memcmp(scalar.data(), vectorised.data(), vertexCount * sizeof(Vertex)) != 0)
+    {
+        std::cerr << "Vector and scalar conversions differ" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}